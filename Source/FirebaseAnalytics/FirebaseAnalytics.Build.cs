@@ -9,6 +9,18 @@ public class FirebaseAnalytics : ModuleRules
     {
         PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "Projects", "HTTP" });
+
+        // Local endpoint for the Http backend, see FirebaseAnalyticsHttpStubCommandlet.h. Never shipped
+        bool bWithHttpStub = Target.Configuration != UnrealTargetConfiguration.Shipping
+            && (Target.Platform == UnrealTargetPlatform.Win64
+            || Target.Platform == UnrealTargetPlatform.Mac
+            || Target.Platform == UnrealTargetPlatform.Linux);
+        if (bWithHttpStub)
+        {
+            PrivateDependencyModuleNames.Add("HTTPServer");
+        }
+        PrivateDefinitions.Add("WITH_FIREBASE_ANALYTICS_HTTP_STUB=" + (bWithHttpStub ? "1" : "0"));
 
         string PluginPath = Utils.MakePathRelativeTo(ModuleDirectory, Target.RelativeEnginePath);
         if (Target.Platform == UnrealTargetPlatform.Android)
@@ -0,0 +1,825 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsAndroidBackend.h"
+
+#if PLATFORM_ANDROID
+#include "FirebaseAnalytics.h"
+#include "FirebaseAnalyticsBuiltinNames.h"
+#include "FirebaseAnalyticsJavaBundleFill.h"
+#include "FirebaseAnalyticsJavaEnv.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "FirebaseAnalyticsStats.h"
+#include "FirebaseAnalyticsStringCache.h"
+#include "Android/AndroidJNI.h"
+#include "Android/AndroidApplication.h"
+#include "Async/Async.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+
+// Analytics methods
+static jmethodID LogEvent_MethodID;
+static jmethodID LogEventWithStringParameter_MethodID;
+static jmethodID LogEventWithFloatParameter_MethodID;
+static jmethodID LogEventWithIntegerParameter_MethodID;
+static jmethodID LogEventWithParameters_MethodID;
+static jmethodID LogEventBatch_MethodID;
+static jmethodID ResetAnalyticsData_MethodID;
+static jmethodID SetAnalyticsCollectionEnabled_MethodID;
+static jmethodID SetSessionTimeoutDuration_MethodID;
+static jmethodID SetUserID_MethodID;
+static jmethodID SetUserProperty_MethodID;
+static jmethodID SetDefaultEventParameters_MethodID;
+static jmethodID InitializeDeferred_MethodID;
+static jmethodID BuildItemBundles_MethodID;
+
+// Set from UFirebaseAnalyticsSettings::bMarshalItemsByColumn when the backend is created
+static TAtomic<bool> bFirebaseAnalyticsItemsByColumn{true};
+
+// Set by the Java side once FirebaseAnalytics.getInstance has returned
+static TAtomic<bool> bFirebaseSdkReady{false};
+
+// Bundle methods
+static jmethodID Bundle_Constructor_MethodID;
+static jmethodID Bundle_PutString_MethodID;
+static jmethodID Bundle_PutFloat_MethodID;
+static jmethodID Bundle_PutInteger_MethodID;
+static jmethodID Bundle_PutDouble_MethodID;
+static jmethodID Bundle_PutLong_MethodID;
+static jmethodID Bundle_PutParcelableArray_MethodID;
+static jclass BundleClassID;
+static jclass ParcelableClassID;
+
+/** Java copy of Value as a plain local ref, accounted for in the stats.
+ *	FString already holds UTF-16, so it's handed to NewString as is instead of going through
+ *	a temporary UTF-8 copy and the VM's modified UTF-8 decoder like FJavaHelper::ToJavaString.
+ */
+static jstring NewJavaString(JNIEnv* Env, const FString& Value)
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_ToJavaString);
+	FIREBASE_ANALYTICS_RECORD_BYTES(Value.Len() * sizeof(UTF16CHAR));
+
+	if (sizeof(TCHAR) == sizeof(jchar))
+	{
+		return Env->NewString((const jchar*)*Value, Value.Len());
+	}
+
+	const auto Converted = StringCast<UTF16CHAR>(*Value, Value.Len());
+	return Env->NewString((const jchar*)Converted.Get(), Converted.Length());
+}
+
+static FScopedJavaObject<jstring> ToJavaString(JNIEnv* Env, const FString& Value)
+{
+	return NewScopedJavaObject(Env, NewJavaString(Env, Value));
+}
+
+static jobject NewJavaBundle(JNIEnv* Env)
+{
+	jobject JBundle = Env->NewObject(BundleClassID, Bundle_Constructor_MethodID);
+	ClearFirebaseAnalyticsJavaException(Env, TEXT("Bundle.<init>"));
+	return JBundle;
+}
+
+/** Cached per-thread JNIEnv, counting the call as failed when there is no VM to talk to. */
+static JNIEnv* GetJavaEnv()
+{
+	JNIEnv* Env = GetFirebaseAnalyticsJavaEnv();
+	if (Env == nullptr)
+	{
+		FIREBASE_ANALYTICS_RECORD_FAILED_CALL();
+	}
+
+	return Env;
+}
+
+/** Keeps global references to the Java strings of event and parameter names. */
+struct FJavaNameCachePolicy
+{
+	typedef jstring HandleType;
+
+	jstring Create(const FString& Name)
+	{
+		JNIEnv* Env = GetFirebaseAnalyticsJavaEnv();
+		if (Env == nullptr)
+		{
+			return nullptr;
+		}
+
+		auto LocalName = ToJavaString(Env, Name);
+		return (jstring)Env->NewGlobalRef(*LocalName);
+	}
+
+	void Release(jstring Handle)
+	{
+		if (JNIEnv* Env = GetFirebaseAnalyticsJavaEnv())
+		{
+			Env->DeleteGlobalRef(Handle);
+		}
+	}
+};
+
+typedef TFirebaseAnalyticsStringCache<FJavaNameCachePolicy> FJavaNameCache;
+
+static FJavaNameCache& GetJavaNameCache()
+{
+	// Intentionally leaked, global refs can't be released once the VM is gone at exit
+	static FJavaNameCache* Cache = new FJavaNameCache(GetDefault<UFirebaseAnalyticsSettings>()->JavaNameCacheSize);
+	return *Cache;
+}
+
+/** Same as NewJavaString, but for names: served from the global-ref cache when possible. */
+static jstring NewJavaName(JNIEnv* Env, const FString& Name)
+{
+	jstring LocalName = nullptr;
+	GetJavaNameCache().Visit(Name, [Env, &LocalName](jstring GlobalName)
+	{
+		if (GlobalName)
+		{
+			LocalName = (jstring)Env->NewLocalRef(GlobalName);
+		}
+	});
+
+	return LocalName ? LocalName : NewJavaString(Env, Name);
+}
+
+static FScopedJavaObject<jstring> ToJavaName(JNIEnv* Env, const FString& Name)
+{
+	return NewScopedJavaObject(Env, NewJavaName(Env, Name));
+}
+
+static jmethodID FindMethodInSpecificClass(
+	JNIEnv* Env,
+	jclass Class,
+	const char* Name, 
+	const char* Signature)
+{
+	if (Env && Name && Signature && Class)
+	{
+		return Env->GetMethodID(Class, Name, Signature);
+	}
+
+	return nullptr;
+}
+
+static jmethodID FindMethod(JNIEnv* Env, const char* Name, const char* Signature)
+{
+	if (Env && Name && Signature)
+	{
+		return Env->GetMethodID(FJavaWrapper::GameActivityClassID, Name, Signature);
+	}
+
+	return nullptr;
+}
+
+static void CallVoidMethod(JNIEnv* Env, jmethodID Method, ...)
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_CallVoidMethod);
+
+    // make sure the function exists
+	jobject Object = FJavaWrapper::GameActivityThis;
+	if (Method == NULL || Object == NULL || Env == NULL)
+	{
+		FIREBASE_ANALYTICS_RECORD_FAILED_CALL();
+		return;
+	}
+
+	va_list Args;
+	va_start(Args, Method);
+	Env->CallVoidMethodV(Object, Method, Args);
+	va_end(Args);
+
+	ClearFirebaseAnalyticsJavaException(Env, TEXT("GameActivity thunk"));
+}
+
+static void CallVoidObjectMethod(
+	JNIEnv* Env, 
+	jobject Object, 
+	jmethodID Method, ...)
+{
+    // make sure the function exists
+	if (Method == NULL || Object == NULL || Env == NULL)
+	{
+		FIREBASE_ANALYTICS_RECORD_FAILED_CALL();
+		return;
+	}
+
+	va_list Args;
+	va_start(Args, Method);
+	Env->CallVoidMethodV(Object, Method, Args);
+	va_end(Args);
+
+	ClearFirebaseAnalyticsJavaException(Env, TEXT("Bundle method"));
+}
+
+/** Static names are as many as the typed events compiled in, so their global refs are kept for good, by pointer. */
+static jstring NewJavaStaticName(JNIEnv* Env, const TCHAR* Name)
+{
+	static FCriticalSection CriticalSection;
+	static TMap<const TCHAR*, jstring> GlobalNames;
+
+	FScopeLock Lock(&CriticalSection);
+	jstring& GlobalName = GlobalNames.FindOrAdd(Name);
+	if (GlobalName == nullptr)
+	{
+		auto LocalName = ToJavaString(Env, Name);
+		GlobalName = (jstring)Env->NewGlobalRef(*LocalName);
+	}
+
+	return (jstring)Env->NewLocalRef(GlobalName);
+}
+
+/** Java name of a parameter as a plain local ref. Built-in names are kept in a table indexed by EBuiltinParamNames. */
+static jstring NewJavaParameterName(JNIEnv* Env, const FFirebaseAnalyticsParameter& Parameter)
+{
+	if (Parameter.StaticName)
+	{
+		return NewJavaStaticName(Env, Parameter.StaticName);
+	}
+
+	if (!Parameter.IsBuiltin())
+	{
+		return NewJavaName(Env, Parameter.Name);
+	}
+
+	static TAtomic<jstring> BuiltinNames[NumBuiltinParamNames];
+
+	TAtomic<jstring>& GlobalName = BuiltinNames[Parameter.BuiltinName];
+	jstring CurrentName = GlobalName.Load();
+	if (CurrentName == nullptr)
+	{
+		auto LocalName = ToJavaString(Env, Parameter.GetName());
+		jstring NewName = (jstring)Env->NewGlobalRef(*LocalName);
+
+		// Another thread may have won the race, keep its reference and drop ours
+		if (GlobalName.CompareExchange(CurrentName, NewName))
+		{
+			CurrentName = NewName;
+		}
+		else
+		{
+			Env->DeleteGlobalRef(NewName);
+		}
+	}
+
+	return (jstring)Env->NewLocalRef(CurrentName);
+}
+
+static FScopedJavaObject<jstring> ToJavaParameterName(JNIEnv* Env, const FFirebaseAnalyticsParameter& Parameter)
+{
+	return NewScopedJavaObject(Env, NewJavaParameterName(Env, Parameter));
+}
+
+/** Type codes of AndroidThunkJava_BuildItemBundles, keep in sync with FIREBASE_ITEMS_* in the UPL. */
+enum class EFirebaseAnalyticsJavaItemType : jbyte
+{
+	String = 0,
+	Float = 1,
+	Double = 2,
+	Integer = 3,
+	Int64 = 4,
+};
+
+/** True when every item has the same parameters in the same order and none of them is nested or null,
+ *	so the items can be sent as columns.
+ */
+static bool AreFirebaseAnalyticsItemsUniform(const FFlatBundle& Bundle, const FFirebaseAnalyticsParameter& Parameter)
+{
+	const TArrayView<const FFirebaseAnalyticsParameter> FirstItem = Bundle.GetItemParameters(Parameter, 0);
+	for (const FFirebaseAnalyticsParameter& Column : FirstItem)
+	{
+		if (Column.Type == EFirebaseAnalyticsParameterType::Bundles || Column.Type == EFirebaseAnalyticsParameterType::Null)
+		{
+			return false;
+		}
+	}
+
+	for (int32 ItemIdx = 1; ItemIdx < Parameter.Items.Num; ItemIdx++)
+	{
+		const TArrayView<const FFirebaseAnalyticsParameter> Item = Bundle.GetItemParameters(Parameter, ItemIdx);
+		if (Item.Num() != FirstItem.Num())
+		{
+			return false;
+		}
+
+		for (int32 ColumnIdx = 0; ColumnIdx < Item.Num(); ColumnIdx++)
+		{
+			const FFirebaseAnalyticsParameter& Cell = Item[ColumnIdx];
+			const FFirebaseAnalyticsParameter& Column = FirstItem[ColumnIdx];
+			if (Cell.Type != Column.Type
+				|| Cell.BuiltinName != Column.BuiltinName
+				|| (!Column.IsBuiltin() && !Cell.HasName(Column.GetName())))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/** Put the items of a uniform Bundles parameter into JBundle with a single Java call.
+ *	Keys, types and values go over as a few primitive arrays, one column after another, and the item
+ *	bundles are built on the Java side, instead of a JNI round trip per item and per parameter.
+ */
+static void PutJavaItemsByColumn(
+	JNIEnv* Env,
+	jobject JBundle,
+	jstring JParameterName,
+	const FFlatBundle& Bundle,
+	const FFirebaseAnalyticsParameter& Parameter)
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_ConvertBundleToJavaBundle);
+
+	const int32 NumItems = Parameter.Items.Num;
+	const TArrayView<const FFirebaseAnalyticsParameter> FirstItem = Bundle.GetItemParameters(Parameter, 0);
+	const int32 NumColumns = FirstItem.Num();
+
+	// Keys, the primitive arrays and the result
+	FFirebaseAnalyticsLocalFrame Frame(Env, 8);
+
+	TArray<jbyte, TInlineAllocator<16>> Types;
+	int32 NumStringCells = 0;
+	int32 NumLongCells = 0;
+	int32 NumDoubleCells = 0;
+
+	jobjectArray JKeys = Env->NewObjectArray(NumColumns, FJavaWrapper::JavaStringClass, nullptr);
+	for (int32 ColumnIdx = 0; ColumnIdx < NumColumns; ColumnIdx++)
+	{
+		const FFirebaseAnalyticsParameter& Column = FirstItem[ColumnIdx];
+
+		auto JKey = ToJavaParameterName(Env, Column);
+		Env->SetObjectArrayElement(JKeys, ColumnIdx, *JKey);
+
+		switch (Column.Type)
+		{
+			case EFirebaseAnalyticsParameterType::String:
+				Types.Add((jbyte)EFirebaseAnalyticsJavaItemType::String);
+				NumStringCells += NumItems;
+				break;
+			case EFirebaseAnalyticsParameterType::Float:
+				Types.Add((jbyte)EFirebaseAnalyticsJavaItemType::Float);
+				NumDoubleCells += NumItems;
+				break;
+			case EFirebaseAnalyticsParameterType::Double:
+				Types.Add((jbyte)EFirebaseAnalyticsJavaItemType::Double);
+				NumDoubleCells += NumItems;
+				break;
+			case EFirebaseAnalyticsParameterType::Integer:
+				Types.Add((jbyte)EFirebaseAnalyticsJavaItemType::Integer);
+				NumLongCells += NumItems;
+				break;
+			default:
+				Types.Add((jbyte)EFirebaseAnalyticsJavaItemType::Int64);
+				NumLongCells += NumItems;
+				break;
+		}
+	}
+
+	// Every cell of a column before the next column, strings concatenated with their end offsets alongside
+	TArray<UTF16CHAR> Chars;
+	TArray<jint> StringEnds;
+	TArray<jlong> Longs;
+	TArray<jdouble> Doubles;
+	StringEnds.Reserve(NumStringCells);
+	Longs.Reserve(NumLongCells);
+	Doubles.Reserve(NumDoubleCells);
+
+	for (int32 ColumnIdx = 0; ColumnIdx < NumColumns; ColumnIdx++)
+	{
+		for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+		{
+			const FFirebaseAnalyticsParameter& Cell = Bundle.GetItemParameters(Parameter, ItemIdx)[ColumnIdx];
+			switch (Cell.Type)
+			{
+				case EFirebaseAnalyticsParameterType::String:
+				{
+					if (sizeof(TCHAR) == sizeof(UTF16CHAR))
+					{
+						Chars.Append((const UTF16CHAR*)*Cell.StringValue, Cell.StringValue.Len());
+					}
+					else
+					{
+						const auto Converted = StringCast<UTF16CHAR>(*Cell.StringValue, Cell.StringValue.Len());
+						Chars.Append(Converted.Get(), Converted.Length());
+					}
+					StringEnds.Add(Chars.Num());
+					break;
+				}
+				case EFirebaseAnalyticsParameterType::Float:
+					Doubles.Add(Cell.FloatValue);
+					break;
+				case EFirebaseAnalyticsParameterType::Double:
+					Doubles.Add(Cell.DoubleValue);
+					break;
+				case EFirebaseAnalyticsParameterType::Integer:
+					Longs.Add(Cell.IntegerValue);
+					break;
+				default:
+					Longs.Add(Cell.Int64Value);
+					break;
+			}
+		}
+	}
+
+	FIREBASE_ANALYTICS_RECORD_BYTES(
+		Chars.Num() * sizeof(UTF16CHAR) + StringEnds.Num() * sizeof(jint) + Longs.Num() * sizeof(jlong) + Doubles.Num() * sizeof(jdouble));
+
+	jbyteArray JTypes = Env->NewByteArray(Types.Num());
+	Env->SetByteArrayRegion(JTypes, 0, Types.Num(), Types.GetData());
+	jcharArray JChars = Env->NewCharArray(Chars.Num());
+	Env->SetCharArrayRegion(JChars, 0, Chars.Num(), (const jchar*)Chars.GetData());
+	jintArray JStringEnds = Env->NewIntArray(StringEnds.Num());
+	Env->SetIntArrayRegion(JStringEnds, 0, StringEnds.Num(), StringEnds.GetData());
+	jlongArray JLongs = Env->NewLongArray(Longs.Num());
+	Env->SetLongArrayRegion(JLongs, 0, Longs.Num(), Longs.GetData());
+	jdoubleArray JDoubles = Env->NewDoubleArray(Doubles.Num());
+	Env->SetDoubleArrayRegion(JDoubles, 0, Doubles.Num(), Doubles.GetData());
+
+	jobject JItems = Env->CallObjectMethod(
+		FJavaWrapper::GameActivityThis,
+		BuildItemBundles_MethodID,
+		(jint)NumItems,
+		JKeys,
+		JTypes,
+		JChars,
+		JStringEnds,
+		JLongs,
+		JDoubles);
+	if (ClearFirebaseAnalyticsJavaException(Env, TEXT("AndroidThunkJava_BuildItemBundles")) || JItems == nullptr)
+	{
+		FIREBASE_ANALYTICS_RECORD_FAILED_CALL();
+		return;
+	}
+
+	CallVoidObjectMethod(Env, JBundle, Bundle_PutParcelableArray_MethodID, JParameterName, JItems);
+}
+
+/** JNI side of FillFirebaseAnalyticsJavaBundle. */
+struct FFirebaseAnalyticsJniBundleWriter
+{
+	typedef jobject ObjectType;
+
+	struct FrameType
+	{
+		FFirebaseAnalyticsLocalFrame Frame;
+
+		FrameType(FFirebaseAnalyticsJniBundleWriter& Writer, int32 Capacity)
+			: Frame(Writer.Env, Capacity)
+		{
+		}
+	};
+
+	JNIEnv* Env;
+
+	jobject NewName(const FFirebaseAnalyticsParameter& Parameter) { return NewJavaParameterName(Env, Parameter); }
+	jobject NewString(const FString& Value) { return NewJavaString(Env, Value); }
+
+	void PutString(jobject JBundle, jobject Name, jobject Value) { CallVoidObjectMethod(Env, JBundle, Bundle_PutString_MethodID, Name, Value); }
+	void PutFloat(jobject JBundle, jobject Name, float Value) { CallVoidObjectMethod(Env, JBundle, Bundle_PutFloat_MethodID, Name, Value); }
+	void PutDouble(jobject JBundle, jobject Name, double Value) { CallVoidObjectMethod(Env, JBundle, Bundle_PutDouble_MethodID, Name, Value); }
+	void PutInteger(jobject JBundle, jobject Name, int32 Value) { CallVoidObjectMethod(Env, JBundle, Bundle_PutInteger_MethodID, Name, Value); }
+	void PutLong(jobject JBundle, jobject Name, int64 Value) { CallVoidObjectMethod(Env, JBundle, Bundle_PutLong_MethodID, Name, (jlong)Value); }
+
+	bool PutItemsByColumn(jobject JBundle, jobject Name, const FFlatBundle& Bundle, const FFirebaseAnalyticsParameter& Parameter)
+	{
+		if (Parameter.Items.Num < 2
+			|| !bFirebaseAnalyticsItemsByColumn
+			|| BuildItemBundles_MethodID == nullptr
+			|| !AreFirebaseAnalyticsItemsUniform(Bundle, Parameter))
+		{
+			return false;
+		}
+
+		PutJavaItemsByColumn(Env, JBundle, (jstring)Name, Bundle, Parameter);
+		return true;
+	}
+
+	jobject NewItemBundle() { return NewJavaBundle(Env); }
+
+	jobject NewItemArray(int32 Length)
+	{
+		jobject Array = Env->NewObjectArray(Length, ParcelableClassID, nullptr);
+		ClearFirebaseAnalyticsJavaException(Env, TEXT("NewObjectArray"));
+		return Array;
+	}
+
+	void SetItem(jobject Array, int32 ItemIdx, jobject ItemBundle)
+	{
+		Env->SetObjectArrayElement((jobjectArray)Array, ItemIdx, ItemBundle);
+		ClearFirebaseAnalyticsJavaException(Env, TEXT("SetObjectArrayElement"));
+	}
+
+	void PutItemArray(jobject JBundle, jobject Name, jobject Array) { CallVoidObjectMethod(Env, JBundle, Bundle_PutParcelableArray_MethodID, Name, Array); }
+	void ReleaseItem(jobject Object) { Env->DeleteLocalRef(Object); }
+};
+
+/** Returns a fresh local ref, the SDK keeps the Bundle it is given so it is never reused. */
+static jobject ConvertBundleToJavaBundle(JNIEnv* Env, const FFlatBundle& Bundle)
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_ConvertBundleToJavaBundle);
+
+	jobject JBundle = NewJavaBundle(Env);
+	FFirebaseAnalyticsJniBundleWriter Writer{Env};
+	FillFirebaseAnalyticsJavaBundle(Writer, JBundle, Bundle, Bundle.GetParameters());
+	return JBundle;
+}
+
+FFirebaseAnalyticsAndroidBackend::FFirebaseAnalyticsAndroidBackend()
+{
+	bMarshalThroughNativeBuffer = GetDefault<UFirebaseAnalyticsSettings>()->bMarshalThroughNativeBuffer;
+	bFirebaseAnalyticsItemsByColumn = GetDefault<UFirebaseAnalyticsSettings>()->bMarshalItemsByColumn;
+
+	if (GetDefault<UFirebaseAnalyticsSettings>()->bDeferInitialization)
+	{
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FFirebaseAnalyticsAndroidBackend::StartDeferredInitialization);
+	}
+}
+
+FFirebaseAnalyticsAndroidBackend::~FFirebaseAnalyticsAndroidBackend()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetMarshalItemsByColumn(bool bEnabled)
+{
+	bFirebaseAnalyticsItemsByColumn = bEnabled;
+}
+
+bool FFirebaseAnalyticsAndroidBackend::IsMarshalingItemsByColumn()
+{
+	return bFirebaseAnalyticsItemsByColumn;
+}
+
+void FFirebaseAnalyticsAndroidBackend::DumpNameCacheStats(FOutputDevice& Ar)
+{
+	const FJavaNameCache& Cache = GetJavaNameCache();
+	const FFirebaseAnalyticsStringCacheStats Stats = Cache.GetStats();
+	const uint64 Lookups = Stats.Hits + Stats.Misses;
+	Ar.Logf(TEXT("Firebase Analytics name cache: %d of %d names, %llu hits / %llu misses (%.1f%%), %llu evictions"),
+		Stats.Num,
+		Cache.GetCapacity(),
+		Stats.Hits,
+		Stats.Misses,
+		Lookups ? 100.0 * Stats.Hits / Lookups : 0.0,
+		Stats.Evictions);
+}
+
+void FFirebaseAnalyticsAndroidBackend::StartDeferredInitialization()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	EndFrameHandle.Reset();
+
+	if (bFirebaseSdkReady)
+	{
+		return;
+	}
+
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		CallVoidMethod(Env, InitializeDeferred_MethodID);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	JNIEnv* Env = GetJavaEnv();
+	if (Env == nullptr)
+	{
+		return;
+	}
+
+	auto JEventName = ToJavaName(Env, Event.Name);
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters = Event.Parameters.GetParameters();
+
+	// Events without parameters or with a single plain one don't need a native built Bundle
+	if (Parameters.Num() == 0)
+	{
+		CallVoidMethod(Env, LogEvent_MethodID, *JEventName);
+		return;
+	}
+
+	if (Parameters.Num() == 1)
+	{
+		const FFirebaseAnalyticsParameter& Parameter = Parameters[0];
+		switch (Parameter.Type)
+		{
+			case EFirebaseAnalyticsParameterType::String:
+			{
+				auto JParameterName = ToJavaParameterName(Env, Parameter);
+				auto JParameterValue = ToJavaString(Env, Parameter.StringValue);
+
+				CallVoidMethod(
+					Env,
+					LogEventWithStringParameter_MethodID,
+					*JEventName,
+					*JParameterName,
+					*JParameterValue);
+				return;
+			}
+			case EFirebaseAnalyticsParameterType::Float:
+			{
+				auto JParameterName = ToJavaParameterName(Env, Parameter);
+
+				CallVoidMethod(
+					Env,
+					LogEventWithFloatParameter_MethodID,
+					*JEventName,
+					*JParameterName,
+					Parameter.FloatValue);
+				return;
+			}
+			case EFirebaseAnalyticsParameterType::Integer:
+			{
+				auto JParameterName = ToJavaParameterName(Env, Parameter);
+
+				CallVoidMethod(
+					Env,
+					LogEventWithIntegerParameter_MethodID,
+					*JEventName,
+					*JParameterName,
+					Parameter.IntegerValue);
+				return;
+			}
+			default:
+			{
+				break;
+			}
+		}
+	}
+
+	if (bMarshalThroughNativeBuffer && LogEventBatch_MethodID != nullptr)
+	{
+		LogEncodedEvents(Env, MakeArrayView(&Event, 1));
+		return;
+	}
+
+	auto JBundle = NewScopedJavaObject(Env, ConvertBundleToJavaBundle(Env, Event.Parameters));
+
+	CallVoidMethod(
+		Env,
+		LogEventWithParameters_MethodID,
+		*JEventName,
+		*JBundle);
+}
+
+void FFirebaseAnalyticsAndroidBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	JNIEnv* Env = GetFirebaseAnalyticsJavaEnv();
+	if (Env == nullptr || LogEventBatch_MethodID == nullptr || Events.Num() < 2)
+	{
+		IFirebaseAnalyticsBackend::LogEvents(Events);
+		return;
+	}
+
+	LogEncodedEvents(Env, Events);
+}
+
+void FFirebaseAnalyticsAndroidBackend::LogEncodedEvents(JNIEnv* Env, TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	// Batches come from the dispatch thread only, the lock keeps direct LogEvent callers honest
+	FScopeLock Lock(&EncoderCriticalSection);
+
+	{
+		FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_EncodeBatch);
+
+		Encoder.Reset();
+		for (const FFirebaseAnalyticsEvent& Event : Events)
+		{
+			Encoder.AddEvent(Event);
+		}
+	}
+
+	FIREBASE_ANALYTICS_RECORD_BYTES(Encoder.GetSize());
+
+	// The direct buffer aliases native memory, the Java side decodes it before the call returns
+	auto JBatch = NewScopedJavaObject(Env, Env->NewDirectByteBuffer((void*)Encoder.GetData(), Encoder.GetSize()));
+	CallVoidMethod(Env, LogEventBatch_MethodID, *JBatch);
+}
+
+void FFirebaseAnalyticsAndroidBackend::ResetAnalyticsData()
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		CallVoidMethod(Env, ResetAnalyticsData_MethodID);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		CallVoidMethod(Env, SetAnalyticsCollectionEnabled_MethodID, bEnabled);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		CallVoidMethod(Env, SetSessionTimeoutDuration_MethodID, Milliseconds);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetUserID(const FString& UserID)
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		auto JUserID = ToJavaString(Env, UserID);
+		
+		CallVoidMethod(Env, SetUserID_MethodID, *JUserID);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		auto JPropertyName = ToJavaName(Env, PropertyName);
+		auto JPropertyValue = ToJavaString(Env, PropertyValue);
+
+		CallVoidMethod(
+			Env, 
+			SetUserProperty_MethodID,
+			*JPropertyName, 
+			*JPropertyValue);
+	}
+}
+
+void FFirebaseAnalyticsAndroidBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	if (JNIEnv* Env = GetJavaEnv())
+	{
+		auto JBundle = NewScopedJavaObject(Env, ConvertBundleToJavaBundle(Env, Parameters));
+		CallVoidMethod(
+			Env, 
+			SetDefaultEventParameters_MethodID,
+			*JBundle);
+	}
+}
+
+bool FFirebaseAnalyticsAndroidBackend::IsReady() const
+{
+	return bFirebaseSdkReady
+		&& FJavaWrapper::GameActivityThis != nullptr
+		&& LogEvent_MethodID != nullptr
+		&& LogEventWithParameters_MethodID != nullptr;
+}
+
+JNI_METHOD void Java_com_epicgames_ue4_GameActivity_NativeInitialize(
+	JNIEnv* Env,
+	jobject Thiz)
+{
+	// Find methods in game activity
+    LogEvent_MethodID						= FindMethod(Env, "AndroidThunkJava_LogEvent",						"(Ljava/lang/String;)V");
+    LogEventWithStringParameter_MethodID	= FindMethod(Env, "AndroidThunkJava_LogEventWithParameter",			"(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+    LogEventWithFloatParameter_MethodID		= FindMethod(Env, "AndroidThunkJava_LogEventWithParameter",			"(Ljava/lang/String;Ljava/lang/String;F)V");
+    LogEventWithIntegerParameter_MethodID	= FindMethod(Env, "AndroidThunkJava_LogEventWithParameter",			"(Ljava/lang/String;Ljava/lang/String;I)V");
+    LogEventWithParameters_MethodID			= FindMethod(Env, "AndroidThunkJava_LogEventWithParameters",		"(Ljava/lang/String;Landroid/os/Bundle;)V");
+	LogEventBatch_MethodID					= FindMethod(Env, "AndroidThunkJava_LogEventBatch",					"(Ljava/nio/ByteBuffer;)V");
+    ResetAnalyticsData_MethodID				= FindMethod(Env, "AndroidThunkJava_ResetAnalyticsData",			"()V");
+    SetAnalyticsCollectionEnabled_MethodID	= FindMethod(Env, "AndroidThunkJava_SetAnalyticsCollectionEnabled", "(Z)V");
+    SetSessionTimeoutDuration_MethodID		= FindMethod(Env, "AndroidThunkJava_SetSessionTimeoutDuration",		"(I)V");
+    SetUserID_MethodID						= FindMethod(Env, "AndroidThunkJava_SetUserID",						"(Ljava/lang/String;)V");
+    SetUserProperty_MethodID				= FindMethod(Env, "AndroidThunkJava_SetUserProperty",				"(Ljava/lang/String;Ljava/lang/String;)V");
+	SetDefaultEventParameters_MethodID		= FindMethod(Env, "AndroidThunkJava_SetDefaultEventParameters",		"(Landroid/os/Bundle;)V");
+	InitializeDeferred_MethodID				= FindMethod(Env, "AndroidThunkJava_FirebaseAnalyticsInitializeDeferred", "()V");
+	BuildItemBundles_MethodID				= FindMethod(Env, "AndroidThunkJava_BuildItemBundles",				"(I[Ljava/lang/String;[B[C[I[J[D)[Landroid/os/Parcelable;");
+	
+	// Find methods in Bundle class
+	ParcelableClassID						= FJavaWrapper::FindClassGlobalRef(Env, "android/os/Parcelable", false);
+	BundleClassID							= FJavaWrapper::FindClassGlobalRef(Env, "android/os/Bundle", false);
+	Bundle_Constructor_MethodID				= FindMethodInSpecificClass(Env, BundleClassID, "<init>",				"()V");
+	Bundle_PutString_MethodID				= FindMethodInSpecificClass(Env, BundleClassID, "putString",			"(Ljava/lang/String;Ljava/lang/String;)V");
+	Bundle_PutFloat_MethodID				= FindMethodInSpecificClass(Env, BundleClassID, "putFloat",				"(Ljava/lang/String;F)V");
+	Bundle_PutInteger_MethodID				= FindMethodInSpecificClass(Env, BundleClassID, "putInt",				"(Ljava/lang/String;I)V");
+	Bundle_PutDouble_MethodID				= FindMethodInSpecificClass(Env, BundleClassID, "putDouble",			"(Ljava/lang/String;D)V");
+	Bundle_PutLong_MethodID					= FindMethodInSpecificClass(Env, BundleClassID, "putLong",				"(Ljava/lang/String;J)V");
+	Bundle_PutParcelableArray_MethodID		= FindMethodInSpecificClass(Env, BundleClassID, "putParcelableArray",	"(Ljava/lang/String;[Landroid/os/Parcelable;)V");
+}
+
+JNI_METHOD void Java_com_epicgames_ue4_GameActivity_NativeOnFirebaseAnalyticsReady(
+	JNIEnv* Env,
+	jobject Thiz,
+	jlong InitializeNanoseconds)
+{
+	// May run from onCreate, before the log is up
+	FPlatformMisc::LowLevelOutputDebugStringf(TEXT("Firebase Analytics SDK initialized in %.1f ms"), InitializeNanoseconds / 1000000.0);
+
+	bFirebaseSdkReady = true;
+
+	// This is the FirebaseAnalyticsInit thread. Held calls go out on the game thread, which delivers every other
+	// direct call too, so the backend is never entered from two threads at once. Without the module there is
+	// nothing held yet, SetBackend notices the ready backend once it is created.
+	if (FFirebaseAnalyticsModule::Get())
+	{
+		AsyncTask(ENamedThreads::GameThread, []()
+		{
+			if (FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get())
+			{
+				Module->OnBackendReady();
+			}
+		});
+	}
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_ANDROID
+#include <jni.h>
+#include "FirebaseAnalyticsBackend.h"
+#include "FirebaseAnalyticsBatchCodec.h"
+
+/** Forwards every call to the Firebase SDK through the GameActivity thunks. */
+class FFirebaseAnalyticsAndroidBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	FFirebaseAnalyticsAndroidBackend();
+	virtual ~FFirebaseAnalyticsAndroidBackend();
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	virtual bool IsReady() const override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	/** Override bMarshalItemsByColumn until the next backend is created, so both item paths can be timed in one run. */
+	static void SetMarshalItemsByColumn(bool bEnabled);
+	static bool IsMarshalingItemsByColumn();
+
+	/** Print hits, misses and evictions of the global-ref name cache, part of FirebaseAnalytics.DumpStats. */
+	static void DumpNameCacheStats(FOutputDevice& Ar);
+
+private:
+	/** Ask the Java side to initialize the SDK on its own thread, once the first frame is out. */
+	void StartDeferredInitialization();
+
+	/** Encode events into the native buffer and hand it to the Java decoder in one call. */
+	void LogEncodedEvents(JNIEnv* Env, TArrayView<const FFirebaseAnalyticsEvent> Events);
+
+	FDelegateHandle EndFrameHandle;
+	bool bMarshalThroughNativeBuffer = false;
+
+	FCriticalSection EncoderCriticalSection;
+	FFirebaseAnalyticsBatchEncoder Encoder;
+};
+
+#endif
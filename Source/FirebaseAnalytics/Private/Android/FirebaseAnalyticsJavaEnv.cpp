@@ -0,0 +1,56 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsJavaEnv.h"
+
+#if PLATFORM_ANDROID
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsStats.h"
+#include "Android/AndroidApplication.h"
+
+JNIEnv* GetFirebaseAnalyticsJavaEnv()
+{
+	static thread_local JNIEnv* CachedEnv = nullptr;
+	if (CachedEnv == nullptr)
+	{
+		CachedEnv = FAndroidApplication::GetJavaEnv();
+	}
+
+	return CachedEnv;
+}
+
+bool ClearFirebaseAnalyticsJavaException(JNIEnv* Env, const TCHAR* Context)
+{
+	if (!Env->ExceptionCheck())
+	{
+		return false;
+	}
+
+	// Describe prints the stack trace to logcat
+	Env->ExceptionDescribe();
+	Env->ExceptionClear();
+
+	UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Java exception in %s"), Context);
+	FIREBASE_ANALYTICS_RECORD_FAILED_CALL();
+	return true;
+}
+
+FFirebaseAnalyticsLocalFrame::FFirebaseAnalyticsLocalFrame(JNIEnv* InEnv, int32 Capacity)
+	: Env(InEnv)
+{
+	// Without a frame refs land in the enclosing one, still correct, just not freed early
+	bPushed = Env->PushLocalFrame(FMath::Max(Capacity, 1)) == 0;
+	if (!bPushed)
+	{
+		ClearFirebaseAnalyticsJavaException(Env, TEXT("PushLocalFrame"));
+	}
+}
+
+FFirebaseAnalyticsLocalFrame::~FFirebaseAnalyticsLocalFrame()
+{
+	if (bPushed)
+	{
+		Env->PopLocalFrame(nullptr);
+	}
+}
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_ANDROID
+#include <jni.h>
+
+/** FAndroidApplication::GetJavaEnv, looked up once per thread.
+ *	Threads stay attached to the VM until they exit, so the cached pointer outlives every use.
+ */
+JNIEnv* GetFirebaseAnalyticsJavaEnv();
+
+/** Describe and clear a pending Java exception, so the next JNI call is legal again. Returns true if there was one. */
+bool ClearFirebaseAnalyticsJavaException(JNIEnv* Env, const TCHAR* Context);
+
+/** PushLocalFrame on construction, PopLocalFrame on destruction.
+ *	Local refs created in between are freed together instead of one DeleteLocalRef each,
+ *	so none of them may be kept past the frame.
+ */
+class FFirebaseAnalyticsLocalFrame
+{
+public:
+	FFirebaseAnalyticsLocalFrame(JNIEnv* InEnv, int32 Capacity);
+	~FFirebaseAnalyticsLocalFrame();
+
+private:
+	JNIEnv* Env;
+	bool bPushed;
+};
+
+#endif
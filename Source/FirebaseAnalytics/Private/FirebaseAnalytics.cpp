@@ -1,11 +1,41 @@
 // Copyright (C) 2021. Nikita Klimov. All rights reserved.
 
 #include "FirebaseAnalytics.h"
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsBundlePool.h"
+#include "FirebaseAnalyticsDedupBackend.h"
+#include "FirebaseAnalyticsDispatcher.h"
+#include "FirebaseAnalyticsEventFilter.h"
+#include "FirebaseAnalyticsJournal.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsMetrics.h"
+#include "FirebaseAnalyticsPriorityLanes.h"
 #include "FirebaseAnalyticsSettings.h"
+#include "FirebaseAnalyticsStats.h"
+#include "FirebaseAnalyticsTrace.h"
+#include "FirebaseAnalyticsValidator.h"
+#include "Containers/Ticker.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
 #include "Settings/Public/ISettingsModule.h"
+#include "UObject/UObjectGlobals.h"
 
 #define LOCTEXT_NAMESPACE "FFirebaseAnalyticsModule"
 
+DEFINE_LOG_CATEGORY(LogFirebaseAnalytics);
+
+static FFirebaseAnalyticsModule* ModuleInstance = nullptr;
+
+FFirebaseAnalyticsModule::FFirebaseAnalyticsModule()
+	: TraceWriter(MakeUnique<FFirebaseAnalyticsTraceWriter>())
+{
+}
+
+FFirebaseAnalyticsModule::~FFirebaseAnalyticsModule()
+{
+}
+
 void FFirebaseAnalyticsModule::StartupModule()
 {
 	if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings"))
@@ -18,10 +48,140 @@ void FFirebaseAnalyticsModule::StartupModule()
 			LOCTEXT("Firebase Analytics", "Settings for Firebase Analytics"),
 			GetMutableDefault<UFirebaseAnalyticsSettings>());
 	}
+
+	const UFirebaseAnalyticsSettings* Settings = GetDefault<UFirebaseAnalyticsSettings>();
+	StartupTime = FPlatformTime::Seconds();
+
+	if (Settings->EventRules.Num() > 0)
+	{
+		EventFilter = MakeUnique<FFirebaseAnalyticsEventFilter>(Settings->EventRules, Settings->SampleRateParameterName);
+	}
+
+	if (Settings->Validation != EFirebaseAnalyticsValidationPolicy::Off || Settings->EventSchema.Num() > 0)
+	{
+		Validator = MakeUnique<FFirebaseAnalyticsValidator>(*Settings);
+	}
+
+	Backend = CreateFirebaseAnalyticsBackend(Settings->Backend);
+	if (Settings->bSkipRedundantWrites)
+	{
+		Backend = MakeShared<FFirebaseAnalyticsDedupBackend, ESPMode::ThreadSafe>(Backend);
+	}
+
+	TArray<FFirebaseAnalyticsEvent> JournaledEvents;
+	if (Settings->bEnableEventJournal)
+	{
+		Journal = MakeUnique<FFirebaseAnalyticsJournal>(
+			FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics") / TEXT("EventJournal.bin"),
+			(int64)Settings->EventJournalSizeKB * 1024);
+
+		if (!Journal->Open(JournaledEvents))
+		{
+			Journal.Reset();
+		}
+	}
+
+	if (Settings->bAsyncEventDispatch && FPlatformProcess::SupportsMultithreading())
+	{
+		Dispatcher = MakeUnique<FFirebaseAnalyticsDispatcher>(Backend, Settings->MaxEventsPerBatch, Journal.Get());
+	}
+
+	ModuleInstance = this;
+
+	// -FirebaseAnalyticsTrace=<file> catches the calls made during startup too
+	FString TraceFilename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("FirebaseAnalyticsTrace="), TraceFilename))
+	{
+		TraceWriter->Start(TraceFilename.IsEmpty() ? GetDefaultFirebaseAnalyticsTraceFilename() : TraceFilename);
+	}
+
+	// The SDK may still be initializing, hold calls back instead of losing them.
+	// Readiness is checked again under the lock in case it flipped in the meantime.
+	if (Backend && !Backend->IsReady() && Settings->PreInitBufferSize > 0)
+	{
+		FScopeLock Lock(&PreInitCriticalSection);
+		MaxPreInitCalls = Settings->PreInitBufferSize;
+		bHoldingPreInitCalls = !Backend->IsReady();
+	}
+
+	BundlePool = MakeUnique<FFirebaseAnalyticsBundlePool>(Settings->BundleHandlePoolSize);
+
+	if (Settings->bEnablePriorityLanes)
+	{
+		PriorityLanes = MakeUnique<FFirebaseAnalyticsPriorityLanes>(*Settings);
+		PriorityLanesTickerHandle = FTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FFirebaseAnalyticsModule::TickPriorityLanes));
+	}
+
+	LifecycleFlushDeadlineSeconds = Settings->LifecycleFlushDeadlineSeconds;
+	EnterBackgroundHandle = FCoreDelegates::ApplicationWillEnterBackgroundDelegate.AddRaw(this, &FFirebaseAnalyticsModule::FlushForLifecycle);
+	TerminateHandle = FCoreDelegates::ApplicationWillTerminateDelegate.AddRaw(this, &FFirebaseAnalyticsModule::FlushForLifecycle);
+
+	Metrics = MakeUnique<FFirebaseAnalyticsMetrics>(Settings->MaxMetricSeriesPerThread, Settings->MetricsRelativeAccuracy);
+	if (Settings->MetricsFlushInterval > 0.0f)
+	{
+		MetricsTickerHandle = FTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FFirebaseAnalyticsModule::TickMetrics),
+			Settings->MetricsFlushInterval);
+	}
+	if (Settings->bFlushMetricsOnMapChange)
+	{
+		PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddRaw(this, &FFirebaseAnalyticsModule::OnPreLoadMap);
+	}
+
+	// Events the previous run never got to deliver go through the normal path, and into the journal again
+	if (JournaledEvents.Num() > 0)
+	{
+		UE_LOG(LogFirebaseAnalytics, Log, TEXT("Replaying %d journaled Firebase Analytics events"), JournaledEvents.Num());
+
+		for (FFirebaseAnalyticsEvent& Event : JournaledEvents)
+		{
+			FFirebaseAnalyticsCall Call;
+			Call.Event = MoveTemp(Event);
+			SubmitCall(MoveTemp(Call));
+		}
+	}
 }
 
 void FFirebaseAnalyticsModule::ShutdownModule()
 {
+	FTicker::GetCoreTicker().RemoveTicker(MetricsTickerHandle);
+	FTicker::GetCoreTicker().RemoveTicker(PriorityLanesTickerHandle);
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreDelegates::ApplicationWillEnterBackgroundDelegate.Remove(EnterBackgroundHandle);
+	FCoreDelegates::ApplicationWillTerminateDelegate.Remove(TerminateHandle);
+	FlushMetrics();
+
+	// Held events get a bounded chance to leave, the journal brings back whatever doesn't make it
+	if (PriorityLanes)
+	{
+		PriorityLanes->Drain(
+			FPlatformTime::Seconds() + LifecycleFlushDeadlineSeconds,
+			0.0,
+			[this](FFirebaseAnalyticsCall&& Call) { DeliverCall(MoveTemp(Call)); });
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(PriorityLanes->Discard());
+		PriorityLanes.Reset();
+	}
+
+	ModuleInstance = nullptr;
+
+	{
+		FScopeLock Lock(&PreInitCriticalSection);
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(PreInitCalls.Num());
+		PreInitCalls.Empty();
+		bHoldingPreInitCalls = false;
+	}
+
+	// Destroying the dispatcher drains whatever is still queued
+	Dispatcher.Reset();
+	Journal.Reset();
+	EventFilter.Reset();
+	Metrics.Reset();
+	Validator.Reset();
+	BundlePool.Reset();
+	TraceWriter->Stop();
+	SetBackend(nullptr);
+
 	if (ISettingsModule* SettingsModule = FModuleManager::GetModulePtr<ISettingsModule>("Settings"))
 	{
 		SettingsModule->UnregisterSettings(
@@ -31,5 +191,208 @@ void FFirebaseAnalyticsModule::ShutdownModule()
 	}
 }
 
+FFirebaseAnalyticsModule* FFirebaseAnalyticsModule::Get()
+{
+	return ModuleInstance;
+}
+
+void FFirebaseAnalyticsModule::SetBackend(FFirebaseAnalyticsBackendPtr InBackend)
+{
+	{
+		FScopeLock Lock(&BackendCriticalSection);
+		Backend = InBackend;
+	}
+
+	const bool bReady = InBackend && InBackend->IsReady();
+	if (Dispatcher)
+	{
+		Dispatcher->SetBackend(MoveTemp(InBackend));
+	}
+
+	if (bReady)
+	{
+		OnBackendReady();
+	}
+}
+
+FFirebaseAnalyticsBackendPtr FFirebaseAnalyticsModule::GetBackend() const
+{
+	FScopeLock Lock(&BackendCriticalSection);
+	return Backend;
+}
+
+void FFirebaseAnalyticsModule::SubmitCall(FFirebaseAnalyticsCall&& Call)
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_SubmitCall);
+
+	TraceWriter->Record(Call);
+
+	// Firebase would drop these silently, after the whole marshaling cost
+	if (Validator && !Validator->Validate(Call))
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+		return;
+	}
+
+	if (Call.Type == EFirebaseAnalyticsCallType::LogEvent)
+	{
+		FIREBASE_ANALYTICS_RECORD_EVENT(Call.Event.Name, Call.Event.Parameters.Num());
+
+		if (Journal && !bJournalSuspended)
+		{
+			Call.JournalRecord = Journal->Append(Call.Event);
+		}
+	}
+
+	if (bHoldingPreInitCalls)
+	{
+		FScopeLock Lock(&PreInitCriticalSection);
+		if (bHoldingPreInitCalls)
+		{
+			// Journaled events dropped here stay unacknowledged and come back on the next launch
+			if (PreInitCalls.Num() < MaxPreInitCalls)
+			{
+				PreInitCalls.Add(MoveTemp(Call));
+			}
+			else
+			{
+				FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+			}
+			return;
+		}
+	}
+
+	RouteCall(MoveTemp(Call));
+}
+
+void FFirebaseAnalyticsModule::RouteCall(FFirebaseAnalyticsCall&& Call)
+{
+	if (PriorityLanes)
+	{
+		if (PriorityLanes->Hold(Call, [this](FFirebaseAnalyticsCall&& HeldCall) { DeliverCall(MoveTemp(HeldCall)); }))
+		{
+			return;
+		}
+
+		// Anything but an event may change how later events are attributed, so held events go first
+		if (Call.Type != EFirebaseAnalyticsCallType::LogEvent)
+		{
+			PriorityLanes->Drain(
+				TNumericLimits<double>::Max(),
+				0.0,
+				[this](FFirebaseAnalyticsCall&& HeldCall) { DeliverCall(MoveTemp(HeldCall)); });
+		}
+	}
+
+	DeliverCall(MoveTemp(Call));
+}
+
+void FFirebaseAnalyticsModule::DeliverCall(FFirebaseAnalyticsCall&& Call)
+{
+	if (Dispatcher)
+	{
+		Dispatcher->Enqueue(MoveTemp(Call));
+		return;
+	}
+
+	if (FFirebaseAnalyticsBackendPtr CurrentBackend = GetBackend())
+	{
+		CurrentBackend->Apply(Call);
+
+		if (Journal && Call.JournalRecord.IsValid() && CurrentBackend->IsReady())
+		{
+			Journal->Acknowledge(Call.JournalRecord);
+		}
+	}
+	else
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+	}
+}
+
+void FFirebaseAnalyticsModule::FlushMetrics()
+{
+	if (!Metrics)
+	{
+		return;
+	}
+
+	TArray<FFirebaseAnalyticsEvent> Summaries;
+	Metrics->Collect(Summaries);
+
+	// Summaries bypass the event rules, they are already what the rules are there to achieve
+	for (FFirebaseAnalyticsEvent& Summary : Summaries)
+	{
+		FFirebaseAnalyticsCall Call;
+		Call.Event = MoveTemp(Summary);
+		SubmitCall(MoveTemp(Call));
+	}
+}
+
+bool FFirebaseAnalyticsModule::TickMetrics(float DeltaTime)
+{
+	FlushMetrics();
+	return true;
+}
+
+void FFirebaseAnalyticsModule::OnPreLoadMap(const FString& MapName)
+{
+	FlushMetrics();
+}
+
+bool FFirebaseAnalyticsModule::TickPriorityLanes(float DeltaTime)
+{
+	PriorityLanes->Tick(DeltaTime, [this](FFirebaseAnalyticsCall&& Call) { DeliverCall(MoveTemp(Call)); });
+	return true;
+}
+
+void FFirebaseAnalyticsModule::FlushForLifecycle()
+{
+	FlushMetrics();
+
+	if (!FlushEventsUntil(FPlatformTime::Seconds() + LifecycleFlushDeadlineSeconds))
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Firebase Analytics events still pending after %.2f s lifecycle flush"), LifecycleFlushDeadlineSeconds);
+	}
+}
+
+void FFirebaseAnalyticsModule::OnBackendReady()
+{
+	// Held for the whole delivery, so calls submitted meanwhile queue up behind the held ones
+	FScopeLock Lock(&PreInitCriticalSection);
+	if (!bHoldingPreInitCalls)
+	{
+		return;
+	}
+
+	UE_LOG(LogFirebaseAnalytics, Log, TEXT("Firebase Analytics backend ready %.1f ms after startup, delivering %d held calls"),
+		(FPlatformTime::Seconds() - StartupTime) * 1000.0, PreInitCalls.Num());
+
+	for (FFirebaseAnalyticsCall& Call : PreInitCalls)
+	{
+		RouteCall(MoveTemp(Call));
+	}
+
+	PreInitCalls.Empty();
+	bHoldingPreInitCalls = false;
+}
+
+void FFirebaseAnalyticsModule::FlushEvents()
+{
+	FlushEventsUntil(TNumericLimits<double>::Max());
+}
+
+bool FFirebaseAnalyticsModule::FlushEventsUntil(double Deadline)
+{
+	if (PriorityLanes)
+	{
+		PriorityLanes->Drain(Deadline, 0.0, [this](FFirebaseAnalyticsCall&& Call) { DeliverCall(MoveTemp(Call)); });
+	}
+
+	const bool bLanesEmpty = !PriorityLanes || PriorityLanes->GetNumHeld() == 0;
+	const bool bDispatcherEmpty = !Dispatcher || Dispatcher->FlushUntil(Deadline);
+	return bLanesEmpty && bDispatcherEmpty;
+}
+
 #undef LOCTEXT_NAMESPACE
 IMPLEMENT_MODULE(FFirebaseAnalyticsModule, FirebaseAnalytics)
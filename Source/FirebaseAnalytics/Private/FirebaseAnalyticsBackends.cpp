@@ -0,0 +1,529 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsBlockLog.h"
+#include "FirebaseAnalyticsHttpBackend.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_ANDROID
+#include "Android/FirebaseAnalyticsAndroidBackend.h"
+#endif
+
+const TCHAR* LexToString(EFirebaseAnalyticsCallType Type)
+{
+	switch (Type)
+	{
+		case EFirebaseAnalyticsCallType::LogEvent:						return TEXT("log_event");
+		case EFirebaseAnalyticsCallType::ResetAnalyticsData:			return TEXT("reset_analytics_data");
+		case EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled:	return TEXT("set_analytics_collection_enabled");
+		case EFirebaseAnalyticsCallType::SetSessionTimeoutDuration:		return TEXT("set_session_timeout_duration");
+		case EFirebaseAnalyticsCallType::SetUserID:						return TEXT("set_user_id");
+		case EFirebaseAnalyticsCallType::SetUserProperty:				return TEXT("set_user_property");
+		case EFirebaseAnalyticsCallType::SetDefaultEventParameters:		return TEXT("set_default_event_parameters");
+	}
+
+	return TEXT("unknown");
+}
+
+void IFirebaseAnalyticsBackend::Apply(const FFirebaseAnalyticsCall& Call)
+{
+	switch (Call.Type)
+	{
+		case EFirebaseAnalyticsCallType::LogEvent:
+		{
+			LogEvent(Call.Event);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::ResetAnalyticsData:
+		{
+			ResetAnalyticsData();
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled:
+		{
+			SetAnalyticsCollectionEnabled(Call.IntegerValue != 0);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetSessionTimeoutDuration:
+		{
+			SetSessionTimeoutDuration(Call.IntegerValue);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetUserID:
+		{
+			SetUserID(Call.Value);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetUserProperty:
+		{
+			SetUserProperty(Call.Event.Name, Call.Value);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetDefaultEventParameters:
+		{
+			SetDefaultEventParameters(Call.Event.Parameters);
+			break;
+		}
+	}
+}
+
+FFirebaseAnalyticsBackendPtr CreateFirebaseAnalyticsBackend(EFirebaseAnalyticsBackendType Type)
+{
+	const UFirebaseAnalyticsSettings* Settings = GetDefault<UFirebaseAnalyticsSettings>();
+	switch (Type)
+	{
+		case EFirebaseAnalyticsBackendType::Platform:
+		{
+#if PLATFORM_ANDROID
+			return MakeShared<FFirebaseAnalyticsAndroidBackend, ESPMode::ThreadSafe>();
+#else
+			if (IsRunningDedicatedServer() && !Settings->HttpMeasurementId.IsEmpty())
+			{
+				return MakeShared<FFirebaseAnalyticsHttpBackend, ESPMode::ThreadSafe>(GetFirebaseAnalyticsHttpOptions());
+			}
+			break;
+#endif
+		}
+		case EFirebaseAnalyticsBackendType::Memory:
+		{
+			return MakeShared<FFirebaseAnalyticsMemoryBackend, ESPMode::ThreadSafe>(Settings->MemoryBackendCapacity);
+		}
+		case EFirebaseAnalyticsBackendType::File:
+		{
+			const FString Filename = Settings->FileBackendPath.IsEmpty()
+				? FPaths::ProjectLogDir() / TEXT("FirebaseAnalytics.jsonl")
+				: Settings->FileBackendPath;
+
+			return MakeShared<FFirebaseAnalyticsFileBackend, ESPMode::ThreadSafe>(Filename);
+		}
+		case EFirebaseAnalyticsBackendType::BlockLog:
+		{
+			return MakeShared<FFirebaseAnalyticsBlockLogBackend, ESPMode::ThreadSafe>(GetFirebaseAnalyticsBlockLogOptions());
+		}
+		case EFirebaseAnalyticsBackendType::Http:
+		{
+			return MakeShared<FFirebaseAnalyticsHttpBackend, ESPMode::ThreadSafe>(GetFirebaseAnalyticsHttpOptions());
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return MakeShared<FFirebaseAnalyticsNullBackend, ESPMode::ThreadSafe>();
+}
+
+FFirebaseAnalyticsMemoryBackend::FFirebaseAnalyticsMemoryBackend(int32 InCapacity)
+	: Capacity(FMath::Max(InCapacity, 1))
+{
+}
+
+void FFirebaseAnalyticsMemoryBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::LogEvent).Event = Event;
+}
+
+void FFirebaseAnalyticsMemoryBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	FScopeLock Lock(&CriticalSection);
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		Add(EFirebaseAnalyticsCallType::LogEvent).Event = Event;
+	}
+}
+
+void FFirebaseAnalyticsMemoryBackend::ResetAnalyticsData()
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::ResetAnalyticsData);
+}
+
+void FFirebaseAnalyticsMemoryBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled).IntegerValue = bEnabled ? 1 : 0;
+}
+
+void FFirebaseAnalyticsMemoryBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::SetSessionTimeoutDuration).IntegerValue = Milliseconds;
+}
+
+void FFirebaseAnalyticsMemoryBackend::SetUserID(const FString& UserID)
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::SetUserID).Value = UserID;
+}
+
+void FFirebaseAnalyticsMemoryBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FFirebaseAnalyticsCall& Call = Add(EFirebaseAnalyticsCallType::SetUserProperty);
+	Call.Event.Name = PropertyName;
+	Call.Value = PropertyValue;
+}
+
+void FFirebaseAnalyticsMemoryBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	FScopeLock Lock(&CriticalSection);
+	Add(EFirebaseAnalyticsCallType::SetDefaultEventParameters).Event.Parameters = Parameters;
+}
+
+TArray<FFirebaseAnalyticsCall> FFirebaseAnalyticsMemoryBackend::GetCalls() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (Calls.Num() < Capacity)
+	{
+		return Calls;
+	}
+
+	// Buffer has wrapped, the oldest call sits right after the newest one
+	const int32 OldestIdx = (int32)(NumReceived % Capacity);
+
+	TArray<FFirebaseAnalyticsCall> Result;
+	Result.Reserve(Capacity);
+	Result.Append(Calls.GetData() + OldestIdx, Capacity - OldestIdx);
+	Result.Append(Calls.GetData(), OldestIdx);
+	return Result;
+}
+
+int64 FFirebaseAnalyticsMemoryBackend::GetNumReceived() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return NumReceived;
+}
+
+void FFirebaseAnalyticsMemoryBackend::Empty()
+{
+	FScopeLock Lock(&CriticalSection);
+	Calls.Empty();
+	NumReceived = 0;
+}
+
+FFirebaseAnalyticsCall& FFirebaseAnalyticsMemoryBackend::Add(EFirebaseAnalyticsCallType Type)
+{
+	FFirebaseAnalyticsCall* Call;
+	if (Calls.Num() < Capacity)
+	{
+		Call = &Calls.AddDefaulted_GetRef();
+	}
+	else
+	{
+		Call = &Calls[NumReceived % Capacity];
+		*Call = FFirebaseAnalyticsCall();
+	}
+
+	NumReceived++;
+
+	Call->Type = Type;
+	return *Call;
+}
+
+static void AppendJsonString(FString& Out, const TCHAR* Value)
+{
+	Out += TEXT('"');
+	for (; *Value; Value++)
+	{
+		const TCHAR Char = *Value;
+		switch (Char)
+		{
+			case TEXT('"'):		Out += TEXT("\\\""); break;
+			case TEXT('\\'):	Out += TEXT("\\\\"); break;
+			case TEXT('\n'):	Out += TEXT("\\n"); break;
+			case TEXT('\r'):	Out += TEXT("\\r"); break;
+			case TEXT('\t'):	Out += TEXT("\\t"); break;
+			default:
+			{
+				if (Char < 0x20)
+				{
+					Out += FString::Printf(TEXT("\\u%04x"), (uint32)Char);
+				}
+				else
+				{
+					Out += Char;
+				}
+				break;
+			}
+		}
+	}
+	Out += TEXT('"');
+}
+
+static void AppendJsonNumber(FString& Out, double Value, const TCHAR* Format)
+{
+	// JSON has no NaN or infinity
+	if (FMath::IsFinite(Value))
+	{
+		Out += FString::Printf(Format, Value);
+	}
+	else
+	{
+		Out += TEXT("null");
+	}
+}
+
+static void AppendJsonParameters(
+	FString& Out,
+	const FFlatBundle& Bundle,
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters)
+{
+	Out += TEXT('{');
+	for (int32 ParameterIdx = 0; ParameterIdx < Parameters.Num(); ParameterIdx++)
+	{
+		const FFirebaseAnalyticsParameter& Parameter = Parameters[ParameterIdx];
+		if (ParameterIdx > 0)
+		{
+			Out += TEXT(',');
+		}
+
+		AppendJsonString(Out, Parameter.GetName());
+		Out += TEXT(':');
+
+		switch (Parameter.Type)
+		{
+			case EFirebaseAnalyticsParameterType::String:
+			{
+				AppendJsonString(Out, *Parameter.StringValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Float:
+			{
+				AppendJsonNumber(Out, Parameter.FloatValue, TEXT("%.9g"));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Double:
+			{
+				AppendJsonNumber(Out, Parameter.DoubleValue, TEXT("%.17g"));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Integer:
+			{
+				Out.AppendInt(Parameter.IntegerValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Int64:
+			{
+				Out += FString::Printf(TEXT("%lld"), (long long)Parameter.Int64Value);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Bundles:
+			{
+				Out += TEXT('[');
+				for (int32 ItemIdx = 0; ItemIdx < Parameter.Items.Num; ItemIdx++)
+				{
+					if (ItemIdx > 0)
+					{
+						Out += TEXT(',');
+					}
+					AppendJsonParameters(Out, Bundle, Bundle.GetItemParameters(Parameter, ItemIdx));
+				}
+				Out += TEXT(']');
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Null:
+			{
+				Out += TEXT("null");
+				break;
+			}
+		}
+	}
+	Out += TEXT('}');
+}
+
+void AppendFirebaseAnalyticsJsonString(FString& Out, const TCHAR* Value)
+{
+	AppendJsonString(Out, Value);
+}
+
+void AppendFirebaseAnalyticsParametersJson(
+	FString& Out,
+	const FFlatBundle& Owner,
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters)
+{
+	AppendJsonParameters(Out, Owner, Parameters);
+}
+
+FString FirebaseAnalyticsCallToJson(const FFirebaseAnalyticsCall& Call)
+{
+	FString Out = TEXT("{\"call\":");
+	AppendJsonString(Out, LexToString(Call.Type));
+
+	switch (Call.Type)
+	{
+		case EFirebaseAnalyticsCallType::LogEvent:
+		{
+			Out += TEXT(",\"name\":");
+			AppendJsonString(Out, *Call.Event.Name);
+			Out += TEXT(",\"params\":");
+			AppendJsonParameters(Out, Call.Event.Parameters, Call.Event.Parameters.GetParameters());
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled:
+		{
+			Out += Call.IntegerValue != 0 ? TEXT(",\"value\":true") : TEXT(",\"value\":false");
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetSessionTimeoutDuration:
+		{
+			Out += TEXT(",\"value\":");
+			Out.AppendInt(Call.IntegerValue);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetUserID:
+		{
+			Out += TEXT(",\"value\":");
+			AppendJsonString(Out, *Call.Value);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetUserProperty:
+		{
+			Out += TEXT(",\"name\":");
+			AppendJsonString(Out, *Call.Event.Name);
+			Out += TEXT(",\"value\":");
+			AppendJsonString(Out, *Call.Value);
+			break;
+		}
+		case EFirebaseAnalyticsCallType::SetDefaultEventParameters:
+		{
+			Out += TEXT(",\"params\":");
+			AppendJsonParameters(Out, Call.Event.Parameters, Call.Event.Parameters.GetParameters());
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	Out += TEXT('}');
+	return Out;
+}
+
+FFirebaseAnalyticsFileBackend::FFirebaseAnalyticsFileBackend(const FString& InFilename)
+	: Filename(InFilename)
+{
+	Writer = IFileManager::Get().CreateFileWriter(*Filename, FILEWRITE_Append | FILEWRITE_AllowRead);
+	if (Writer == nullptr)
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Firebase Analytics file backend can't open %s, calls are discarded"), *Filename);
+	}
+}
+
+FFirebaseAnalyticsFileBackend::~FFirebaseAnalyticsFileBackend()
+{
+	delete Writer;
+	Writer = nullptr;
+}
+
+void FFirebaseAnalyticsFileBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::LogEvent);
+	Line += TEXT(",\"name\":");
+	AppendJsonString(Line, *Event.Name);
+	Line += TEXT(",\"params\":");
+	AppendJsonParameters(Line, Event.Parameters, Event.Parameters.GetParameters());
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		LogEvent(Event);
+	}
+}
+
+void FFirebaseAnalyticsFileBackend::ResetAnalyticsData()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::ResetAnalyticsData);
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled);
+	Line += bEnabled ? TEXT(",\"value\":true") : TEXT(",\"value\":false");
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::SetSessionTimeoutDuration);
+	Line += TEXT(",\"value\":");
+	Line.AppendInt(Milliseconds);
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::SetUserID(const FString& UserID)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::SetUserID);
+	Line += TEXT(",\"value\":");
+	AppendJsonString(Line, *UserID);
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::SetUserProperty);
+	Line += TEXT(",\"name\":");
+	AppendJsonString(Line, *PropertyName);
+	Line += TEXT(",\"value\":");
+	AppendJsonString(Line, *PropertyValue);
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	BeginLine(EFirebaseAnalyticsCallType::SetDefaultEventParameters);
+	Line += TEXT(",\"params\":");
+	AppendJsonParameters(Line, Parameters, Parameters.GetParameters());
+	WriteLine();
+}
+
+void FFirebaseAnalyticsFileBackend::Flush()
+{
+	FScopeLock Lock(&CriticalSection);
+	if (Writer)
+	{
+		Writer->Flush();
+	}
+}
+
+void FFirebaseAnalyticsFileBackend::BeginLine(EFirebaseAnalyticsCallType Type)
+{
+	Line.Reset();
+	Line += TEXT("{\"call\":");
+	AppendJsonString(Line, LexToString(Type));
+}
+
+void FFirebaseAnalyticsFileBackend::WriteLine()
+{
+	Line += TEXT("}\n");
+	if (Writer)
+	{
+		FTCHARToUTF8 Utf8Line(*Line, Line.Len());
+		Writer->Serialize((void*)Utf8Line.Get(), Utf8Line.Length());
+	}
+}
@@ -0,0 +1,416 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBatchCodec.h"
+#include "FirebaseAnalyticsSwar.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Batch format is little-endian, add byte swapping for this platform.");
+
+// Version byte + event count
+static constexpr int32 FirebaseAnalyticsBatchHeaderSize = 1 + 4;
+
+// Items are one level deep, anything much deeper is a damaged buffer rather than a real event
+static constexpr int32 FirebaseAnalyticsBatchMaxDepth = 8;
+
+FFirebaseAnalyticsBatchEncoder::FFirebaseAnalyticsBatchEncoder()
+{
+	Reset();
+}
+
+void FFirebaseAnalyticsBatchEncoder::Reset()
+{
+	Buffer.Reset();
+	Buffer.AddZeroed(FirebaseAnalyticsBatchHeaderSize);
+	Buffer[0] = FirebaseAnalyticsBatchVersion;
+	NumEvents = 0;
+}
+
+void FFirebaseAnalyticsBatchEncoder::AddEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	WriteString(Event.Name);
+
+	const int32 SizeOffset = Buffer.AddUninitialized(sizeof(uint32));
+	WriteParameters(Event.Parameters, Event.Parameters.GetParameters());
+
+	const uint32 BundleSize = Buffer.Num() - SizeOffset - sizeof(uint32);
+	FMemory::Memcpy(Buffer.GetData() + SizeOffset, &BundleSize, sizeof(uint32));
+
+	NumEvents++;
+	FMemory::Memcpy(Buffer.GetData() + 1, &NumEvents, sizeof(uint32));
+}
+
+void FFirebaseAnalyticsBatchEncoder::WriteByte(uint8 Value)
+{
+	Buffer.Add(Value);
+}
+
+void FFirebaseAnalyticsBatchEncoder::WriteUInt16(uint16 Value)
+{
+	WritePod(&Value, sizeof(Value));
+}
+
+void FFirebaseAnalyticsBatchEncoder::WritePod(const void* Value, int32 Size)
+{
+	Buffer.Append((const uint8*)Value, Size);
+}
+
+void FFirebaseAnalyticsBatchEncoder::WriteString(const TCHAR* Value, int32 Length)
+{
+	if (Length > FirebaseAnalyticsBatchMaxStringLength)
+	{
+		// Don't leave half a surrogate pair behind
+		Length = FirebaseAnalyticsBatchMaxStringLength;
+		if (((uint32)Value[Length - 1] & 0xFC00) == 0xD800)
+		{
+			Length--;
+		}
+	}
+
+	if (FirebaseAnalyticsSwar::AllBelow(Value, Length, 0xFF))
+	{
+		WriteUInt16((uint16)Length);
+
+		// Plain narrowing loop, left for the compiler to vectorize
+		const int32 Offset = Buffer.AddUninitialized(Length);
+		uint8* Out = Buffer.GetData() + Offset;
+		for (int32 CharIdx = 0; CharIdx < Length; CharIdx++)
+		{
+			Out[CharIdx] = (uint8)Value[CharIdx];
+		}
+		return;
+	}
+
+	if (sizeof(TCHAR) == sizeof(UTF16CHAR))
+	{
+		WriteUInt16((uint16)Length | FirebaseAnalyticsBatchUtf16Flag);
+		Buffer.Append((const uint8*)Value, Length * sizeof(UTF16CHAR));
+	}
+	else
+	{
+		const auto Converted = StringCast<UTF16CHAR>(Value, Length);
+		const int32 NumUnits = FMath::Min(Converted.Length(), FirebaseAnalyticsBatchMaxStringLength);
+
+		WriteUInt16((uint16)NumUnits | FirebaseAnalyticsBatchUtf16Flag);
+		Buffer.Append((const uint8*)Converted.Get(), NumUnits * sizeof(UTF16CHAR));
+	}
+}
+
+void FFirebaseAnalyticsBatchEncoder::WriteString(const FString& Value)
+{
+	WriteString(*Value, Value.Len());
+}
+
+void FFirebaseAnalyticsBatchEncoder::WriteParameters(
+	const FFlatBundle& Owner,
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters)
+{
+	// Far past the Firebase limits, but the count and what follows it must agree
+	const int32 NumParameters = FMath::Min(Parameters.Num(), (int32)MAX_uint16);
+	WriteUInt16((uint16)NumParameters);
+
+	for (const FFirebaseAnalyticsParameter& Parameter : Parameters.Slice(0, NumParameters))
+	{
+		const TCHAR* Name = Parameter.GetName();
+		switch (Parameter.Type)
+		{
+			case EFirebaseAnalyticsParameterType::String:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::String);
+				WriteString(Name, FCString::Strlen(Name));
+				WriteString(Parameter.StringValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Float:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Float);
+				WriteString(Name, FCString::Strlen(Name));
+				WritePod(&Parameter.FloatValue, sizeof(float));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Double:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Double);
+				WriteString(Name, FCString::Strlen(Name));
+				WritePod(&Parameter.DoubleValue, sizeof(double));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Integer:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Integer);
+				WriteString(Name, FCString::Strlen(Name));
+				WritePod(&Parameter.IntegerValue, sizeof(int32));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Int64:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Int64);
+				WriteString(Name, FCString::Strlen(Name));
+				WritePod(&Parameter.Int64Value, sizeof(int64));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Bundles:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Bundles);
+				WriteString(Name, FCString::Strlen(Name));
+				const int32 NumItems = FMath::Min(Parameter.Items.Num, (int32)MAX_uint16);
+				WriteUInt16((uint16)NumItems);
+				for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+				{
+					WriteParameters(Owner, Owner.GetItemParameters(Parameter, ItemIdx));
+				}
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Null:
+			{
+				WriteByte((uint8)EFirebaseAnalyticsBatchParameterType::Null);
+				WriteString(Name, FCString::Strlen(Name));
+				break;
+			}
+		}
+	}
+}
+
+/** Bounds checked cursor over an encoded batch. */
+class FFirebaseAnalyticsBatchReader
+{
+public:
+	FFirebaseAnalyticsBatchReader(const uint8* InData, int32 InSize)
+		: Data(InData)
+		, Size(InSize)
+	{
+	}
+
+	bool Read(void* Out, int32 Count)
+	{
+		if (Count < 0 || Offset + Count > Size)
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(Out, Data + Offset, Count);
+		Offset += Count;
+		return true;
+	}
+
+	bool ReadString(FString& Out)
+	{
+		uint16 Header = 0;
+		if (!Read(&Header, sizeof(Header)))
+		{
+			return false;
+		}
+
+		const int32 Length = Header & ~FirebaseAnalyticsBatchUtf16Flag;
+		if (!(Header & FirebaseAnalyticsBatchUtf16Flag))
+		{
+			if (Offset + Length > Size)
+			{
+				return false;
+			}
+
+			if (Length == 0)
+			{
+				Out.Reset();
+				return true;
+			}
+
+			TArray<TCHAR>& Chars = Out.GetCharArray();
+			Chars.SetNumUninitialized(Length + 1);
+			for (int32 CharIdx = 0; CharIdx < Length; CharIdx++)
+			{
+				Chars[CharIdx] = (TCHAR)Data[Offset + CharIdx];
+			}
+			Chars[Length] = TEXT('\0');
+
+			Offset += Length;
+			return true;
+		}
+
+		// Code units may sit at odd offsets, copy them out before converting
+		TArray<UTF16CHAR, TInlineAllocator<128>> Units;
+		Units.SetNumUninitialized(Length);
+		if (!Read(Units.GetData(), Length * sizeof(UTF16CHAR)))
+		{
+			return false;
+		}
+
+		const auto Converted = StringCast<TCHAR>(Units.GetData(), Length);
+		Out = FString(Converted.Length(), Converted.Get());
+		return true;
+	}
+
+	bool ReadBundle(FFlatBundle& Out, int32 Depth = 0)
+	{
+		if (Depth > FirebaseAnalyticsBatchMaxDepth)
+		{
+			return false;
+		}
+
+		uint16 NumParameters = 0;
+		if (!Read(&NumParameters, sizeof(NumParameters)))
+		{
+			return false;
+		}
+
+		for (int32 Idx = 0; Idx < NumParameters; Idx++)
+		{
+			uint8 Type = 0;
+			FString Name;
+			if (!Read(&Type, sizeof(Type)) || !ReadString(Name))
+			{
+				return false;
+			}
+
+			switch ((EFirebaseAnalyticsBatchParameterType)Type)
+			{
+				case EFirebaseAnalyticsBatchParameterType::String:
+				{
+					FString Value;
+					if (!ReadString(Value))
+					{
+						return false;
+					}
+					Out.PutString(Name, Value);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Float:
+				{
+					float Value = 0.f;
+					if (!Read(&Value, sizeof(Value)))
+					{
+						return false;
+					}
+					Out.PutFloat(Name, Value);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Double:
+				{
+					double Value = 0.0;
+					if (!Read(&Value, sizeof(Value)))
+					{
+						return false;
+					}
+					Out.PutDouble(Name, Value);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Integer:
+				{
+					int32 Value = 0;
+					if (!Read(&Value, sizeof(Value)))
+					{
+						return false;
+					}
+					Out.PutInteger(Name, Value);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Int64:
+				{
+					int64 Value = 0;
+					if (!Read(&Value, sizeof(Value)))
+					{
+						return false;
+					}
+					Out.PutInt64(Name, Value);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Bundles:
+				{
+					uint16 NumBundles = 0;
+					if (!Read(&NumBundles, sizeof(NumBundles)))
+					{
+						return false;
+					}
+
+					TArray<FFlatBundle> Bundles;
+					Bundles.SetNum(NumBundles);
+					for (FFlatBundle& Nested : Bundles)
+					{
+						if (!ReadBundle(Nested, Depth + 1))
+						{
+							return false;
+						}
+					}
+
+					Out.PutBundles(Name, Bundles);
+					break;
+				}
+				case EFirebaseAnalyticsBatchParameterType::Null:
+				{
+					Out.PutNull(Name);
+					break;
+				}
+				default:
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool IsAtEnd() const { return Offset == Size; }
+
+	int32 GetOffset() const { return Offset; }
+	void SetOffset(int32 InOffset) { Offset = InOffset; }
+
+private:
+	const uint8* Data;
+	int32 Size;
+	int32 Offset = 0;
+};
+
+bool FFirebaseAnalyticsBatchDecoder::Decode(const uint8* Data, int32 Size, TArray<FFirebaseAnalyticsEvent>& OutEvents)
+{
+	FFirebaseAnalyticsBatchReader Reader(Data, Size);
+
+	uint8 Version = 0;
+	uint32 NumEvents = 0;
+	if (!Reader.Read(&Version, sizeof(Version))
+		|| (Version != FirebaseAnalyticsBatchVersion && Version != FirebaseAnalyticsBatchUnframedVersion))
+	{
+		return false;
+	}
+
+	if (!Reader.Read(&NumEvents, sizeof(NumEvents)))
+	{
+		return false;
+	}
+
+	OutEvents.Reserve(OutEvents.Num() + FMath::Min((int32)NumEvents, Size));
+	for (uint32 Idx = 0; Idx < NumEvents; Idx++)
+	{
+		FFirebaseAnalyticsEvent Event;
+		if (!Reader.ReadString(Event.Name))
+		{
+			return false;
+		}
+
+		if (Version == FirebaseAnalyticsBatchUnframedVersion)
+		{
+			if (!Reader.ReadBundle(Event.Parameters))
+			{
+				return false;
+			}
+			OutEvents.Add(MoveTemp(Event));
+			continue;
+		}
+
+		uint32 BundleSize = 0;
+		if (!Reader.Read(&BundleSize, sizeof(BundleSize)) || BundleSize > (uint32)(Size - Reader.GetOffset()))
+		{
+			return false;
+		}
+
+		// A bundle that doesn't parse, or doesn't end where its size says, costs only its own event
+		const int32 BundleEnd = Reader.GetOffset() + (int32)BundleSize;
+		FFirebaseAnalyticsBatchReader BundleReader(Data, BundleEnd);
+		BundleReader.SetOffset(Reader.GetOffset());
+		if (BundleReader.ReadBundle(Event.Parameters) && BundleReader.IsAtEnd())
+		{
+			OutEvents.Add(MoveTemp(Event));
+		}
+		Reader.SetOffset(BundleEnd);
+	}
+
+	return Reader.IsAtEnd();
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsEvent.h"
+
+/** Binary layout shared with AndroidThunkJava_LogEventBatch, all values little-endian:
+ *
+ *	Batch		:= uint8 Version, uint32 EventCount, Event[EventCount]
+ *	Event		:= String Name, uint32 BundleSize, Bundle
+ *	Bundle		:= uint16 ParameterCount, Parameter[ParameterCount]
+ *	Parameter	:= uint8 ParameterType, String Name, Value
+ *	Value		:= String | float32 | float64 | int32 | int64 | uint16 BundleCount, Bundle[BundleCount] | nothing for Null
+ *	String		:= uint16 Header, Latin-1 bytes[Header] if the top bit is clear, UTF-16 code units[Header & 0x7FFF] if set
+ *
+ *	Strings are copied as they are stored in FString: one byte per character when all of them fit in Latin-1,
+ *	which the Java side turns into a String without decoding, and raw UTF-16 otherwise, read through a CharBuffer view.
+ *	BundleSize lets a decoder skip an event it can't read and go on with the next one. Bundles with more parameters
+ *	or items than fit in their uint16 count are cut at that count. Version 3 batches, without BundleSize, still decode.
+ *	Keep ParameterType values in sync with the Java decoder in FirebaseAnalytics_UPL_Android.xml.
+ */
+enum class EFirebaseAnalyticsBatchParameterType : uint8
+{
+	String = 0,
+	Float = 1,
+	Integer = 2,
+	Bundles = 3,
+	Double = 4,
+	Int64 = 5,
+	Null = 6,
+};
+
+static constexpr uint8 FirebaseAnalyticsBatchVersion = 4;
+static constexpr uint8 FirebaseAnalyticsBatchUnframedVersion = 3;
+
+static constexpr uint16 FirebaseAnalyticsBatchUtf16Flag = 0x8000;
+static constexpr int32 FirebaseAnalyticsBatchMaxStringLength = 0x7FFF;
+
+/** Packs many events into one buffer so they can cross JNI in a single call.
+ *  The buffer is kept between batches, so a long-lived encoder stops allocating once warmed up.
+ */
+class FFirebaseAnalyticsBatchEncoder
+{
+public:
+	FFirebaseAnalyticsBatchEncoder();
+
+	/** Drop all encoded events but keep the allocated buffer. */
+	void Reset();
+
+	void AddEvent(const FFirebaseAnalyticsEvent& Event);
+
+	int32 GetNumEvents() const { return NumEvents; }
+
+	const uint8* GetData() const { return Buffer.GetData(); }
+	int32 GetSize() const { return Buffer.Num(); }
+
+private:
+	void WriteByte(uint8 Value);
+	void WriteUInt16(uint16 Value);
+	void WritePod(const void* Value, int32 Size);
+	void WriteString(const TCHAR* Value, int32 Length);
+	void WriteString(const FString& Value);
+	void WriteParameters(const FFlatBundle& Owner, TArrayView<const FFirebaseAnalyticsParameter> Parameters);
+
+	TArray<uint8> Buffer;
+	int32 NumEvents = 0;
+};
+
+/** Reference decoder, mirrors the Java side. Used to verify round trips off-device. */
+class FFirebaseAnalyticsBatchDecoder
+{
+public:
+	/** Decode a whole batch. Events whose bundle is malformed are skipped.
+	 *	Returns false if the buffer is truncated or its framing is broken, events decoded up to there are kept.
+	 */
+	static bool Decode(const uint8* Data, int32 Size, TArray<FFirebaseAnalyticsEvent>& OutEvents);
+};
@@ -0,0 +1,675 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBenchmark.h"
+#include "FirebaseAnalytics.h"
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsBatchCodec.h"
+#include "FirebaseAnalyticsBundleFormat.h"
+#include "FirebaseAnalyticsBuiltinNames.h"
+#include "FirebaseAnalyticsFakeJniWriter.h"
+#include "FirebaseAnalyticsJavaBundleFill.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_ANDROID
+#include "Android/FirebaseAnalyticsAndroidBackend.h"
+#endif
+
+static const int32 BenchmarkParameterCounts[] = { 1, 4, 16, 64 };
+static const int32 BenchmarkStringLengths[] = { 8, 64, 512 };
+static const int32 BenchmarkItemCounts[] = { 0, 1, 8, 32 };
+static const int32 BenchmarkItemColumnCounts[] = { 1, 20, 200 };
+
+// String payloads by script, each takes a different path through the string marshaling
+static const TCHAR* const BenchmarkPayloadNames[] = { TEXT("ASCII"), TEXT("Latin1"), TEXT("CJK") };
+static const TCHAR BenchmarkPayloadChars[] = { TEXT('x'), (TCHAR)0x00E9, (TCHAR)0x6F22 };
+
+static const TArray<FString>& GetBenchmarkParameterNames()
+{
+	// Built once, so name formatting doesn't end up in the measurements
+	static const TArray<FString> Names = []()
+	{
+		TArray<FString> Result;
+		for (int32 Idx = 0; Idx < 64; Idx++)
+		{
+			Result.Add(FString::Printf(TEXT("param_%d"), Idx));
+		}
+		return Result;
+	}();
+
+	return Names;
+}
+
+static FBundle MakeBenchmarkBundle(int32 NumParameters, int32 StringLength, int32 NumItems)
+{
+	const TArray<FString>& Names = GetBenchmarkParameterNames();
+	const FString Value = FString::ChrN(StringLength, TEXT('x'));
+
+	FBundle Bundle;
+	for (int32 Idx = 0; Idx < NumParameters; Idx++)
+	{
+		switch (Idx % 3)
+		{
+			case 0: Bundle.StringParameters.Add(Names[Idx], Value); break;
+			case 1: Bundle.FloatParameters.Add(Names[Idx], (float)Idx); break;
+			default: Bundle.IntegerParameters.Add(Names[Idx], Idx); break;
+		}
+	}
+
+	if (NumItems > 0)
+	{
+		FBundle Item;
+		Item.StringParameters.Add(TEXT("item_id"), Value);
+		Item.FloatParameters.Add(TEXT("price"), 9.99f);
+		Item.IntegerParameters.Add(TEXT("quantity"), 1);
+
+		TArray<FBundle> Items;
+		Items.Init(Item, NumItems);
+		Bundle.BundlesParameters.Add(TEXT("items"), Items);
+	}
+
+	return Bundle;
+}
+
+/** Typical ecommerce items, three string columns, a price and a quantity. */
+static FFirebaseAnalyticsItemColumns MakeBenchmarkItemColumns(int32 NumItems)
+{
+	TArray<FString> Ids;
+	TArray<FString> Names;
+	TArray<FString> Categories;
+	TArray<double> Prices;
+	TArray<int64> Quantities;
+	for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+	{
+		Ids.Add(FString::Printf(TEXT("sku_%05d"), ItemIdx));
+		Names.Add(FString::Printf(TEXT("Item %d"), ItemIdx));
+		Categories.Add(TEXT("consumables"));
+		Prices.Add(0.99 + ItemIdx);
+		Quantities.Add(1 + ItemIdx % 4);
+	}
+
+	FFirebaseAnalyticsItemColumns Columns;
+	Columns.SetStrings(EBuiltinParamNames::ITEM_ID, MoveTemp(Ids));
+	Columns.SetStrings(EBuiltinParamNames::ITEM_NAME, MoveTemp(Names));
+	Columns.SetStrings(EBuiltinParamNames::ITEM_CATEGORY, MoveTemp(Categories));
+	Columns.SetDoubles(EBuiltinParamNames::PRICE, Prices);
+	Columns.SetIntegers(EBuiltinParamNames::QUANTITY, Quantities);
+	return Columns;
+}
+
+/** The same items as MakeBenchmarkItemColumns, built one bundle per item. */
+static TArray<FFlatBundle> MakeBenchmarkItemRows(const FFirebaseAnalyticsItemColumns& Columns)
+{
+	TArray<FFlatBundle> Items;
+	Items.SetNum(Columns.Num());
+	for (const FFirebaseAnalyticsItemColumn& Column : Columns.GetColumns())
+	{
+		for (int32 ItemIdx = 0; ItemIdx < Column.Num(); ItemIdx++)
+		{
+			switch (Column.Type)
+			{
+				case EFirebaseAnalyticsParameterType::String: Items[ItemIdx].PutString(Column.Name, Column.Strings[ItemIdx]); break;
+				case EFirebaseAnalyticsParameterType::Double: Items[ItemIdx].PutDouble(Column.Name, Column.Doubles[ItemIdx]); break;
+				default: Items[ItemIdx].PutInt64(Column.Name, Column.Integers[ItemIdx]); break;
+			}
+		}
+	}
+	return Items;
+}
+
+/** Fill Bundle the way ConvertBundleToJavaBundle does, against the fake JNI writer. */
+static int32 FillBenchmarkJavaBundle(const FFlatBundle& Bundle)
+{
+	FFirebaseAnalyticsFakeJniWriter Writer(1);
+	const FFirebaseAnalyticsFakeJniWriter::ObjectType JBundle = Writer.NewLocal();
+	FillFirebaseAnalyticsJavaBundle(Writer, JBundle, Bundle, Bundle.GetParameters());
+	return Writer.NumPuts;
+}
+
+FFirebaseAnalyticsBenchmark::FFirebaseAnalyticsBenchmark(const FFirebaseAnalyticsBenchmarkOptions& InOptions)
+	: Options(InOptions)
+{
+	Options.Iterations = FMath::Max(Options.Iterations, 1);
+	Options.Rounds = FMath::Max(Options.Rounds, 1);
+}
+
+bool FFirebaseAnalyticsBenchmark::Run()
+{
+	FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+	if (Module == nullptr)
+	{
+		return false;
+	}
+
+	Results.Reset();
+
+	FFirebaseAnalyticsBackendPtr PreviousBackend = Module->GetBackend();
+	Module->SetBackend(CreateFirebaseAnalyticsBackend(Options.Backend));
+
+	RunEntryPoints();
+	RunBuilders();
+	RunMarshaling();
+
+	Module->FlushEvents();
+	Module->SetBackend(PreviousBackend);
+
+	return true;
+}
+
+void FFirebaseAnalyticsBenchmark::RunEntryPoints()
+{
+	const FString EventName = TEXT("benchmark_event");
+	const FString ParameterName = TEXT("benchmark_param");
+
+	Measure(TEXT("LogEvent"), 0, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::LogEvent(EventName);
+	});
+
+	for (int32 StringLength : BenchmarkStringLengths)
+	{
+		const FString Value = FString::ChrN(StringLength, TEXT('x'));
+		Measure(TEXT("LogEventWithStringParameter"), 1, StringLength, 0, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::LogEventWithStringParameter(EventName, ParameterName, Value);
+		});
+	}
+
+	for (int32 PayloadIdx = 1; PayloadIdx < UE_ARRAY_COUNT(BenchmarkPayloadChars); PayloadIdx++)
+	{
+		const FString Name = FString::Printf(TEXT("LogEventWithStringParameter.%s"), BenchmarkPayloadNames[PayloadIdx]);
+		for (int32 StringLength : BenchmarkStringLengths)
+		{
+			const FString Value = FString::ChrN(StringLength, BenchmarkPayloadChars[PayloadIdx]);
+			Measure(*Name, 1, StringLength, 0, [&]()
+			{
+				UFirebaseAnalyticsSubsystem::LogEventWithStringParameter(EventName, ParameterName, Value);
+			});
+		}
+	}
+
+	Measure(TEXT("LogEventWithFloatParameter"), 1, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::LogEventWithFloatParameter(EventName, ParameterName, 1.f);
+	});
+
+	Measure(TEXT("LogEventWithIntegerParameter"), 1, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::LogEventWithIntegerParameter(EventName, ParameterName, 1);
+	});
+
+	for (int32 NumParameters : BenchmarkParameterCounts)
+	{
+		for (int32 StringLength : BenchmarkStringLengths)
+		{
+			for (int32 NumItems : BenchmarkItemCounts)
+			{
+				const FBundle Bundle = MakeBenchmarkBundle(NumParameters, StringLength, NumItems);
+				const FFlatBundle FlatBundle(Bundle);
+
+				Measure(TEXT("LogEventWithParameters"), NumParameters, StringLength, NumItems, [&]()
+				{
+					UFirebaseAnalyticsSubsystem::LogEventWithParameters(EventName, Bundle);
+				});
+
+				Measure(TEXT("LogEventWithFlatParameters"), NumParameters, StringLength, NumItems, [&]()
+				{
+					UFirebaseAnalyticsSubsystem::LogEventWithFlatParameters(EventName, FlatBundle);
+				});
+			}
+		}
+	}
+
+	// The same uniform items either go over as columns or as one Bundle per item, picked by the backend alone
+	for (int32 NumItems : BenchmarkItemColumnCounts)
+	{
+		FFlatBundle Bundle;
+		Bundle.PutItems(MakeBenchmarkItemColumns(NumItems));
+
+#if PLATFORM_ANDROID
+		const bool bWasByColumn = FFirebaseAnalyticsAndroidBackend::IsMarshalingItemsByColumn();
+		for (bool bByColumn : { true, false })
+		{
+			FFirebaseAnalyticsAndroidBackend::SetMarshalItemsByColumn(bByColumn);
+			Measure(bByColumn ? TEXT("LogEventWithItems.ByColumn") : TEXT("LogEventWithItems.ByRow"), 5, 8, NumItems, [&]()
+			{
+				UFirebaseAnalyticsSubsystem::LogEventWithFlatParameters(EventName, Bundle);
+			});
+		}
+		FFirebaseAnalyticsAndroidBackend::SetMarshalItemsByColumn(bWasByColumn);
+#else
+		Measure(TEXT("LogEventWithItems"), 5, 8, NumItems, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::LogEventWithFlatParameters(EventName, Bundle);
+		});
+#endif
+	}
+
+	{
+		const FBundle Bundle = MakeBenchmarkBundle(4, 8, 0);
+		Measure(TEXT("LogBuiltinEvent"), 4, 8, 0, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::LogBuiltinEvent(EBuiltinEventNames::SELECT_CONTENT, Bundle);
+		});
+	}
+
+	Measure(TEXT("ResetAnalyticsData"), 0, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::ResetAnalyticsData();
+	});
+
+	Measure(TEXT("SetAnalyticsCollectionEnabled"), 0, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::SetAnalyticsCollectionEnabled(true);
+	});
+
+	Measure(TEXT("SetSessionTimeoutDuration"), 0, 0, 0, [&]()
+	{
+		UFirebaseAnalyticsSubsystem::SetSessionTimeoutDuration(1800000);
+	});
+
+	for (int32 StringLength : BenchmarkStringLengths)
+	{
+		const FString Value = FString::ChrN(StringLength, TEXT('x'));
+		Measure(TEXT("SetUserID"), 0, StringLength, 0, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::SetUserID(Value);
+		});
+
+		Measure(TEXT("SetUserProperty"), 0, StringLength, 0, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::SetUserProperty(ParameterName, Value);
+		});
+	}
+
+	for (int32 NumParameters : BenchmarkParameterCounts)
+	{
+		const FBundle Bundle = MakeBenchmarkBundle(NumParameters, 8, 0);
+		Measure(TEXT("SetDefaultEventParameters"), NumParameters, 8, 0, [&]()
+		{
+			UFirebaseAnalyticsSubsystem::SetDefaultEventParameters(Bundle);
+		});
+	}
+}
+
+void FFirebaseAnalyticsBenchmark::RunBuilders()
+{
+	const TArray<FString>& Names = GetBenchmarkParameterNames();
+
+	// Builders are measured per bundle of NumParameters puts, like a call site filling in an event
+	for (int32 NumParameters : BenchmarkParameterCounts)
+	{
+		for (int32 StringLength : BenchmarkStringLengths)
+		{
+			const FString Value = FString::ChrN(StringLength, TEXT('x'));
+
+			Measure(TEXT("PutString"), NumParameters, StringLength, 0, [&]()
+			{
+				FBundle Bundle;
+				for (int32 Idx = 0; Idx < NumParameters; Idx++)
+				{
+					UFirebaseAnalyticsSubsystem::PutString(Bundle, Names[Idx], Value);
+				}
+				Sink += Bundle.StringParameters.Num();
+			});
+
+			Measure(TEXT("PutFlatString"), NumParameters, StringLength, 0, [&]()
+			{
+				FFlatBundle Bundle;
+				for (int32 Idx = 0; Idx < NumParameters; Idx++)
+				{
+					UFirebaseAnalyticsSubsystem::PutFlatString(Bundle, Names[Idx], Value);
+				}
+				Sink += Bundle.Num();
+			});
+		}
+
+		Measure(TEXT("PutFloat"), NumParameters, 0, 0, [&]()
+		{
+			FBundle Bundle;
+			for (int32 Idx = 0; Idx < NumParameters; Idx++)
+			{
+				UFirebaseAnalyticsSubsystem::PutFloat(Bundle, Names[Idx], (float)Idx);
+			}
+			Sink += Bundle.FloatParameters.Num();
+		});
+
+		Measure(TEXT("PutFlatFloat"), NumParameters, 0, 0, [&]()
+		{
+			FFlatBundle Bundle;
+			for (int32 Idx = 0; Idx < NumParameters; Idx++)
+			{
+				UFirebaseAnalyticsSubsystem::PutFlatFloat(Bundle, Names[Idx], (float)Idx);
+			}
+			Sink += Bundle.Num();
+		});
+
+		Measure(TEXT("PutInteger"), NumParameters, 0, 0, [&]()
+		{
+			FBundle Bundle;
+			for (int32 Idx = 0; Idx < NumParameters; Idx++)
+			{
+				UFirebaseAnalyticsSubsystem::PutInteger(Bundle, Names[Idx], Idx);
+			}
+			Sink += Bundle.IntegerParameters.Num();
+		});
+
+		Measure(TEXT("PutFlatInteger"), NumParameters, 0, 0, [&]()
+		{
+			FFlatBundle Bundle;
+			for (int32 Idx = 0; Idx < NumParameters; Idx++)
+			{
+				UFirebaseAnalyticsSubsystem::PutFlatInteger(Bundle, Names[Idx], Idx);
+			}
+			Sink += Bundle.Num();
+		});
+
+		Measure(TEXT("PutFlatBuiltinInteger"), NumParameters, 0, 0, [&]()
+		{
+			FFlatBundle Bundle;
+			for (int32 Idx = 0; Idx < NumParameters; Idx++)
+			{
+				UFirebaseAnalyticsSubsystem::PutFlatBuiltinInteger(Bundle, (EBuiltinParamNames)(Idx % NumBuiltinParamNames), Idx);
+			}
+			Sink += Bundle.Num();
+		});
+	}
+
+	for (int32 NumItems : BenchmarkItemCounts)
+	{
+		const FBundle Item = MakeBenchmarkBundle(3, 8, 0);
+		TArray<FBundle> Items;
+		Items.Init(Item, NumItems);
+
+		const FFlatBundle FlatItem(Item);
+		TArray<FFlatBundle> FlatItems;
+		FlatItems.Init(FlatItem, NumItems);
+
+		Measure(TEXT("PutBundles"), 3, 8, NumItems, [&]()
+		{
+			FBundle Bundle;
+			UFirebaseAnalyticsSubsystem::PutBundles(Bundle, Names[0], Items);
+			Sink += Bundle.BundlesParameters.Num();
+		});
+
+		Measure(TEXT("PutFlatBundles"), 3, 8, NumItems, [&]()
+		{
+			FFlatBundle Bundle;
+			UFirebaseAnalyticsSubsystem::PutFlatBundles(Bundle, Names[0], FlatItems);
+			Sink += Bundle.Num();
+		});
+	}
+
+	for (int32 NumItems : BenchmarkItemColumnCounts)
+	{
+		const FFirebaseAnalyticsItemColumns Columns = MakeBenchmarkItemColumns(NumItems);
+		const TArray<FFlatBundle> Rows = MakeBenchmarkItemRows(Columns);
+
+		Measure(TEXT("PutItemColumns"), 5, 8, NumItems, [&]()
+		{
+			FFlatBundle Bundle;
+			Bundle.PutItems(Columns);
+			Sink += Bundle.Num();
+		});
+
+		Measure(TEXT("PutItemRows"), 5, 8, NumItems, [&]()
+		{
+			FFlatBundle Bundle;
+			Bundle.PutBundles(EBuiltinParamNames::ITEMS, Rows);
+			Sink += Bundle.Num();
+		});
+	}
+
+	Measure(TEXT("GetBuiltinEventName"), 0, 0, 0, [&]()
+	{
+		Sink += UFirebaseAnalyticsSubsystem::GetBuiltinEventName(EBuiltinEventNames::PURCHASE).Len();
+	});
+
+	Measure(TEXT("GetBuiltinParamName"), 0, 0, 0, [&]()
+	{
+		Sink += UFirebaseAnalyticsSubsystem::GetBuiltinParamName(EBuiltinParamNames::ITEM_ID).Len();
+	});
+}
+
+void FFirebaseAnalyticsBenchmark::RunMarshaling()
+{
+	// The steps between the call site and the SDK, measured in isolation
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	TArray<uint8> BundleBlob;
+
+	for (int32 NumParameters : BenchmarkParameterCounts)
+	{
+		for (int32 StringLength : BenchmarkStringLengths)
+		{
+			for (int32 NumItems : BenchmarkItemCounts)
+			{
+				const FBundle Bundle = MakeBenchmarkBundle(NumParameters, StringLength, NumItems);
+
+				FFirebaseAnalyticsEvent Event;
+				Event.Name = TEXT("benchmark_event");
+				Event.Parameters = FFlatBundle(Bundle);
+
+				Measure(TEXT("FlattenBundle"), NumParameters, StringLength, NumItems, [&]()
+				{
+					const FFlatBundle FlatBundle(Bundle);
+					Sink += FlatBundle.Num();
+				});
+
+				// Only the walk and the local frames, the fake writer has none of the VM's cost
+				Measure(TEXT("FillJavaBundle"), NumParameters, StringLength, NumItems, [&]()
+				{
+					Sink += FillBenchmarkJavaBundle(Event.Parameters);
+				});
+
+				Measure(TEXT("EncodeBatchEvent"), NumParameters, StringLength, NumItems, [&]()
+				{
+					Encoder.Reset();
+					Encoder.AddEvent(Event);
+					Sink += Encoder.GetSize();
+				});
+
+				Measure(TEXT("WriteBundleBlob"), NumParameters, StringLength, NumItems, [&]()
+				{
+					BundleBlob.Reset();
+					FFirebaseAnalyticsBundleWriter::Write(Bundle, BundleBlob);
+					Sink += BundleBlob.Num();
+				});
+
+				Measure(TEXT("VisitBundleBlob"), NumParameters, StringLength, NumItems, [&]()
+				{
+					FFirebaseAnalyticsBundleView View;
+					if (View.Initialize(BundleBlob))
+					{
+						View.ForEachParameter([this](const FFirebaseAnalyticsBundleParameter& Parameter)
+						{
+							Sink += Parameter.Name.Length;
+						});
+					}
+				});
+
+				Measure(TEXT("ReadBundleBlob"), NumParameters, StringLength, NumItems, [&]()
+				{
+					FBundle Copy;
+					FFirebaseAnalyticsBundleView View;
+					if (View.Initialize(BundleBlob))
+					{
+						View.ToBundle(Copy);
+					}
+					Sink += Copy.StringParameters.Num();
+				});
+			}
+		}
+	}
+
+	// Item arrays as large as a cart, one Bundle per item since the fake writer never takes the column path
+	for (int32 NumItems : BenchmarkItemColumnCounts)
+	{
+		FFlatBundle Bundle;
+		Bundle.PutItems(MakeBenchmarkItemColumns(NumItems));
+
+		Measure(TEXT("FillJavaBundleItems"), 5, 8, NumItems, [&]()
+		{
+			Sink += FillBenchmarkJavaBundle(Bundle);
+		});
+	}
+
+	// Batch string encoding against the UTF-8 transcode it replaced
+	for (int32 PayloadIdx = 0; PayloadIdx < UE_ARRAY_COUNT(BenchmarkPayloadChars); PayloadIdx++)
+	{
+		const FString EncodeName = FString::Printf(TEXT("EncodeBatchString.%s"), BenchmarkPayloadNames[PayloadIdx]);
+		const FString TranscodeName = FString::Printf(TEXT("TranscodeUTF8.%s"), BenchmarkPayloadNames[PayloadIdx]);
+
+		for (int32 StringLength : BenchmarkStringLengths)
+		{
+			const FString Value = FString::ChrN(StringLength, BenchmarkPayloadChars[PayloadIdx]);
+
+			FFirebaseAnalyticsEvent Event;
+			Event.Name = TEXT("benchmark_event");
+			Event.Parameters.PutString(TEXT("benchmark_param"), Value);
+
+			Measure(*EncodeName, 1, StringLength, 0, [&]()
+			{
+				Encoder.Reset();
+				Encoder.AddEvent(Event);
+				Sink += Encoder.GetSize();
+			});
+
+			Measure(*TranscodeName, 1, StringLength, 0, [&]()
+			{
+				FTCHARToUTF8 Converted(*Value, Value.Len());
+				Sink += Converted.Length();
+			});
+		}
+	}
+}
+
+template <typename FunctionType>
+void FFirebaseAnalyticsBenchmark::Measure(
+	const TCHAR* Name,
+	int32 NumParameters,
+	int32 StringLength,
+	int32 NumItems,
+	FunctionType&& Function)
+{
+	FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+
+	// Warm up caches and the name tables before timing anything
+	for (int32 Idx = 0; Idx < FMath::Min(Options.Iterations, 100); Idx++)
+	{
+		Function();
+	}
+	Module->FlushEvents();
+
+	TArray<double, TInlineAllocator<16>> Samples;
+	for (int32 Round = 0; Round < Options.Rounds; Round++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Idx = 0; Idx < Options.Iterations; Idx++)
+		{
+			Function();
+		}
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+
+		// With async dispatch the backend catches up here, outside of the timed loop
+		Module->FlushEvents();
+
+		Samples.Add(FPlatformTime::ToSeconds64(EndCycles - StartCycles) * 1e9 / Options.Iterations);
+	}
+
+	Samples.Sort();
+
+	FFirebaseAnalyticsBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+	Result.Name = Name;
+	Result.NumParameters = NumParameters;
+	Result.StringLength = StringLength;
+	Result.NumItems = NumItems;
+	Result.Iterations = Options.Iterations;
+	Result.MinNanoseconds = Samples[0];
+	Result.MedianNanoseconds = Samples[Samples.Num() / 2];
+}
+
+FString FFirebaseAnalyticsBenchmark::ToCSV() const
+{
+	FString Out = TEXT("name,parameters,string_length,items,iterations,min_ns,median_ns\n");
+	for (const FFirebaseAnalyticsBenchmarkResult& Result : Results)
+	{
+		Out += FString::Printf(TEXT("%s,%d,%d,%d,%d,%.1f,%.1f\n"),
+			*Result.Name, Result.NumParameters, Result.StringLength, Result.NumItems,
+			Result.Iterations, Result.MinNanoseconds, Result.MedianNanoseconds);
+	}
+	return Out;
+}
+
+FString FFirebaseAnalyticsBenchmark::ToJson() const
+{
+	FString PluginVersion = TEXT("unknown");
+	if (TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("FirebaseAnalytics")))
+	{
+		PluginVersion = Plugin->GetDescriptor().VersionName;
+	}
+
+	const FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+
+	FString Out = TEXT("{\n");
+	Out += FString::Printf(TEXT("\t\"plugin_version\": \"%s\",\n"), *PluginVersion);
+	Out += FString::Printf(TEXT("\t\"platform\": \"%s\",\n"), ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()));
+	Out += FString::Printf(TEXT("\t\"backend\": \"%s\",\n"),
+		*StaticEnum<EFirebaseAnalyticsBackendType>()->GetNameStringByValue((int64)Options.Backend));
+	Out += FString::Printf(TEXT("\t\"async_dispatch\": %s,\n"),
+		Module && Module->IsAsyncDispatchEnabled() ? TEXT("true") : TEXT("false"));
+	Out += FString::Printf(TEXT("\t\"rounds\": %d,\n"), Options.Rounds);
+	Out += TEXT("\t\"results\": [\n");
+
+	for (int32 Idx = 0; Idx < Results.Num(); Idx++)
+	{
+		const FFirebaseAnalyticsBenchmarkResult& Result = Results[Idx];
+		Out += FString::Printf(
+			TEXT("\t\t{\"name\": \"%s\", \"parameters\": %d, \"string_length\": %d, \"items\": %d, \"iterations\": %d, \"min_ns\": %.1f, \"median_ns\": %.1f}%s\n"),
+			*Result.Name, Result.NumParameters, Result.StringLength, Result.NumItems,
+			Result.Iterations, Result.MinNanoseconds, Result.MedianNanoseconds,
+			Idx + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+
+	Out += TEXT("\t]\n}\n");
+	return Out;
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand RunBenchmarkCommand(
+	TEXT("FirebaseAnalytics.Benchmark"),
+	TEXT("Time the Firebase Analytics entry points against the platform backend. ")
+	TEXT("Optional arguments: iterations and rounds. Results go to Saved/FirebaseAnalytics/Benchmark.csv and .json."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		FFirebaseAnalyticsBenchmarkOptions Options;
+		Options.Backend = EFirebaseAnalyticsBackendType::Platform;
+		if (Args.Num() > 0)
+		{
+			LexFromString(Options.Iterations, *Args[0]);
+		}
+		if (Args.Num() > 1)
+		{
+			LexFromString(Options.Rounds, *Args[1]);
+		}
+
+		FFirebaseAnalyticsBenchmark Benchmark(Options);
+		if (!Benchmark.Run())
+		{
+			return;
+		}
+
+		const FString Directory = FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics");
+		FFileHelper::SaveStringToFile(Benchmark.ToCSV(), *(Directory / TEXT("Benchmark.csv")));
+		FFileHelper::SaveStringToFile(Benchmark.ToJson(), *(Directory / TEXT("Benchmark.json")));
+
+		UE_LOG(LogFirebaseAnalytics, Log, TEXT("Firebase Analytics benchmark: %d cases written to %s"),
+			Benchmark.GetResults().Num(), *Directory);
+	}));
+
+#endif
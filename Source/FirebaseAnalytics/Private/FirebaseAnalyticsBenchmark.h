@@ -0,0 +1,60 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+struct FFirebaseAnalyticsBenchmarkOptions
+{
+	/** Calls per timed round. */
+	int32 Iterations = 1000;
+
+	/** Timed rounds per case, min and median are taken across rounds. */
+	int32 Rounds = 5;
+
+	/** Backend installed for the duration of the run. Platform measures the real SDK round trip on device. */
+	EFirebaseAnalyticsBackendType Backend = EFirebaseAnalyticsBackendType::Null;
+};
+
+struct FFirebaseAnalyticsBenchmarkResult
+{
+	FString Name;
+	int32 NumParameters = 0;
+	int32 StringLength = 0;
+	int32 NumItems = 0;
+	int32 Iterations = 0;
+	double MinNanoseconds = 0.0;
+	double MedianNanoseconds = 0.0;
+};
+
+/** Times the static API entry points, the bundle builders and the marshaling steps behind them.
+ *	Sweeps parameter counts, string lengths and item array sizes, and reports nanoseconds per call.
+ */
+class FFirebaseAnalyticsBenchmark
+{
+public:
+	explicit FFirebaseAnalyticsBenchmark(const FFirebaseAnalyticsBenchmarkOptions& InOptions);
+
+	/** Run every case. Returns false when the module isn't loaded. */
+	bool Run();
+
+	const TArray<FFirebaseAnalyticsBenchmarkResult>& GetResults() const { return Results; }
+
+	FString ToCSV() const;
+	FString ToJson() const;
+
+private:
+	void RunEntryPoints();
+	void RunBuilders();
+	void RunMarshaling();
+
+	template <typename FunctionType>
+	void Measure(const TCHAR* Name, int32 NumParameters, int32 StringLength, int32 NumItems, FunctionType&& Function);
+
+	FFirebaseAnalyticsBenchmarkOptions Options;
+	TArray<FFirebaseAnalyticsBenchmarkResult> Results;
+
+	// Fed with results nobody reads, so the optimizer can't drop the measured work
+	volatile int32 Sink = 0;
+};
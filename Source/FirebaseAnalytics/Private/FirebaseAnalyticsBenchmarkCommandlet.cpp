@@ -0,0 +1,58 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBenchmarkCommandlet.h"
+#include "FirebaseAnalyticsBenchmark.h"
+#include "FirebaseAnalyticsLog.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UFirebaseAnalyticsBenchmarkCommandlet::UFirebaseAnalyticsBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UFirebaseAnalyticsBenchmarkCommandlet::Main(const FString& Params)
+{
+	FFirebaseAnalyticsBenchmarkOptions Options;
+	FParse::Value(*Params, TEXT("Iterations="), Options.Iterations);
+	FParse::Value(*Params, TEXT("Rounds="), Options.Rounds);
+
+	FString BackendName;
+	if (FParse::Value(*Params, TEXT("Backend="), BackendName))
+	{
+		const int64 Backend = StaticEnum<EFirebaseAnalyticsBackendType>()->GetValueByNameString(BackendName);
+		if (Backend == INDEX_NONE)
+		{
+			UE_LOG(LogFirebaseAnalytics, Error, TEXT("Unknown backend '%s'"), *BackendName);
+			return 1;
+		}
+		Options.Backend = (EFirebaseAnalyticsBackendType)Backend;
+	}
+
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics");
+	FString CSVFilename = Directory / TEXT("Benchmark.csv");
+	FString JsonFilename = Directory / TEXT("Benchmark.json");
+	FParse::Value(*Params, TEXT("CSV="), CSVFilename);
+	FParse::Value(*Params, TEXT("JSON="), JsonFilename);
+
+	FFirebaseAnalyticsBenchmark Benchmark(Options);
+	if (!Benchmark.Run())
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("FirebaseAnalytics module isn't loaded, nothing to benchmark"));
+		return 1;
+	}
+
+	if (!FFileHelper::SaveStringToFile(Benchmark.ToCSV(), *CSVFilename) ||
+		!FFileHelper::SaveStringToFile(Benchmark.ToJson(), *JsonFilename))
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't write benchmark results to %s and %s"), *CSVFilename, *JsonFilename);
+		return 1;
+	}
+
+	UE_LOG(LogFirebaseAnalytics, Display, TEXT("%d benchmark cases written to %s and %s"),
+		Benchmark.GetResults().Num(), *CSVFilename, *JsonFilename);
+	return 0;
+}
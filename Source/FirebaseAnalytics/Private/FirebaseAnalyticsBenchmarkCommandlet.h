@@ -0,0 +1,24 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FirebaseAnalyticsBenchmarkCommandlet.generated.h"
+
+/** Headless benchmark run, e.g. on a Linux build machine:
+ *	UE4Editor-Cmd <Project> -run=FirebaseAnalyticsBenchmark [-Iterations=1000] [-Rounds=5]
+ *		[-Backend=Null|Memory|File|BlockLog|Http|Platform] [-CSV=<path>] [-JSON=<path>]
+ */
+UCLASS()
+class UFirebaseAnalyticsBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFirebaseAnalyticsBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
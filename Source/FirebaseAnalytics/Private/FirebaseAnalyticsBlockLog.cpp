@@ -0,0 +1,470 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBlockLog.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "FirebaseAnalyticsStats.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+// How long a caller waits on the writer thread between checks, when both blocks are full
+static constexpr uint32 BlockLogWriteWaitMilliseconds = 10;
+
+FFirebaseAnalyticsBlockLogOptions GetFirebaseAnalyticsBlockLogOptions()
+{
+	const UFirebaseAnalyticsSettings* Settings = GetDefault<UFirebaseAnalyticsSettings>();
+
+	FFirebaseAnalyticsBlockLogOptions Options;
+	Options.Directory = Settings->BlockLogDirectory.IsEmpty()
+		? FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics") / TEXT("EventLog")
+		: Settings->BlockLogDirectory;
+	Options.CompressionFormat = Settings->BlockLogCompressionFormat;
+	Options.BlockSize = FMath::Max(Settings->BlockLogBlockSizeKB, 1) * 1024;
+	Options.FlushIntervalSeconds = Settings->BlockLogFlushIntervalSeconds;
+	Options.MaxFileSize = (int64)Settings->BlockLogMaxFileSizeMB * 1024 * 1024;
+	Options.RotationIntervalSeconds = Settings->BlockLogRotationIntervalMinutes * 60.0f;
+	Options.MaxFiles = Settings->BlockLogMaxFiles;
+	return Options;
+}
+
+void FFirebaseAnalyticsBlockLogBackend::FBlock::Reset()
+{
+	Data.Reset();
+	FirstTicks = 0;
+	LastTicks = 0;
+	NumRecords = 0;
+	OpenedSeconds = 0.0;
+}
+
+FFirebaseAnalyticsBlockLogBackend::FFirebaseAnalyticsBlockLogBackend(const FFirebaseAnalyticsBlockLogOptions& InOptions)
+	: Options(InOptions)
+{
+	if (!FCompression::IsFormatValid(Options.CompressionFormat))
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Unknown compression format %s for the Firebase Analytics block log, using Zlib"),
+			*Options.CompressionFormat.ToString());
+		Options.CompressionFormat = NAME_Zlib;
+	}
+
+	Options.BlockSize = FMath::Clamp(Options.BlockSize, 1024, (int32)(FirebaseAnalyticsBlockLogMaxBlockSize / 2));
+	for (FBlock& Block : Blocks)
+	{
+		Block.Data.Reserve(Options.BlockSize + Options.BlockSize / 4);
+	}
+
+	BlockReadyEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	BlockWrittenEvent = FPlatformProcess::GetSynchEventFromPool(false);
+
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		Thread = FRunnableThread::Create(this, TEXT("FirebaseAnalyticsBlockLog"), 0, TPri_BelowNormal);
+	}
+}
+
+FFirebaseAnalyticsBlockLogBackend::~FFirebaseAnalyticsBlockLogBackend()
+{
+	Flush();
+
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	CloseFile();
+
+	FPlatformProcess::ReturnSynchEventToPool(BlockReadyEvent);
+	FPlatformProcess::ReturnSynchEventToPool(BlockWrittenEvent);
+	BlockReadyEvent = nullptr;
+	BlockWrittenEvent = nullptr;
+}
+
+void FFirebaseAnalyticsBlockLogBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	AddRecord(EFirebaseAnalyticsCallType::LogEvent, 0, FString(), &Event);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		AddRecord(EFirebaseAnalyticsCallType::LogEvent, 0, FString(), &Event);
+	}
+}
+
+void FFirebaseAnalyticsBlockLogBackend::ResetAnalyticsData()
+{
+	AddRecord(EFirebaseAnalyticsCallType::ResetAnalyticsData, 0, FString(), nullptr);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	AddRecord(EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled, bEnabled ? 1 : 0, FString(), nullptr);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	AddRecord(EFirebaseAnalyticsCallType::SetSessionTimeoutDuration, Milliseconds, FString(), nullptr);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SetUserID(const FString& UserID)
+{
+	AddRecord(EFirebaseAnalyticsCallType::SetUserID, 0, UserID, nullptr);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	FFirebaseAnalyticsEvent Property;
+	Property.Name = PropertyName;
+	AddRecord(EFirebaseAnalyticsCallType::SetUserProperty, 0, PropertyValue, &Property);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	FFirebaseAnalyticsEvent Defaults;
+	Defaults.Parameters = Parameters;
+	AddRecord(EFirebaseAnalyticsCallType::SetDefaultEventParameters, 0, FString(), &Defaults);
+}
+
+void FFirebaseAnalyticsBlockLogBackend::AddRecord(
+	EFirebaseAnalyticsCallType Type,
+	int32 IntegerValue,
+	const FString& Value,
+	const FFirebaseAnalyticsEvent* Event)
+{
+	FScopeLock Lock(&FrontCriticalSection);
+
+	const int64 Ticks = FDateTime::UtcNow().GetTicks();
+	if (Front->NumRecords == 0)
+	{
+		Front->FirstTicks = Ticks;
+		Front->OpenedSeconds = FPlatformTime::Seconds();
+	}
+
+	FMemoryWriter Ar(Front->Data, false, true);
+	RecordWriter.Write(Ar, Ticks, Type, IntegerValue, Value, Event);
+
+	Front->LastTicks = Ticks;
+	Front->NumRecords++;
+
+	if (Front->Data.Num() >= Options.BlockSize)
+	{
+		SubmitFrontBlock();
+	}
+}
+
+void FFirebaseAnalyticsBlockLogBackend::SubmitFrontBlock()
+{
+	if (Front->NumRecords == 0)
+	{
+		return;
+	}
+
+	if (Thread == nullptr)
+	{
+		Swap(Front, Back);
+		WriteBackBlock();
+		return;
+	}
+
+	// Both blocks full means the disk can't keep up, the caller waits rather than growing without bound
+	while (bBackBusy)
+	{
+		BlockWrittenEvent->Wait(BlockLogWriteWaitMilliseconds);
+	}
+
+	Swap(Front, Back);
+	bBackBusy = true;
+	BlockReadyEvent->Trigger();
+}
+
+void FFirebaseAnalyticsBlockLogBackend::Flush()
+{
+	{
+		FScopeLock Lock(&FrontCriticalSection);
+		SubmitFrontBlock();
+	}
+
+	while (bBackBusy)
+	{
+		BlockWrittenEvent->Wait(BlockLogWriteWaitMilliseconds);
+	}
+}
+
+uint32 FFirebaseAnalyticsBlockLogBackend::Run()
+{
+	// Without a flush interval blocks only go out when full, the timeout just keeps the thread responsive to Stop
+	const uint32 WaitMilliseconds = Options.FlushIntervalSeconds > 0.0f
+		? FMath::Max((uint32)(Options.FlushIntervalSeconds * 1000.0f), 1u)
+		: 1000u;
+
+	while (!bStopping)
+	{
+		BlockReadyEvent->Wait(WaitMilliseconds);
+
+		// A quiet stream still reaches the disk within the flush interval. Only tried, a caller holding
+		// the lock may be waiting for this thread to free the back block.
+		if (!bBackBusy && Options.FlushIntervalSeconds > 0.0f && FrontCriticalSection.TryLock())
+		{
+			if (!bBackBusy && Front->NumRecords > 0 && FPlatformTime::Seconds() - Front->OpenedSeconds >= Options.FlushIntervalSeconds)
+			{
+				SubmitFrontBlock();
+			}
+			FrontCriticalSection.Unlock();
+		}
+
+		if (bBackBusy)
+		{
+			WriteBackBlock();
+			bBackBusy = false;
+			BlockWrittenEvent->Trigger();
+		}
+	}
+
+	return 0;
+}
+
+void FFirebaseAnalyticsBlockLogBackend::Stop()
+{
+	bStopping = true;
+	BlockReadyEvent->Trigger();
+}
+
+void FFirebaseAnalyticsBlockLogBackend::WriteBackBlock()
+{
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_WriteLogBlock);
+
+	if (Writer)
+	{
+		const bool bFileFull = Options.MaxFileSize > 0 && Writer->Tell() >= Options.MaxFileSize;
+		const bool bFileOld = Options.RotationIntervalSeconds > 0.0f
+			&& FPlatformTime::Seconds() - FileOpenedSeconds >= Options.RotationIntervalSeconds;
+		if (bFileFull || bFileOld)
+		{
+			CloseFile();
+		}
+	}
+
+	if (Writer == nullptr && !OpenFile())
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Back->NumRecords);
+		Back->Reset();
+		return;
+	}
+
+	const int32 UncompressedSize = Back->Data.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(Options.CompressionFormat, UncompressedSize);
+	CompressedData.SetNumUninitialized(CompressedSize, false);
+
+	uint8 bCompressed = FCompression::CompressMemory(
+		Options.CompressionFormat,
+		CompressedData.GetData(),
+		CompressedSize,
+		Back->Data.GetData(),
+		UncompressedSize)
+		&& CompressedSize < UncompressedSize;
+
+	const uint8* Payload = bCompressed ? CompressedData.GetData() : Back->Data.GetData();
+	uint32 PayloadSize = bCompressed ? CompressedSize : UncompressedSize;
+
+	uint32 BlockMagic = FirebaseAnalyticsBlockLogBlockMagic;
+	uint32 UncompressedSize32 = UncompressedSize;
+	*Writer << BlockMagic << Back->FirstTicks << Back->LastTicks << Back->NumRecords << UncompressedSize32 << PayloadSize << bCompressed;
+	Writer->Serialize((void*)Payload, PayloadSize);
+	Writer->Flush();
+
+	FIREBASE_ANALYTICS_RECORD_BYTES(PayloadSize);
+	Back->Reset();
+}
+
+bool FFirebaseAnalyticsBlockLogBackend::OpenFile()
+{
+	IFileManager::Get().MakeDirectory(*Options.Directory, true);
+
+	Filename = Options.Directory / FString::Printf(TEXT("Events-%s.fablog"), *FDateTime::Now().ToString(TEXT("%Y.%m.%d-%H.%M.%S-%s")));
+	Writer = IFileManager::Get().CreateFileWriter(*Filename, FILEWRITE_AllowRead);
+	if (Writer == nullptr)
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Can't open Firebase Analytics block log %s, calls are discarded"), *Filename);
+		return false;
+	}
+
+	uint32 Magic = FirebaseAnalyticsBlockLogMagic;
+	uint32 Version = FirebaseAnalyticsBlockLogVersion;
+	FString FormatName = Options.CompressionFormat.ToString();
+	*Writer << Magic << Version << FormatName;
+
+	FileOpenedSeconds = FPlatformTime::Seconds();
+	DeleteOldFiles();
+	return true;
+}
+
+void FFirebaseAnalyticsBlockLogBackend::CloseFile()
+{
+	delete Writer;
+	Writer = nullptr;
+}
+
+void FFirebaseAnalyticsBlockLogBackend::DeleteOldFiles()
+{
+	if (Options.MaxFiles <= 0)
+	{
+		return;
+	}
+
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Options.Directory / TEXT("*.fablog")), true, false);
+	if (Files.Num() <= Options.MaxFiles)
+	{
+		return;
+	}
+
+	// Names carry the opening time, so they sort oldest first
+	Files.Sort();
+	for (int32 FileIdx = 0; FileIdx < Files.Num() - Options.MaxFiles; FileIdx++)
+	{
+		IFileManager::Get().Delete(*(Options.Directory / Files[FileIdx]));
+	}
+}
+
+FFirebaseAnalyticsBlockLogReader::~FFirebaseAnalyticsBlockLogReader()
+{
+	delete Reader;
+	Reader = nullptr;
+}
+
+bool FFirebaseAnalyticsBlockLogReader::Open(const FString& Filename)
+{
+	delete Reader;
+	Reader = IFileManager::Get().CreateFileReader(*Filename, FILEREAD_AllowWrite);
+	CurrentPayloadOffset = INDEX_NONE;
+	if (Reader == nullptr)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	FString FormatName;
+	*Reader << Magic << Version << FormatName;
+	if (Reader->IsError() || Magic != FirebaseAnalyticsBlockLogMagic || Version != FirebaseAnalyticsBlockLogVersion)
+	{
+		return false;
+	}
+
+	CompressionFormat = FName(*FormatName);
+	return true;
+}
+
+bool FFirebaseAnalyticsBlockLogReader::NextBlock(FFirebaseAnalyticsBlockLogBlockInfo& OutInfo)
+{
+	if (Reader == nullptr)
+	{
+		return false;
+	}
+
+	// Payloads nobody asked for are skipped, never read
+	if (CurrentPayloadOffset != INDEX_NONE)
+	{
+		Reader->Seek(CurrentPayloadOffset + Current.CompressedSize);
+		CurrentPayloadOffset = INDEX_NONE;
+	}
+
+	if (Reader->AtEnd())
+	{
+		return false;
+	}
+
+	uint32 BlockMagic = 0;
+	int64 FirstTicks = 0;
+	int64 LastTicks = 0;
+	uint8 bCompressed = 0;
+	*Reader << BlockMagic << FirstTicks << LastTicks << Current.NumRecords << Current.UncompressedSize << Current.CompressedSize << bCompressed;
+
+	// A log cut short by a crash ends mid-block
+	if (Reader->IsError()
+		|| BlockMagic != FirebaseAnalyticsBlockLogBlockMagic
+		|| Current.CompressedSize > (uint32)(Reader->TotalSize() - Reader->Tell()))
+	{
+		return false;
+	}
+
+	Current.FirstTime = FDateTime(FirstTicks);
+	Current.LastTime = FDateTime(LastTicks);
+	Current.bCompressed = bCompressed != 0;
+	CurrentPayloadOffset = Reader->Tell();
+
+	OutInfo = Current;
+	return true;
+}
+
+bool FFirebaseAnalyticsBlockLogReader::ReadRecords(TArray<FFirebaseAnalyticsBlockLogRecord>& OutRecords)
+{
+	if (Reader == nullptr || CurrentPayloadOffset == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Checked before anything is allocated, the sizes come straight from the file
+	const bool bPlausibleSize = Current.UncompressedSize <= FirebaseAnalyticsBlockLogMaxBlockSize
+		&& (Current.bCompressed
+			? (uint64)Current.UncompressedSize <= (uint64)Current.CompressedSize * FirebaseAnalyticsBlockLogMaxCompressionRatio
+			: Current.UncompressedSize == Current.CompressedSize);
+	if (!bPlausibleSize)
+	{
+		return false;
+	}
+
+	Reader->Seek(CurrentPayloadOffset);
+
+	UncompressedData.SetNumUninitialized(Current.UncompressedSize, false);
+	if (Current.bCompressed)
+	{
+		CompressedData.SetNumUninitialized(Current.CompressedSize, false);
+		Reader->Serialize(CompressedData.GetData(), Current.CompressedSize);
+		if (Reader->IsError() || !FCompression::UncompressMemory(
+			CompressionFormat,
+			UncompressedData.GetData(),
+			Current.UncompressedSize,
+			CompressedData.GetData(),
+			Current.CompressedSize))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		Reader->Serialize(UncompressedData.GetData(), Current.UncompressedSize);
+		if (Reader->IsError())
+		{
+			return false;
+		}
+	}
+
+	FMemoryReader Ar(UncompressedData);
+	FFirebaseAnalyticsCallRecordReader RecordReader;
+	for (uint32 RecordIdx = 0; RecordIdx < Current.NumRecords; RecordIdx++)
+	{
+		int64 Ticks = 0;
+		FFirebaseAnalyticsBlockLogRecord Record;
+		if (!RecordReader.Read(Ar, Ticks, Record.Call))
+		{
+			return false;
+		}
+
+		Record.Time = FDateTime(Ticks);
+		OutRecords.Add(MoveTemp(Record));
+	}
+
+	return true;
+}
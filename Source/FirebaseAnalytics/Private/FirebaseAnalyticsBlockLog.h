@@ -0,0 +1,180 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "FirebaseAnalyticsBackend.h"
+#include "FirebaseAnalyticsCallRecord.h"
+
+class FEvent;
+class FRunnableThread;
+
+/** Block log file layout, written through FArchive:
+ *
+ *	File	:= uint32 Magic, uint32 Version, FName CompressionFormat as FString, Block...
+ *	Block	:= uint32 BlockMagic, int64 FirstTicks, int64 LastTicks, uint32 NumRecords,
+ *			   uint32 UncompressedSize, uint32 CompressedSize, uint8 bCompressed, bytes[CompressedSize]
+ *
+ *	A block holds NumRecords records laid out as in FFirebaseAnalyticsCallRecordWriter, timed in FDateTime UTC ticks.
+ *	Block headers carry everything needed to skip a block without decompressing it, blocks that didn't get smaller
+ *	are stored as they are.
+ */
+static constexpr uint32 FirebaseAnalyticsBlockLogMagic = 0x4C424146; // "FABL"
+static constexpr uint32 FirebaseAnalyticsBlockLogBlockMagic = 0x4B4C4246; // "FBLK"
+static constexpr uint32 FirebaseAnalyticsBlockLogVersion = 1;
+
+// Readers refuse blocks that claim more, so a damaged header can't ask for an arbitrary allocation.
+// Writers stay at half of it, a block may run one record past BlockSize.
+static constexpr uint32 FirebaseAnalyticsBlockLogMaxBlockSize = 256 * 1024 * 1024;
+
+// Past the best ratio any supported format reaches, zlib tops out a little above 1000:1
+static constexpr uint32 FirebaseAnalyticsBlockLogMaxCompressionRatio = 1100;
+
+struct FFirebaseAnalyticsBlockLogOptions
+{
+	/** Directory the log files are written to, one file per rotation. */
+	FString Directory;
+
+	/** Codec passed to FCompression, e.g. Zlib, Gzip or LZ4. */
+	FName CompressionFormat = NAME_Zlib;
+
+	/** Uncompressed bytes per block. */
+	int32 BlockSize = 64 * 1024;
+
+	/** Seconds a partial block may wait before it is written anyway. */
+	float FlushIntervalSeconds = 5.0f;
+
+	/** Start a new file past this many bytes, 0 for no limit. */
+	int64 MaxFileSize = 64 * 1024 * 1024;
+
+	/** Start a new file after this many seconds, 0 for no limit. */
+	float RotationIntervalSeconds = 3600.0f;
+
+	/** Oldest files past this count are deleted when a new one starts, 0 keeps all of them. */
+	int32 MaxFiles = 16;
+};
+
+/** Writes every call into a compressed block log. Records are appended to a front block on the caller,
+ *	a full or timed out block is swapped with the back one and compressed and written on a thread of its own.
+ */
+class FFirebaseAnalyticsBlockLogBackend : public IFirebaseAnalyticsBackend, public FRunnable
+{
+public:
+	explicit FFirebaseAnalyticsBlockLogBackend(const FFirebaseAnalyticsBlockLogOptions& InOptions);
+	virtual ~FFirebaseAnalyticsBlockLogBackend();
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+	/** Write the partial front block and wait until it is on disk. */
+	void Flush();
+
+private:
+	struct FBlock
+	{
+		TArray<uint8> Data;
+		int64 FirstTicks = 0;
+		int64 LastTicks = 0;
+		uint32 NumRecords = 0;
+		double OpenedSeconds = 0.0;
+
+		void Reset();
+	};
+
+	void AddRecord(EFirebaseAnalyticsCallType Type, int32 IntegerValue, const FString& Value, const FFirebaseAnalyticsEvent* Event);
+
+	/** Hand the front block to the writer thread, waiting for it to finish the previous one. Called with FrontCriticalSection held. */
+	void SubmitFrontBlock();
+
+	/** Writer thread side. */
+	void WriteBackBlock();
+	bool OpenFile();
+	void CloseFile();
+	void DeleteOldFiles();
+
+	FFirebaseAnalyticsBlockLogOptions Options;
+
+	// Front block, filled by the callers
+	FCriticalSection FrontCriticalSection;
+	FBlock Blocks[2];
+	FBlock* Front = &Blocks[0];
+	FFirebaseAnalyticsCallRecordWriter RecordWriter;
+
+	// Back block, owned by the writer thread while bBackBusy is set
+	FBlock* Back = &Blocks[1];
+	TAtomic<bool> bBackBusy{false};
+	FEvent* BlockReadyEvent = nullptr;
+	FEvent* BlockWrittenEvent = nullptr;
+
+	// Only touched by the writer thread
+	FArchive* Writer = nullptr;
+	FString Filename;
+	double FileOpenedSeconds = 0.0;
+	TArray<uint8> CompressedData;
+
+	FRunnableThread* Thread = nullptr;
+	TAtomic<bool> bStopping{false};
+};
+
+/** One call read back from a block log. */
+struct FFirebaseAnalyticsBlockLogRecord
+{
+	FDateTime Time;
+	FFirebaseAnalyticsCall Call;
+};
+
+/** Header of one block, enough to decide whether to decompress it. */
+struct FFirebaseAnalyticsBlockLogBlockInfo
+{
+	FDateTime FirstTime;
+	FDateTime LastTime;
+	uint32 NumRecords = 0;
+	uint32 UncompressedSize = 0;
+	uint32 CompressedSize = 0;
+	bool bCompressed = false;
+};
+
+/** Sequential reader. NextBlock reads a header and skips the payload, ReadRecords decompresses it only when asked to. */
+class FFirebaseAnalyticsBlockLogReader
+{
+public:
+	~FFirebaseAnalyticsBlockLogReader();
+
+	/** Returns false if the file is missing or not a block log. */
+	bool Open(const FString& Filename);
+
+	/** Move to the next block. Returns false at the end of the file or at a damaged block. */
+	bool NextBlock(FFirebaseAnalyticsBlockLogBlockInfo& OutInfo);
+
+	/** Decompress and decode the block NextBlock moved to, appending its records. */
+	bool ReadRecords(TArray<FFirebaseAnalyticsBlockLogRecord>& OutRecords);
+
+	FName GetCompressionFormat() const { return CompressionFormat; }
+
+private:
+	FArchive* Reader = nullptr;
+	FName CompressionFormat;
+	FFirebaseAnalyticsBlockLogBlockInfo Current;
+	int64 CurrentPayloadOffset = INDEX_NONE;
+
+	// Reused between blocks
+	TArray<uint8> CompressedData;
+	TArray<uint8> UncompressedData;
+};
+
+/** Options from UFirebaseAnalyticsSettings. */
+FFirebaseAnalyticsBlockLogOptions GetFirebaseAnalyticsBlockLogOptions();
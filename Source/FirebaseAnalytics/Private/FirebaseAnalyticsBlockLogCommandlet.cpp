@@ -0,0 +1,156 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBlockLogCommandlet.h"
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsBlockLog.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+#include "FirebaseAnalyticsLog.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+UFirebaseAnalyticsBlockLogCommandlet::UFirebaseAnalyticsBlockLogCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UFirebaseAnalyticsBlockLogCommandlet::Main(const FString& Params)
+{
+	FString LogPath;
+	if (!FParse::Value(*Params, TEXT("Log="), LogPath))
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Missing -Log=<file or directory>"));
+		return 1;
+	}
+
+	FString EventFilter;
+	FParse::Value(*Params, TEXT("Event="), EventFilter);
+	const bool bSummary = FParse::Param(*Params, TEXT("Summary"));
+
+	// A directory is read oldest file first, its names carry the time they were opened
+	TArray<FString> Filenames;
+	if (IFileManager::Get().DirectoryExists(*LogPath))
+	{
+		IFileManager::Get().FindFiles(Filenames, *(LogPath / TEXT("*.fablog")), true, false);
+		Filenames.Sort();
+		for (FString& Filename : Filenames)
+		{
+			Filename = LogPath / Filename;
+		}
+	}
+	else
+	{
+		Filenames.Add(LogPath);
+	}
+
+	TUniquePtr<FArchive> Out;
+	FString OutFilename;
+	if (FParse::Value(*Params, TEXT("Out="), OutFilename))
+	{
+		Out.Reset(IFileManager::Get().CreateFileWriter(*OutFilename));
+		if (!Out)
+		{
+			UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't write %s"), *OutFilename);
+			return 1;
+		}
+	}
+
+	auto Print = [&Out](const FString& Line)
+	{
+		if (Out)
+		{
+			FTCHARToUTF8 Utf8Line(*Line, Line.Len());
+			Out->Serialize((void*)Utf8Line.Get(), Utf8Line.Length());
+			Out->Serialize((void*)"\n", 1);
+		}
+		else
+		{
+			UE_LOG(LogFirebaseAnalytics, Display, TEXT("%s"), *Line);
+		}
+	};
+
+	int64 NumBlocks = 0;
+	int64 NumRecords = 0;
+	int64 CompressedBytes = 0;
+	int64 UncompressedBytes = 0;
+	FDateTime FirstTime = FDateTime::MaxValue();
+	FDateTime LastTime = FDateTime::MinValue();
+	TMap<EFirebaseAnalyticsCallType, int64> CallCounts;
+	TFirebaseAnalyticsNameMap<int64> EventCounts;
+
+	TArray<FFirebaseAnalyticsBlockLogRecord> Records;
+	for (const FString& Filename : Filenames)
+	{
+		FFirebaseAnalyticsBlockLogReader Reader;
+		if (!Reader.Open(Filename))
+		{
+			UE_LOG(LogFirebaseAnalytics, Error, TEXT("%s is not a Firebase Analytics block log"), *Filename);
+			return 1;
+		}
+
+		FFirebaseAnalyticsBlockLogBlockInfo Block;
+		while (Reader.NextBlock(Block))
+		{
+			NumBlocks++;
+			CompressedBytes += Block.CompressedSize;
+			UncompressedBytes += Block.UncompressedSize;
+			FirstTime = FMath::Min(FirstTime, Block.FirstTime);
+			LastTime = FMath::Max(LastTime, Block.LastTime);
+
+			Records.Reset();
+			if (!Reader.ReadRecords(Records))
+			{
+				UE_LOG(LogFirebaseAnalytics, Warning, TEXT("%s has a damaged block after %lld calls"), *Filename, NumRecords);
+				break;
+			}
+
+			for (const FFirebaseAnalyticsBlockLogRecord& Record : Records)
+			{
+				const bool bEvent = Record.Call.Type == EFirebaseAnalyticsCallType::LogEvent;
+				if (!EventFilter.IsEmpty() && !(bEvent && Record.Call.Event.Name.Equals(EventFilter, ESearchCase::CaseSensitive)))
+				{
+					continue;
+				}
+
+				NumRecords++;
+				if (bSummary)
+				{
+					CallCounts.FindOrAdd(Record.Call.Type)++;
+					if (bEvent)
+					{
+						EventCounts.FindOrAdd(Record.Call.Event.Name)++;
+					}
+				}
+				else
+				{
+					// Same objects the File backend writes, with the time in front
+					Print(FString::Printf(TEXT("{\"time\":\"%s\",%s"), *Record.Time.ToIso8601(), *FirebaseAnalyticsCallToJson(Record.Call).RightChop(1)));
+				}
+			}
+		}
+	}
+
+	if (bSummary)
+	{
+		Print(FString::Printf(TEXT("%lld calls in %lld blocks of %d files, %s to %s"),
+			NumRecords, NumBlocks, Filenames.Num(), *FirstTime.ToIso8601(), *LastTime.ToIso8601()));
+		Print(FString::Printf(TEXT("%.1f KB compressed from %.1f KB (%.1f%%)"),
+			CompressedBytes / 1024.0, UncompressedBytes / 1024.0,
+			UncompressedBytes > 0 ? 100.0 * CompressedBytes / UncompressedBytes : 0.0));
+
+		for (const TPair<EFirebaseAnalyticsCallType, int64>& Count : CallCounts)
+		{
+			Print(FString::Printf(TEXT("%-32s %lld"), LexToString(Count.Key), Count.Value));
+		}
+
+		EventCounts.ValueSort([](int64 A, int64 B) { return A > B; });
+		for (const TPair<FString, int64>& Count : EventCounts)
+		{
+			Print(FString::Printf(TEXT("  %-40s %lld"), *Count.Key, Count.Value));
+		}
+	}
+
+	return 0;
+}
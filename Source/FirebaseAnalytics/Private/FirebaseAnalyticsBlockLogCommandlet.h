@@ -0,0 +1,24 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FirebaseAnalyticsBlockLogCommandlet.generated.h"
+
+/** Decompresses BlockLog backend files and prints or aggregates them:
+ *	UE4Editor-Cmd <Project> -run=FirebaseAnalyticsBlockLog -Log=<file or directory> [-Event=<name>] [-Summary] [-Out=<path>]
+ *	Calls are printed one JSON object per line, -Summary prints counts per call and event name instead.
+ */
+UCLASS()
+class UFirebaseAnalyticsBlockLogCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFirebaseAnalyticsBlockLogCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -0,0 +1,592 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBundleFormat.h"
+#include "FirebaseAnalyticsSwar.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Bundle format is little-endian, add byte swapping for this platform.");
+
+// Deeper nesting than FBundle ever needs, only there to keep hostile input off the stack
+static constexpr int32 FirebaseAnalyticsBundleMaxDepth = 16;
+
+typedef TArray<FFirebaseAnalyticsBundleString, TInlineAllocator<16>> FFirebaseAnalyticsBundleKeys;
+
+static FORCEINLINE uint32 FirebaseAnalyticsBundleZigZag(int32 Value)
+{
+	return ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+}
+
+static FORCEINLINE int32 FirebaseAnalyticsBundleUnZigZag(uint32 Value)
+{
+	return (int32)(Value >> 1) ^ -(int32)(Value & 1);
+}
+
+static FORCEINLINE UTF16CHAR FirebaseAnalyticsBundleCharAt(const FFirebaseAnalyticsBundleString& String, int32 CharIdx)
+{
+	if (!String.bUTF16)
+	{
+		return String.Data[CharIdx];
+	}
+
+	UTF16CHAR Unit;
+	FMemory::Memcpy(&Unit, String.Data + CharIdx * sizeof(UTF16CHAR), sizeof(Unit));
+	return Unit;
+}
+
+FString FFirebaseAnalyticsBundleString::ToString() const
+{
+	if (Length == 0)
+	{
+		return FString();
+	}
+
+	if (bUTF16 && sizeof(TCHAR) != sizeof(UTF16CHAR))
+	{
+		TArray<UTF16CHAR, TInlineAllocator<128>> Units;
+		Units.SetNumUninitialized(Length);
+		FMemory::Memcpy(Units.GetData(), Data, Length * sizeof(UTF16CHAR));
+
+		const auto Converted = StringCast<TCHAR>(Units.GetData(), Length);
+		return FString(Converted.Length(), Converted.Get());
+	}
+
+	FString Result;
+	TArray<TCHAR>& Chars = Result.GetCharArray();
+	Chars.SetNumUninitialized(Length + 1);
+
+	if (bUTF16)
+	{
+		FMemory::Memcpy(Chars.GetData(), Data, Length * sizeof(TCHAR));
+	}
+	else
+	{
+		for (int32 CharIdx = 0; CharIdx < Length; CharIdx++)
+		{
+			Chars[CharIdx] = (TCHAR)Data[CharIdx];
+		}
+	}
+
+	Chars[Length] = TEXT('\0');
+	return Result;
+}
+
+bool FFirebaseAnalyticsBundleString::Equals(const TCHAR* Other) const
+{
+	for (int32 CharIdx = 0; CharIdx < Length; CharIdx++)
+	{
+		// Also stops at the terminator of a shorter Other
+		if ((uint32)Other[CharIdx] != FirebaseAnalyticsBundleCharAt(*this, CharIdx))
+		{
+			return false;
+		}
+	}
+
+	return Other[Length] == TEXT('\0');
+}
+
+/** Bounds checked walk over a whole blob, done once by Initialize. */
+class FFirebaseAnalyticsBundleChecker
+{
+public:
+	FFirebaseAnalyticsBundleChecker(TArrayView<const uint8> InData, FFirebaseAnalyticsBundleKeys& InKeys)
+		: Data(InData.GetData())
+		, Size(InData.Num())
+		, Keys(InKeys)
+	{
+	}
+
+	bool ReadByte(uint8& Out)
+	{
+		if (Offset >= Size)
+		{
+			return false;
+		}
+
+		Out = Data[Offset++];
+		return true;
+	}
+
+	bool ReadVarint(uint32& Out)
+	{
+		Out = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			uint8 Byte = 0;
+			if (!ReadByte(Byte))
+			{
+				return false;
+			}
+
+			Out |= (uint32)(Byte & 0x7F) << Shift;
+			if (!(Byte & 0x80))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool Skip(int64 Count)
+	{
+		if (Count > Size - Offset)
+		{
+			return false;
+		}
+
+		Offset += (int32)Count;
+		return true;
+	}
+
+	bool ReadString(FFirebaseAnalyticsBundleString& Out)
+	{
+		uint32 Header = 0;
+		if (!ReadVarint(Header))
+		{
+			return false;
+		}
+
+		Out.Data = Data + Offset;
+		Out.Length = (int32)(Header >> 1);
+		Out.bUTF16 = (Header & 1) != 0;
+		return Skip((int64)Out.Length * (Out.bUTF16 ? sizeof(UTF16CHAR) : 1));
+	}
+
+	bool CheckBundle(int32 Depth)
+	{
+		uint32 NumParameters = 0;
+		if (Depth > FirebaseAnalyticsBundleMaxDepth || !ReadVarint(NumParameters))
+		{
+			return false;
+		}
+
+		for (uint32 ParameterIdx = 0; ParameterIdx < NumParameters; ParameterIdx++)
+		{
+			uint8 Type = 0;
+			uint32 KeyRef = 0;
+			if (!ReadByte(Type) || !ReadVarint(KeyRef))
+			{
+				return false;
+			}
+
+			if (KeyRef == 0)
+			{
+				if (!ReadString(Keys.AddDefaulted_GetRef()))
+				{
+					return false;
+				}
+			}
+			else if (KeyRef > (uint32)Keys.Num())
+			{
+				return false;
+			}
+
+			switch ((EFirebaseAnalyticsBundleValueType)Type)
+			{
+				case EFirebaseAnalyticsBundleValueType::String:
+				{
+					FFirebaseAnalyticsBundleString Value;
+					if (!ReadString(Value))
+					{
+						return false;
+					}
+					break;
+				}
+				case EFirebaseAnalyticsBundleValueType::Integer:
+				{
+					uint32 Value = 0;
+					if (!ReadVarint(Value))
+					{
+						return false;
+					}
+					break;
+				}
+				case EFirebaseAnalyticsBundleValueType::Float:
+				{
+					if (!Skip(sizeof(float)))
+					{
+						return false;
+					}
+					break;
+				}
+				case EFirebaseAnalyticsBundleValueType::Bundles:
+				{
+					uint32 NumItems = 0;
+					uint32 ItemBytes = 0;
+					if (!ReadVarint(NumItems) || Offset + (int64)sizeof(ItemBytes) > Size)
+					{
+						return false;
+					}
+
+					FMemory::Memcpy(&ItemBytes, Data + Offset, sizeof(ItemBytes));
+					Offset += sizeof(ItemBytes);
+
+					// The size lets readers skip the items, so it has to match them exactly
+					const int64 End = Offset + (int64)ItemBytes;
+					if (End > Size)
+					{
+						return false;
+					}
+
+					for (uint32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+					{
+						if (!CheckBundle(Depth + 1))
+						{
+							return false;
+						}
+					}
+
+					if (Offset != End)
+					{
+						return false;
+					}
+					break;
+				}
+				default:
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool IsAtEnd() const { return Offset == Size; }
+
+private:
+	const uint8* Data;
+	int32 Size;
+	int32 Offset = 0;
+	FFirebaseAnalyticsBundleKeys& Keys;
+};
+
+bool FFirebaseAnalyticsBundleView::Initialize(TArrayView<const uint8> Data)
+{
+	Root = nullptr;
+	Bundle = nullptr;
+	Keys.Reset();
+
+	if (Data.Num() < 2 || Data[0] != FirebaseAnalyticsBundleMagic || Data[1] != FirebaseAnalyticsBundleVersion)
+	{
+		return false;
+	}
+
+	FFirebaseAnalyticsBundleChecker Checker(Data.Slice(2, Data.Num() - 2), Keys);
+	if (!Checker.CheckBundle(0) || !Checker.IsAtEnd())
+	{
+		Keys.Reset();
+		return false;
+	}
+
+	Bundle = Data.GetData() + 2;
+	return true;
+}
+
+uint32 FFirebaseAnalyticsBundleView::ReadVarint(const uint8*& Cursor)
+{
+	uint32 Value = 0;
+	for (int32 Shift = 0;; Shift += 7)
+	{
+		const uint8 Byte = *Cursor++;
+		Value |= (uint32)(Byte & 0x7F) << Shift;
+		if (!(Byte & 0x80))
+		{
+			return Value;
+		}
+	}
+}
+
+static FORCEINLINE FFirebaseAnalyticsBundleString FirebaseAnalyticsBundleReadString(const uint8*& Cursor, uint32 Header)
+{
+	FFirebaseAnalyticsBundleString Result;
+	Result.Data = Cursor;
+	Result.Length = (int32)(Header >> 1);
+	Result.bUTF16 = (Header & 1) != 0;
+
+	Cursor += Result.Length * (Result.bUTF16 ? sizeof(UTF16CHAR) : 1);
+	return Result;
+}
+
+const uint8* FFirebaseAnalyticsBundleView::ReadParameter(const uint8* Cursor, FFirebaseAnalyticsBundleParameter& Out) const
+{
+	Out.Type = (EFirebaseAnalyticsBundleValueType)*Cursor++;
+
+	// First appearances sit right here, repeats point back into the index built by Initialize
+	const uint32 KeyRef = ReadVarint(Cursor);
+	if (KeyRef == 0)
+	{
+		Out.Name = FirebaseAnalyticsBundleReadString(Cursor, ReadVarint(Cursor));
+	}
+	else
+	{
+		Out.Name = GetRoot()->Keys[KeyRef - 1];
+	}
+
+	switch (Out.Type)
+	{
+		case EFirebaseAnalyticsBundleValueType::String:
+		{
+			Out.StringValue = FirebaseAnalyticsBundleReadString(Cursor, ReadVarint(Cursor));
+			break;
+		}
+		case EFirebaseAnalyticsBundleValueType::Integer:
+		{
+			Out.IntegerValue = FirebaseAnalyticsBundleUnZigZag(ReadVarint(Cursor));
+			break;
+		}
+		case EFirebaseAnalyticsBundleValueType::Float:
+		{
+			FMemory::Memcpy(&Out.FloatValue, Cursor, sizeof(float));
+			Cursor += sizeof(float);
+			break;
+		}
+		case EFirebaseAnalyticsBundleValueType::Bundles:
+		{
+			uint32 ItemBytes = 0;
+			Out.Items.Owner = this;
+			Out.Items.Num = (int32)ReadVarint(Cursor);
+			FMemory::Memcpy(&ItemBytes, Cursor, sizeof(ItemBytes));
+			Out.Items.First = Cursor + sizeof(ItemBytes);
+			Cursor = Out.Items.First + ItemBytes;
+			break;
+		}
+	}
+
+	return Cursor;
+}
+
+const uint8* FFirebaseAnalyticsBundleView::SkipBundle(const uint8* Cursor) const
+{
+	const uint32 NumParameters = ReadVarint(Cursor);
+
+	FFirebaseAnalyticsBundleParameter Parameter;
+	for (uint32 ParameterIdx = 0; ParameterIdx < NumParameters; ParameterIdx++)
+	{
+		Cursor = ReadParameter(Cursor, Parameter);
+	}
+
+	return Cursor;
+}
+
+void FFirebaseAnalyticsBundleView::ToBundle(FBundle& Out) const
+{
+	ForEachParameter([&Out](const FFirebaseAnalyticsBundleParameter& Parameter)
+	{
+		switch (Parameter.Type)
+		{
+			case EFirebaseAnalyticsBundleValueType::String:
+			{
+				Out.StringParameters.Add(Parameter.Name.ToString(), Parameter.StringValue.ToString());
+				break;
+			}
+			case EFirebaseAnalyticsBundleValueType::Integer:
+			{
+				Out.IntegerParameters.Add(Parameter.Name.ToString(), Parameter.IntegerValue);
+				break;
+			}
+			case EFirebaseAnalyticsBundleValueType::Float:
+			{
+				Out.FloatParameters.Add(Parameter.Name.ToString(), Parameter.FloatValue);
+				break;
+			}
+			case EFirebaseAnalyticsBundleValueType::Bundles:
+			{
+				TArray<FBundle>& Items = Out.BundlesParameters.Add(Parameter.Name.ToString());
+				Items.Reserve(Parameter.Items.Num);
+				Parameter.Items.ForEach([&Items](const FFirebaseAnalyticsBundleView& Item)
+				{
+					Item.ToBundle(Items.AddDefaulted_GetRef());
+				});
+				break;
+			}
+		}
+	});
+}
+
+/** Writes into a fixed span, remembering an overflow instead of checking every call site. */
+class FFirebaseAnalyticsBundleEncoder
+{
+public:
+	explicit FFirebaseAnalyticsBundleEncoder(TArrayView<uint8> InBuffer)
+		: Data(InBuffer.GetData())
+		, Capacity(InBuffer.Num())
+	{
+	}
+
+	uint8* Reserve(int32 Count)
+	{
+		if (bOverflow || Count > Capacity - Offset)
+		{
+			bOverflow = true;
+			return nullptr;
+		}
+
+		uint8* Result = Data + Offset;
+		Offset += Count;
+		return Result;
+	}
+
+	void WriteByte(uint8 Value)
+	{
+		if (uint8* Out = Reserve(1))
+		{
+			*Out = Value;
+		}
+	}
+
+	void WriteBytes(const void* Value, int32 Count)
+	{
+		if (uint8* Out = Reserve(Count))
+		{
+			FMemory::Memcpy(Out, Value, Count);
+		}
+	}
+
+	void WriteVarint(uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			WriteByte((uint8)(Value | 0x80));
+			Value >>= 7;
+		}
+		WriteByte((uint8)Value);
+	}
+
+	void WriteString(const FString& Value)
+	{
+		const TCHAR* Chars = *Value;
+		const int32 Length = Value.Len();
+
+		if (FirebaseAnalyticsSwar::AllBelow(Chars, Length, 0xFF))
+		{
+			WriteVarint((uint32)Length << 1);
+			if (uint8* Out = Reserve(Length))
+			{
+				for (int32 CharIdx = 0; CharIdx < Length; CharIdx++)
+				{
+					Out[CharIdx] = (uint8)Chars[CharIdx];
+				}
+			}
+		}
+		else if (sizeof(TCHAR) == sizeof(UTF16CHAR))
+		{
+			WriteVarint((uint32)Length << 1 | 1);
+			WriteBytes(Chars, Length * sizeof(UTF16CHAR));
+		}
+		else
+		{
+			const auto Converted = StringCast<UTF16CHAR>(Chars, Length);
+			WriteVarint((uint32)Converted.Length() << 1 | 1);
+			WriteBytes(Converted.Get(), Converted.Length() * sizeof(UTF16CHAR));
+		}
+	}
+
+	void WriteKey(EFirebaseAnalyticsBundleValueType Type, const FString& Key)
+	{
+		WriteByte((uint8)Type);
+
+		// Bundles rarely have more than a few dozen distinct keys, a linear scan over hashes beats a map here
+		const uint32 Hash = FCrc::StrCrc32(*Key);
+		for (int32 KeyIdx = 0; KeyIdx < Keys.Num(); KeyIdx++)
+		{
+			if (Keys[KeyIdx].Key == Hash && Keys[KeyIdx].Value->Equals(Key, ESearchCase::CaseSensitive))
+			{
+				WriteVarint((uint32)KeyIdx + 1);
+				return;
+			}
+		}
+
+		Keys.Emplace(Hash, &Key);
+		WriteVarint(0);
+		WriteString(Key);
+	}
+
+	void WriteBundle(const FBundle& Bundle)
+	{
+		WriteVarint(
+			Bundle.StringParameters.Num() +
+			Bundle.FloatParameters.Num() +
+			Bundle.IntegerParameters.Num() +
+			Bundle.BundlesParameters.Num());
+
+		for (const auto& Parameter : Bundle.StringParameters)
+		{
+			WriteKey(EFirebaseAnalyticsBundleValueType::String, Parameter.Key);
+			WriteString(Parameter.Value);
+		}
+
+		for (const auto& Parameter : Bundle.FloatParameters)
+		{
+			WriteKey(EFirebaseAnalyticsBundleValueType::Float, Parameter.Key);
+			WriteBytes(&Parameter.Value, sizeof(float));
+		}
+
+		for (const auto& Parameter : Bundle.IntegerParameters)
+		{
+			WriteKey(EFirebaseAnalyticsBundleValueType::Integer, Parameter.Key);
+			WriteVarint(FirebaseAnalyticsBundleZigZag(Parameter.Value));
+		}
+
+		for (const auto& Parameter : Bundle.BundlesParameters)
+		{
+			WriteKey(EFirebaseAnalyticsBundleValueType::Bundles, Parameter.Key);
+			WriteVarint(Parameter.Value.Num());
+
+			// Patched once the items are written, so readers can skip them
+			uint8* ItemBytes = Reserve(sizeof(uint32));
+			const int32 ItemsOffset = Offset;
+
+			for (const FBundle& Item : Parameter.Value)
+			{
+				WriteBundle(Item);
+			}
+
+			if (!bOverflow)
+			{
+				const uint32 Size = (uint32)(Offset - ItemsOffset);
+				FMemory::Memcpy(ItemBytes, &Size, sizeof(Size));
+			}
+		}
+	}
+
+	int32 GetResult() const { return bOverflow ? INDEX_NONE : Offset; }
+
+private:
+	uint8* Data;
+	int32 Capacity;
+	int32 Offset = 0;
+	bool bOverflow = false;
+
+	// Hash and string of every key written so far, by key index
+	TArray<TPair<uint32, const FString*>, TInlineAllocator<32>> Keys;
+};
+
+int32 FFirebaseAnalyticsBundleWriter::Write(const FBundle& Bundle, TArrayView<uint8> Buffer)
+{
+	FFirebaseAnalyticsBundleEncoder Encoder(Buffer);
+	Encoder.WriteByte(FirebaseAnalyticsBundleMagic);
+	Encoder.WriteByte(FirebaseAnalyticsBundleVersion);
+	Encoder.WriteBundle(Bundle);
+	return Encoder.GetResult();
+}
+
+void FFirebaseAnalyticsBundleWriter::Write(const FBundle& Bundle, TArray<uint8>& Out)
+{
+	const int32 Start = Out.Num();
+	int32 Capacity = FMath::Max(Out.GetSlack(), 256);
+
+	// Sizing up front would take a second pass, retrying in a bigger buffer is rarely needed
+	for (;;)
+	{
+		Out.SetNumUninitialized(Start + Capacity, false);
+
+		const int32 Written = Write(Bundle, MakeArrayView(Out.GetData() + Start, Capacity));
+		if (Written != INDEX_NONE)
+		{
+			Out.SetNum(Start + Written, false);
+			return;
+		}
+
+		Capacity *= 2;
+	}
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsBundlePool.h"
+#include "FirebaseAnalyticsLog.h"
+#include "Misc/ScopeLock.h"
+
+FFirebaseAnalyticsBundlePool::FFirebaseAnalyticsBundlePool(int32 InMaxBundles)
+	: MaxBundles(FMath::Max(InMaxBundles, 1))
+{
+}
+
+FFirebaseAnalyticsBundleHandle FFirebaseAnalyticsBundlePool::Acquire()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FFirebaseAnalyticsBundleHandle Handle;
+	if (FreeSlots.Num() > 0)
+	{
+		Handle.Index = FreeSlots.Pop(false);
+	}
+	else if (Slots.Num() < MaxBundles)
+	{
+		Handle.Index = Slots.AddDefaulted();
+	}
+	else
+	{
+		if (!bWarnedFull)
+		{
+			bWarnedFull = true;
+			UE_LOG(LogFirebaseAnalytics, Warning, TEXT("All %d bundle handles are in use, are some never logged or released?"), MaxBundles);
+		}
+		return Handle;
+	}
+
+	FSlot& Slot = Slots[Handle.Index];
+	Slot.bInUse = true;
+	Handle.Serial = Slot.Serial;
+	return Handle;
+}
+
+bool FFirebaseAnalyticsBundlePool::Modify(FFirebaseAnalyticsBundleHandle Handle, TFunctionRef<void(FFlatBundle&)> Function)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FSlot* Slot = FindSlot(Handle);
+	if (Slot == nullptr)
+	{
+		return false;
+	}
+
+	Function(Slot->Bundle);
+	return true;
+}
+
+bool FFirebaseAnalyticsBundlePool::Take(FFirebaseAnalyticsBundleHandle Handle, FFlatBundle& OutBundle)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FSlot* Slot = FindSlot(Handle);
+	if (Slot == nullptr)
+	{
+		return false;
+	}
+
+	OutBundle = MoveTemp(Slot->Bundle);
+	ReleaseSlot(Handle, *Slot);
+	return true;
+}
+
+bool FFirebaseAnalyticsBundlePool::Release(FFirebaseAnalyticsBundleHandle Handle)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FSlot* Slot = FindSlot(Handle);
+	if (Slot == nullptr)
+	{
+		return false;
+	}
+
+	ReleaseSlot(Handle, *Slot);
+	return true;
+}
+
+int32 FFirebaseAnalyticsBundlePool::GetNumInUse() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Slots.Num() - FreeSlots.Num();
+}
+
+FFirebaseAnalyticsBundlePool::FSlot* FFirebaseAnalyticsBundlePool::FindSlot(FFirebaseAnalyticsBundleHandle Handle)
+{
+	if (!Slots.IsValidIndex(Handle.Index))
+	{
+		return nullptr;
+	}
+
+	FSlot& Slot = Slots[Handle.Index];
+	return Slot.bInUse && Slot.Serial == Handle.Serial ? &Slot : nullptr;
+}
+
+void FFirebaseAnalyticsBundlePool::ReleaseSlot(FFirebaseAnalyticsBundleHandle Handle, FSlot& Slot)
+{
+	Slot.Bundle.Reset();
+	Slot.bInUse = false;
+
+	// Copies of the handle still held by the graph go stale
+	Slot.Serial++;
+	FreeSlots.Add(Handle.Index);
+}
@@ -0,0 +1,48 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+#include "Templates/Function.h"
+
+/** Flat bundles Blueprints fill in place through FFirebaseAnalyticsBundleHandle.
+ *	Released slots keep their allocations for the next bundle, taken ones hand them over with the bundle since it
+ *	leaves the pool to be logged. Safe to call from any thread.
+ */
+class FFirebaseAnalyticsBundlePool
+{
+public:
+	explicit FFirebaseAnalyticsBundlePool(int32 InMaxBundles);
+
+	/** Returns an invalid handle when every slot is taken. */
+	FFirebaseAnalyticsBundleHandle Acquire();
+
+	/** Run Function on the bundle behind Handle. Returns false for stale or invalid handles. */
+	bool Modify(FFirebaseAnalyticsBundleHandle Handle, TFunctionRef<void(FFlatBundle&)> Function);
+
+	/** Move the bundle out and release its slot, which starts over with an empty bundle. */
+	bool Take(FFirebaseAnalyticsBundleHandle Handle, FFlatBundle& OutBundle);
+
+	/** Discard the bundle. */
+	bool Release(FFirebaseAnalyticsBundleHandle Handle);
+
+	int32 GetNumInUse() const;
+
+private:
+	struct FSlot
+	{
+		FFlatBundle Bundle;
+		uint32 Serial = 1;
+		bool bInUse = false;
+	};
+
+	FSlot* FindSlot(FFirebaseAnalyticsBundleHandle Handle);
+	void ReleaseSlot(FFirebaseAnalyticsBundleHandle Handle, FSlot& Slot);
+
+	mutable FCriticalSection CriticalSection;
+	TArray<FSlot> Slots;
+	TArray<int32> FreeSlots;
+	int32 MaxBundles;
+	bool bWarnedFull = false;
+};
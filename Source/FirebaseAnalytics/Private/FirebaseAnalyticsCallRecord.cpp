@@ -0,0 +1,47 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsCallRecord.h"
+
+void FFirebaseAnalyticsCallRecordWriter::Write(
+	FArchive& Ar,
+	int64 Time,
+	EFirebaseAnalyticsCallType Type,
+	int32 IntegerValue,
+	const FString& Value,
+	const FFirebaseAnalyticsEvent* Event)
+{
+	EventBytes.Reset();
+	if (Event && (!Event->Name.IsEmpty() || !Event->Parameters.IsEmpty()))
+	{
+		Encoder.Reset();
+		Encoder.AddEvent(*Event);
+		EventBytes.Append(Encoder.GetData(), Encoder.GetSize());
+	}
+
+	uint8 TypeByte = (uint8)Type;
+	Ar << Time << TypeByte << IntegerValue << const_cast<FString&>(Value) << EventBytes;
+}
+
+bool FFirebaseAnalyticsCallRecordReader::Read(FArchive& Ar, int64& OutTime, FFirebaseAnalyticsCall& OutCall)
+{
+	uint8 Type = 0;
+	Ar << OutTime << Type << OutCall.IntegerValue << OutCall.Value << EventBytes;
+	if (Ar.IsError() || Type > (uint8)EFirebaseAnalyticsCallType::SetDefaultEventParameters)
+	{
+		return false;
+	}
+
+	OutCall.Type = (EFirebaseAnalyticsCallType)Type;
+	OutCall.Event = FFirebaseAnalyticsEvent();
+	if (EventBytes.Num() > 0)
+	{
+		Events.Reset();
+		if (!FFirebaseAnalyticsBatchDecoder::Decode(EventBytes.GetData(), EventBytes.Num(), Events) || Events.Num() != 1)
+		{
+			return false;
+		}
+		OutCall.Event = MoveTemp(Events[0]);
+	}
+
+	return true;
+}
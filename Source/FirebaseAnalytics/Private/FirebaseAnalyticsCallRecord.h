@@ -0,0 +1,44 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsBatchCodec.h"
+#include "FirebaseAnalyticsEvent.h"
+
+/** One call as stored by the trace and the block log, written through FArchive:
+ *
+ *	Record	:= int64 Time, uint8 CallType, int32 IntegerValue, FString Value, TArray<uint8> Event
+ *
+ *	Event is a one-event batch from FFirebaseAnalyticsBatchEncoder, empty for calls without a name or parameters.
+ *	What Time counts is up to the file the record is in.
+ */
+class FFirebaseAnalyticsCallRecordWriter
+{
+public:
+	/** Append a record for Call to Ar. */
+	void Write(FArchive& Ar, int64 Time, const FFirebaseAnalyticsCall& Call)
+	{
+		Write(Ar, Time, Call.Type, Call.IntegerValue, Call.Value, &Call.Event);
+	}
+
+	/** Append a record to Ar, Event may be null for calls that don't carry one. */
+	void Write(FArchive& Ar, int64 Time, EFirebaseAnalyticsCallType Type, int32 IntegerValue, const FString& Value, const FFirebaseAnalyticsEvent* Event);
+
+private:
+	// Reused between records
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	TArray<uint8> EventBytes;
+};
+
+class FFirebaseAnalyticsCallRecordReader
+{
+public:
+	/** Read the next record from Ar. Returns false for a damaged or cut short one, OutCall is then left undefined. */
+	bool Read(FArchive& Ar, int64& OutTime, FFirebaseAnalyticsCall& OutCall);
+
+private:
+	// Reused between records
+	TArray<uint8> EventBytes;
+	TArray<FFirebaseAnalyticsEvent> Events;
+};
@@ -0,0 +1,259 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsDedupBackend.h"
+#include "FirebaseAnalyticsStats.h"
+#include "Algo/AllOf.h"
+#include "Misc/ScopeLock.h"
+
+static const FFirebaseAnalyticsParameter* FindDedupParameter(const FFlatBundle& Bundle, const TCHAR* Name)
+{
+	for (const FFirebaseAnalyticsParameter& Parameter : Bundle.GetParameters())
+	{
+		if (Parameter.HasName(Name))
+		{
+			return &Parameter;
+		}
+	}
+
+	return nullptr;
+}
+
+static bool AreDedupParametersEqual(
+	const FFlatBundle& BundleA,
+	const FFirebaseAnalyticsParameter& A,
+	const FFlatBundle& BundleB,
+	const FFirebaseAnalyticsParameter& B)
+{
+	if (A.Type != B.Type)
+	{
+		return false;
+	}
+
+	switch (A.Type)
+	{
+		case EFirebaseAnalyticsParameterType::String:	return A.StringValue.Equals(B.StringValue, ESearchCase::CaseSensitive);
+		case EFirebaseAnalyticsParameterType::Float:	return A.FloatValue == B.FloatValue;
+		case EFirebaseAnalyticsParameterType::Double:	return A.DoubleValue == B.DoubleValue;
+		case EFirebaseAnalyticsParameterType::Integer:	return A.IntegerValue == B.IntegerValue;
+		case EFirebaseAnalyticsParameterType::Int64:	return A.Int64Value == B.Int64Value;
+		case EFirebaseAnalyticsParameterType::Null:		return true;
+		case EFirebaseAnalyticsParameterType::Bundles:
+		{
+			if (A.Items.Num != B.Items.Num)
+			{
+				return false;
+			}
+
+			for (int32 ItemIdx = 0; ItemIdx < A.Items.Num; ItemIdx++)
+			{
+				TArrayView<const FFirebaseAnalyticsParameter> ItemA = BundleA.GetItemParameters(A, ItemIdx);
+				TArrayView<const FFirebaseAnalyticsParameter> ItemB = BundleB.GetItemParameters(B, ItemIdx);
+				if (ItemA.Num() != ItemB.Num())
+				{
+					return false;
+				}
+
+				for (int32 ParameterIdx = 0; ParameterIdx < ItemA.Num(); ParameterIdx++)
+				{
+					if (!ItemA[ParameterIdx].HasName(ItemB[ParameterIdx].GetName())
+						|| !AreDedupParametersEqual(BundleA, ItemA[ParameterIdx], BundleB, ItemB[ParameterIdx]))
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void CopyDedupParameter(FFlatBundle& To, const FFlatBundle& From, const FFirebaseAnalyticsParameter& Parameter);
+
+template <typename NameType>
+static void CopyDedupParameterAs(FFlatBundle& To, const NameType& Name, const FFlatBundle& From, const FFirebaseAnalyticsParameter& Parameter)
+{
+	switch (Parameter.Type)
+	{
+		case EFirebaseAnalyticsParameterType::String:	To.PutString(Name, Parameter.StringValue); break;
+		case EFirebaseAnalyticsParameterType::Float:	To.PutFloat(Name, Parameter.FloatValue); break;
+		case EFirebaseAnalyticsParameterType::Double:	To.PutDouble(Name, Parameter.DoubleValue); break;
+		case EFirebaseAnalyticsParameterType::Integer:	To.PutInteger(Name, Parameter.IntegerValue); break;
+		case EFirebaseAnalyticsParameterType::Int64:	To.PutInt64(Name, Parameter.Int64Value); break;
+		case EFirebaseAnalyticsParameterType::Null:		To.PutNull(Name); break;
+		case EFirebaseAnalyticsParameterType::Bundles:
+		{
+			TArray<FFlatBundle, TInlineAllocator<8>> Items;
+			Items.SetNum(Parameter.Items.Num);
+			for (int32 ItemIdx = 0; ItemIdx < Parameter.Items.Num; ItemIdx++)
+			{
+				for (const FFirebaseAnalyticsParameter& ItemParameter : From.GetItemParameters(Parameter, ItemIdx))
+				{
+					CopyDedupParameter(Items[ItemIdx], From, ItemParameter);
+				}
+			}
+
+			To.PutBundles(Name, Items);
+			break;
+		}
+	}
+}
+
+static void CopyDedupParameter(FFlatBundle& To, const FFlatBundle& From, const FFirebaseAnalyticsParameter& Parameter)
+{
+	if (Parameter.IsBuiltin())
+	{
+		CopyDedupParameterAs(To, (EBuiltinParamNames)Parameter.BuiltinName, From, Parameter);
+	}
+	else if (Parameter.StaticName)
+	{
+		CopyDedupParameterAs(To, FFirebaseAnalyticsStaticName(Parameter.StaticName), From, Parameter);
+	}
+	else
+	{
+		CopyDedupParameterAs(To, Parameter.Name, From, Parameter);
+	}
+}
+
+FFirebaseAnalyticsDedupBackend::FFirebaseAnalyticsDedupBackend(FFirebaseAnalyticsBackendPtr InInner)
+	: Inner(MoveTemp(InInner))
+{
+	check(Inner.IsValid());
+}
+
+void FFirebaseAnalyticsDedupBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	Inner->LogEvent(Event);
+}
+
+void FFirebaseAnalyticsDedupBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	Inner->LogEvents(Events);
+}
+
+void FFirebaseAnalyticsDedupBackend::ResetAnalyticsData()
+{
+	FScopeLock Lock(&CriticalSection);
+	Inner->ResetAnalyticsData();
+	Forget();
+}
+
+void FFirebaseAnalyticsDedupBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	Inner->SetAnalyticsCollectionEnabled(bEnabled);
+}
+
+void FFirebaseAnalyticsDedupBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	Inner->SetSessionTimeoutDuration(Milliseconds);
+}
+
+void FFirebaseAnalyticsDedupBackend::SetUserID(const FString& InUserID)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Inner->IsReady())
+	{
+		Inner->SetUserID(InUserID);
+		return;
+	}
+
+	if (UserID.IsSet() && UserID->Equals(InUserID, ESearchCase::CaseSensitive))
+	{
+		FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL();
+		return;
+	}
+
+	Inner->SetUserID(InUserID);
+	UserID = InUserID;
+}
+
+void FFirebaseAnalyticsDedupBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Inner->IsReady())
+	{
+		Inner->SetUserProperty(PropertyName, PropertyValue);
+		return;
+	}
+
+	FString* CurrentValue = UserProperties.Find(PropertyName);
+	if (CurrentValue && CurrentValue->Equals(PropertyValue, ESearchCase::CaseSensitive))
+	{
+		FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL();
+		return;
+	}
+
+	Inner->SetUserProperty(PropertyName, PropertyValue);
+	UserProperties.Add(PropertyName, PropertyValue);
+}
+
+void FFirebaseAnalyticsDedupBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Inner->IsReady())
+	{
+		Inner->SetDefaultEventParameters(Parameters);
+		return;
+	}
+
+	// An empty bundle clears every default parameter
+	if (Parameters.IsEmpty())
+	{
+		const bool bAlreadyClear = bDefaultParametersCleared && Algo::AllOf(DefaultParameters.GetParameters(), [](const FFirebaseAnalyticsParameter& Parameter)
+		{
+			return Parameter.Type == EFirebaseAnalyticsParameterType::Null;
+		});
+
+		if (bAlreadyClear)
+		{
+			FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL();
+			return;
+		}
+
+		Inner->SetDefaultEventParameters(Parameters);
+		DefaultParameters.Reset();
+		bDefaultParametersCleared = true;
+		return;
+	}
+
+	FFlatBundle Diff;
+	for (const FFirebaseAnalyticsParameter& Parameter : Parameters.GetParameters())
+	{
+		const FFirebaseAnalyticsParameter* Current = FindDedupParameter(DefaultParameters, Parameter.GetName());
+		const bool bUnchanged = Parameter.Type == EFirebaseAnalyticsParameterType::Null
+			? (Current ? Current->Type == EFirebaseAnalyticsParameterType::Null : bDefaultParametersCleared)
+			: (Current && AreDedupParametersEqual(DefaultParameters, *Current, Parameters, Parameter));
+
+		if (!bUnchanged)
+		{
+			CopyDedupParameter(Diff, Parameters, Parameter);
+			CopyDedupParameter(DefaultParameters, Parameters, Parameter);
+		}
+	}
+
+	if (Diff.IsEmpty())
+	{
+		FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL();
+		return;
+	}
+
+	Inner->SetDefaultEventParameters(Diff);
+}
+
+bool FFirebaseAnalyticsDedupBackend::IsReady() const
+{
+	return Inner->IsReady();
+}
+
+void FFirebaseAnalyticsDedupBackend::Forget()
+{
+	UserID.Reset();
+	UserProperties.Reset();
+	DefaultParameters.Reset();
+	bDefaultParametersCleared = false;
+}
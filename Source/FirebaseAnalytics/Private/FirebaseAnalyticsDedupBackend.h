@@ -0,0 +1,52 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsBackend.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+
+/** Sits in front of another backend and keeps a shadow of what it was told, so writes that change
+ *	nothing are skipped: a repeated user ID or user property, and default parameters already set to
+ *	the same value. Default parameters that did change are forwarded as a diff.
+ *
+ *	Nothing is known about state left by earlier runs, so the first write of every value goes through.
+ *	While the wrapped backend isn't ready calls are forwarded without being remembered.
+ */
+class FFirebaseAnalyticsDedupBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	explicit FFirebaseAnalyticsDedupBackend(FFirebaseAnalyticsBackendPtr InInner);
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	virtual bool IsReady() const override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	const FFirebaseAnalyticsBackendPtr& GetInner() const { return Inner; }
+
+private:
+	/** Drop the whole shadow, every next write goes through. Called with CriticalSection held. */
+	void Forget();
+
+	FFirebaseAnalyticsBackendPtr Inner;
+
+	/** Held from comparing against the shadow until it is updated, so a write can't slip between the two. */
+	FCriticalSection CriticalSection;
+
+	TOptional<FString> UserID;
+	TFirebaseAnalyticsNameMap<FString> UserProperties;
+
+	/** Default parameters as last sent. Null entries are keys known to be unset. */
+	FFlatBundle DefaultParameters;
+
+	/** Set after a clear-all, keys missing from DefaultParameters are then known to be unset too. */
+	bool bDefaultParametersCleared = false;
+};
@@ -0,0 +1,201 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsDispatcher.h"
+#include "FirebaseAnalyticsJournal.h"
+#include "FirebaseAnalyticsStats.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+// How long the dispatch thread sleeps when nobody wakes it up
+static constexpr uint32 DispatcherIdleWaitMilliseconds = 100;
+
+FFirebaseAnalyticsDispatcher::FFirebaseAnalyticsDispatcher(
+	FFirebaseAnalyticsBackendPtr InBackend,
+	int32 InMaxBatchSize,
+	FFirebaseAnalyticsJournal* InJournal)
+	: Backend(MoveTemp(InBackend))
+	, MaxBatchSize(FMath::Max(InMaxBatchSize, 1))
+	, Journal(InJournal)
+{
+	Batch.Reserve(MaxBatchSize);
+	BatchJournalRecords.Reserve(MaxBatchSize);
+
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	DrainedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	Thread = FRunnableThread::Create(this, TEXT("FirebaseAnalyticsDispatcher"), 0, TPri_BelowNormal);
+}
+
+FFirebaseAnalyticsDispatcher::~FFirebaseAnalyticsDispatcher()
+{
+	if (Thread)
+	{
+		// Kill() calls Stop() and waits until everything queued has been drained
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	FPlatformProcess::ReturnSynchEventToPool(DrainedEvent);
+	WakeUpEvent = nullptr;
+	DrainedEvent = nullptr;
+}
+
+void FFirebaseAnalyticsDispatcher::Enqueue(FFirebaseAnalyticsCall&& Call)
+{
+	++NumPending;
+	Queue.Enqueue(MoveTemp(Call));
+
+	// Only pay for the wake up when the dispatch thread is actually waiting
+	if (bSleeping.Exchange(false))
+	{
+		WakeUpEvent->Trigger();
+	}
+}
+
+void FFirebaseAnalyticsDispatcher::SetBackend(FFirebaseAnalyticsBackendPtr InBackend)
+{
+	FScopeLock Lock(&BackendCriticalSection);
+	Backend = MoveTemp(InBackend);
+}
+
+void FFirebaseAnalyticsDispatcher::Flush()
+{
+	FlushUntil(TNumericLimits<double>::Max());
+}
+
+bool FFirebaseAnalyticsDispatcher::FlushUntil(double Deadline)
+{
+	if (Thread == nullptr)
+	{
+		Drain();
+		return true;
+	}
+
+	WakeUpEvent->Trigger();
+	while (NumPending.Load() > 0)
+	{
+		const double Remaining = Deadline - FPlatformTime::Seconds();
+		if (Remaining <= 0.0)
+		{
+			return false;
+		}
+
+		// Bounded, so two threads flushing at once can't both sleep on a single trigger for long
+		const uint32 WaitMilliseconds = (uint32)FMath::Clamp(Remaining * 1000.0, 1.0, (double)DispatcherIdleWaitMilliseconds);
+		DrainedEvent->Wait(WaitMilliseconds);
+	}
+	return true;
+}
+
+int32 FFirebaseAnalyticsDispatcher::GetNumPending() const
+{
+	return FMath::Max(NumPending.Load(), 0);
+}
+
+uint32 FFirebaseAnalyticsDispatcher::Run()
+{
+	while (!bStopping)
+	{
+		Drain();
+
+		// Announce the sleep first and re-check the queue afterwards,
+		// so a push racing with us can't be left behind until the timeout
+		bSleeping = true;
+		if (Queue.IsEmpty() && !bStopping)
+		{
+			WakeUpEvent->Wait(DispatcherIdleWaitMilliseconds);
+		}
+		bSleeping = false;
+	}
+
+	Drain();
+	return 0;
+}
+
+void FFirebaseAnalyticsDispatcher::Stop()
+{
+	bStopping = true;
+	WakeUpEvent->Trigger();
+}
+
+void FFirebaseAnalyticsDispatcher::Drain()
+{
+	if (Queue.IsEmpty())
+	{
+		return;
+	}
+
+	FFirebaseAnalyticsBackendPtr CurrentBackend;
+	{
+		FScopeLock Lock(&BackendCriticalSection);
+		CurrentBackend = Backend;
+	}
+
+	FFirebaseAnalyticsCall Call;
+	while (Queue.Dequeue(Call))
+	{
+		if (Call.Type == EFirebaseAnalyticsCallType::LogEvent)
+		{
+			Batch.Add(MoveTemp(Call.Event));
+			BatchJournalRecords.Add(Call.JournalRecord);
+			if (Batch.Num() == MaxBatchSize || Queue.IsEmpty())
+			{
+				DeliverBatch(CurrentBackend.Get());
+			}
+			continue;
+		}
+
+		// Anything else may change how later events are attributed, so events queued before it go first
+		DeliverBatch(CurrentBackend.Get());
+
+		if (CurrentBackend.IsValid())
+		{
+			CurrentBackend->Apply(Call);
+		}
+		else
+		{
+			FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+		}
+
+		MarkDelivered(1);
+	}
+}
+
+void FFirebaseAnalyticsDispatcher::DeliverBatch(IFirebaseAnalyticsBackend* CurrentBackend)
+{
+	if (Batch.Num() == 0)
+	{
+		return;
+	}
+
+	if (CurrentBackend)
+	{
+		FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_DispatchBatch);
+		CurrentBackend->LogEvents(Batch);
+
+		if (Journal && CurrentBackend->IsReady())
+		{
+			Journal->Acknowledge(BatchJournalRecords);
+		}
+	}
+	else
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Batch.Num());
+	}
+
+	MarkDelivered(Batch.Num());
+	Batch.Reset();
+	BatchJournalRecords.Reset();
+}
+
+void FFirebaseAnalyticsDispatcher::MarkDelivered(int32 NumCalls)
+{
+	if ((NumPending -= NumCalls) <= 0)
+	{
+		DrainedEvent->Trigger();
+	}
+}
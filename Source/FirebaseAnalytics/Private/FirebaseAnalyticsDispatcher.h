@@ -0,0 +1,70 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "FirebaseAnalyticsBackend.h"
+
+class FEvent;
+class FFirebaseAnalyticsJournal;
+class FRunnableThread;
+
+/** Drains captured calls on a dedicated thread, so the caller only pays for a queue push.
+ *	Calls reach the backend in submission order, runs of events are delivered as one batch.
+ */
+class FFirebaseAnalyticsDispatcher : public FRunnable
+{
+public:
+	/** Journal is optional. When set, delivered events are acknowledged in it. */
+	FFirebaseAnalyticsDispatcher(FFirebaseAnalyticsBackendPtr InBackend, int32 InMaxBatchSize, FFirebaseAnalyticsJournal* InJournal = nullptr);
+	virtual ~FFirebaseAnalyticsDispatcher();
+
+	/** Queue a call for the dispatch thread. Lock-free, safe to call from any thread. */
+	void Enqueue(FFirebaseAnalyticsCall&& Call);
+
+	/** Replace the backend that queued calls are delivered to. */
+	void SetBackend(FFirebaseAnalyticsBackendPtr InBackend);
+
+	/** Block the caller until every call queued so far has been delivered. */
+	void Flush();
+
+	/** Like Flush, but gives up at Deadline, in FPlatformTime::Seconds. Returns false when calls were still pending. */
+	bool FlushUntil(double Deadline);
+
+	/** Number of calls pushed but not delivered yet. */
+	int32 GetNumPending() const;
+
+	//~ Begin FRunnable Interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable Interface
+
+private:
+	void Drain();
+	void DeliverBatch(IFirebaseAnalyticsBackend* CurrentBackend);
+	void MarkDelivered(int32 NumCalls);
+
+	TQueue<FFirebaseAnalyticsCall, EQueueMode::Mpsc> Queue;
+
+	FCriticalSection BackendCriticalSection;
+	FFirebaseAnalyticsBackendPtr Backend;
+
+	// Only touched by the dispatch thread, reused between batches
+	TArray<FFirebaseAnalyticsEvent> Batch;
+	TArray<FFirebaseAnalyticsJournalRecord> BatchJournalRecords;
+	int32 MaxBatchSize;
+
+	FFirebaseAnalyticsJournal* Journal;
+
+	FEvent* WakeUpEvent = nullptr;
+
+	// Triggered by the dispatch thread whenever nothing is pending any more, flushes wait on it
+	FEvent* DrainedEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+
+	TAtomic<int32> NumPending{0};
+	TAtomic<bool> bSleeping{false};
+	TAtomic<bool> bStopping{false};
+};
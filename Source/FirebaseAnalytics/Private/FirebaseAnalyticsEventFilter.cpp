@@ -0,0 +1,156 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsEventFilter.h"
+#include "FirebaseAnalytics.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+FFirebaseAnalyticsEventFilter::FFirebaseAnalyticsEventFilter(
+	TArrayView<const FFirebaseAnalyticsEventRule> InRules,
+	const FString& InSampleRateParameterName)
+	: SampleRateParameterName(InSampleRateParameterName)
+	, RandomStream(FPlatformTime::Cycles())
+{
+	const double Now = FPlatformTime::Seconds();
+	for (const FFirebaseAnalyticsEventRule& Rule : InRules)
+	{
+		FRuleState& State = Rules.AddDefaulted_GetRef();
+		State.Rule = Rule;
+		State.Rule.BurstSize = FMath::Max(Rule.BurstSize, 1);
+		State.Tokens = State.Rule.BurstSize;
+		State.LastRefillSeconds = Now;
+
+		// A later rule for the same name replaces the earlier one
+		if (Rule.EventName == TEXT("*"))
+		{
+			DefaultRuleIdx = Rules.Num() - 1;
+		}
+		else
+		{
+			RuleIndices.Add(Rule.EventName, Rules.Num() - 1);
+		}
+	}
+
+	for (int32 NameIdx = 0; NameIdx < NumBuiltinEventNames; NameIdx++)
+	{
+		BuiltinRuleIndices[NameIdx] = FindRule(GetBuiltinEventNameLiteral((EBuiltinEventNames)NameIdx));
+	}
+}
+
+bool FFirebaseAnalyticsEventFilter::Evaluate(const FString& EventName, float& OutSampleRate)
+{
+	return EvaluateRule(FindRule(EventName), OutSampleRate);
+}
+
+bool FFirebaseAnalyticsEventFilter::Evaluate(EBuiltinEventNames EventName, float& OutSampleRate)
+{
+	return EvaluateRule(BuiltinRuleIndices[(int32)EventName], OutSampleRate);
+}
+
+int32 FFirebaseAnalyticsEventFilter::FindRule(const FString& EventName) const
+{
+	const int32* RuleIdx = RuleIndices.Find(EventName);
+	return RuleIdx ? *RuleIdx : DefaultRuleIdx;
+}
+
+bool FFirebaseAnalyticsEventFilter::EvaluateRule(int32 RuleIdx, float& OutSampleRate)
+{
+	OutSampleRate = 0.0f;
+	if (RuleIdx == INDEX_NONE)
+	{
+		return true;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	FRuleState& State = Rules[RuleIdx];
+	const FFirebaseAnalyticsEventRule& Rule = State.Rule;
+
+	if (Rule.SampleRate < 1.0f && RandomStream.GetFraction() >= Rule.SampleRate)
+	{
+		State.NumSampledOut++;
+		return false;
+	}
+
+	if (Rule.MaxEventsPerSecond > 0.0f)
+	{
+		const double Now = FPlatformTime::Seconds();
+		State.Tokens = FMath::Min<double>(State.Tokens + (Now - State.LastRefillSeconds) * Rule.MaxEventsPerSecond, Rule.BurstSize);
+		State.LastRefillSeconds = Now;
+
+		if (State.Tokens < 1.0)
+		{
+			State.NumRateLimited++;
+			return false;
+		}
+
+		State.Tokens -= 1.0;
+	}
+
+	State.NumPassed++;
+
+	if (Rule.bAddSampleRateParameter)
+	{
+		OutSampleRate = Rule.SampleRate;
+	}
+
+	return true;
+}
+
+void FFirebaseAnalyticsEventFilter::Dump(FOutputDevice& Ar) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Ar.Logf(TEXT("Firebase Analytics event rules: %d"), Rules.Num());
+	for (const FRuleState& State : Rules)
+	{
+		Ar.Logf(TEXT("  %-40s rate=%.3f limit=%.1f/s burst=%d passed=%llu sampled_out=%llu rate_limited=%llu"),
+			*State.Rule.EventName,
+			State.Rule.SampleRate,
+			State.Rule.MaxEventsPerSecond,
+			State.Rule.BurstSize,
+			State.NumPassed,
+			State.NumSampledOut,
+			State.NumRateLimited);
+	}
+}
+
+void FFirebaseAnalyticsEventFilter::ResetCounters()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	for (FRuleState& State : Rules)
+	{
+		State.NumPassed = 0;
+		State.NumSampledOut = 0;
+		State.NumRateLimited = 0;
+	}
+}
+
+static FAutoConsoleCommandWithOutputDevice DumpEventRulesCommand(
+	TEXT("FirebaseAnalytics.DumpEventRules"),
+	TEXT("Print the sampling and rate limit rules with the number of events each one passed and dropped."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+		if (const FFirebaseAnalyticsEventFilter* Filter = Module ? Module->GetEventFilter() : nullptr)
+		{
+			Filter->Dump(Ar);
+		}
+		else
+		{
+			Ar.Log(TEXT("Firebase Analytics has no event rules"));
+		}
+	}));
+
+static FAutoConsoleCommand ResetEventRulesCommand(
+	TEXT("FirebaseAnalytics.ResetEventRules"),
+	TEXT("Clear the counters printed by FirebaseAnalytics.DumpEventRules."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+		if (FFirebaseAnalyticsEventFilter* Filter = Module ? Module->GetEventFilter() : nullptr)
+		{
+			Filter->ResetCounters();
+		}
+	}));
@@ -0,0 +1,50 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "FirebaseAnalyticsBuiltinNames.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+#include "FirebaseAnalyticsTypes.h"
+
+/** Applies FFirebaseAnalyticsEventRule to event names, sampling first and then the token bucket.
+ *	Rules are fixed at construction, so names without a rule are answered without taking a lock.
+ */
+class FFirebaseAnalyticsEventFilter
+{
+public:
+	FFirebaseAnalyticsEventFilter(TArrayView<const FFirebaseAnalyticsEventRule> InRules, const FString& InSampleRateParameterName);
+
+	/** Returns false for events to drop. OutSampleRate is the rate kept events should carry, or 0 when they carry none. */
+	bool Evaluate(const FString& EventName, float& OutSampleRate);
+	bool Evaluate(EBuiltinEventNames EventName, float& OutSampleRate);
+
+	const FString& GetSampleRateParameterName() const { return SampleRateParameterName; }
+
+	/** Print passed and dropped counts of every rule. */
+	void Dump(FOutputDevice& Ar) const;
+	void ResetCounters();
+
+private:
+	struct FRuleState
+	{
+		FFirebaseAnalyticsEventRule Rule;
+		double Tokens = 0.0;
+		double LastRefillSeconds = 0.0;
+		uint64 NumPassed = 0;
+		uint64 NumSampledOut = 0;
+		uint64 NumRateLimited = 0;
+	};
+
+	int32 FindRule(const FString& EventName) const;
+	bool EvaluateRule(int32 RuleIdx, float& OutSampleRate);
+
+	mutable FCriticalSection CriticalSection;
+	TArray<FRuleState> Rules;
+	TFirebaseAnalyticsNameMap<int32> RuleIndices;
+	int32 DefaultRuleIdx = INDEX_NONE;
+	int32 BuiltinRuleIndices[NumBuiltinEventNames];
+	FString SampleRateParameterName;
+	FRandomStream RandomStream;
+};
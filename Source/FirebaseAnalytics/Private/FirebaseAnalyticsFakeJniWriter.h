@@ -0,0 +1,123 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+/** Stands in for JNIEnv in FillFirebaseAnalyticsJavaBundle: hands out integer refs and keeps the local frames the way the VM does.
+ *	Lets the tests check the local ref discipline and the benchmark time the fill without a device.
+ */
+class FFirebaseAnalyticsFakeJniWriter
+{
+public:
+	typedef int32 ObjectType;
+
+	struct FrameType
+	{
+		FFirebaseAnalyticsFakeJniWriter& Writer;
+
+		FrameType(FFirebaseAnalyticsFakeJniWriter& InWriter, int32 Capacity)
+			: Writer(InWriter)
+		{
+			Writer.PushFrame(Capacity);
+		}
+
+		~FrameType()
+		{
+			Writer.PopFrame();
+		}
+	};
+
+	explicit FFirebaseAnalyticsFakeJniWriter(int32 RootCapacity)
+	{
+		PushFrame(RootCapacity);
+	}
+
+	ObjectType NewName(const FFirebaseAnalyticsParameter& Parameter) { return NewLocal(); }
+	ObjectType NewString(const FString& Value) { return NewLocal(); }
+
+	void PutString(ObjectType Bundle, ObjectType Name, ObjectType Value) { Use(Bundle); Use(Name); if (Value) { Use(Value); } NumPuts++; }
+	void PutFloat(ObjectType Bundle, ObjectType Name, float Value) { Use(Bundle); Use(Name); NumPuts++; }
+	void PutDouble(ObjectType Bundle, ObjectType Name, double Value) { Use(Bundle); Use(Name); NumPuts++; }
+	void PutInteger(ObjectType Bundle, ObjectType Name, int32 Value) { Use(Bundle); Use(Name); NumPuts++; }
+	void PutLong(ObjectType Bundle, ObjectType Name, int64 Value) { Use(Bundle); Use(Name); NumPuts++; }
+
+	bool PutItemsByColumn(ObjectType Bundle, ObjectType Name, const FFlatBundle& FlatBundle, const FFirebaseAnalyticsParameter& Parameter) { return false; }
+
+	ObjectType NewItemBundle() { return NewLocal(); }
+	ObjectType NewItemArray(int32 Length) { return NewLocal(); }
+
+	void SetItem(ObjectType Array, int32 ItemIdx, ObjectType ItemBundle) { Use(Array); Use(ItemBundle); NumItemsSet++; }
+	void PutItemArray(ObjectType Bundle, ObjectType Name, ObjectType Array) { Use(Bundle); Use(Name); Use(Array); NumPuts++; }
+
+	void ReleaseItem(ObjectType Object)
+	{
+		Use(Object);
+		if (const int32* FrameIdx = LiveRefs.Find(Object))
+		{
+			Frames[*FrameIdx].NumLive--;
+			LiveRefs.Remove(Object);
+		}
+	}
+
+	ObjectType NewLocal()
+	{
+		const ObjectType Ref = NextRef++;
+		LiveRefs.Add(Ref, Frames.Num() - 1);
+
+		FFrame& Frame = Frames.Last();
+		if (++Frame.NumLive > Frame.Capacity)
+		{
+			NumOverCapacity++;
+		}
+		PeakLiveRefs = FMath::Max(PeakLiveRefs, LiveRefs.Num());
+		return Ref;
+	}
+
+	int32 GetNumLiveRefs() const { return LiveRefs.Num(); }
+	int32 GetNumFrames() const { return Frames.Num(); }
+
+	int32 PeakLiveRefs = 0;
+	int32 NumOverCapacity = 0;
+	int32 NumDeadUses = 0;
+	int32 NumPuts = 0;
+	int32 NumItemsSet = 0;
+
+private:
+	struct FFrame
+	{
+		int32 Capacity = 0;
+		int32 NumLive = 0;
+	};
+
+	void PushFrame(int32 Capacity)
+	{
+		Frames.Add({FMath::Max(Capacity, 1), 0});
+	}
+
+	void PopFrame()
+	{
+		const int32 FrameIdx = Frames.Num() - 1;
+		for (auto It = LiveRefs.CreateIterator(); It; ++It)
+		{
+			if (It.Value() == FrameIdx)
+			{
+				It.RemoveCurrent();
+			}
+		}
+		Frames.Pop();
+	}
+
+	void Use(ObjectType Object)
+	{
+		if (!LiveRefs.Contains(Object))
+		{
+			NumDeadUses++;
+		}
+	}
+
+	TArray<FFrame> Frames;
+	TMap<ObjectType, int32> LiveRefs;
+	ObjectType NextRef = 1;
+};
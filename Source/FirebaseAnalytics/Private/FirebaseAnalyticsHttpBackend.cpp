@@ -0,0 +1,541 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsHttpBackend.h"
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "FirebaseAnalyticsStats.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/Compression.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+static const TCHAR* HttpSpillFilePrefix = TEXT("Request-");
+
+FFirebaseAnalyticsHttpOptions GetFirebaseAnalyticsHttpOptions()
+{
+	const UFirebaseAnalyticsSettings* Settings = GetDefault<UFirebaseAnalyticsSettings>();
+
+	FFirebaseAnalyticsHttpOptions Options;
+	Options.Endpoint = Settings->HttpEndpoint;
+	Options.MeasurementId = Settings->HttpMeasurementId;
+	Options.ApiSecret = Settings->HttpApiSecret;
+	Options.ClientId = Settings->HttpClientId;
+	Options.MaxEventsPerRequest = Settings->HttpMaxEventsPerRequest;
+	Options.BatchIntervalSeconds = Settings->HttpBatchIntervalSeconds;
+	Options.MaxConcurrentRequests = Settings->HttpMaxConcurrentRequests;
+	Options.bGzip = Settings->bHttpGzip;
+	Options.MaxRetries = Settings->HttpMaxRetries;
+	Options.RetryBaseDelaySeconds = Settings->HttpRetryBaseDelaySeconds;
+	Options.RetryMaxDelaySeconds = Settings->HttpRetryMaxDelaySeconds;
+	Options.MaxQueuedBytes = (int64)FMath::Max(Settings->HttpMaxQueuedKB, 1) * 1024;
+	Options.SpillDirectory = Settings->HttpSpillDirectory.IsEmpty()
+		? FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics") / TEXT("HttpSpill")
+		: Settings->HttpSpillDirectory;
+	Options.MaxSpillBytes = (int64)Settings->HttpMaxSpillSizeMB * 1024 * 1024;
+	return Options;
+}
+
+static FString NewFirebaseAnalyticsHttpClientId()
+{
+	return FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphens).ToLower();
+}
+
+FFirebaseAnalyticsHttpBackend::FFirebaseAnalyticsHttpBackend(const FFirebaseAnalyticsHttpOptions& InOptions)
+	: Options(InOptions)
+{
+	Options.MaxEventsPerRequest = FMath::Max(Options.MaxEventsPerRequest, 1);
+	Options.MaxConcurrentRequests = FMath::Max(Options.MaxConcurrentRequests, 1);
+
+	Url = Options.Endpoint;
+	Url += Url.Contains(TEXT("?")) ? TEXT("&") : TEXT("?");
+	Url += TEXT("measurement_id=") + FGenericPlatformHttp::UrlEncode(Options.MeasurementId);
+	Url += TEXT("&api_secret=") + FGenericPlatformHttp::UrlEncode(Options.ApiSecret);
+
+	ClientId = Options.ClientId;
+	if (ClientId.IsEmpty())
+	{
+		ClientId = FPlatformMisc::GetLoginId();
+	}
+	if (ClientId.IsEmpty())
+	{
+		ClientId = NewFirebaseAnalyticsHttpClientId();
+	}
+
+	ScanSpillDirectory();
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FFirebaseAnalyticsHttpBackend::Tick));
+}
+
+FFirebaseAnalyticsHttpBackend::~FFirebaseAnalyticsHttpBackend()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	FScopeLock Lock(&CriticalSection);
+	CloseBatch();
+
+	// Requests still in flight may or may not have arrived, sending them again next run is the lesser evil
+	for (TPair<FHttpRequestPtr, FPayload>& Pair : InFlight)
+	{
+		Pair.Key->OnProcessRequestComplete().Unbind();
+		Pair.Key->CancelRequest();
+		SpillPayload(Pair.Value);
+	}
+	InFlight.Empty();
+
+	for (const FPayload& Payload : Queue)
+	{
+		SpillPayload(Payload);
+	}
+	Queue.Empty();
+	QueuedBytes = 0;
+}
+
+void FFirebaseAnalyticsHttpBackend::LogEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	FScopeLock Lock(&CriticalSection);
+	AddEvent(Event);
+}
+
+void FFirebaseAnalyticsHttpBackend::LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+{
+	FScopeLock Lock(&CriticalSection);
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		AddEvent(Event);
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::ResetAnalyticsData()
+{
+	FScopeLock Lock(&CriticalSection);
+	CloseBatch();
+
+	ClientId = NewFirebaseAnalyticsHttpClientId();
+	UserId.Reset();
+	UserProperties.Reset();
+	DefaultParameters.Reset();
+}
+
+void FFirebaseAnalyticsHttpBackend::SetAnalyticsCollectionEnabled(bool bEnabled)
+{
+	FScopeLock Lock(&CriticalSection);
+	bCollectionEnabled = bEnabled;
+}
+
+void FFirebaseAnalyticsHttpBackend::SetSessionTimeoutDuration(int32 Milliseconds)
+{
+	// The Measurement Protocol has no sessions of its own
+}
+
+void FFirebaseAnalyticsHttpBackend::SetUserID(const FString& UserID)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (!UserId.Equals(UserID, ESearchCase::CaseSensitive))
+	{
+		CloseBatch();
+		UserId = UserID;
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::SetUserProperty(const FString& PropertyName, const FString& PropertyValue)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const FString* Current = UserProperties.Find(PropertyName);
+	if (PropertyValue.IsEmpty())
+	{
+		if (Current)
+		{
+			CloseBatch();
+			UserProperties.Remove(PropertyName);
+		}
+	}
+	else if (Current == nullptr || !Current->Equals(PropertyValue, ESearchCase::CaseSensitive))
+	{
+		CloseBatch();
+		UserProperties.Add(PropertyName, PropertyValue);
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::SetDefaultEventParameters(const FFlatBundle& Parameters)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	// Kept as ready "name":value members, merged into every event that doesn't set them itself
+	for (const FFirebaseAnalyticsParameter& Parameter : Parameters.GetParameters())
+	{
+		if (Parameter.Type == EFirebaseAnalyticsParameterType::Null)
+		{
+			DefaultParameters.Remove(Parameter.GetName());
+			continue;
+		}
+
+		FString Member;
+		AppendFirebaseAnalyticsParametersJson(Member, Parameters, MakeArrayView(&Parameter, 1));
+		DefaultParameters.Add(Parameter.GetName(), Member.Mid(1, Member.Len() - 2));
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::Flush()
+{
+	FScopeLock Lock(&CriticalSection);
+	CloseBatch();
+	StartRequests(FPlatformTime::Seconds());
+}
+
+int32 FFirebaseAnalyticsHttpBackend::GetNumPendingRequests() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Queue.Num() + InFlight.Num() + SpillFiles.Num() + (NumBatchEvents > 0 ? 1 : 0);
+}
+
+bool FFirebaseAnalyticsHttpBackend::Tick(float DeltaTime)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const double Now = FPlatformTime::Seconds();
+	if (NumBatchEvents > 0 && Now - BatchOpenedSeconds >= Options.BatchIntervalSeconds)
+	{
+		CloseBatch();
+	}
+
+	StartRequests(Now);
+	return true;
+}
+
+void FFirebaseAnalyticsHttpBackend::AddEvent(const FFirebaseAnalyticsEvent& Event)
+{
+	if (!bCollectionEnabled)
+	{
+		return;
+	}
+
+	if (NumBatchEvents == 0)
+	{
+		BatchOpenedSeconds = FPlatformTime::Seconds();
+		BatchTimestampMicros = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMicrosecond;
+	}
+	else
+	{
+		BatchEvents += TEXT(',');
+	}
+
+	ParametersJson.Reset();
+	AppendFirebaseAnalyticsParametersJson(ParametersJson, Event.Parameters, Event.Parameters.GetParameters());
+
+	if (DefaultParameters.Num() > 0)
+	{
+		ParametersJson.LeftChopInline(1, false);
+		for (const TPair<FString, FString>& Default : DefaultParameters)
+		{
+			const bool bOverridden = Event.Parameters.GetParameters().ContainsByPredicate(
+				[&Default](const FFirebaseAnalyticsParameter& Parameter) { return Parameter.HasName(*Default.Key); });
+			if (!bOverridden)
+			{
+				if (ParametersJson.Len() > 1)
+				{
+					ParametersJson += TEXT(',');
+				}
+				ParametersJson += Default.Value;
+			}
+		}
+		ParametersJson += TEXT('}');
+	}
+
+	BatchEvents += TEXT("{\"name\":");
+	AppendFirebaseAnalyticsJsonString(BatchEvents, *Event.Name);
+	BatchEvents += TEXT(",\"params\":");
+	BatchEvents += ParametersJson;
+	BatchEvents += TEXT('}');
+
+	if (++NumBatchEvents >= Options.MaxEventsPerRequest)
+	{
+		CloseBatch();
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::CloseBatch()
+{
+	if (NumBatchEvents == 0)
+	{
+		return;
+	}
+
+	FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(STAT_FirebaseAnalytics_BuildHttpRequest);
+
+	FString Json;
+	Json.Reserve(BatchEvents.Len() + 256);
+	Json += TEXT("{\"client_id\":");
+	AppendFirebaseAnalyticsJsonString(Json, *ClientId);
+	if (!UserId.IsEmpty())
+	{
+		Json += TEXT(",\"user_id\":");
+		AppendFirebaseAnalyticsJsonString(Json, *UserId);
+	}
+	Json += FString::Printf(TEXT(",\"timestamp_micros\":%lld"), (long long)BatchTimestampMicros);
+
+	if (UserProperties.Num() > 0)
+	{
+		Json += TEXT(",\"user_properties\":{");
+		bool bFirst = true;
+		for (const TPair<FString, FString>& Property : UserProperties)
+		{
+			if (!bFirst)
+			{
+				Json += TEXT(',');
+			}
+			bFirst = false;
+
+			AppendFirebaseAnalyticsJsonString(Json, *Property.Key);
+			Json += TEXT(":{\"value\":");
+			AppendFirebaseAnalyticsJsonString(Json, *Property.Value);
+			Json += TEXT('}');
+		}
+		Json += TEXT('}');
+	}
+
+	Json += TEXT(",\"events\":[");
+	Json += BatchEvents;
+	Json += TEXT("]}");
+
+	FPayload Payload;
+	Payload.NumEvents = NumBatchEvents;
+
+	FTCHARToUTF8 Utf8(*Json);
+	if (Options.bGzip)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Gzip, Utf8.Length());
+		Payload.Body.SetNumUninitialized(CompressedSize);
+		Payload.bGzipped = FCompression::CompressMemory(NAME_Gzip, Payload.Body.GetData(), CompressedSize, Utf8.Get(), Utf8.Length());
+		Payload.Body.SetNum(Payload.bGzipped ? CompressedSize : 0, false);
+	}
+	if (!Payload.bGzipped)
+	{
+		Payload.Body.Append((const uint8*)Utf8.Get(), Utf8.Length());
+	}
+
+	FIREBASE_ANALYTICS_RECORD_BYTES(Payload.Body.Num());
+
+	BatchEvents.Reset();
+	NumBatchEvents = 0;
+
+	EnqueuePayload(MoveTemp(Payload));
+}
+
+void FFirebaseAnalyticsHttpBackend::EnqueuePayload(FPayload&& Payload)
+{
+	QueuedBytes += Payload.Body.Num();
+	Queue.Add(MoveTemp(Payload));
+	TrimQueue();
+}
+
+void FFirebaseAnalyticsHttpBackend::TrimQueue()
+{
+	// The newest payloads go, the ones in memory are the ones sent next
+	while (QueuedBytes > Options.MaxQueuedBytes && Queue.Num() > 1)
+	{
+		FPayload Payload = Queue.Pop(false);
+		QueuedBytes -= Payload.Body.Num();
+		SpillPayload(Payload);
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::StartRequests(double Now)
+{
+	while (InFlight.Num() < Options.MaxConcurrentRequests)
+	{
+		while (Queue.Num() == 0 && SpillFiles.Num() > 0)
+		{
+			LoadSpilledPayload();
+		}
+
+		const int32 PayloadIdx = Queue.IndexOfByPredicate([Now](const FPayload& Payload) { return Payload.NextAttemptSeconds <= Now; });
+		if (PayloadIdx == INDEX_NONE)
+		{
+			break;
+		}
+
+		FPayload Payload = MoveTemp(Queue[PayloadIdx]);
+		Queue.RemoveAt(PayloadIdx, 1, false);
+		QueuedBytes -= Payload.Body.Num();
+
+		TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = FHttpModule::Get().CreateRequest();
+		Request->SetURL(Url);
+		Request->SetVerb(TEXT("POST"));
+		Request->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+		Request->SetHeader(TEXT("Connection"), TEXT("keep-alive"));
+		if (Payload.bGzipped)
+		{
+			Request->SetHeader(TEXT("Content-Encoding"), TEXT("gzip"));
+		}
+		Request->SetContent(Payload.Body);
+		Request->OnProcessRequestComplete().BindRaw(this, &FFirebaseAnalyticsHttpBackend::OnRequestComplete);
+
+		InFlight.Emplace(Request, MoveTemp(Payload));
+
+		// A request that can't even start may or may not have completed already, whatever is left is handled here
+		if (!Request->ProcessRequest())
+		{
+			const int32 InFlightIdx = InFlight.IndexOfByPredicate(
+				[&Request](const TPair<FHttpRequestPtr, FPayload>& Pair) { return Pair.Key == Request; });
+			if (InFlightIdx != INDEX_NONE)
+			{
+				FPayload Failed = MoveTemp(InFlight[InFlightIdx].Value);
+				InFlight.RemoveAtSwap(InFlightIdx);
+				RetryOrDrop(MoveTemp(Failed), 0, 0.0);
+			}
+		}
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bConnectedSuccessfully)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 InFlightIdx = InFlight.IndexOfByPredicate(
+		[&Request](const TPair<FHttpRequestPtr, FPayload>& Pair) { return Pair.Key == Request; });
+	if (InFlightIdx == INDEX_NONE)
+	{
+		return;
+	}
+
+	FPayload Payload = MoveTemp(InFlight[InFlightIdx].Value);
+	InFlight.RemoveAtSwap(InFlightIdx);
+
+	const int32 ResponseCode = bConnectedSuccessfully && Response.IsValid() ? Response->GetResponseCode() : 0;
+	if (!EHttpResponseCodes::IsOk(ResponseCode))
+	{
+		const double RetryAfterSeconds = Response.IsValid() ? FCString::Atod(*Response->GetHeader(TEXT("Retry-After"))) : 0.0;
+		RetryOrDrop(MoveTemp(Payload), ResponseCode, RetryAfterSeconds);
+	}
+
+	// The connection this request used is free again
+	StartRequests(FPlatformTime::Seconds());
+}
+
+void FFirebaseAnalyticsHttpBackend::RetryOrDrop(FPayload&& Payload, int32 ResponseCode, double RetryAfterSeconds)
+{
+	// No response, request timeout, throttling and server errors may go through later, other errors won't
+	const bool bRetryable = ResponseCode == 0 || ResponseCode == 408 || ResponseCode == 429 || ResponseCode >= 500;
+	if (!bRetryable || Payload.NumRetries >= Options.MaxRetries)
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Dropping %d Firebase Analytics events after %d retries, HTTP status %d"),
+			Payload.NumEvents, Payload.NumRetries, ResponseCode);
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Payload.NumEvents);
+		return;
+	}
+
+	// Equal jitter: half of the backoff is kept, the other half is random so a failed burst doesn't retry in step
+	const double Backoff = FMath::Min(
+		(double)Options.RetryBaseDelaySeconds * FMath::Pow(2.0f, (float)Payload.NumRetries),
+		(double)Options.RetryMaxDelaySeconds);
+	const double DelaySeconds = FMath::Max(
+		Backoff * (0.5 + 0.5 * FMath::FRand()),
+		FMath::Min(RetryAfterSeconds, (double)Options.RetryMaxDelaySeconds));
+
+	Payload.NumRetries++;
+	Payload.NextAttemptSeconds = FPlatformTime::Seconds() + DelaySeconds;
+
+	// Back in front, so the retry keeps its place ahead of newer payloads
+	QueuedBytes += Payload.Body.Num();
+	Queue.Insert(MoveTemp(Payload), 0);
+	TrimQueue();
+}
+
+void FFirebaseAnalyticsHttpBackend::ScanSpillDirectory()
+{
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Options.SpillDirectory / (FString(HttpSpillFilePrefix) + TEXT("*"))), true, false);
+
+	// Names carry the spill time, so they sort oldest first
+	Files.Sort();
+	for (const FString& File : Files)
+	{
+		// Request-<ticks>-<events>.json[.gz]
+		FString Stem;
+		FString EventsCount;
+		File.Split(TEXT("."), &Stem, nullptr);
+		Stem.Split(TEXT("-"), nullptr, &EventsCount, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+
+		FSpillFile& SpillFile = SpillFiles.AddDefaulted_GetRef();
+		SpillFile.Filename = Options.SpillDirectory / File;
+		SpillFile.Size = IFileManager::Get().FileSize(*SpillFile.Filename);
+		SpillFile.NumEvents = FCString::Atoi(*EventsCount);
+		SpillBytes += FMath::Max<int64>(SpillFile.Size, 0);
+	}
+
+	if (SpillFiles.Num() > 0)
+	{
+		UE_LOG(LogFirebaseAnalytics, Log, TEXT("Found %d spilled Firebase Analytics requests in %s"), SpillFiles.Num(), *Options.SpillDirectory);
+	}
+}
+
+void FFirebaseAnalyticsHttpBackend::SpillPayload(const FPayload& Payload)
+{
+	const int64 Size = Payload.Body.Num();
+	if (Size > Options.MaxSpillBytes)
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Payload.NumEvents);
+		return;
+	}
+
+	while (SpillBytes + Size > Options.MaxSpillBytes && SpillFiles.Num() > 0)
+	{
+		const FSpillFile Oldest = SpillFiles[0];
+		SpillFiles.RemoveAt(0, 1, false);
+		SpillBytes -= Oldest.Size;
+
+		IFileManager::Get().Delete(*Oldest.Filename);
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Oldest.NumEvents);
+	}
+
+	LastSpillTicks = FMath::Max(FDateTime::UtcNow().GetTicks(), LastSpillTicks + 1);
+
+	FSpillFile SpillFile;
+	SpillFile.Filename = Options.SpillDirectory / FString::Printf(TEXT("%s%020lld-%d%s"),
+		HttpSpillFilePrefix, (long long)LastSpillTicks, Payload.NumEvents, Payload.bGzipped ? TEXT(".json.gz") : TEXT(".json"));
+	SpillFile.Size = Size;
+	SpillFile.NumEvents = Payload.NumEvents;
+
+	if (!FFileHelper::SaveArrayToFile(Payload.Body, *SpillFile.Filename))
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Can't spill Firebase Analytics request to %s, %d events are discarded"),
+			*SpillFile.Filename, Payload.NumEvents);
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(Payload.NumEvents);
+		return;
+	}
+
+	SpillBytes += Size;
+	SpillFiles.Add(MoveTemp(SpillFile));
+}
+
+bool FFirebaseAnalyticsHttpBackend::LoadSpilledPayload()
+{
+	const FSpillFile SpillFile = SpillFiles[0];
+	SpillFiles.RemoveAt(0, 1, false);
+	SpillBytes -= FMath::Max<int64>(SpillFile.Size, 0);
+
+	FPayload Payload;
+	Payload.NumEvents = SpillFile.NumEvents;
+	Payload.bGzipped = SpillFile.Filename.EndsWith(TEXT(".gz"));
+	const bool bLoaded = FFileHelper::LoadFileToArray(Payload.Body, *SpillFile.Filename, FILEREAD_Silent);
+	IFileManager::Get().Delete(*SpillFile.Filename);
+
+	if (!bLoaded || Payload.Body.Num() == 0)
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(SpillFile.NumEvents);
+		return false;
+	}
+
+	QueuedBytes += Payload.Body.Num();
+	Queue.Add(MoveTemp(Payload));
+	return true;
+}
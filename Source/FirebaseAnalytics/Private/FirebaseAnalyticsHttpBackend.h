@@ -0,0 +1,139 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+#include "FirebaseAnalyticsBackend.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+
+struct FFirebaseAnalyticsHttpOptions
+{
+	/** Measurement Protocol endpoint, the measurement id and API secret are added as query parameters. */
+	FString Endpoint;
+	FString MeasurementId;
+	FString ApiSecret;
+
+	/** Sent as client_id of every request. */
+	FString ClientId;
+
+	int32 MaxEventsPerRequest = 25;
+	float BatchIntervalSeconds = 1.0f;
+	int32 MaxConcurrentRequests = 2;
+	bool bGzip = true;
+
+	int32 MaxRetries = 5;
+	float RetryBaseDelaySeconds = 1.0f;
+	float RetryMaxDelaySeconds = 60.0f;
+
+	/** Request bodies kept in memory, past this the newest ones go to SpillDirectory. */
+	int64 MaxQueuedBytes = 512 * 1024;
+
+	FString SpillDirectory;
+
+	/** Size cap of SpillDirectory, the oldest bodies are dropped past it. 0 drops instead of spilling. */
+	int64 MaxSpillBytes = 16 * 1024 * 1024;
+};
+
+/** Posts events to a Measurement Protocol endpoint, meant for dedicated servers.
+ *
+ *	Events are batched into one JSON body per request, together with the user id and user properties current when
+ *	they were logged, and gzipped. Requests are started and completed on the game thread by a core ticker, at most
+ *	MaxConcurrentRequests at a time so the HTTP module keeps reusing the same few connections. Failed requests are
+ *	retried with jittered exponential backoff, bodies that don't fit in memory are spilled to disk and sent once the
+ *	queue drains, and whatever is still unsent on shutdown is spilled for the next run.
+ */
+class FFirebaseAnalyticsHttpBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	explicit FFirebaseAnalyticsHttpBackend(const FFirebaseAnalyticsHttpOptions& InOptions);
+	virtual ~FFirebaseAnalyticsHttpBackend();
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	/** Close the open batch and start as many requests as the concurrency limit allows. Game thread only. */
+	void Flush();
+
+	/** Number of requests waiting in memory, on disk and in flight. */
+	int32 GetNumPendingRequests() const;
+
+private:
+	struct FPayload
+	{
+		TArray<uint8> Body;
+		bool bGzipped = false;
+		int32 NumEvents = 0;
+		int32 NumRetries = 0;
+		double NextAttemptSeconds = 0.0;
+	};
+
+	struct FSpillFile
+	{
+		FString Filename;
+		int64 Size = 0;
+		int32 NumEvents = 0;
+	};
+
+	bool Tick(float DeltaTime);
+
+	void AddEvent(const FFirebaseAnalyticsEvent& Event);
+
+	/** Turn the open batch into a payload. Called with CriticalSection held, as are all the helpers below. */
+	void CloseBatch();
+	void EnqueuePayload(FPayload&& Payload);
+	void StartRequests(double Now);
+	void OnRequestComplete(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bConnectedSuccessfully);
+	void RetryOrDrop(FPayload&& Payload, int32 ResponseCode, double RetryAfterSeconds);
+	void TrimQueue();
+
+	void ScanSpillDirectory();
+	void SpillPayload(const FPayload& Payload);
+	bool LoadSpilledPayload();
+
+	FFirebaseAnalyticsHttpOptions Options;
+	FString Url;
+
+	mutable FCriticalSection CriticalSection;
+
+	// User context stamped on every batch, a change closes the open one
+	FString ClientId;
+	FString UserId;
+	TFirebaseAnalyticsNameMap<FString> UserProperties;
+	TFirebaseAnalyticsNameMap<FString> DefaultParameters;
+	bool bCollectionEnabled = true;
+
+	// Open batch, the JSON of its events without the enclosing brackets
+	FString BatchEvents;
+	int32 NumBatchEvents = 0;
+	double BatchOpenedSeconds = 0.0;
+	int64 BatchTimestampMicros = 0;
+
+	// Reused between events
+	FString ParametersJson;
+
+	// Payloads waiting to be sent, oldest first
+	TArray<FPayload> Queue;
+	int64 QueuedBytes = 0;
+
+	TArray<TPair<FHttpRequestPtr, FPayload>> InFlight;
+
+	// Spilled payloads, oldest first
+	TArray<FSpillFile> SpillFiles;
+	int64 SpillBytes = 0;
+	int64 LastSpillTicks = 0;
+
+	FDelegateHandle TickerHandle;
+};
+
+/** Options from UFirebaseAnalyticsSettings. */
+FFirebaseAnalyticsHttpOptions GetFirebaseAnalyticsHttpOptions();
@@ -0,0 +1,179 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsHttpStubCommandlet.h"
+#include "FirebaseAnalyticsLog.h"
+
+#if WITH_FIREBASE_ANALYTICS_HTTP_STUB
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Misc/Compression.h"
+#include "Misc/DateTime.h"
+
+struct FFirebaseAnalyticsHttpStubResponse
+{
+	double DueSeconds = 0.0;
+	int32 Status = 0;
+	FHttpResultCallback OnComplete;
+};
+
+static bool UncompressFirebaseAnalyticsGzip(const TArray<uint8>& Compressed, TArray<uint8>& OutUncompressed)
+{
+	// The gzip trailer ends with the uncompressed size, modulo 2^32
+	if (Compressed.Num() < 18)
+	{
+		return false;
+	}
+
+	const uint8* Trailer = Compressed.GetData() + Compressed.Num() - 4;
+	const int32 UncompressedSize = (int32)(Trailer[0] | (Trailer[1] << 8) | (Trailer[2] << 16) | ((uint32)Trailer[3] << 24));
+	OutUncompressed.SetNumUninitialized(UncompressedSize);
+	return FCompression::UncompressMemory(NAME_Gzip, OutUncompressed.GetData(), UncompressedSize, Compressed.GetData(), Compressed.Num());
+}
+#endif
+
+UFirebaseAnalyticsHttpStubCommandlet::UFirebaseAnalyticsHttpStubCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UFirebaseAnalyticsHttpStubCommandlet::Main(const FString& Params)
+{
+#if WITH_FIREBASE_ANALYTICS_HTTP_STUB
+	int32 Port = 8080;
+	FString Path = TEXT("/mp/collect");
+	int32 LatencyMilliseconds = 0;
+	int32 JitterMilliseconds = 0;
+	float FailureRate = 0.0f;
+	int32 FailureStatus = 503;
+	float DurationSeconds = 0.0f;
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Path="), Path);
+	FParse::Value(*Params, TEXT("Latency="), LatencyMilliseconds);
+	FParse::Value(*Params, TEXT("Jitter="), JitterMilliseconds);
+	FParse::Value(*Params, TEXT("FailureRate="), FailureRate);
+	FParse::Value(*Params, TEXT("FailureStatus="), FailureStatus);
+	FParse::Value(*Params, TEXT("Duration="), DurationSeconds);
+
+	TUniquePtr<FArchive> Out;
+	FString OutFilename;
+	if (FParse::Value(*Params, TEXT("Out="), OutFilename))
+	{
+		Out.Reset(IFileManager::Get().CreateFileWriter(*OutFilename, FILEWRITE_AllowRead));
+		if (!Out)
+		{
+			UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't write %s"), *OutFilename);
+			return 1;
+		}
+	}
+
+	TSharedPtr<IHttpRouter> Router = FHttpServerModule::Get().GetHttpRouter(Port);
+	if (!Router.IsValid())
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't listen on port %d"), Port);
+		return 1;
+	}
+
+	TArray<FFirebaseAnalyticsHttpStubResponse> Pending;
+	int64 NumRequests = 0;
+	int64 NumFailed = 0;
+	int64 NumBytes = 0;
+	int64 NumUncompressedBytes = 0;
+	TArray<uint8> Uncompressed;
+
+	FHttpRouteHandle RouteHandle = Router->BindRoute(FHttpPath(Path), EHttpServerRequestVerbs::VERB_POST,
+		[&](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+		{
+			NumRequests++;
+			NumBytes += Request.Body.Num();
+
+			const TArray<FString>* Encoding = Request.Headers.Find(TEXT("Content-Encoding"));
+			const bool bGzipped = Encoding && Encoding->Contains(TEXT("gzip"));
+			const TArray<uint8>* Body = &Request.Body;
+			if (bGzipped)
+			{
+				Body = UncompressFirebaseAnalyticsGzip(Request.Body, Uncompressed) ? &Uncompressed : nullptr;
+			}
+
+			FFirebaseAnalyticsHttpStubResponse& Response = Pending.AddDefaulted_GetRef();
+			Response.DueSeconds = FPlatformTime::Seconds() + (LatencyMilliseconds + FMath::RandRange(0, FMath::Max(JitterMilliseconds, 0))) / 1000.0;
+			Response.Status = Body == nullptr ? 400 : FMath::FRand() < FailureRate ? FailureStatus : 204;
+			Response.OnComplete = OnComplete;
+
+			if (Response.Status != 204)
+			{
+				NumFailed++;
+			}
+
+			if (Body)
+			{
+				NumUncompressedBytes += Body->Num();
+				if (Out)
+				{
+					const FString Header = FString::Printf(TEXT("{\"time\":\"%s\",\"gzip\":%s,\"bytes\":%d,\"status\":%d,\"body\":"),
+						*FDateTime::UtcNow().ToIso8601(), bGzipped ? TEXT("true") : TEXT("false"), Request.Body.Num(), Response.Status);
+					FTCHARToUTF8 Utf8Header(*Header, Header.Len());
+					Out->Serialize((void*)Utf8Header.Get(), Utf8Header.Length());
+					Out->Serialize((void*)Body->GetData(), Body->Num());
+					Out->Serialize((void*)"}\n", 2);
+					Out->Flush();
+				}
+			}
+			return true;
+		});
+
+	if (!RouteHandle.IsValid())
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't bind %s on port %d"), *Path, Port);
+		return 1;
+	}
+
+	FHttpServerModule::Get().StartAllListeners();
+	UE_LOG(LogFirebaseAnalytics, Display, TEXT("Listening on http://localhost:%d%s, latency %d+%d ms, failure rate %.2f"),
+		Port, *Path, LatencyMilliseconds, JitterMilliseconds, FailureRate);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	double LastSeconds = StartSeconds;
+	while (!IsEngineExitRequested() && (DurationSeconds <= 0.0f || LastSeconds - StartSeconds < DurationSeconds))
+	{
+		const double Now = FPlatformTime::Seconds();
+		FTicker::GetCoreTicker().Tick(Now - LastSeconds);
+		LastSeconds = Now;
+
+		for (int32 ResponseIdx = 0; ResponseIdx < Pending.Num(); )
+		{
+			if (Pending[ResponseIdx].DueSeconds > Now)
+			{
+				ResponseIdx++;
+				continue;
+			}
+
+			TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
+			Response->Code = (EHttpServerResponseCodes)Pending[ResponseIdx].Status;
+			Pending[ResponseIdx].OnComplete(MoveTemp(Response));
+			Pending.RemoveAtSwap(ResponseIdx);
+		}
+
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	Router->UnbindRoute(RouteHandle);
+	FHttpServerModule::Get().StopAllListeners();
+
+	UE_LOG(LogFirebaseAnalytics, Display, TEXT("%lld requests, %lld failed, %lld bytes received, %lld uncompressed"),
+		NumRequests, NumFailed, NumBytes, NumUncompressedBytes);
+	return 0;
+#else
+	UE_LOG(LogFirebaseAnalytics, Error, TEXT("The HTTP stub is only built for desktop platforms outside Shipping"));
+	return 1;
+#endif
+}
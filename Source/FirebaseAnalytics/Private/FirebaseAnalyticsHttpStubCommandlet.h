@@ -0,0 +1,26 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FirebaseAnalyticsHttpStubCommandlet.generated.h"
+
+/** Local Measurement Protocol endpoint to test the Http backend against, desktop platforms outside Shipping only:
+ *	UE4Editor-Cmd <Project> -run=FirebaseAnalyticsHttpStub [-Port=8080] [-Path=/mp/collect] [-Latency=<ms>] [-Jitter=<ms>]
+ *		[-FailureRate=<0..1>] [-FailureStatus=503] [-Duration=<seconds>] [-Out=<path>]
+ *	Point HttpEndpoint at http://localhost:<Port><Path>. Every request body is gunzipped and recorded one JSON object
+ *	per line, responses are delayed by Latency plus up to Jitter and a FailureRate share of them fail with FailureStatus.
+ */
+UCLASS()
+class UFirebaseAnalyticsHttpStubCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFirebaseAnalyticsHttpStubCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
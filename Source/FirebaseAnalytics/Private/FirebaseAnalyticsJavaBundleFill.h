@@ -0,0 +1,101 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+/** Put Parameters into JBundle inside a local frame of their own.
+ *	Names and values are plain local refs freed by the frame, and every item bundle gets a nested frame,
+ *	so the local ref table holds one bundle level at a time however many items there are.
+ *
+ *	All JNI goes through WriterType, which lets the local ref discipline be checked off-device. WriterType must provide:
+ *		typedef ... ObjectType;											// default constructed value is null
+ *		typedef ... FrameType;											// FrameType(WriterType&, int32 Capacity) pushes a local frame, its destructor pops it
+ *		ObjectType NewName(const FFirebaseAnalyticsParameter& Parameter);
+ *		ObjectType NewString(const FString& Value);
+ *		void PutString(ObjectType Bundle, ObjectType Name, ObjectType Value);
+ *		void PutFloat(ObjectType Bundle, ObjectType Name, float Value);	// and PutDouble, PutInteger, PutLong alike
+ *		bool PutItemsByColumn(ObjectType Bundle, ObjectType Name, const FFlatBundle& Bundle, const FFirebaseAnalyticsParameter& Parameter);
+ *		ObjectType NewItemBundle();
+ *		ObjectType NewItemArray(int32 Length);
+ *		void SetItem(ObjectType Array, int32 ItemIdx, ObjectType ItemBundle);
+ *		void PutItemArray(ObjectType Bundle, ObjectType Name, ObjectType Array);
+ *		void ReleaseItem(ObjectType Object);							// object already stored in its parent
+ */
+template <typename WriterType>
+void FillFirebaseAnalyticsJavaBundle(
+	WriterType& Writer,
+	typename WriterType::ObjectType JBundle,
+	const FFlatBundle& Bundle,
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters)
+{
+	typedef typename WriterType::ObjectType ObjectType;
+
+	// Name and value of every parameter, plus the array and the current item of a bundles parameter
+	typename WriterType::FrameType Frame(Writer, Parameters.Num() * 2 + 2);
+
+	for (const FFirebaseAnalyticsParameter& Parameter : Parameters)
+	{
+		ObjectType JParameterName = Writer.NewName(Parameter);
+		switch (Parameter.Type)
+		{
+			case EFirebaseAnalyticsParameterType::String:
+			{
+				Writer.PutString(JBundle, JParameterName, Writer.NewString(Parameter.StringValue));
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Float:
+			{
+				Writer.PutFloat(JBundle, JParameterName, Parameter.FloatValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Double:
+			{
+				Writer.PutDouble(JBundle, JParameterName, Parameter.DoubleValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Integer:
+			{
+				Writer.PutInteger(JBundle, JParameterName, Parameter.IntegerValue);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Int64:
+			{
+				Writer.PutLong(JBundle, JParameterName, Parameter.Int64Value);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Bundles:
+			{
+				const int32 NumItems = Parameter.Items.Num;
+
+				// Several items with the same layout, e.g. from FFlatBundle::PutItems, may go over as columns
+				if (Writer.PutItemsByColumn(JBundle, JParameterName, Bundle, Parameter))
+				{
+					break;
+				}
+
+				// Each item bundle is created out here, so its nested frame can't free it
+				ObjectType JItemArray = Writer.NewItemArray(NumItems);
+				for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+				{
+					ObjectType JItemBundle = Writer.NewItemBundle();
+					FillFirebaseAnalyticsJavaBundle(Writer, JItemBundle, Bundle, Bundle.GetItemParameters(Parameter, ItemIdx));
+
+					Writer.SetItem(JItemArray, ItemIdx, JItemBundle);
+					Writer.ReleaseItem(JItemBundle);
+				}
+
+				Writer.PutItemArray(JBundle, JParameterName, JItemArray);
+				Writer.ReleaseItem(JItemArray);
+				break;
+			}
+			case EFirebaseAnalyticsParameterType::Null:
+			{
+				// A null value is how setDefaultEventParameters clears a key
+				Writer.PutString(JBundle, JParameterName, ObjectType());
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,284 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsJournal.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsStats.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+
+static constexpr uint32 FirebaseAnalyticsJournalMagic = 0x4A414646;			// "FFAJ"
+static constexpr uint32 FirebaseAnalyticsJournalVersion = 1;
+static constexpr uint32 FirebaseAnalyticsJournalRecordMagic = 0x52414646;		// "FFAR"
+static constexpr uint32 FirebaseAnalyticsJournalPaddingMagic = 0x50414646;		// "FFAP"
+static constexpr uint32 FirebaseAnalyticsJournalAcknowledged = 1 << 0;
+static constexpr int64 FirebaseAnalyticsJournalFileHeaderSize = 64;
+static constexpr int64 FirebaseAnalyticsJournalAlignment = 8;
+static constexpr int64 FirebaseAnalyticsJournalMinCapacity = 4096;
+
+struct FFirebaseAnalyticsJournalFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint64 NextSequence;
+};
+
+struct FFirebaseAnalyticsJournalRecordHeader
+{
+	uint32 Magic;
+	uint32 PayloadSize;
+	uint64 Sequence;
+	uint32 Crc;
+
+	/** Not covered by Crc, flipped in place on acknowledgement. */
+	uint32 Flags;
+};
+
+static_assert(sizeof(FFirebaseAnalyticsJournalRecordHeader) % FirebaseAnalyticsJournalAlignment == 0, "Record headers must keep records aligned.");
+
+static int64 GetJournalRecordSize(uint32 PayloadSize)
+{
+	return Align(sizeof(FFirebaseAnalyticsJournalRecordHeader) + PayloadSize, FirebaseAnalyticsJournalAlignment);
+}
+
+static uint32 ComputeJournalRecordCrc(const FFirebaseAnalyticsJournalRecordHeader& Header)
+{
+	uint32 Crc = FCrc::MemCrc32(&Header.Sequence, sizeof(Header.Sequence));
+	Crc = FCrc::MemCrc32(&Header.PayloadSize, sizeof(Header.PayloadSize), Crc);
+	return FCrc::MemCrc32(&Header + 1, Header.PayloadSize, Crc);
+}
+
+FFirebaseAnalyticsJournal::FFirebaseAnalyticsJournal(const FString& InFilename, int64 InSize)
+	: Filename(InFilename)
+	, RequestedSize(FirebaseAnalyticsJournalFileHeaderSize + Align(FMath::Max(InSize, FirebaseAnalyticsJournalMinCapacity), FirebaseAnalyticsJournalAlignment))
+{
+}
+
+FFirebaseAnalyticsJournal::~FFirebaseAnalyticsJournal()
+{
+	Close();
+}
+
+bool FFirebaseAnalyticsJournal::Open(TArray<FFirebaseAnalyticsEvent>& OutPendingEvents)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!File.Open(Filename, RequestedSize))
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Firebase Analytics journal can't map %s, events won't be journaled"), *Filename);
+		return false;
+	}
+
+	FFirebaseAnalyticsJournalFileHeader* FileHeader = (FFirebaseAnalyticsJournalFileHeader*)File.GetData();
+	if (FileHeader->Magic != FirebaseAnalyticsJournalMagic || FileHeader->Version != FirebaseAnalyticsJournalVersion)
+	{
+		// New file or an unknown layout, nothing worth replaying
+		FMemory::Memzero(File.GetData(), File.GetSize());
+		FileHeader->Magic = FirebaseAnalyticsJournalMagic;
+		FileHeader->Version = FirebaseAnalyticsJournalVersion;
+		FileHeader->NextSequence = 1;
+		Head = 0;
+		Tail = 0;
+		return true;
+	}
+
+	struct FPendingRecord
+	{
+		uint64 Sequence;
+		int64 Position;
+	};
+
+	// The ring has no reliable start after a crash, so walk all of it and let the checksums decide
+	TArray<FPendingRecord> PendingRecords;
+	const int64 Capacity = GetCapacity();
+	int64 Position = 0;
+	while (Position + (int64)sizeof(FFirebaseAnalyticsJournalRecordHeader) <= Capacity)
+	{
+		const FFirebaseAnalyticsJournalRecordHeader* Record = GetRecordHeader(Position);
+		if (!IsRecordValid(*Record, Position))
+		{
+			Position += FirebaseAnalyticsJournalAlignment;
+			continue;
+		}
+
+		if ((Record->Flags & FirebaseAnalyticsJournalAcknowledged) == 0)
+		{
+			PendingRecords.Add({ Record->Sequence, Position });
+		}
+
+		FileHeader->NextSequence = FMath::Max(FileHeader->NextSequence, Record->Sequence + 1);
+		Position += GetJournalRecordSize(Record->PayloadSize);
+	}
+
+	PendingRecords.Sort([](const FPendingRecord& A, const FPendingRecord& B)
+	{
+		return A.Sequence < B.Sequence;
+	});
+
+	uint64 LastSequence = 0;
+	for (const FPendingRecord& PendingRecord : PendingRecords)
+	{
+		FFirebaseAnalyticsJournalRecordHeader* Record = GetRecordHeader(PendingRecord.Position);
+
+		// Survivors are handed to the caller and journaled again, so they're done here either way
+		Record->Flags |= FirebaseAnalyticsJournalAcknowledged;
+
+		if (PendingRecord.Sequence == LastSequence)
+		{
+			continue;
+		}
+		LastSequence = PendingRecord.Sequence;
+
+		FFirebaseAnalyticsBatchDecoder::Decode((const uint8*)(Record + 1), Record->PayloadSize, OutPendingEvents);
+	}
+
+	// Everything left in the file is acknowledged now, start over from the beginning of the ring
+	Head = 0;
+	Tail = 0;
+	return true;
+}
+
+void FFirebaseAnalyticsJournal::Close()
+{
+	FScopeLock Lock(&CriticalSection);
+	File.Close();
+}
+
+FFirebaseAnalyticsJournalRecord FFirebaseAnalyticsJournal::Append(const FFirebaseAnalyticsEvent& Event)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FFirebaseAnalyticsJournalRecord Result;
+	if (!File.IsOpen())
+	{
+		return Result;
+	}
+
+	Encoder.Reset();
+	Encoder.AddEvent(Event);
+
+	const int64 Capacity = GetCapacity();
+	const uint32 PayloadSize = (uint32)Encoder.GetSize();
+	const int64 RecordSize = GetJournalRecordSize(PayloadSize);
+	if (RecordSize > Capacity)
+	{
+		FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+		return Result;
+	}
+
+	// Records never wrap around the end of the ring, the rest of the lap becomes padding
+	const int64 RemainingInLap = Capacity - (int64)(Head % Capacity);
+	if (RecordSize > RemainingInLap)
+	{
+		MakeRoom(RemainingInLap);
+		if (RemainingInLap >= (int64)sizeof(FFirebaseAnalyticsJournalRecordHeader))
+		{
+			FFirebaseAnalyticsJournalRecordHeader* Padding = GetRecordHeader(Head % Capacity);
+			Padding->PayloadSize = (uint32)(RemainingInLap - sizeof(FFirebaseAnalyticsJournalRecordHeader));
+			Padding->Magic = FirebaseAnalyticsJournalPaddingMagic;
+		}
+		Head += RemainingInLap;
+	}
+
+	MakeRoom(RecordSize);
+
+	FFirebaseAnalyticsJournalFileHeader* FileHeader = (FFirebaseAnalyticsJournalFileHeader*)File.GetData();
+	const int64 Position = Head % Capacity;
+	FFirebaseAnalyticsJournalRecordHeader* Record = GetRecordHeader(Position);
+
+	// Invalidate the slot first, a record torn by a crash then fails the magic or the checksum
+	Record->Magic = 0;
+	FPlatformMisc::MemoryBarrier();
+
+	FMemory::Memcpy(Record + 1, Encoder.GetData(), PayloadSize);
+	Record->PayloadSize = PayloadSize;
+	Record->Sequence = FileHeader->NextSequence++;
+	Record->Flags = 0;
+	Record->Crc = ComputeJournalRecordCrc(*Record);
+	FPlatformMisc::MemoryBarrier();
+
+	Record->Magic = FirebaseAnalyticsJournalRecordMagic;
+
+	Head += RecordSize;
+
+	Result.Offset = (int32)Position;
+	Result.Sequence = Record->Sequence;
+	return Result;
+}
+
+void FFirebaseAnalyticsJournal::Acknowledge(TArrayView<const FFirebaseAnalyticsJournalRecord> Records)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!File.IsOpen())
+	{
+		return;
+	}
+
+	for (const FFirebaseAnalyticsJournalRecord& Record : Records)
+	{
+		if (!Record.IsValid())
+		{
+			continue;
+		}
+
+		// The slot may have been reclaimed and reused since, only flag the record we wrote
+		FFirebaseAnalyticsJournalRecordHeader* Header = GetRecordHeader(Record.Offset);
+		if (Header->Magic == FirebaseAnalyticsJournalRecordMagic && Header->Sequence == Record.Sequence)
+		{
+			Header->Flags |= FirebaseAnalyticsJournalAcknowledged;
+		}
+	}
+}
+
+uint8* FFirebaseAnalyticsJournal::GetRecords() const
+{
+	return File.GetData() + FirebaseAnalyticsJournalFileHeaderSize;
+}
+
+int64 FFirebaseAnalyticsJournal::GetCapacity() const
+{
+	return File.GetSize() - FirebaseAnalyticsJournalFileHeaderSize;
+}
+
+FFirebaseAnalyticsJournalRecordHeader* FFirebaseAnalyticsJournal::GetRecordHeader(int64 Position) const
+{
+	return (FFirebaseAnalyticsJournalRecordHeader*)(GetRecords() + Position);
+}
+
+bool FFirebaseAnalyticsJournal::IsRecordValid(const FFirebaseAnalyticsJournalRecordHeader& Header, int64 Position) const
+{
+	return Header.Magic == FirebaseAnalyticsJournalRecordMagic
+		&& Header.PayloadSize <= GetCapacity() - Position - (int64)sizeof(FFirebaseAnalyticsJournalRecordHeader)
+		&& Header.Crc == ComputeJournalRecordCrc(Header);
+}
+
+void FFirebaseAnalyticsJournal::MakeRoom(int64 Size)
+{
+	const int64 Capacity = GetCapacity();
+	while (Head + Size - Tail > (uint64)Capacity)
+	{
+		const int64 Position = Tail % Capacity;
+		const int64 RemainingInLap = Capacity - Position;
+		if (RemainingInLap < (int64)sizeof(FFirebaseAnalyticsJournalRecordHeader))
+		{
+			Tail += RemainingInLap;
+			continue;
+		}
+
+		const FFirebaseAnalyticsJournalRecordHeader* Record = GetRecordHeader(Position);
+		if (Record->Magic != FirebaseAnalyticsJournalRecordMagic)
+		{
+			// Padding, it always runs to the end of the lap
+			Tail += RemainingInLap;
+			continue;
+		}
+
+		if ((Record->Flags & FirebaseAnalyticsJournalAcknowledged) == 0)
+		{
+			UE_LOG(LogFirebaseAnalytics, Verbose, TEXT("Firebase Analytics journal is full, dropping unacknowledged record %llu"), Record->Sequence);
+			FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(1);
+		}
+
+		Tail += GetJournalRecordSize(Record->PayloadSize);
+	}
+}
@@ -0,0 +1,63 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsBatchCodec.h"
+#include "FirebaseAnalyticsEvent.h"
+#include "FirebaseAnalyticsMappedFile.h"
+
+struct FFirebaseAnalyticsJournalRecordHeader;
+
+/** Append-only ring of logged events in a memory-mapped file.
+ *
+ *	Every record carries a sequence number and a CRC, and gets an acknowledged flag once the
+ *	backend has taken the event. Records that are still unacknowledged when the process dies are
+ *	handed back by Open() on the next launch. Nothing is fsync'd, the mapping only protects
+ *	against the process going away, not the device.
+ *
+ *	Compaction: Open() takes the survivors out and starts from an empty ring, replayed events
+ *	are journaled again as new records. At runtime the writer reclaims the oldest records when
+ *	it runs out of room; unacknowledged ones lost that way are counted as dropped.
+ */
+class FFirebaseAnalyticsJournal
+{
+public:
+	FFirebaseAnalyticsJournal(const FString& InFilename, int64 InSize);
+	~FFirebaseAnalyticsJournal();
+
+	/** Map the journal and collect unacknowledged events from the previous run, oldest first. */
+	bool Open(TArray<FFirebaseAnalyticsEvent>& OutPendingEvents);
+	void Close();
+
+	bool IsOpen() const { return File.IsOpen(); }
+
+	/** Write Event to the journal. Returns an invalid record when the journal is closed or the event is too big. */
+	FFirebaseAnalyticsJournalRecord Append(const FFirebaseAnalyticsEvent& Event);
+
+	/** Flag delivered records so they are not replayed. Records already reclaimed are ignored. */
+	void Acknowledge(TArrayView<const FFirebaseAnalyticsJournalRecord> Records);
+	void Acknowledge(const FFirebaseAnalyticsJournalRecord& Record) { Acknowledge(MakeArrayView(&Record, 1)); }
+
+private:
+	uint8* GetRecords() const;
+	int64 GetCapacity() const;
+
+	FFirebaseAnalyticsJournalRecordHeader* GetRecordHeader(int64 Position) const;
+	bool IsRecordValid(const FFirebaseAnalyticsJournalRecordHeader& Header, int64 Position) const;
+
+	/** Retire records from the tail until Size bytes fit at the head. */
+	void MakeRoom(int64 Size);
+
+	FCriticalSection CriticalSection;
+	FString Filename;
+	int64 RequestedSize;
+	FFirebaseAnalyticsMappedFile File;
+
+	// Reused between appends
+	FFirebaseAnalyticsBatchEncoder Encoder;
+
+	// Monotonic byte positions, physical offsets are these modulo the capacity
+	uint64 Head = 0;
+	uint64 Tail = 0;
+};
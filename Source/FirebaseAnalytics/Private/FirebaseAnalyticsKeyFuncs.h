@@ -0,0 +1,28 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Firebase names are case sensitive, unlike the default FString key funcs of TMap. */
+template <typename ValueType>
+struct TFirebaseAnalyticsCaseSensitiveKeyFuncs : BaseKeyFuncs<TPair<FString, ValueType>, FString, false>
+{
+	static FORCEINLINE const FString& GetSetKey(const TPair<FString, ValueType>& Element)
+	{
+		return Element.Key;
+	}
+
+	static FORCEINLINE bool Matches(const FString& A, const FString& B)
+	{
+		return A.Equals(B, ESearchCase::CaseSensitive);
+	}
+
+	static FORCEINLINE uint32 GetKeyHash(const FString& Key)
+	{
+		return FCrc::StrCrc32(*Key);
+	}
+};
+
+template <typename ValueType>
+using TFirebaseAnalyticsNameMap = TMap<FString, ValueType, FDefaultSetAllocator, TFirebaseAnalyticsCaseSensitiveKeyFuncs<ValueType>>;
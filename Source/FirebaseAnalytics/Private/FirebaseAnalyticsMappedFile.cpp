@@ -0,0 +1,121 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsMappedFile.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC || PLATFORM_ANDROID
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define FIREBASE_ANALYTICS_POSIX_MAPPING 1
+#endif
+
+#ifndef FIREBASE_ANALYTICS_POSIX_MAPPING
+#define FIREBASE_ANALYTICS_POSIX_MAPPING 0
+#endif
+
+FFirebaseAnalyticsMappedFile::~FFirebaseAnalyticsMappedFile()
+{
+	Close();
+}
+
+bool FFirebaseAnalyticsMappedFile::Open(const FString& Filename, int64 InSize)
+{
+	Close();
+
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+	const FString AbsoluteFilename = IFileManager::Get().ConvertToAbsolutePathForExternalAppForWrite(*Filename);
+
+#if PLATFORM_WINDOWS
+	HANDLE File = ::CreateFileW(*AbsoluteFilename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+	FileSize.QuadPart = InSize;
+	if (!::SetFilePointerEx(File, FileSize, nullptr, FILE_BEGIN) || !::SetEndOfFile(File))
+	{
+		::CloseHandle(File);
+		return false;
+	}
+
+	HANDLE Mapping = ::CreateFileMappingW(File, nullptr, PAGE_READWRITE, FileSize.HighPart, FileSize.LowPart, nullptr);
+	if (Mapping == nullptr)
+	{
+		::CloseHandle(File);
+		return false;
+	}
+
+	void* View = ::MapViewOfFile(Mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)InSize);
+	if (View == nullptr)
+	{
+		::CloseHandle(Mapping);
+		::CloseHandle(File);
+		return false;
+	}
+
+	FileHandle = File;
+	MappingHandle = Mapping;
+	Data = (uint8*)View;
+	Size = InSize;
+	return true;
+#elif FIREBASE_ANALYTICS_POSIX_MAPPING
+	const int32 Descriptor = ::open(TCHAR_TO_UTF8(*AbsoluteFilename), O_RDWR | O_CREAT, 0644);
+	if (Descriptor < 0)
+	{
+		return false;
+	}
+
+	if (::ftruncate(Descriptor, (off_t)InSize) != 0)
+	{
+		::close(Descriptor);
+		return false;
+	}
+
+	void* View = ::mmap(nullptr, (size_t)InSize, PROT_READ | PROT_WRITE, MAP_SHARED, Descriptor, 0);
+	if (View == MAP_FAILED)
+	{
+		::close(Descriptor);
+		return false;
+	}
+
+	FileDescriptor = Descriptor;
+	Data = (uint8*)View;
+	Size = InSize;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FFirebaseAnalyticsMappedFile::Close()
+{
+	if (Data == nullptr)
+	{
+		return;
+	}
+
+#if PLATFORM_WINDOWS
+	::UnmapViewOfFile(Data);
+	::CloseHandle((HANDLE)MappingHandle);
+	::CloseHandle((HANDLE)FileHandle);
+	MappingHandle = nullptr;
+	FileHandle = nullptr;
+#elif FIREBASE_ANALYTICS_POSIX_MAPPING
+	::munmap(Data, (size_t)Size);
+	::close(FileDescriptor);
+	FileDescriptor = -1;
+#endif
+
+	Data = nullptr;
+	Size = 0;
+}
+
+#undef FIREBASE_ANALYTICS_POSIX_MAPPING
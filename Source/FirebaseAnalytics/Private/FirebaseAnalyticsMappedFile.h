@@ -0,0 +1,37 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Read-write shared mapping of a whole file. Writes reach the page cache right away
+ *	and survive the process being killed; nothing here forces them to disk.
+ */
+class FFirebaseAnalyticsMappedFile
+{
+public:
+	FFirebaseAnalyticsMappedFile() = default;
+	~FFirebaseAnalyticsMappedFile();
+
+	FFirebaseAnalyticsMappedFile(const FFirebaseAnalyticsMappedFile&) = delete;
+	FFirebaseAnalyticsMappedFile& operator=(const FFirebaseAnalyticsMappedFile&) = delete;
+
+	/** Create or open Filename, resize it to Size bytes and map it. New bytes read as zero. */
+	bool Open(const FString& Filename, int64 Size);
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+	uint8* GetData() const { return Data; }
+	int64 GetSize() const { return Size; }
+
+private:
+	uint8* Data = nullptr;
+	int64 Size = 0;
+
+#if PLATFORM_WINDOWS
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#else
+	int32 FileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,178 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsMetrics.h"
+#include "FirebaseAnalyticsStats.h"
+#include "HAL/PlatformTLS.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/TypeHash.h"
+
+// Control characters can't appear in Firebase names, so they keep series keys unambiguous
+static constexpr TCHAR MetricKeyDimensionSeparator = TEXT('\x1E');
+static constexpr TCHAR MetricKeyValueSeparator = TEXT('\x1F');
+
+FFirebaseAnalyticsMetrics::FFirebaseAnalyticsMetrics(int32 InMaxSeriesPerShard, double InRelativeAccuracy)
+	: MaxSeriesPerShard(FMath::Max(InMaxSeriesPerShard, 1))
+	, RelativeAccuracy(InRelativeAccuracy)
+{
+}
+
+void FFirebaseAnalyticsMetrics::Record(const FString& Metric, double Value)
+{
+	FDimensionRefs Dimensions;
+	Record(Metric, Value, Dimensions);
+}
+
+void FFirebaseAnalyticsMetrics::Record(const FString& Metric, double Value, const TMap<FString, FString>& Dimensions)
+{
+	FDimensionRefs DimensionRefs;
+	for (const TPair<FString, FString>& Dimension : Dimensions)
+	{
+		DimensionRefs.Emplace(&Dimension.Key, &Dimension.Value);
+	}
+
+	// Same dimensions in a different order are the same series
+	DimensionRefs.Sort([](const TPair<const FString*, const FString*>& A, const TPair<const FString*, const FString*>& B)
+	{
+		return FCString::Strcmp(**A.Key, **B.Key) < 0;
+	});
+
+	Record(Metric, Value, DimensionRefs);
+}
+
+void FFirebaseAnalyticsMetrics::Record(const FString& Metric, double Value, FDimensionRefs& Dimensions)
+{
+	if (FMath::IsNaN(Value))
+	{
+		return;
+	}
+
+	// Reused per thread, so looking up an existing series doesn't allocate
+	static thread_local FString Key;
+	Key.Reset();
+	Key += Metric;
+	for (const TPair<const FString*, const FString*>& Dimension : Dimensions)
+	{
+		Key += MetricKeyDimensionSeparator;
+		Key += *Dimension.Key;
+		Key += MetricKeyValueSeparator;
+		Key += *Dimension.Value;
+	}
+
+	FShard& Shard = GetShard();
+	FScopeLock Lock(&Shard.CriticalSection);
+
+	FSeries* Series = Shard.Series.Find(Key);
+	if (Series == nullptr)
+	{
+		if (Shard.Series.Num() >= MaxSeriesPerShard)
+		{
+			Shard.NumDropped++;
+			return;
+		}
+
+		Series = &Shard.Series.Add(Key);
+		Series->Metric = Metric;
+		Series->Sketch = FFirebaseAnalyticsSketch(RelativeAccuracy);
+		for (const TPair<const FString*, const FString*>& Dimension : Dimensions)
+		{
+			Series->Dimensions.Emplace(*Dimension.Key, *Dimension.Value);
+		}
+	}
+
+	Series->Add(Value);
+}
+
+void FFirebaseAnalyticsMetrics::Collect(TArray<FFirebaseAnalyticsEvent>& OutSummaries)
+{
+	TFirebaseAnalyticsNameMap<FSeries> Merged;
+	uint64 NumDropped = 0;
+
+	for (FShard& Shard : Shards)
+	{
+		FScopeLock ShardLock(&Shard.CriticalSection);
+		for (auto It = Shard.Series.CreateIterator(); It; ++It)
+		{
+			FSeries& Series = It.Value();
+
+			// Series that went quiet for a whole interval give their slot back
+			if (Series.Count == 0)
+			{
+				It.RemoveCurrent();
+				continue;
+			}
+
+			FSeries* MergedSeries = Merged.Find(It.Key());
+			if (MergedSeries == nullptr)
+			{
+				MergedSeries = &Merged.Add(It.Key(), Series);
+			}
+			else
+			{
+				MergedSeries->Merge(Series);
+			}
+
+			Series.Reset();
+		}
+
+		NumDropped += Shard.NumDropped;
+		Shard.NumDropped = 0;
+	}
+
+	FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS((int32)NumDropped);
+
+	OutSummaries.Reserve(OutSummaries.Num() + Merged.Num());
+	for (const TPair<FString, FSeries>& Pair : Merged)
+	{
+		const FSeries& Series = Pair.Value;
+
+		FFirebaseAnalyticsEvent& Summary = OutSummaries.AddDefaulted_GetRef();
+		Summary.Name = Series.Metric;
+		for (const TPair<FString, FString>& Dimension : Series.Dimensions)
+		{
+			Summary.Parameters.PutString(Dimension.Key, Dimension.Value);
+		}
+
+		Summary.Parameters.PutInt64(TEXT("count"), (int64)Series.Count);
+		Summary.Parameters.PutDouble(TEXT("sum"), Series.Sum);
+		Summary.Parameters.PutDouble(TEXT("min"), Series.Min);
+		Summary.Parameters.PutDouble(TEXT("max"), Series.Max);
+
+		// Sketch estimates can fall a bit outside of the exact range
+		Summary.Parameters.PutDouble(TEXT("p50"), FMath::Clamp(Series.Sketch.GetQuantile(0.5), Series.Min, Series.Max));
+		Summary.Parameters.PutDouble(TEXT("p90"), FMath::Clamp(Series.Sketch.GetQuantile(0.9), Series.Min, Series.Max));
+		Summary.Parameters.PutDouble(TEXT("p99"), FMath::Clamp(Series.Sketch.GetQuantile(0.99), Series.Min, Series.Max));
+	}
+}
+
+FFirebaseAnalyticsMetrics::FShard& FFirebaseAnalyticsMetrics::GetShard()
+{
+	// Thread ids are often sequential or aligned, mix them before picking a shard
+	return Shards[MurmurFinalize32(FPlatformTLS::GetCurrentThreadId()) % NumShards];
+}
+
+void FFirebaseAnalyticsMetrics::FSeries::Add(double Value)
+{
+	Min = Count > 0 ? FMath::Min(Min, Value) : Value;
+	Max = Count > 0 ? FMath::Max(Max, Value) : Value;
+	Sum += Value;
+	Count++;
+	Sketch.Add(Value);
+}
+
+void FFirebaseAnalyticsMetrics::FSeries::Merge(const FSeries& Other)
+{
+	Min = FMath::Min(Min, Other.Min);
+	Max = FMath::Max(Max, Other.Max);
+	Sum += Other.Sum;
+	Count += Other.Count;
+	Sketch.Merge(Other.Sketch);
+}
+
+void FFirebaseAnalyticsMetrics::FSeries::Reset()
+{
+	Count = 0;
+	Sum = 0.0;
+	Min = 0.0;
+	Max = 0.0;
+	Sketch.Reset();
+}
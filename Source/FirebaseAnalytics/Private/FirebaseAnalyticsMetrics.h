@@ -0,0 +1,62 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsEvent.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+#include "FirebaseAnalyticsSketch.h"
+
+/** Summaries of values too frequent to log one event each, per metric name and set of dimensions.
+ *
+ *	Threads record into one of a fixed number of shards picked by thread id, so gameplay and worker threads
+ *	rarely contend with each other or with Collect(). Each shard keeps at most MaxSeriesPerShard series; values
+ *	of new series past that are dropped until the next interval, so memory stays bounded however many threads record.
+ */
+class FFirebaseAnalyticsMetrics
+{
+public:
+	FFirebaseAnalyticsMetrics(int32 InMaxSeriesPerShard, double InRelativeAccuracy);
+
+	void Record(const FString& Metric, double Value);
+	void Record(const FString& Metric, double Value, const TMap<FString, FString>& Dimensions);
+
+	/** Merge every shard into one summary event per series and start a new interval.
+	 *	Summaries carry the dimensions, then count, sum, min, max, p50, p90 and p99.
+	 */
+	void Collect(TArray<FFirebaseAnalyticsEvent>& OutSummaries);
+
+private:
+	struct FSeries
+	{
+		FString Metric;
+		TArray<TPair<FString, FString>> Dimensions;
+		uint64 Count = 0;
+		double Sum = 0.0;
+		double Min = 0.0;
+		double Max = 0.0;
+		FFirebaseAnalyticsSketch Sketch;
+
+		void Add(double Value);
+		void Merge(const FSeries& Other);
+		void Reset();
+	};
+
+	struct FShard
+	{
+		FCriticalSection CriticalSection;
+		TFirebaseAnalyticsNameMap<FSeries> Series;
+		uint64 NumDropped = 0;
+	};
+
+	typedef TArray<TPair<const FString*, const FString*>, TInlineAllocator<8>> FDimensionRefs;
+
+	void Record(const FString& Metric, double Value, FDimensionRefs& Dimensions);
+	FShard& GetShard();
+
+	static constexpr int32 NumShards = 16;
+	FShard Shards[NumShards];
+
+	int32 MaxSeriesPerShard;
+	double RelativeAccuracy;
+};
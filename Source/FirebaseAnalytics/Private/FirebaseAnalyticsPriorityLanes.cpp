@@ -0,0 +1,203 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsPriorityLanes.h"
+#include "FirebaseAnalyticsBuiltinNames.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+// The budget never shrinks below this fraction, so a long run of hitches still lets events trickle out
+static constexpr double PriorityLanesMinBudgetScale = 1.0 / 16.0;
+
+static EFirebaseAnalyticsEventPriority GetDefaultFirebaseAnalyticsEventPriority(EBuiltinEventNames EventName)
+{
+	switch (EventName)
+	{
+		case EBuiltinEventNames::ECOMMERCE_PURCHASE:
+		case EBuiltinEventNames::PURCHASE:
+		case EBuiltinEventNames::PURCHASE_REFUND:
+		case EBuiltinEventNames::REFUND:
+			return EFirebaseAnalyticsEventPriority::Critical;
+		case EBuiltinEventNames::SCREEN_VIEW:
+		case EBuiltinEventNames::SELECT_CONTENT:
+		case EBuiltinEventNames::SELECT_ITEM:
+		case EBuiltinEventNames::SELECT_PROMOTION:
+		case EBuiltinEventNames::VIEW_CART:
+		case EBuiltinEventNames::VIEW_ITEM:
+		case EBuiltinEventNames::VIEW_ITEM_LIST:
+		case EBuiltinEventNames::VIEW_PROMOTION:
+		case EBuiltinEventNames::VIEW_SEARCH_RESULTS:
+			return EFirebaseAnalyticsEventPriority::Low;
+		default:
+			return EFirebaseAnalyticsEventPriority::Normal;
+	}
+}
+
+FFirebaseAnalyticsCall FFirebaseAnalyticsPriorityLanes::FLane::Pop()
+{
+	FFirebaseAnalyticsCall Call = MoveTemp(Calls[Head].Call);
+	Head++;
+
+	if (Head == Calls.Num())
+	{
+		Calls.Reset();
+		Head = 0;
+	}
+	else if (Head * 2 >= Calls.Num())
+	{
+		Calls.RemoveAt(0, Head, false);
+		Head = 0;
+	}
+
+	return Call;
+}
+
+FFirebaseAnalyticsPriorityLanes::FFirebaseAnalyticsPriorityLanes(const UFirebaseAnalyticsSettings& Settings)
+	: MaxHeldCalls(FMath::Max(Settings.MaxHeldEvents, 1))
+	, BudgetSeconds(FMath::Max(Settings.FlushBudgetMilliseconds, 0.01f) / 1000.0)
+	, HitchThresholdSeconds(Settings.HitchThresholdMilliseconds / 1000.0)
+	, MaxHoldSeconds(Settings.MaxEventHoldSeconds)
+{
+	for (int32 NameIdx = 0; NameIdx < NumBuiltinEventNames; NameIdx++)
+	{
+		const EBuiltinEventNames EventName = (EBuiltinEventNames)NameIdx;
+		Priorities.Add(GetBuiltinEventNameLiteral(EventName), GetDefaultFirebaseAnalyticsEventPriority(EventName));
+	}
+
+	// A later entry for the same name replaces the earlier one
+	for (const FFirebaseAnalyticsEventPriorityRule& Rule : Settings.EventPriorities)
+	{
+		if (Rule.EventName == TEXT("*"))
+		{
+			DefaultPriority = Rule.Priority;
+		}
+		else
+		{
+			Priorities.Add(Rule.EventName, Rule.Priority);
+		}
+	}
+}
+
+EFirebaseAnalyticsEventPriority FFirebaseAnalyticsPriorityLanes::GetPriority(const FString& EventName) const
+{
+	const EFirebaseAnalyticsEventPriority* Priority = Priorities.Find(EventName);
+	return Priority ? *Priority : DefaultPriority;
+}
+
+bool FFirebaseAnalyticsPriorityLanes::Hold(FFirebaseAnalyticsCall& Call, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver)
+{
+	if (Call.Type != EFirebaseAnalyticsCallType::LogEvent)
+	{
+		return false;
+	}
+
+	const EFirebaseAnalyticsEventPriority Priority = GetPriority(Call.Event.Name);
+	if (Priority == EFirebaseAnalyticsEventPriority::Critical)
+	{
+		return false;
+	}
+
+	FLane& Lane = Lanes[Priority == EFirebaseAnalyticsEventPriority::Normal ? 0 : 1];
+	{
+		FScopeLock Lock(&CriticalSection);
+		if (Lanes[0].Num() + Lanes[1].Num() < MaxHeldCalls)
+		{
+			FHeldCall& Held = Lane.Calls.AddDefaulted_GetRef();
+			Held.Call = MoveTemp(Call);
+			Held.HeldSeconds = FPlatformTime::Seconds();
+			return true;
+		}
+	}
+
+	// Full, the call can't overtake the older events of its lane, so they go ahead of it
+	FScopeLock DrainLock(&DrainCriticalSection);
+	for (;;)
+	{
+		FFirebaseAnalyticsCall HeldCall;
+		{
+			FScopeLock Lock(&CriticalSection);
+			if (Lane.Num() == 0)
+			{
+				break;
+			}
+			HeldCall = Lane.Pop();
+		}
+		Deliver(MoveTemp(HeldCall));
+	}
+
+	Deliver(MoveTemp(Call));
+	return true;
+}
+
+FFirebaseAnalyticsPriorityLanes::FLane* FFirebaseAnalyticsPriorityLanes::PickLane(bool bWithinBudget, double OverdueBefore)
+{
+	for (FLane& Lane : Lanes)
+	{
+		if (Lane.Num() > 0 && (bWithinBudget || Lane.Peek().HeldSeconds < OverdueBefore))
+		{
+			return &Lane;
+		}
+	}
+	return nullptr;
+}
+
+int32 FFirebaseAnalyticsPriorityLanes::Drain(double Deadline, double OverdueBefore, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver)
+{
+	FScopeLock DrainLock(&DrainCriticalSection);
+
+	int32 NumDelivered = 0;
+	for (;;)
+	{
+		FFirebaseAnalyticsCall Call;
+		{
+			FScopeLock Lock(&CriticalSection);
+			FLane* Lane = PickLane(FPlatformTime::Seconds() < Deadline, OverdueBefore);
+			if (Lane == nullptr)
+			{
+				break;
+			}
+			Call = Lane->Pop();
+		}
+
+		// Delivered outside the lock, so callers logging meanwhile don't wait on the backend
+		Deliver(MoveTemp(Call));
+		NumDelivered++;
+	}
+
+	return NumDelivered;
+}
+
+int32 FFirebaseAnalyticsPriorityLanes::Tick(float DeltaTime, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver)
+{
+	// Back off quickly on a hitch and recover slowly, so a heavy stretch of frames isn't made worse
+	if (DeltaTime > HitchThresholdSeconds)
+	{
+		BudgetScale = FMath::Max(BudgetScale * 0.5, PriorityLanesMinBudgetScale);
+	}
+	else
+	{
+		BudgetScale = FMath::Min(BudgetScale * 1.25, 1.0);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	return Drain(Now + BudgetSeconds * BudgetScale, Now - MaxHoldSeconds, Deliver);
+}
+
+int32 FFirebaseAnalyticsPriorityLanes::Discard()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const int32 NumDiscarded = Lanes[0].Num() + Lanes[1].Num();
+	for (FLane& Lane : Lanes)
+	{
+		Lane.Calls.Empty();
+		Lane.Head = 0;
+	}
+	return NumDiscarded;
+}
+
+int32 FFirebaseAnalyticsPriorityLanes::GetNumHeld() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return Lanes[0].Num() + Lanes[1].Num();
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsEvent.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+
+class UFirebaseAnalyticsSettings;
+
+/** Holds Normal and Low priority events until there is time to send them, Critical events and other calls pass through.
+ *	Events of one lane leave in the order they were logged, Normal ones before Low ones.
+ */
+class FFirebaseAnalyticsPriorityLanes
+{
+public:
+	explicit FFirebaseAnalyticsPriorityLanes(const UFirebaseAnalyticsSettings& Settings);
+
+	EFirebaseAnalyticsEventPriority GetPriority(const FString& EventName) const;
+
+	/** Take the call if it can wait. Returns false for calls to send right away: not events and Critical ones.
+	 *	When the lanes are full, the events held in the call's lane are handed to Deliver first and the call after them.
+	 */
+	bool Hold(FFirebaseAnalyticsCall& Call, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver);
+
+	/** Hand held events to Deliver until Deadline, in FPlatformTime::Seconds.
+	 *	Events held since before OverdueBefore go even past the deadline. Returns the number of events delivered.
+	 */
+	int32 Drain(double Deadline, double OverdueBefore, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver);
+
+	/** Drain for one frame of DeltaTime, within the budget and its hitch back-off. Call from one thread only. */
+	int32 Tick(float DeltaTime, TFunctionRef<void(FFirebaseAnalyticsCall&&)> Deliver);
+
+	/** Forget every held event, returns how many there were. */
+	int32 Discard();
+
+	int32 GetNumHeld() const;
+
+private:
+	struct FHeldCall
+	{
+		FFirebaseAnalyticsCall Call;
+		double HeldSeconds = 0.0;
+	};
+
+	/** FIFO without shifting on every pop, the array is compacted once half of it is consumed. */
+	struct FLane
+	{
+		TArray<FHeldCall> Calls;
+		int32 Head = 0;
+
+		int32 Num() const { return Calls.Num() - Head; }
+		const FHeldCall& Peek() const { return Calls[Head]; }
+		FFirebaseAnalyticsCall Pop();
+	};
+
+	/** Next lane to take an event from, nullptr when nothing can go. Called with CriticalSection held. */
+	FLane* PickLane(bool bWithinBudget, double OverdueBefore);
+
+	mutable FCriticalSection CriticalSection;
+	FLane Lanes[2];
+	int32 MaxHeldCalls;
+
+	// Serializes drains, so events of a lane can't overtake each other between two draining threads
+	FCriticalSection DrainCriticalSection;
+
+	TFirebaseAnalyticsNameMap<EFirebaseAnalyticsEventPriority> Priorities;
+	EFirebaseAnalyticsEventPriority DefaultPriority = EFirebaseAnalyticsEventPriority::Normal;
+
+	double BudgetSeconds;
+	double HitchThresholdSeconds;
+	double MaxHoldSeconds;
+	double BudgetScale = 1.0;
+};
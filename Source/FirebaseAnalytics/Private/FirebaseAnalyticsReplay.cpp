@@ -0,0 +1,163 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsReplay.h"
+#include "FirebaseAnalytics.h"
+#include "FirebaseAnalyticsBackends.h"
+#include "FirebaseAnalyticsLog.h"
+#include "Async/Async.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+FFirebaseAnalyticsReplay::FFirebaseAnalyticsReplay(TArray<FFirebaseAnalyticsTraceRecord>&& InRecords, const FFirebaseAnalyticsReplayOptions& InOptions)
+	: Records(MoveTemp(InRecords))
+	, Options(InOptions)
+{
+	Options.Threads = FMath::Max(Options.Threads, 1);
+	Options.Speed = FMath::Max(Options.Speed, 0.0);
+}
+
+bool FFirebaseAnalyticsReplay::Run()
+{
+	FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+	if (Module == nullptr)
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("FirebaseAnalytics module isn't loaded, nothing to replay"));
+		return false;
+	}
+
+	// Without the dispatcher every replay thread would call into the backend at once, which no backend expects
+	if (!Module->IsAsyncDispatchEnabled())
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Firebase Analytics replay needs async dispatch, enable bAsyncEventDispatch in the settings"));
+		return false;
+	}
+
+	// Replayed calls would otherwise end up in the trace being recorded
+	FFirebaseAnalyticsTraceWriter& TraceWriter = Module->GetTraceWriter();
+	if (TraceWriter.IsRecording())
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Stopping the Firebase Analytics trace recording to replay"));
+		TraceWriter.Stop();
+	}
+
+	Result = FFirebaseAnalyticsReplayResult();
+
+	// Replayed events aren't the player's, they must not come back on the next launch
+	Module->SetJournalSuspended(true);
+
+	FFirebaseAnalyticsBackendPtr PreviousBackend = Module->GetBackend();
+	Module->SetBackend(CreateFirebaseAnalyticsBackend(Options.Backend));
+
+	Result.StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	Result.PeakUsedPhysical = Result.StartUsedPhysical;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<TFuture<TArray<float>>> Shares;
+	for (int32 ThreadIdx = 0; ThreadIdx < Options.Threads; ThreadIdx++)
+	{
+		Shares.Add(Async(EAsyncExecution::Thread, [this, ThreadIdx, StartTime]()
+		{
+			return ReplayShare(ThreadIdx, StartTime);
+		}));
+	}
+
+	// The process peak counter isn't available everywhere, so the high-water mark is sampled
+	for (const TFuture<TArray<float>>& Share : Shares)
+	{
+		while (!Share.WaitFor(FTimespan::FromMilliseconds(10.0)))
+		{
+			Result.PeakUsedPhysical = FMath::Max<uint64>(Result.PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+		}
+	}
+
+	Module->FlushEvents();
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	Result.PeakUsedPhysical = FMath::Max<uint64>(Result.PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	Module->SetBackend(PreviousBackend);
+	Module->SetJournalSuspended(false);
+
+	TArray<float> Latencies;
+	Latencies.Reserve(Records.Num());
+	for (TFuture<TArray<float>>& Share : Shares)
+	{
+		Latencies.Append(Share.Get());
+	}
+	Latencies.Sort();
+
+	Result.Calls = Latencies.Num();
+	Result.CallsPerSecond = Result.Seconds > 0.0 ? Result.Calls / Result.Seconds : 0.0;
+
+	if (Latencies.Num() > 0)
+	{
+		auto Percentile = [&Latencies](double Fraction)
+		{
+			return (double)Latencies[FMath::Min((int32)(Fraction * Latencies.Num()), Latencies.Num() - 1)];
+		};
+
+		Result.P50Microseconds = Percentile(0.50);
+		Result.P90Microseconds = Percentile(0.90);
+		Result.P99Microseconds = Percentile(0.99);
+		Result.MaxMicroseconds = Latencies.Last();
+	}
+
+	return true;
+}
+
+TArray<float> FFirebaseAnalyticsReplay::ReplayShare(int32 ThreadIdx, double StartTime) const
+{
+	FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get();
+
+	TArray<float> Latencies;
+	Latencies.Reserve(Records.Num() / Options.Threads + 1);
+
+	for (int32 RecordIdx = ThreadIdx; RecordIdx < Records.Num(); RecordIdx += Options.Threads)
+	{
+		const FFirebaseAnalyticsTraceRecord& Record = Records[RecordIdx];
+
+		if (Options.Speed > 0.0)
+		{
+			const double DueTime = StartTime + Record.Seconds / Options.Speed;
+			for (double Now = FPlatformTime::Seconds(); Now < DueTime; Now = FPlatformTime::Seconds())
+			{
+				// Sleep through long gaps, spin through the last millisecond
+				const double Remaining = DueTime - Now;
+				if (Remaining > 0.002)
+				{
+					FPlatformProcess::Sleep((float)(Remaining - 0.001));
+				}
+			}
+		}
+
+		// Copied outside the timed section, the caller would have built it anyway
+		FFirebaseAnalyticsCall Call = Record.Call;
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Module->SubmitCall(MoveTemp(Call));
+		Latencies.Add((float)(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0));
+	}
+
+	return Latencies;
+}
+
+FString FFirebaseAnalyticsReplay::ToJson() const
+{
+	FString Out = TEXT("{\n");
+	Out += FString::Printf(TEXT("\t\"backend\": \"%s\",\n"),
+		*StaticEnum<EFirebaseAnalyticsBackendType>()->GetNameStringByValue((int64)Options.Backend));
+	Out += FString::Printf(TEXT("\t\"speed\": %.2f,\n"), Options.Speed);
+	Out += FString::Printf(TEXT("\t\"threads\": %d,\n"), Options.Threads);
+	Out += FString::Printf(TEXT("\t\"calls\": %d,\n"), Result.Calls);
+	Out += FString::Printf(TEXT("\t\"seconds\": %.3f,\n"), Result.Seconds);
+	Out += FString::Printf(TEXT("\t\"calls_per_second\": %.1f,\n"), Result.CallsPerSecond);
+	Out += FString::Printf(TEXT("\t\"p50_us\": %.2f,\n"), Result.P50Microseconds);
+	Out += FString::Printf(TEXT("\t\"p90_us\": %.2f,\n"), Result.P90Microseconds);
+	Out += FString::Printf(TEXT("\t\"p99_us\": %.2f,\n"), Result.P99Microseconds);
+	Out += FString::Printf(TEXT("\t\"max_us\": %.2f,\n"), Result.MaxMicroseconds);
+	Out += FString::Printf(TEXT("\t\"start_used_physical\": %llu,\n"), Result.StartUsedPhysical);
+	Out += FString::Printf(TEXT("\t\"peak_used_physical\": %llu\n"), Result.PeakUsedPhysical);
+	Out += TEXT("}\n");
+	return Out;
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTrace.h"
+
+struct FFirebaseAnalyticsReplayOptions
+{
+	/** Multiple of the recorded pace. 0 submits as fast as the threads allow. */
+	double Speed = 1.0;
+
+	/** Calls are dealt round-robin to this many threads, each keeping its share's recorded timing. */
+	int32 Threads = 1;
+
+	/** Backend installed for the duration of the replay. */
+	EFirebaseAnalyticsBackendType Backend = EFirebaseAnalyticsBackendType::Null;
+};
+
+struct FFirebaseAnalyticsReplayResult
+{
+	int32 Calls = 0;
+	double Seconds = 0.0;
+	double CallsPerSecond = 0.0;
+
+	/** SubmitCall latency as seen by the caller, the flush at the end isn't included. */
+	double P50Microseconds = 0.0;
+	double P90Microseconds = 0.0;
+	double P99Microseconds = 0.0;
+	double MaxMicroseconds = 0.0;
+
+	/** Process memory sampled while replaying. */
+	uint64 StartUsedPhysical = 0;
+	uint64 PeakUsedPhysical = 0;
+};
+
+/** Plays a recorded trace back through SubmitCall, for load testing a backend with a real call stream. */
+class FFirebaseAnalyticsReplay
+{
+public:
+	FFirebaseAnalyticsReplay(TArray<FFirebaseAnalyticsTraceRecord>&& InRecords, const FFirebaseAnalyticsReplayOptions& InOptions);
+
+	/** Returns false when the module isn't loaded or async dispatch is off. */
+	bool Run();
+
+	const FFirebaseAnalyticsReplayResult& GetResult() const { return Result; }
+
+	FString ToJson() const;
+
+private:
+	/** Submit every Threads-th record starting at ThreadIdx, returns the latency of each call in microseconds. */
+	TArray<float> ReplayShare(int32 ThreadIdx, double StartTime) const;
+
+	TArray<FFirebaseAnalyticsTraceRecord> Records;
+	FFirebaseAnalyticsReplayOptions Options;
+	FFirebaseAnalyticsReplayResult Result;
+};
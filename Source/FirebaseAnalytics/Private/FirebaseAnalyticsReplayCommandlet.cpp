@@ -0,0 +1,76 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsReplayCommandlet.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsReplay.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UFirebaseAnalyticsReplayCommandlet::UFirebaseAnalyticsReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UFirebaseAnalyticsReplayCommandlet::Main(const FString& Params)
+{
+	FString TraceFilename;
+	if (!FParse::Value(*Params, TEXT("Trace="), TraceFilename))
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Missing -Trace=<path>"));
+		return 1;
+	}
+
+	FFirebaseAnalyticsReplayOptions Options;
+	float Speed = (float)Options.Speed;
+	FParse::Value(*Params, TEXT("Speed="), Speed);
+	Options.Speed = Speed;
+	FParse::Value(*Params, TEXT("Threads="), Options.Threads);
+
+	FString BackendName;
+	if (FParse::Value(*Params, TEXT("Backend="), BackendName))
+	{
+		const int64 Backend = StaticEnum<EFirebaseAnalyticsBackendType>()->GetValueByNameString(BackendName);
+		if (Backend == INDEX_NONE)
+		{
+			UE_LOG(LogFirebaseAnalytics, Error, TEXT("Unknown backend '%s'"), *BackendName);
+			return 1;
+		}
+		Options.Backend = (EFirebaseAnalyticsBackendType)Backend;
+	}
+
+	FString JsonFilename = FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics") / TEXT("Replay.json");
+	FParse::Value(*Params, TEXT("JSON="), JsonFilename);
+
+	TArray<FFirebaseAnalyticsTraceRecord> Records;
+	if (!LoadFirebaseAnalyticsTrace(TraceFilename, Records))
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't read Firebase Analytics trace %s"), *TraceFilename);
+		return 1;
+	}
+
+	FFirebaseAnalyticsReplay Replay(MoveTemp(Records), Options);
+	if (!Replay.Run())
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Firebase Analytics trace %s wasn't replayed"), *TraceFilename);
+		return 1;
+	}
+
+	const FFirebaseAnalyticsReplayResult& Result = Replay.GetResult();
+	UE_LOG(LogFirebaseAnalytics, Display, TEXT("Replayed %d calls in %.3f s (%.1f calls/s), latency p50 %.2f us, p90 %.2f us, p99 %.2f us, max %.2f us"),
+		Result.Calls, Result.Seconds, Result.CallsPerSecond,
+		Result.P50Microseconds, Result.P90Microseconds, Result.P99Microseconds, Result.MaxMicroseconds);
+	UE_LOG(LogFirebaseAnalytics, Display, TEXT("Memory peak %.1f MB, %.1f MB above the start"),
+		Result.PeakUsedPhysical / (1024.0 * 1024.0),
+		(Result.PeakUsedPhysical - Result.StartUsedPhysical) / (1024.0 * 1024.0));
+
+	if (!FFileHelper::SaveStringToFile(Replay.ToJson(), *JsonFilename))
+	{
+		UE_LOG(LogFirebaseAnalytics, Error, TEXT("Can't write replay results to %s"), *JsonFilename);
+		return 1;
+	}
+
+	return 0;
+}
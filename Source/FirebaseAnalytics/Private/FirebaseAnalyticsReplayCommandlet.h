@@ -0,0 +1,25 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FirebaseAnalyticsReplayCommandlet.generated.h"
+
+/** Load test with a recorded call stream, see FirebaseAnalytics.StartTrace:
+ *	UE4Editor-Cmd <Project> -run=FirebaseAnalyticsReplay -Trace=<path> [-Speed=1] [-Threads=1]
+ *		[-Backend=Null|Memory|File|BlockLog|Http|Platform] [-JSON=<path>]
+ *	-Speed=0 replays as fast as possible.
+ */
+UCLASS()
+class UFirebaseAnalyticsReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFirebaseAnalyticsReplayCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+};
@@ -0,0 +1,174 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsSketch.h"
+
+FFirebaseAnalyticsSketch::FFirebaseAnalyticsSketch(double RelativeAccuracy, int32 InMaxBins)
+	: MaxBins(FMath::Max(InMaxBins, 1))
+{
+	RelativeAccuracy = FMath::Clamp(RelativeAccuracy, 1e-4, 0.5);
+	Gamma = (1.0 + RelativeAccuracy) / (1.0 - RelativeAccuracy);
+	LogGamma = FMath::Loge(Gamma);
+
+	// Denormals share the zero count, their logarithm isn't worth a bin
+	MinIndexableValue = TNumericLimits<double>::Min();
+}
+
+void FFirebaseAnalyticsSketch::Add(double Value, uint64 Count)
+{
+	if (Count == 0 || FMath::IsNaN(Value))
+	{
+		return;
+	}
+
+	if (Value > MinIndexableValue)
+	{
+		Positive.Add(GetIndex(Value), Count, MaxBins);
+	}
+	else if (Value < -MinIndexableValue)
+	{
+		Negative.Add(GetIndex(-Value), Count, MaxBins);
+	}
+	else
+	{
+		ZeroCount += Count;
+	}
+}
+
+void FFirebaseAnalyticsSketch::Merge(const FFirebaseAnalyticsSketch& Other)
+{
+	check(Gamma == Other.Gamma);
+
+	for (int32 BinIdx = 0; BinIdx < Other.Positive.Bins.Num(); BinIdx++)
+	{
+		if (Other.Positive.Bins[BinIdx] > 0)
+		{
+			Positive.Add(Other.Positive.MinIndex + BinIdx, Other.Positive.Bins[BinIdx], MaxBins);
+		}
+	}
+
+	for (int32 BinIdx = 0; BinIdx < Other.Negative.Bins.Num(); BinIdx++)
+	{
+		if (Other.Negative.Bins[BinIdx] > 0)
+		{
+			Negative.Add(Other.Negative.MinIndex + BinIdx, Other.Negative.Bins[BinIdx], MaxBins);
+		}
+	}
+
+	ZeroCount += Other.ZeroCount;
+}
+
+double FFirebaseAnalyticsSketch::GetQuantile(double Q) const
+{
+	const uint64 Count = GetCount();
+	if (Count == 0)
+	{
+		return 0.0;
+	}
+
+	const double Rank = FMath::Clamp(Q, 0.0, 1.0) * (Count - 1);
+	uint64 Seen = 0;
+
+	// Most negative values first: the highest indices of the negative store
+	for (int32 BinIdx = Negative.Bins.Num() - 1; BinIdx >= 0; BinIdx--)
+	{
+		Seen += Negative.Bins[BinIdx];
+		if (Seen > Rank)
+		{
+			return -GetValue(Negative.MinIndex + BinIdx);
+		}
+	}
+
+	Seen += ZeroCount;
+	if (Seen > Rank)
+	{
+		return 0.0;
+	}
+
+	for (int32 BinIdx = 0; BinIdx < Positive.Bins.Num(); BinIdx++)
+	{
+		Seen += Positive.Bins[BinIdx];
+		if (Seen > Rank)
+		{
+			return GetValue(Positive.MinIndex + BinIdx);
+		}
+	}
+
+	return GetValue(Positive.GetMaxIndex());
+}
+
+void FFirebaseAnalyticsSketch::Reset()
+{
+	Positive.Reset();
+	Negative.Reset();
+	ZeroCount = 0;
+}
+
+int32 FFirebaseAnalyticsSketch::GetIndex(double Value) const
+{
+	return (int32)FMath::CeilToDouble(FMath::Loge(Value) / LogGamma);
+}
+
+double FFirebaseAnalyticsSketch::GetValue(int32 Index) const
+{
+	// Midpoint of the bin in relative terms, which is what bounds the error by RelativeAccuracy
+	return 2.0 * FMath::Pow(Gamma, (double)Index) / (Gamma + 1.0);
+}
+
+void FFirebaseAnalyticsSketch::FStore::Add(int32 Index, uint64 InCount, int32 MaxBins)
+{
+	Count += InCount;
+
+	if (Bins.Num() == 0)
+	{
+		MinIndex = Index;
+		Bins.Add(InCount);
+		return;
+	}
+
+	if (Index < MinIndex)
+	{
+		// Extend downwards, but never past MaxBins: lower values then land in the lowest bin
+		const int32 NewMinIndex = FMath::Max(Index, GetMaxIndex() - MaxBins + 1);
+		if (NewMinIndex < MinIndex)
+		{
+			Bins.InsertZeroed(0, MinIndex - NewMinIndex);
+			MinIndex = NewMinIndex;
+		}
+		Bins[FMath::Max(Index, MinIndex) - MinIndex] += InCount;
+		return;
+	}
+
+	if (Index > GetMaxIndex())
+	{
+		const int32 NewMinIndex = Index - MaxBins + 1;
+		if (NewMinIndex > MinIndex)
+		{
+			// Collapse everything below the new window into its lowest bin
+			const int32 NumCollapsed = FMath::Min(NewMinIndex - MinIndex, Bins.Num());
+			uint64 Collapsed = 0;
+			for (int32 BinIdx = 0; BinIdx < NumCollapsed; BinIdx++)
+			{
+				Collapsed += Bins[BinIdx];
+			}
+
+			Bins.RemoveAt(0, NumCollapsed, false);
+			MinIndex = NewMinIndex;
+			if (Bins.Num() == 0)
+			{
+				Bins.Add(0);
+			}
+			Bins[0] += Collapsed;
+		}
+
+		Bins.AddZeroed(Index - GetMaxIndex());
+	}
+
+	Bins[Index - MinIndex] += InCount;
+}
+
+void FFirebaseAnalyticsSketch::FStore::Reset()
+{
+	Bins.Reset();
+	MinIndex = 0;
+	Count = 0;
+}
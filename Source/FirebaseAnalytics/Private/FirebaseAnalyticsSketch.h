@@ -0,0 +1,56 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** DDSketch: quantiles with a bounded relative error, mergeable between sketches of the same accuracy.
+ *
+ *	Values go to logarithmic bins, bin i covering (Gamma^(i-1), Gamma^i]. Each store keeps at most
+ *	MaxBins contiguous bins, when a value falls outside of that the lowest bins are collapsed into
+ *	one, so only the lowest quantiles lose accuracy.
+ */
+class FFirebaseAnalyticsSketch
+{
+public:
+	explicit FFirebaseAnalyticsSketch(double RelativeAccuracy = 0.01, int32 InMaxBins = 1024);
+
+	void Add(double Value, uint64 Count = 1);
+
+	/** Add every value of Other. Both sketches must have the same accuracy. */
+	void Merge(const FFirebaseAnalyticsSketch& Other);
+
+	/** Value at quantile Q in [0, 1], or 0 when the sketch is empty. */
+	double GetQuantile(double Q) const;
+
+	uint64 GetCount() const { return Positive.Count + Negative.Count + ZeroCount; }
+	bool IsEmpty() const { return GetCount() == 0; }
+
+	/** Forget every value but keep the bin storage. */
+	void Reset();
+
+private:
+	/** Contiguous bins starting at MinIndex. */
+	struct FStore
+	{
+		TArray<uint64> Bins;
+		int32 MinIndex = 0;
+		uint64 Count = 0;
+
+		int32 GetMaxIndex() const { return MinIndex + Bins.Num() - 1; }
+		void Add(int32 Index, uint64 Count, int32 MaxBins);
+		void Reset();
+	};
+
+	int32 GetIndex(double Value) const;
+	double GetValue(int32 Index) const;
+
+	double Gamma;
+	double LogGamma;
+	double MinIndexableValue;
+	int32 MaxBins;
+
+	FStore Positive;
+	FStore Negative;
+	uint64 ZeroCount = 0;
+};
@@ -0,0 +1,142 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsStats.h"
+
+#if FIREBASE_ANALYTICS_STATS
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+#if PLATFORM_ANDROID
+#include "Android/FirebaseAnalyticsAndroidBackend.h"
+#endif
+
+DEFINE_STAT(STAT_FirebaseAnalytics_SubmitCall);
+DEFINE_STAT(STAT_FirebaseAnalytics_DispatchBatch);
+DEFINE_STAT(STAT_FirebaseAnalytics_EncodeBatch);
+DEFINE_STAT(STAT_FirebaseAnalytics_ToJavaString);
+DEFINE_STAT(STAT_FirebaseAnalytics_ConvertBundleToJavaBundle);
+DEFINE_STAT(STAT_FirebaseAnalytics_CallVoidMethod);
+DEFINE_STAT(STAT_FirebaseAnalytics_WriteLogBlock);
+DEFINE_STAT(STAT_FirebaseAnalytics_BuildHttpRequest);
+
+DEFINE_STAT(STAT_FirebaseAnalytics_Events);
+DEFINE_STAT(STAT_FirebaseAnalytics_Parameters);
+DEFINE_STAT(STAT_FirebaseAnalytics_BytesMarshaled);
+DEFINE_STAT(STAT_FirebaseAnalytics_FailedCalls);
+DEFINE_STAT(STAT_FirebaseAnalytics_DroppedCalls);
+DEFINE_STAT(STAT_FirebaseAnalytics_SkippedCalls);
+
+UE_TRACE_CHANNEL_DEFINE(FirebaseAnalyticsChannel);
+
+FFirebaseAnalyticsStats& FFirebaseAnalyticsStats::Get()
+{
+	static FFirebaseAnalyticsStats Stats;
+	return Stats;
+}
+
+FFirebaseAnalyticsStats::FFirebaseAnalyticsStats()
+	: StartSeconds(FPlatformTime::Seconds())
+{
+}
+
+void FFirebaseAnalyticsStats::RecordEvent(const FString& Name, int32 InNumParameters)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FEventTotals& Totals = Events.FindOrAdd(Name);
+	Totals.Count++;
+	Totals.Parameters += InNumParameters;
+
+	NumEvents++;
+	NumParameters += InNumParameters;
+}
+
+void FFirebaseAnalyticsStats::RecordBytes(int32 InNumBytes)
+{
+	FScopeLock Lock(&CriticalSection);
+	NumBytes += InNumBytes;
+}
+
+void FFirebaseAnalyticsStats::RecordFailedCall()
+{
+	FScopeLock Lock(&CriticalSection);
+	NumFailedCalls++;
+}
+
+void FFirebaseAnalyticsStats::RecordDroppedCalls(int32 NumCalls)
+{
+	FScopeLock Lock(&CriticalSection);
+	NumDroppedCalls += NumCalls;
+}
+
+void FFirebaseAnalyticsStats::RecordSkippedCall()
+{
+	FScopeLock Lock(&CriticalSection);
+	NumSkippedCalls++;
+}
+
+void FFirebaseAnalyticsStats::Dump(FOutputDevice& Ar) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const double ElapsedSeconds = FMath::Max(FPlatformTime::Seconds() - StartSeconds, 1e-3);
+	Ar.Logf(TEXT("Firebase Analytics: %llu events in %.1fs (%.2f/s), %.2f parameters/event, %llu bytes marshaled, %llu failed, %llu dropped, %llu skipped as redundant"),
+		NumEvents,
+		ElapsedSeconds,
+		NumEvents / ElapsedSeconds,
+		NumEvents ? (double)NumParameters / NumEvents : 0.0,
+		NumBytes,
+		NumFailedCalls,
+		NumDroppedCalls,
+		NumSkippedCalls);
+
+	TArray<TPair<FString, FEventTotals>> SortedEvents = Events.Array();
+	SortedEvents.Sort([](const TPair<FString, FEventTotals>& A, const TPair<FString, FEventTotals>& B)
+	{
+		return A.Value.Count > B.Value.Count;
+	});
+
+	for (const TPair<FString, FEventTotals>& Event : SortedEvents)
+	{
+		Ar.Logf(TEXT("  %-40s %10llu events %8.2f parameters/event"),
+			*Event.Key,
+			Event.Value.Count,
+			(double)Event.Value.Parameters / Event.Value.Count);
+	}
+}
+
+void FFirebaseAnalyticsStats::Reset()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Events.Reset();
+	NumEvents = 0;
+	NumParameters = 0;
+	NumBytes = 0;
+	NumFailedCalls = 0;
+	NumDroppedCalls = 0;
+	NumSkippedCalls = 0;
+	StartSeconds = FPlatformTime::Seconds();
+}
+
+static FAutoConsoleCommandWithOutputDevice DumpStatsCommand(
+	TEXT("FirebaseAnalytics.DumpStats"),
+	TEXT("Print Firebase Analytics totals and per-event-name counts since startup or the last FirebaseAnalytics.ResetStats. On Android also the Java name cache."),
+	FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+	{
+		FFirebaseAnalyticsStats::Get().Dump(Ar);
+#if PLATFORM_ANDROID
+		FFirebaseAnalyticsAndroidBackend::DumpNameCacheStats(Ar);
+#endif
+	}));
+
+static FAutoConsoleCommand ResetStatsCommand(
+	TEXT("FirebaseAnalytics.ResetStats"),
+	TEXT("Clear the totals printed by FirebaseAnalytics.DumpStats."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FFirebaseAnalyticsStats::Get().Reset();
+	}));
+
+#endif
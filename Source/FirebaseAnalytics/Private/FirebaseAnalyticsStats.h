@@ -0,0 +1,108 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Stat counters, the FirebaseAnalytics trace channel and per-event totals.
+ *	Off in Shipping unless the target defines FIREBASE_ANALYTICS_STATS=1.
+ */
+#ifndef FIREBASE_ANALYTICS_STATS
+#define FIREBASE_ANALYTICS_STATS !UE_BUILD_SHIPPING
+#endif
+
+#if FIREBASE_ANALYTICS_STATS
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+
+DECLARE_STATS_GROUP(TEXT("FirebaseAnalytics"), STATGROUP_FirebaseAnalytics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SubmitCall"), STAT_FirebaseAnalytics_SubmitCall, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("DispatchBatch"), STAT_FirebaseAnalytics_DispatchBatch, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("EncodeBatch"), STAT_FirebaseAnalytics_EncodeBatch, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ToJavaString"), STAT_FirebaseAnalytics_ToJavaString, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ConvertBundleToJavaBundle"), STAT_FirebaseAnalytics_ConvertBundleToJavaBundle, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CallVoidMethod"), STAT_FirebaseAnalytics_CallVoidMethod, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("WriteLogBlock"), STAT_FirebaseAnalytics_WriteLogBlock, STATGROUP_FirebaseAnalytics, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("BuildHttpRequest"), STAT_FirebaseAnalytics_BuildHttpRequest, STATGROUP_FirebaseAnalytics, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Events"), STAT_FirebaseAnalytics_Events, STATGROUP_FirebaseAnalytics, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Parameters"), STAT_FirebaseAnalytics_Parameters, STATGROUP_FirebaseAnalytics, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Marshaled"), STAT_FirebaseAnalytics_BytesMarshaled, STATGROUP_FirebaseAnalytics, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Failed Calls"), STAT_FirebaseAnalytics_FailedCalls, STATGROUP_FirebaseAnalytics, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Dropped Calls"), STAT_FirebaseAnalytics_DroppedCalls, STATGROUP_FirebaseAnalytics, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Skipped Calls"), STAT_FirebaseAnalytics_SkippedCalls, STATGROUP_FirebaseAnalytics, );
+
+UE_TRACE_CHANNEL_EXTERN(FirebaseAnalyticsChannel);
+
+/** Running totals behind the FirebaseAnalytics.DumpStats console command. */
+class FFirebaseAnalyticsStats
+{
+public:
+	static FFirebaseAnalyticsStats& Get();
+
+	void RecordEvent(const FString& Name, int32 NumParameters);
+	void RecordBytes(int32 NumBytes);
+	void RecordFailedCall();
+	void RecordDroppedCalls(int32 NumCalls);
+	void RecordSkippedCall();
+
+	void Dump(FOutputDevice& Ar) const;
+	void Reset();
+
+private:
+	FFirebaseAnalyticsStats();
+
+	struct FEventTotals
+	{
+		uint64 Count = 0;
+		uint64 Parameters = 0;
+	};
+
+	mutable FCriticalSection CriticalSection;
+	TFirebaseAnalyticsNameMap<FEventTotals> Events;
+	uint64 NumEvents = 0;
+	uint64 NumParameters = 0;
+	uint64 NumBytes = 0;
+	uint64 NumFailedCalls = 0;
+	uint64 NumDroppedCalls = 0;
+	uint64 NumSkippedCalls = 0;
+	double StartSeconds = 0.0;
+};
+
+#define FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, FirebaseAnalyticsChannel)
+
+#define FIREBASE_ANALYTICS_RECORD_EVENT(Name, NumParameters) \
+	INC_DWORD_STAT(STAT_FirebaseAnalytics_Events); \
+	INC_DWORD_STAT_BY(STAT_FirebaseAnalytics_Parameters, NumParameters); \
+	FFirebaseAnalyticsStats::Get().RecordEvent(Name, NumParameters)
+
+#define FIREBASE_ANALYTICS_RECORD_BYTES(NumBytes) \
+	INC_DWORD_STAT_BY(STAT_FirebaseAnalytics_BytesMarshaled, NumBytes); \
+	FFirebaseAnalyticsStats::Get().RecordBytes(NumBytes)
+
+#define FIREBASE_ANALYTICS_RECORD_FAILED_CALL() \
+	INC_DWORD_STAT(STAT_FirebaseAnalytics_FailedCalls); \
+	FFirebaseAnalyticsStats::Get().RecordFailedCall()
+
+#define FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(NumCalls) \
+	INC_DWORD_STAT_BY(STAT_FirebaseAnalytics_DroppedCalls, NumCalls); \
+	FFirebaseAnalyticsStats::Get().RecordDroppedCalls(NumCalls)
+
+#define FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL() \
+	INC_DWORD_STAT(STAT_FirebaseAnalytics_SkippedCalls); \
+	FFirebaseAnalyticsStats::Get().RecordSkippedCall()
+
+#else
+
+#define FIREBASE_ANALYTICS_SCOPE_CYCLE_COUNTER(Stat)
+#define FIREBASE_ANALYTICS_RECORD_EVENT(Name, NumParameters)
+#define FIREBASE_ANALYTICS_RECORD_BYTES(NumBytes)
+#define FIREBASE_ANALYTICS_RECORD_FAILED_CALL()
+#define FIREBASE_ANALYTICS_RECORD_DROPPED_CALLS(NumCalls)
+#define FIREBASE_ANALYTICS_RECORD_SKIPPED_CALL()
+
+#endif
@@ -0,0 +1,191 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeLock.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+
+struct FFirebaseAnalyticsStringCacheStats
+{
+	uint64 Hits = 0;
+	uint64 Misses = 0;
+	uint64 Evictions = 0;
+	int32 Num = 0;
+};
+
+/** Bounded, least-recently-used map from names to long-lived handles.
+ *
+ *	All handle management goes through PolicyType, which lets the cache run against
+ *	a fake handle type off-device. PolicyType must provide:
+ *		typedef ... HandleType;							// default constructed value means "no handle"
+ *		HandleType Create(const FString& Name);
+ *		void Release(HandleType Handle);
+ */
+template <typename PolicyType>
+class TFirebaseAnalyticsStringCache
+{
+public:
+	typedef typename PolicyType::HandleType HandleType;
+
+	explicit TFirebaseAnalyticsStringCache(int32 InCapacity, PolicyType InPolicy = PolicyType())
+		: Policy(MoveTemp(InPolicy))
+		, Capacity(FMath::Max(InCapacity, 1))
+	{
+		Entries.Reserve(Capacity);
+		Index.Reserve(Capacity);
+	}
+
+	~TFirebaseAnalyticsStringCache()
+	{
+		Empty();
+	}
+
+	/** Find or create the handle for Name and pass it to Visitor while the cache is locked.
+	 *  The handle may be evicted as soon as Visitor returns, so Visitor must take its own reference.
+	 */
+	template <typename VisitorType>
+	void Visit(const FString& Name, VisitorType&& Visitor)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (const int32* EntryIdx = Index.Find(Name))
+		{
+			Stats.Hits++;
+			MoveToFront(*EntryIdx);
+			Visitor(Entries[*EntryIdx].Handle);
+			return;
+		}
+
+		Stats.Misses++;
+
+		HandleType Handle = Policy.Create(Name);
+		if (Handle == HandleType())
+		{
+			Visitor(Handle);
+			return;
+		}
+
+		int32 EntryIdx;
+		if (Entries.Num() < Capacity)
+		{
+			EntryIdx = Entries.AddDefaulted();
+		}
+		else
+		{
+			// Recycle the least recently used slot
+			EntryIdx = Tail;
+			Unlink(EntryIdx);
+			Index.Remove(Entries[EntryIdx].Name);
+			Policy.Release(Entries[EntryIdx].Handle);
+			Stats.Evictions++;
+		}
+
+		FEntry& Entry = Entries[EntryIdx];
+		Entry.Name = Name;
+		Entry.Handle = Handle;
+		Index.Add(Name, EntryIdx);
+		LinkFront(EntryIdx);
+
+		Visitor(Handle);
+	}
+
+	/** Release every handle. */
+	void Empty()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (FEntry& Entry : Entries)
+		{
+			Policy.Release(Entry.Handle);
+		}
+
+		Entries.Reset();
+		Index.Reset();
+		Head = INDEX_NONE;
+		Tail = INDEX_NONE;
+	}
+
+	FFirebaseAnalyticsStringCacheStats GetStats() const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		FFirebaseAnalyticsStringCacheStats Result = Stats;
+		Result.Num = Entries.Num();
+		return Result;
+	}
+
+	int32 GetCapacity() const { return Capacity; }
+
+private:
+	struct FEntry
+	{
+		FString Name;
+		HandleType Handle = HandleType();
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+	};
+
+	void Unlink(int32 EntryIdx)
+	{
+		FEntry& Entry = Entries[EntryIdx];
+		if (Entry.Prev != INDEX_NONE)
+		{
+			Entries[Entry.Prev].Next = Entry.Next;
+		}
+		else
+		{
+			Head = Entry.Next;
+		}
+
+		if (Entry.Next != INDEX_NONE)
+		{
+			Entries[Entry.Next].Prev = Entry.Prev;
+		}
+		else
+		{
+			Tail = Entry.Prev;
+		}
+
+		Entry.Prev = INDEX_NONE;
+		Entry.Next = INDEX_NONE;
+	}
+
+	void LinkFront(int32 EntryIdx)
+	{
+		FEntry& Entry = Entries[EntryIdx];
+		Entry.Prev = INDEX_NONE;
+		Entry.Next = Head;
+
+		if (Head != INDEX_NONE)
+		{
+			Entries[Head].Prev = EntryIdx;
+		}
+
+		Head = EntryIdx;
+		if (Tail == INDEX_NONE)
+		{
+			Tail = EntryIdx;
+		}
+	}
+
+	void MoveToFront(int32 EntryIdx)
+	{
+		if (Head != EntryIdx)
+		{
+			Unlink(EntryIdx);
+			LinkFront(EntryIdx);
+		}
+	}
+
+	mutable FCriticalSection CriticalSection;
+	PolicyType Policy;
+	int32 Capacity;
+
+	TArray<FEntry> Entries;
+	TFirebaseAnalyticsNameMap<int32> Index;
+	int32 Head = INDEX_NONE;
+	int32 Tail = INDEX_NONE;
+
+	FFirebaseAnalyticsStringCacheStats Stats;
+};
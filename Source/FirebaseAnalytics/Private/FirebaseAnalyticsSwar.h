@@ -0,0 +1,58 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Word-at-a-time tests over UTF-16 text, four code units per uint64.
+ *	Portable stand-in for SIMD compares, the compiler keeps everything in general purpose registers.
+ */
+namespace FirebaseAnalyticsSwar
+{
+	/** Value repeated in each 16-bit lane of a word. */
+	constexpr uint64 Lanes(uint64 Value)
+	{
+		return Value * 0x0001000100010001ull;
+	}
+
+	/** 0x80 in every lane holding a value between Lo and Hi. Lanes must be 0x7F or below. */
+	FORCEINLINE uint64 LanesInRange(uint64 Word, uint64 Lo, uint64 Hi)
+	{
+		return (Word + Lanes(0x80 - Lo)) & ~(Word + Lanes(0x7F - Hi)) & Lanes(0x80);
+	}
+
+	FORCEINLINE uint64 LoadLanes(const TCHAR* Chars)
+	{
+		uint64 Word;
+		FMemory::Memcpy(&Word, Chars, sizeof(Word));
+		return Word;
+	}
+
+	/** True when no character is above Mask, where Mask + 1 is a power of two no larger than 0x10000. */
+	FORCEINLINE bool AllBelow(const TCHAR* Chars, int32 Length, uint32 Mask)
+	{
+		int32 CharIdx = 0;
+
+		if (sizeof(TCHAR) == 2)
+		{
+			const uint64 HighBits = Lanes(0xFFFF & ~Mask);
+			for (; CharIdx + 4 <= Length; CharIdx += 4)
+			{
+				if (LoadLanes(Chars + CharIdx) & HighBits)
+				{
+					return false;
+				}
+			}
+		}
+
+		for (; CharIdx < Length; ++CharIdx)
+		{
+			if ((uint32)Chars[CharIdx] > Mask)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
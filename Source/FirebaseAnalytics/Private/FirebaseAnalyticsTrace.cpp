@@ -0,0 +1,132 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsTrace.h"
+#include "FirebaseAnalytics.h"
+#include "FirebaseAnalyticsLog.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+
+FFirebaseAnalyticsTraceWriter::~FFirebaseAnalyticsTraceWriter()
+{
+	Stop();
+}
+
+bool FFirebaseAnalyticsTraceWriter::Start(const FString& InFilename)
+{
+	Stop();
+
+	FScopeLock Lock(&CriticalSection);
+
+	Writer = IFileManager::Get().CreateFileWriter(*InFilename);
+	if (Writer == nullptr)
+	{
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Can't open Firebase Analytics trace %s"), *InFilename);
+		return false;
+	}
+
+	uint32 Magic = FirebaseAnalyticsTraceMagic;
+	uint32 Version = FirebaseAnalyticsTraceVersion;
+	*Writer << Magic << Version;
+
+	Filename = InFilename;
+	StartCycles = FPlatformTime::Cycles64();
+	NumRecords = 0;
+	bRecording = true;
+
+	UE_LOG(LogFirebaseAnalytics, Log, TEXT("Recording Firebase Analytics trace to %s"), *Filename);
+	return true;
+}
+
+void FFirebaseAnalyticsTraceWriter::Stop()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (Writer)
+	{
+		bRecording = false;
+		delete Writer;
+		Writer = nullptr;
+
+		UE_LOG(LogFirebaseAnalytics, Log, TEXT("Firebase Analytics trace %s closed with %d calls"), *Filename, NumRecords);
+	}
+}
+
+void FFirebaseAnalyticsTraceWriter::RecordLocked(const FFirebaseAnalyticsCall& Call)
+{
+	FScopeLock Lock(&CriticalSection);
+	if (Writer == nullptr)
+	{
+		return;
+	}
+
+	const int64 Microseconds = (int64)(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0);
+	RecordWriter.Write(*Writer, Microseconds, Call);
+	NumRecords++;
+}
+
+FString GetDefaultFirebaseAnalyticsTraceFilename()
+{
+	return FPaths::ProjectSavedDir() / TEXT("FirebaseAnalytics") / FString::Printf(TEXT("Trace-%s.fatrace"), *FDateTime::Now().ToString());
+}
+
+bool LoadFirebaseAnalyticsTrace(const FString& Filename, TArray<FFirebaseAnalyticsTraceRecord>& OutRecords)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Reader << Magic << Version;
+	if (Reader->IsError() || Magic != FirebaseAnalyticsTraceMagic || Version != FirebaseAnalyticsTraceVersion)
+	{
+		return false;
+	}
+
+	FFirebaseAnalyticsCallRecordReader RecordReader;
+	while (!Reader->AtEnd())
+	{
+		int64 Microseconds = 0;
+		FFirebaseAnalyticsTraceRecord Record;
+		if (!RecordReader.Read(*Reader, Microseconds, Record.Call))
+		{
+			// A recording cut short by a crash ends mid-record
+			UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Firebase Analytics trace %s is damaged after %d calls"), *Filename, OutRecords.Num());
+			break;
+		}
+
+		Record.Seconds = Microseconds / 1000000.0;
+		OutRecords.Add(MoveTemp(Record));
+	}
+
+	return true;
+}
+
+static FAutoConsoleCommand StartTraceCommand(
+	TEXT("FirebaseAnalytics.StartTrace"),
+	TEXT("Record every Firebase Analytics call to a trace file for FirebaseAnalyticsReplay. Optional argument: file name."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get())
+		{
+			Module->GetTraceWriter().Start(Args.Num() > 0 ? Args[0] : GetDefaultFirebaseAnalyticsTraceFilename());
+		}
+	}));
+
+static FAutoConsoleCommand StopTraceCommand(
+	TEXT("FirebaseAnalytics.StopTrace"),
+	TEXT("Stop recording the Firebase Analytics trace."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		if (FFirebaseAnalyticsModule* Module = FFirebaseAnalyticsModule::Get())
+		{
+			Module->GetTraceWriter().Stop();
+		}
+	}));
@@ -0,0 +1,62 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsCallRecord.h"
+#include "FirebaseAnalyticsEvent.h"
+
+/** Trace file layout, written through FArchive:
+ *
+ *	Trace	:= uint32 Magic, uint32 Version, Record...
+ *
+ *	Records are laid out as in FFirebaseAnalyticsCallRecordWriter, their time in microseconds from the moment recording started.
+ */
+static constexpr uint32 FirebaseAnalyticsTraceMagic = 0x52544146; // "FATR"
+static constexpr uint32 FirebaseAnalyticsTraceVersion = 1;
+
+struct FFirebaseAnalyticsTraceRecord
+{
+	double Seconds = 0.0;
+	FFirebaseAnalyticsCall Call;
+};
+
+/** Records every call passed to SubmitCall while it's running. Safe to call from any thread. */
+class FFirebaseAnalyticsTraceWriter
+{
+public:
+	~FFirebaseAnalyticsTraceWriter();
+
+	/** Start writing to Filename, replacing it. Stops a previous recording first. */
+	bool Start(const FString& Filename);
+	void Stop();
+
+	bool IsRecording() const { return bRecording; }
+
+	/** Costs one atomic load while not recording. */
+	void Record(const FFirebaseAnalyticsCall& Call)
+	{
+		if (bRecording)
+		{
+			RecordLocked(Call);
+		}
+	}
+
+private:
+	void RecordLocked(const FFirebaseAnalyticsCall& Call);
+
+	FCriticalSection CriticalSection;
+	FArchive* Writer = nullptr;
+	FString Filename;
+	uint64 StartCycles = 0;
+	int32 NumRecords = 0;
+	TAtomic<bool> bRecording{false};
+
+	FFirebaseAnalyticsCallRecordWriter RecordWriter;
+};
+
+/** Saved/FirebaseAnalytics/Trace-<timestamp>.fatrace */
+FString GetDefaultFirebaseAnalyticsTraceFilename();
+
+/** Read a whole trace. Returns false if the file is missing or not a trace, records up to a damaged tail are kept. */
+bool LoadFirebaseAnalyticsTrace(const FString& Filename, TArray<FFirebaseAnalyticsTraceRecord>& OutRecords);
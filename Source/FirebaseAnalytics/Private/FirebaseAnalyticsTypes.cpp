@@ -0,0 +1,462 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsTypes.h"
+#include "FirebaseAnalyticsBuiltinNames.h"
+
+const TCHAR* FFirebaseAnalyticsParameter::GetName() const
+{
+	return IsBuiltin() ? GetBuiltinParamNameLiteral((EBuiltinParamNames)BuiltinName) : StaticName ? StaticName : *Name;
+}
+
+bool FFirebaseAnalyticsParameter::HasName(const TCHAR* OtherName) const
+{
+	return FCString::Strcmp(GetName(), OtherName) == 0;
+}
+
+int32 FFirebaseAnalyticsItemColumn::Num() const
+{
+	switch (Type)
+	{
+		case EFirebaseAnalyticsParameterType::String:	return Strings.Num();
+		case EFirebaseAnalyticsParameterType::Double:	return Doubles.Num();
+		default:										return Integers.Num();
+	}
+}
+
+void FFirebaseAnalyticsItemColumns::SetStrings(EBuiltinParamNames Name, TArrayView<const FString> Values)
+{
+	FindOrAdd(Name, EFirebaseAnalyticsParameterType::String).Strings.Append(Values.GetData(), Values.Num());
+}
+
+void FFirebaseAnalyticsItemColumns::SetStrings(EBuiltinParamNames Name, TArray<FString>&& Values)
+{
+	FindOrAdd(Name, EFirebaseAnalyticsParameterType::String).Strings = MoveTemp(Values);
+}
+
+void FFirebaseAnalyticsItemColumns::SetDoubles(EBuiltinParamNames Name, TArrayView<const double> Values)
+{
+	FindOrAdd(Name, EFirebaseAnalyticsParameterType::Double).Doubles.Append(Values.GetData(), Values.Num());
+}
+
+void FFirebaseAnalyticsItemColumns::SetIntegers(EBuiltinParamNames Name, TArrayView<const int64> Values)
+{
+	FindOrAdd(Name, EFirebaseAnalyticsParameterType::Int64).Integers.Append(Values.GetData(), Values.Num());
+}
+
+int32 FFirebaseAnalyticsItemColumns::Num() const
+{
+	int32 NumItems = 0;
+	for (const FFirebaseAnalyticsItemColumn& Column : Columns)
+	{
+		NumItems = FMath::Max(NumItems, Column.Num());
+	}
+	return NumItems;
+}
+
+FFirebaseAnalyticsItemColumn& FFirebaseAnalyticsItemColumns::FindOrAdd(EBuiltinParamNames Name, EFirebaseAnalyticsParameterType Type)
+{
+	FFirebaseAnalyticsItemColumn* Column = Columns.FindByPredicate([Name](const FFirebaseAnalyticsItemColumn& Candidate)
+	{
+		return Candidate.Name == Name;
+	});
+
+	if (Column == nullptr)
+	{
+		Column = &Columns.AddDefaulted_GetRef();
+		Column->Name = Name;
+	}
+
+	Column->Type = Type;
+	Column->Strings.Reset();
+	Column->Doubles.Reset();
+	Column->Integers.Reset();
+	return *Column;
+}
+
+FFlatBundle::FFlatBundle(const FBundle& Bundle)
+{
+	Parameters.Reserve(
+		Bundle.StringParameters.Num() +
+		Bundle.FloatParameters.Num() +
+		Bundle.IntegerParameters.Num() +
+		Bundle.BundlesParameters.Num());
+
+	for (const auto& Parameter : Bundle.StringParameters)
+	{
+		PutString(Parameter.Key, Parameter.Value);
+	}
+
+	for (const auto& Parameter : Bundle.FloatParameters)
+	{
+		PutFloat(Parameter.Key, Parameter.Value);
+	}
+
+	for (const auto& Parameter : Bundle.IntegerParameters)
+	{
+		PutInteger(Parameter.Key, Parameter.Value);
+	}
+
+	for (const auto& Parameter : Bundle.BundlesParameters)
+	{
+		TArray<FFlatBundle, TInlineAllocator<8>> FlatItems;
+		FlatItems.Reserve(Parameter.Value.Num());
+		for (const FBundle& Item : Parameter.Value)
+		{
+			FlatItems.Emplace(Item);
+		}
+
+		PutBundles(Parameter.Key, FlatItems);
+	}
+}
+
+FFlatBundle::FFlatBundle(FBundle&& Bundle)
+{
+	Parameters.Reserve(
+		Bundle.StringParameters.Num() +
+		Bundle.FloatParameters.Num() +
+		Bundle.IntegerParameters.Num() +
+		Bundle.BundlesParameters.Num());
+
+	for (auto& Parameter : Bundle.StringParameters)
+	{
+		FFirebaseAnalyticsParameter& FlatParameter = FindOrAdd(Parameter.Key);
+		FlatParameter.Type = EFirebaseAnalyticsParameterType::String;
+		FlatParameter.StringValue = MoveTemp(Parameter.Value);
+	}
+
+	for (const auto& Parameter : Bundle.FloatParameters)
+	{
+		PutFloat(Parameter.Key, Parameter.Value);
+	}
+
+	for (const auto& Parameter : Bundle.IntegerParameters)
+	{
+		PutInteger(Parameter.Key, Parameter.Value);
+	}
+
+	for (auto& Parameter : Bundle.BundlesParameters)
+	{
+		TArray<FFlatBundle, TInlineAllocator<8>> FlatItems;
+		FlatItems.Reserve(Parameter.Value.Num());
+		for (FBundle& Item : Parameter.Value)
+		{
+			FlatItems.Emplace(MoveTemp(Item));
+		}
+
+		SetItems(FindOrAdd(Parameter.Key), TArrayView<FFlatBundle>(FlatItems));
+	}
+}
+
+void FFlatBundle::PutString(const FString& Name, const FString& Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::String;
+	Parameter.StringValue = Value;
+}
+
+void FFlatBundle::PutString(EBuiltinParamNames Name, const FString& Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::String;
+	Parameter.StringValue = Value;
+}
+
+void FFlatBundle::PutString(FFirebaseAnalyticsStaticName Name, const FString& Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::String;
+	Parameter.StringValue = Value;
+}
+
+void FFlatBundle::PutFloat(const FString& Name, float Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Float;
+	Parameter.FloatValue = Value;
+}
+
+void FFlatBundle::PutFloat(EBuiltinParamNames Name, float Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Float;
+	Parameter.FloatValue = Value;
+}
+
+void FFlatBundle::PutFloat(FFirebaseAnalyticsStaticName Name, float Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Float;
+	Parameter.FloatValue = Value;
+}
+
+void FFlatBundle::PutDouble(const FString& Name, double Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Double;
+	Parameter.DoubleValue = Value;
+}
+
+void FFlatBundle::PutDouble(EBuiltinParamNames Name, double Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Double;
+	Parameter.DoubleValue = Value;
+}
+
+void FFlatBundle::PutDouble(FFirebaseAnalyticsStaticName Name, double Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Double;
+	Parameter.DoubleValue = Value;
+}
+
+void FFlatBundle::PutInteger(const FString& Name, int32 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Integer;
+	Parameter.IntegerValue = Value;
+}
+
+void FFlatBundle::PutInteger(EBuiltinParamNames Name, int32 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Integer;
+	Parameter.IntegerValue = Value;
+}
+
+void FFlatBundle::PutInteger(FFirebaseAnalyticsStaticName Name, int32 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Integer;
+	Parameter.IntegerValue = Value;
+}
+
+void FFlatBundle::PutInt64(const FString& Name, int64 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Int64;
+	Parameter.Int64Value = Value;
+}
+
+void FFlatBundle::PutInt64(EBuiltinParamNames Name, int64 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Int64;
+	Parameter.Int64Value = Value;
+}
+
+void FFlatBundle::PutInt64(FFirebaseAnalyticsStaticName Name, int64 Value)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Int64;
+	Parameter.Int64Value = Value;
+}
+
+void FFlatBundle::PutBundles(const FString& Name, TArrayView<const FFlatBundle> Value)
+{
+	SetItems(FindOrAdd(Name), Value);
+}
+
+void FFlatBundle::PutBundles(EBuiltinParamNames Name, TArrayView<const FFlatBundle> Value)
+{
+	SetItems(FindOrAdd(Name), Value);
+}
+
+void FFlatBundle::PutBundles(FFirebaseAnalyticsStaticName Name, TArrayView<const FFlatBundle> Value)
+{
+	SetItems(FindOrAdd(Name), Value);
+}
+
+void FFlatBundle::PutBundles(const FString& Name, TArray<FFlatBundle>&& Value)
+{
+	SetItems(FindOrAdd(Name), TArrayView<FFlatBundle>(Value));
+	Value.Reset();
+}
+
+void FFlatBundle::PutBundles(EBuiltinParamNames Name, TArray<FFlatBundle>&& Value)
+{
+	SetItems(FindOrAdd(Name), TArrayView<FFlatBundle>(Value));
+	Value.Reset();
+}
+
+void FFlatBundle::PutBundles(FFirebaseAnalyticsStaticName Name, TArray<FFlatBundle>&& Value)
+{
+	SetItems(FindOrAdd(Name), TArrayView<FFlatBundle>(Value));
+	Value.Reset();
+}
+
+void FFlatBundle::PutNull(const FString& Name)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Null;
+	Parameter.StringValue.Empty();
+}
+
+void FFlatBundle::PutNull(EBuiltinParamNames Name)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Null;
+	Parameter.StringValue.Empty();
+}
+
+void FFlatBundle::PutNull(FFirebaseAnalyticsStaticName Name)
+{
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(Name);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Null;
+	Parameter.StringValue.Empty();
+}
+
+TArrayView<const FFirebaseAnalyticsParameter> FFlatBundle::GetItemParameters(
+	const FFirebaseAnalyticsParameter& Parameter,
+	int32 ItemIdx) const
+{
+	check(Parameter.Type == EFirebaseAnalyticsParameterType::Bundles);
+	check(ItemIdx >= 0 && ItemIdx < Parameter.Items.Num);
+
+	const FFlatBundleItemRange& Item = Items[Parameter.Items.First + ItemIdx];
+	return TArrayView<const FFirebaseAnalyticsParameter>(ItemParameters.GetData() + Item.First, Item.Num);
+}
+
+void FFlatBundle::TruncateParameters(int32 NumToKeep)
+{
+	if (NumToKeep < Parameters.Num())
+	{
+		Parameters.SetNum(FMath::Max(NumToKeep, 0), false);
+	}
+}
+
+void FFlatBundle::Reset()
+{
+	Parameters.Reset();
+	ItemParameters.Reset();
+	Items.Reset();
+}
+
+void FFlatBundle::PutItems(const FFirebaseAnalyticsItemColumns& Columns)
+{
+	const int32 NumItems = Columns.Num();
+
+	FFirebaseAnalyticsParameter& Parameter = FindOrAdd(EBuiltinParamNames::ITEMS);
+	Parameter.Type = EFirebaseAnalyticsParameterType::Bundles;
+	Parameter.StringValue.Empty();
+	Parameter.Items.First = Items.Num();
+	Parameter.Items.Num = NumItems;
+
+	ItemParameters.Reserve(ItemParameters.Num() + NumItems * Columns.GetColumns().Num());
+	Items.Reserve(Items.Num() + NumItems);
+
+	// Transposed into rows once here, every backend then sees ordinary items
+	for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+	{
+		FFlatBundleItemRange& Range = Items.AddDefaulted_GetRef();
+		Range.First = ItemParameters.Num();
+		Range.Num = 0;
+
+		for (const FFirebaseAnalyticsItemColumn& Column : Columns.GetColumns())
+		{
+			if (ItemIdx >= Column.Num())
+			{
+				continue;
+			}
+
+			FFirebaseAnalyticsParameter& ItemParameter = ItemParameters.AddDefaulted_GetRef();
+			ItemParameter.BuiltinName = (int16)Column.Name;
+			ItemParameter.Type = Column.Type;
+			switch (Column.Type)
+			{
+				case EFirebaseAnalyticsParameterType::String:
+					ItemParameter.StringValue = Column.Strings[ItemIdx];
+					break;
+				case EFirebaseAnalyticsParameterType::Double:
+					ItemParameter.DoubleValue = Column.Doubles[ItemIdx];
+					break;
+				default:
+					ItemParameter.Int64Value = Column.Integers[ItemIdx];
+					break;
+			}
+			Range.Num++;
+		}
+	}
+}
+
+FFirebaseAnalyticsParameter& FFlatBundle::FindOrAdd(const FString& Name)
+{
+	// Events carry a handful of parameters, a linear scan beats hashing here
+	for (FFirebaseAnalyticsParameter& Parameter : Parameters)
+	{
+		if (Parameter.HasName(*Name))
+		{
+			return Parameter;
+		}
+	}
+
+	FFirebaseAnalyticsParameter& Parameter = Parameters.AddDefaulted_GetRef();
+	Parameter.Name = Name;
+	return Parameter;
+}
+
+FFirebaseAnalyticsParameter& FFlatBundle::FindOrAdd(EBuiltinParamNames Name)
+{
+	const TCHAR* NameLiteral = GetBuiltinParamNameLiteral(Name);
+	for (FFirebaseAnalyticsParameter& Parameter : Parameters)
+	{
+		if (Parameter.BuiltinName == (int16)Name || (!Parameter.IsBuiltin() && Parameter.HasName(NameLiteral)))
+		{
+			return Parameter;
+		}
+	}
+
+	FFirebaseAnalyticsParameter& Parameter = Parameters.AddDefaulted_GetRef();
+	Parameter.BuiltinName = (int16)Name;
+	return Parameter;
+}
+
+FFirebaseAnalyticsParameter& FFlatBundle::FindOrAdd(FFirebaseAnalyticsStaticName Name)
+{
+	for (FFirebaseAnalyticsParameter& Parameter : Parameters)
+	{
+		if (Parameter.StaticName == Name.Name || Parameter.HasName(Name.Name))
+		{
+			return Parameter;
+		}
+	}
+
+	FFirebaseAnalyticsParameter& Parameter = Parameters.AddDefaulted_GetRef();
+	Parameter.StaticName = Name.Name;
+	return Parameter;
+}
+
+static const FFirebaseAnalyticsParameter& FirebaseAnalyticsTakeItemParameter(const FFirebaseAnalyticsParameter& Parameter)
+{
+	return Parameter;
+}
+
+static FFirebaseAnalyticsParameter&& FirebaseAnalyticsTakeItemParameter(FFirebaseAnalyticsParameter& Parameter)
+{
+	return MoveTemp(Parameter);
+}
+
+template <typename ItemType>
+void FFlatBundle::SetItems(FFirebaseAnalyticsParameter& Parameter, TArrayView<ItemType> Value)
+{
+	Parameter.Type = EFirebaseAnalyticsParameterType::Bundles;
+	Parameter.StringValue.Empty();
+	Parameter.Items.First = Items.Num();
+	Parameter.Items.Num = Value.Num();
+
+	for (ItemType& Item : Value)
+	{
+		FFlatBundleItemRange& Range = Items.AddDefaulted_GetRef();
+		Range.First = ItemParameters.Num();
+		Range.Num = 0;
+
+		for (auto& ItemParameter : Item.Parameters)
+		{
+			if (ItemParameter.Type != EFirebaseAnalyticsParameterType::Bundles)
+			{
+				ItemParameters.Add(FirebaseAnalyticsTakeItemParameter(ItemParameter));
+				Range.Num++;
+			}
+		}
+	}
+}
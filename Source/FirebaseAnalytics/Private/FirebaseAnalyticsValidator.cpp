@@ -0,0 +1,389 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "FirebaseAnalyticsValidator.h"
+#include "FirebaseAnalyticsLog.h"
+#include "FirebaseAnalyticsSettings.h"
+#include "FirebaseAnalyticsSwar.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
+
+const TCHAR* LexToString(EFirebaseAnalyticsNameError Error)
+{
+	switch (Error)
+	{
+	case EFirebaseAnalyticsNameError::None: return TEXT("valid");
+	case EFirebaseAnalyticsNameError::Empty: return TEXT("empty");
+	case EFirebaseAnalyticsNameError::BadFirstChar: return TEXT("doesn't start with a letter");
+	case EFirebaseAnalyticsNameError::BadChar: return TEXT("has characters other than letters, digits and underscores");
+	case EFirebaseAnalyticsNameError::ReservedPrefix: return TEXT("starts with a reserved prefix");
+	case EFirebaseAnalyticsNameError::Reserved: return TEXT("is reserved");
+	case EFirebaseAnalyticsNameError::TooLong: return TEXT("is too long");
+	default: return TEXT("unknown");
+	}
+}
+
+static const TCHAR* FirebaseAnalyticsNameKindToString(EFirebaseAnalyticsNameKind Kind)
+{
+	switch (Kind)
+	{
+	case EFirebaseAnalyticsNameKind::Event: return TEXT("Event name");
+	case EFirebaseAnalyticsNameKind::Parameter: return TEXT("Parameter name");
+	case EFirebaseAnalyticsNameKind::UserProperty: return TEXT("User property name");
+	default: return TEXT("Name");
+	}
+}
+
+/** Float and integer widths are interchangeable, Blueprint can only produce the narrow ones. */
+static bool FirebaseAnalyticsSchemaTypeMatches(EFirebaseAnalyticsParameterType Expected, EFirebaseAnalyticsParameterType Actual)
+{
+	switch (Expected)
+	{
+	case EFirebaseAnalyticsParameterType::Float:
+	case EFirebaseAnalyticsParameterType::Double:
+		return Actual == EFirebaseAnalyticsParameterType::Float || Actual == EFirebaseAnalyticsParameterType::Double;
+	case EFirebaseAnalyticsParameterType::Integer:
+	case EFirebaseAnalyticsParameterType::Int64:
+		return Actual == EFirebaseAnalyticsParameterType::Integer || Actual == EFirebaseAnalyticsParameterType::Int64;
+	default:
+		return Actual == Expected;
+	}
+}
+
+FFirebaseAnalyticsValidator::FFirebaseAnalyticsValidator(const UFirebaseAnalyticsSettings& Settings)
+	: Policy(Settings.Validation)
+	, SampleRateParameterName(Settings.SampleRateParameterName)
+	, bRejectEventsOutsideSchema(Settings.bRejectEventsOutsideSchema && UE_BUILD_SHIPPING)
+{
+	for (const FFirebaseAnalyticsEventSchema& Event : Settings.EventSchema)
+	{
+		Schema.Add(Event.EventName, Event.Parameters);
+	}
+
+	ValidateSchema();
+}
+
+void FFirebaseAnalyticsValidator::ValidateSchema()
+{
+	for (const TPair<FString, TArray<FFirebaseAnalyticsParameterSchema>>& Event : Schema)
+	{
+		const EFirebaseAnalyticsNameError EventError = CheckNameCached(Event.Key, EFirebaseAnalyticsNameKind::Event);
+		if (EventError != EFirebaseAnalyticsNameError::None)
+		{
+			UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Event schema: event name \"%s\" %s"), *Event.Key, LexToString(EventError));
+		}
+
+		if (Event.Value.Num() > FirebaseAnalyticsLimits::MaxParameters)
+		{
+			UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Event schema: \"%s\" has more than %d parameters"), *Event.Key, FirebaseAnalyticsLimits::MaxParameters);
+		}
+
+		for (const FFirebaseAnalyticsParameterSchema& Parameter : Event.Value)
+		{
+			const EFirebaseAnalyticsNameError ParameterError = CheckNameCached(Parameter.Name, EFirebaseAnalyticsNameKind::Parameter);
+			if (ParameterError != EFirebaseAnalyticsNameError::None)
+			{
+				UE_LOG(LogFirebaseAnalytics, Warning, TEXT("Event schema: parameter name \"%s\" of \"%s\" %s"),
+					*Parameter.Name, *Event.Key, LexToString(ParameterError));
+			}
+		}
+	}
+}
+
+bool FFirebaseAnalyticsValidator::MatchSchema(const FFirebaseAnalyticsEvent& Event)
+{
+	const TArray<FFirebaseAnalyticsParameterSchema>* Expected = Schema.Find(Event.Name);
+	if (Expected == nullptr)
+	{
+		return ReportSchemaMismatch(FString::Printf(TEXT("Event \"%s\" isn't in the event schema"), *Event.Name));
+	}
+
+	for (const FFirebaseAnalyticsParameter& Parameter : Event.Parameters.GetParameters())
+	{
+		const TCHAR* Name = Parameter.GetName();
+		const FFirebaseAnalyticsParameterSchema* Match = Expected->FindByPredicate([Name](const FFirebaseAnalyticsParameterSchema& Candidate)
+		{
+			return Candidate.Name.Equals(Name, ESearchCase::CaseSensitive);
+		});
+
+		if (Match == nullptr)
+		{
+			if (!SampleRateParameterName.Equals(Name, ESearchCase::CaseSensitive)
+				&& !ReportSchemaMismatch(FString::Printf(TEXT("Parameter \"%s\" of \"%s\" isn't in the event schema"), Name, *Event.Name)))
+			{
+				return false;
+			}
+		}
+		else if (!FirebaseAnalyticsSchemaTypeMatches(Match->Type, Parameter.Type)
+			&& !ReportSchemaMismatch(FString::Printf(TEXT("Parameter \"%s\" of \"%s\" should be %s"),
+				Name, *Event.Name, *StaticEnum<EFirebaseAnalyticsParameterType>()->GetNameStringByValue((int64)Match->Type))))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FFirebaseAnalyticsValidator::HasOnlyNameChars(const TCHAR* Chars, int32 Length)
+{
+	using namespace FirebaseAnalyticsSwar;
+
+	int32 CharIdx = 0;
+
+	if (sizeof(TCHAR) == 2)
+	{
+		// Four UTF-16 code units at a time. Non-ASCII lanes are ruled out first, so the range tests can't carry into the next lane
+		for (; CharIdx + 4 <= Length; CharIdx += 4)
+		{
+			const uint64 Word = LoadLanes(Chars + CharIdx);
+			if (Word & Lanes(0xFF80))
+			{
+				return false;
+			}
+
+			const uint64 Valid =
+				LanesInRange(Word | Lanes(0x20), 'a', 'z') |
+				LanesInRange(Word, '0', '9') |
+				LanesInRange(Word, '_', '_');
+
+			if (Valid != Lanes(0x80))
+			{
+				return false;
+			}
+		}
+	}
+
+	for (; CharIdx < Length; ++CharIdx)
+	{
+		if (!FirebaseAnalyticsLimits::IsNameChar(Chars[CharIdx]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+EFirebaseAnalyticsNameError FFirebaseAnalyticsValidator::CheckName(const TCHAR* Name, int32 Length, EFirebaseAnalyticsNameKind Kind)
+{
+	if (Length == 0)
+	{
+		return EFirebaseAnalyticsNameError::Empty;
+	}
+	if (!FirebaseAnalyticsLimits::IsLetter(Name[0]))
+	{
+		return EFirebaseAnalyticsNameError::BadFirstChar;
+	}
+	if (!HasOnlyNameChars(Name, Length))
+	{
+		return EFirebaseAnalyticsNameError::BadChar;
+	}
+	if (FirebaseAnalyticsLimits::HasReservedPrefix(Name))
+	{
+		return EFirebaseAnalyticsNameError::ReservedPrefix;
+	}
+	if (FirebaseAnalyticsLimits::IsReservedName(Name, Kind))
+	{
+		return EFirebaseAnalyticsNameError::Reserved;
+	}
+	if (Length > FirebaseAnalyticsLimits::GetMaxNameLength(Kind))
+	{
+		return EFirebaseAnalyticsNameError::TooLong;
+	}
+	return EFirebaseAnalyticsNameError::None;
+}
+
+EFirebaseAnalyticsNameError FFirebaseAnalyticsValidator::CheckNameCached(const FString& Name, EFirebaseAnalyticsNameKind Kind)
+{
+	TFirebaseAnalyticsNameMap<EFirebaseAnalyticsNameError>& Cache = NameCaches[(int32)Kind];
+
+	{
+		FRWScopeLock Lock(CacheLock, SLT_ReadOnly);
+		if (const EFirebaseAnalyticsNameError* Error = Cache.Find(Name))
+		{
+			return *Error;
+		}
+	}
+
+	const EFirebaseAnalyticsNameError Error = CheckName(*Name, Name.Len(), Kind);
+
+	// Past the cap names are checked every time rather than evicting, a game rarely has that many
+	FRWScopeLock Lock(CacheLock, SLT_Write);
+	if (Cache.Num() < MaxCachedNames)
+	{
+		Cache.Add(Name, Error);
+	}
+
+	return Error;
+}
+
+bool FFirebaseAnalyticsValidator::Validate(FFirebaseAnalyticsCall& Call)
+{
+	// Typed events are declared in code, their names were checked while compiling
+	const bool bCheckNames = !Call.bNamesValidated;
+
+	if (Call.Type == EFirebaseAnalyticsCallType::LogEvent && bCheckNames && Schema.Num() > 0 && !MatchSchema(Call.Event))
+	{
+		return false;
+	}
+
+	if (Policy == EFirebaseAnalyticsValidationPolicy::Off)
+	{
+		return true;
+	}
+
+	switch (Call.Type)
+	{
+	case EFirebaseAnalyticsCallType::LogEvent:
+		return (!bCheckNames || ValidateName(Call.Event.Name, EFirebaseAnalyticsNameKind::Event))
+			&& ValidateParameters(Call.Event.Parameters, Call.Event.Name, bCheckNames);
+
+	case EFirebaseAnalyticsCallType::SetUserProperty:
+		return ValidateName(Call.Event.Name, EFirebaseAnalyticsNameKind::UserProperty)
+			&& ValidateValue(Call.Value, FirebaseAnalyticsLimits::MaxUserPropertyValueLength, TEXT("Value of user property"), Call.Event.Name);
+
+	case EFirebaseAnalyticsCallType::SetUserID:
+		return ValidateValue(Call.Value, FirebaseAnalyticsLimits::MaxUserIDLength, TEXT("User ID"), FString());
+
+	case EFirebaseAnalyticsCallType::SetDefaultEventParameters:
+		return ValidateParameters(Call.Event.Parameters, TEXT("default event parameters"), bCheckNames);
+
+	default:
+		return true;
+	}
+}
+
+bool FFirebaseAnalyticsValidator::ValidateName(FString& Name, EFirebaseAnalyticsNameKind Kind)
+{
+	const EFirebaseAnalyticsNameError Error = CheckNameCached(Name, Kind);
+	if (Error == EFirebaseAnalyticsNameError::None)
+	{
+		return true;
+	}
+
+	const bool bFixable = Error == EFirebaseAnalyticsNameError::TooLong;
+	if (!Report(bFixable, FString::Printf(TEXT("%s \"%s\" %s"), FirebaseAnalyticsNameKindToString(Kind), *Name, LexToString(Error))))
+	{
+		return false;
+	}
+
+	if (bFixable && Policy == EFirebaseAnalyticsValidationPolicy::Truncate)
+	{
+		// The shorter name could still be reserved, so it is checked like any other
+		Name.LeftInline(FirebaseAnalyticsLimits::GetMaxNameLength(Kind), false);
+		return CheckNameCached(Name, Kind) == EFirebaseAnalyticsNameError::None;
+	}
+
+	return true;
+}
+
+bool FFirebaseAnalyticsValidator::ValidateValue(FString& Value, int32 MaxLength, const TCHAR* What, const FString& Owner)
+{
+	if (Value.Len() <= MaxLength)
+	{
+		return true;
+	}
+
+	const FString Message = Owner.IsEmpty()
+		? FString::Printf(TEXT("%s is longer than %d characters"), What, MaxLength)
+		: FString::Printf(TEXT("%s \"%s\" is longer than %d characters"), What, *Owner, MaxLength);
+
+	if (!Report(true, Message))
+	{
+		return false;
+	}
+
+	if (Policy == EFirebaseAnalyticsValidationPolicy::Truncate)
+	{
+		Value.LeftInline(MaxLength, false);
+	}
+
+	return true;
+}
+
+bool FFirebaseAnalyticsValidator::ValidateParameters(FFlatBundle& Parameters, const FString& Owner, bool bCheckNames)
+{
+	for (FFirebaseAnalyticsParameter& Parameter : Parameters.GetMutableParameters())
+	{
+		if (!ValidateParameter(Parameter, Owner, bCheckNames))
+		{
+			return false;
+		}
+	}
+
+	// Item parameters follow the same rules as top-level ones
+	for (FFirebaseAnalyticsParameter& Parameter : Parameters.GetMutableItemParameters())
+	{
+		if (!ValidateParameter(Parameter, Owner, bCheckNames))
+		{
+			return false;
+		}
+	}
+
+	if (Parameters.Num() > FirebaseAnalyticsLimits::MaxParameters)
+	{
+		if (!Report(true, FString::Printf(TEXT("\"%s\" has more than %d parameters"), *Owner, FirebaseAnalyticsLimits::MaxParameters)))
+		{
+			return false;
+		}
+
+		if (Policy == EFirebaseAnalyticsValidationPolicy::Truncate)
+		{
+			Parameters.TruncateParameters(FirebaseAnalyticsLimits::MaxParameters);
+		}
+	}
+
+	return true;
+}
+
+bool FFirebaseAnalyticsValidator::ValidateParameter(FFirebaseAnalyticsParameter& Parameter, const FString& Owner, bool bCheckNames)
+{
+	if (bCheckNames && Parameter.HasNameString() && !ValidateName(Parameter.Name, EFirebaseAnalyticsNameKind::Parameter))
+	{
+		return false;
+	}
+
+	if (Parameter.Type == EFirebaseAnalyticsParameterType::String && Parameter.StringValue.Len() > FirebaseAnalyticsLimits::MaxParameterValueLength)
+	{
+		return ValidateValue(Parameter.StringValue, FirebaseAnalyticsLimits::MaxParameterValueLength,
+			*FString::Printf(TEXT("Value of parameter \"%s\" in"), Parameter.GetName()), Owner);
+	}
+
+	return true;
+}
+
+bool FFirebaseAnalyticsValidator::Report(bool bFixable, const FString& Message)
+{
+	bool bKeep = true;
+	const TCHAR* Outcome = TEXT("sent anyway");
+
+	if (Policy == EFirebaseAnalyticsValidationPolicy::Reject
+		|| (Policy == EFirebaseAnalyticsValidationPolicy::Truncate && !bFixable))
+	{
+		bKeep = false;
+		Outcome = TEXT("dropped");
+	}
+	else if (Policy == EFirebaseAnalyticsValidationPolicy::Truncate)
+	{
+		Outcome = TEXT("truncated");
+	}
+
+	LogOnce(Message, Outcome);
+	return bKeep;
+}
+
+bool FFirebaseAnalyticsValidator::ReportSchemaMismatch(const FString& Message)
+{
+	LogOnce(Message, bRejectEventsOutsideSchema ? TEXT("dropped") : TEXT("sent anyway"));
+	return !bRejectEventsOutsideSchema;
+}
+
+void FFirebaseAnalyticsValidator::LogOnce(const FString& Message, const TCHAR* Outcome)
+{
+	FScopeLock Lock(&ReportCriticalSection);
+	if (ReportedMessages.Num() < MaxReportedMessages && !ReportedMessages.Contains(Message))
+	{
+		ReportedMessages.Add(Message, true);
+		UE_LOG(LogFirebaseAnalytics, Warning, TEXT("%s, %s. Further occurrences are not logged."), *Message, Outcome);
+	}
+}
@@ -0,0 +1,77 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsEvent.h"
+#include "FirebaseAnalyticsKeyFuncs.h"
+#include "FirebaseAnalyticsValidation.h"
+
+class UFirebaseAnalyticsSettings;
+
+/** Why a name is refused, in the order the checks run. Only TooLong can be fixed. */
+enum class EFirebaseAnalyticsNameError : uint8
+{
+	None,
+	Empty,
+	BadFirstChar,
+	BadChar,
+	ReservedPrefix,
+	Reserved,
+	TooLong,
+};
+
+const TCHAR* LexToString(EFirebaseAnalyticsNameError Error);
+
+/** Checks calls against the Firebase limits and the event schema before they are marshaled, and applies the configured policy.
+ *	Results for custom names are cached, built-in parameter names are known to be valid and never checked.
+ */
+class FFirebaseAnalyticsValidator
+{
+public:
+	explicit FFirebaseAnalyticsValidator(const UFirebaseAnalyticsSettings& Settings);
+
+	/** Returns false for calls to drop. Under the Truncate policy, fixable problems are fixed in place. */
+	bool Validate(FFirebaseAnalyticsCall& Call);
+
+	/** Uncached check of one name. */
+	static EFirebaseAnalyticsNameError CheckName(const TCHAR* Name, int32 Length, EFirebaseAnalyticsNameKind Kind);
+
+	/** True when every character is an ASCII letter, digit or underscore. */
+	static bool HasOnlyNameChars(const TCHAR* Chars, int32 Length);
+
+private:
+	EFirebaseAnalyticsNameError CheckNameCached(const FString& Name, EFirebaseAnalyticsNameKind Kind);
+
+	bool ValidateName(FString& Name, EFirebaseAnalyticsNameKind Kind);
+	bool ValidateValue(FString& Value, int32 MaxLength, const TCHAR* What, const FString& Owner);
+	bool ValidateParameters(FFlatBundle& Parameters, const FString& Owner, bool bCheckNames);
+	bool ValidateParameter(FFirebaseAnalyticsParameter& Parameter, const FString& Owner, bool bCheckNames);
+
+	/** Check the schema itself once, so bad entries show up at startup rather than on first use. */
+	void ValidateSchema();
+
+	/** Returns false for events to drop because they are missing from the schema or don't match it. */
+	bool MatchSchema(const FFirebaseAnalyticsEvent& Event);
+
+	/** Log the problem once and return whether the call is kept. */
+	bool Report(bool bFixable, const FString& Message);
+	bool ReportSchemaMismatch(const FString& Message);
+	void LogOnce(const FString& Message, const TCHAR* Outcome);
+
+	static constexpr int32 MaxCachedNames = 1024;
+	static constexpr int32 MaxReportedMessages = 256;
+
+	EFirebaseAnalyticsValidationPolicy Policy;
+
+	/** Parameters allowed per event name. Empty when there is no schema. */
+	TFirebaseAnalyticsNameMap<TArray<FFirebaseAnalyticsParameterSchema>> Schema;
+	FString SampleRateParameterName;
+	bool bRejectEventsOutsideSchema = false;
+
+	FRWLock CacheLock;
+	TFirebaseAnalyticsNameMap<EFirebaseAnalyticsNameError> NameCaches[3];
+
+	FCriticalSection ReportCriticalSection;
+	TFirebaseAnalyticsNameMap<bool> ReportedMessages;
+};
@@ -0,0 +1,200 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include <limits>
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "FirebaseAnalyticsBackends.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** One call of every type, with values the JSON writer has to escape. */
+static TArray<FFirebaseAnalyticsCall> MakeBackendsTestCalls()
+{
+	TArray<FFirebaseAnalyticsCall> Calls;
+
+	FFirebaseAnalyticsCall& Event = Calls.AddDefaulted_GetRef();
+	Event.Type = EFirebaseAnalyticsCallType::LogEvent;
+	Event.Event.Name = TEXT("level_up");
+	Event.Event.Parameters.PutInteger(EBuiltinParamNames::LEVEL, 3);
+	Event.Event.Parameters.PutString(EBuiltinParamNames::CHARACTER, TEXT("\"Ren\"\n\\caf\u00e9\x01"));
+	Event.Event.Parameters.PutDouble(TEXT("ratio"), 0.5);
+	Event.Event.Parameters.PutFloat(TEXT("broken"), std::numeric_limits<float>::infinity());
+	Event.Event.Parameters.PutInt64(TEXT("big"), (int64)1 << 40);
+	Event.Event.Parameters.PutNull(TEXT("cleared"));
+
+	TArray<FFlatBundle> Items;
+	Items.SetNum(2);
+	Items[0].PutString(EBuiltinParamNames::ITEM_ID, TEXT("sword"));
+	Items[1].PutString(EBuiltinParamNames::ITEM_ID, TEXT("shield"));
+	Event.Event.Parameters.PutBundles(EBuiltinParamNames::ITEMS, MoveTemp(Items));
+
+	Calls.AddDefaulted_GetRef().Type = EFirebaseAnalyticsCallType::ResetAnalyticsData;
+
+	FFirebaseAnalyticsCall& Enabled = Calls.AddDefaulted_GetRef();
+	Enabled.Type = EFirebaseAnalyticsCallType::SetAnalyticsCollectionEnabled;
+	Enabled.IntegerValue = 1;
+
+	FFirebaseAnalyticsCall& Timeout = Calls.AddDefaulted_GetRef();
+	Timeout.Type = EFirebaseAnalyticsCallType::SetSessionTimeoutDuration;
+	Timeout.IntegerValue = 1800000;
+
+	FFirebaseAnalyticsCall& UserID = Calls.AddDefaulted_GetRef();
+	UserID.Type = EFirebaseAnalyticsCallType::SetUserID;
+	UserID.Value = TEXT("player\t42");
+
+	FFirebaseAnalyticsCall& Property = Calls.AddDefaulted_GetRef();
+	Property.Type = EFirebaseAnalyticsCallType::SetUserProperty;
+	Property.Event.Name = TEXT("favorite_food");
+	Property.Value = TEXT("pizza");
+
+	FFirebaseAnalyticsCall& Defaults = Calls.AddDefaulted_GetRef();
+	Defaults.Type = EFirebaseAnalyticsCallType::SetDefaultEventParameters;
+	Defaults.Event.Parameters.PutString(TEXT("build"), TEXT("1.0"));
+
+	return Calls;
+}
+
+/** Lines of a UTF-8 file, without their line ends. */
+static TArray<FString> LoadBackendsTestLines(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	FFileHelper::LoadFileToArray(Bytes, *Filename);
+
+	const FUTF8ToTCHAR Converted((const ANSICHAR*)Bytes.GetData(), Bytes.Num());
+	TArray<FString> Lines;
+	FString(Converted.Length(), Converted.Get()).ParseIntoArray(Lines, TEXT("\n"), false);
+	if (Lines.Num() > 0 && Lines.Last().IsEmpty())
+	{
+		Lines.Pop();
+	}
+	return Lines;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBackendsMemoryTest,
+	"Plugins.FirebaseAnalytics.Backends.Memory",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBackendsMemoryTest::RunTest(const FString& Parameters)
+{
+	const TArray<FFirebaseAnalyticsCall> Calls = MakeBackendsTestCalls();
+
+	// Room for every call keeps them all, in order
+	FFirebaseAnalyticsMemoryBackend Roomy(Calls.Num());
+	for (const FFirebaseAnalyticsCall& Call : Calls)
+	{
+		Roomy.Apply(Call);
+	}
+
+	const TArray<FFirebaseAnalyticsCall> Kept = Roomy.GetCalls();
+	if (TestEqual(TEXT("Calls kept"), Kept.Num(), Calls.Num()))
+	{
+		for (int32 CallIdx = 0; CallIdx < Calls.Num(); CallIdx++)
+		{
+			TestEqual(*FString::Printf(TEXT("Call %d"), CallIdx), FirebaseAnalyticsCallToJson(Kept[CallIdx]), FirebaseAnalyticsCallToJson(Calls[CallIdx]));
+		}
+	}
+
+	// A smaller ring overwrites the oldest and still hands the rest back oldest first
+	FFirebaseAnalyticsMemoryBackend Ring(3);
+	for (int32 Round = 0; Round < 2; Round++)
+	{
+		for (const FFirebaseAnalyticsCall& Call : Calls)
+		{
+			Ring.Apply(Call);
+		}
+	}
+
+	TestEqual(TEXT("Calls received by the ring"), Ring.GetNumReceived(), (int64)Calls.Num() * 2);
+	const TArray<FFirebaseAnalyticsCall> Newest = Ring.GetCalls();
+	if (TestEqual(TEXT("Calls kept by the ring"), Newest.Num(), 3))
+	{
+		for (int32 CallIdx = 0; CallIdx < 3; CallIdx++)
+		{
+			const FFirebaseAnalyticsCall& Expected = Calls[Calls.Num() - 3 + CallIdx];
+			TestEqual(*FString::Printf(TEXT("Ring call %d"), CallIdx), FirebaseAnalyticsCallToJson(Newest[CallIdx]), FirebaseAnalyticsCallToJson(Expected));
+		}
+	}
+
+	// A reused slot doesn't keep fields of the call it held before
+	FFirebaseAnalyticsMemoryBackend Single(0);
+	TestEqual(TEXT("Capacity clamped"), Single.GetCapacity(), 1);
+	Single.Apply(Calls[0]);
+	Single.ResetAnalyticsData();
+	const TArray<FFirebaseAnalyticsCall> Last = Single.GetCalls();
+	TestTrue(TEXT("Reused slot starts empty"), Last.Num() == 1 && Last[0].Event.Name.IsEmpty() && Last[0].Event.Parameters.IsEmpty());
+
+	TArray<FFirebaseAnalyticsEvent> Events;
+	Events.Add(Calls[0].Event);
+	Events.Add(Calls[0].Event);
+	Ring.Empty();
+	Ring.LogEvents(Events);
+	TestEqual(TEXT("Calls received after Empty"), Ring.GetNumReceived(), (int64)2);
+	TestEqual(TEXT("Calls kept after Empty"), Ring.GetCalls().Num(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBackendsFileTest,
+	"Plugins.FirebaseAnalytics.Backends.File",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBackendsFileTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() / TEXT("FirebaseAnalyticsFileBackend.jsonl");
+	IFileManager::Get().Delete(*Filename, false, true, true);
+
+	const TArray<FFirebaseAnalyticsCall> Calls = MakeBackendsTestCalls();
+	{
+		FFirebaseAnalyticsFileBackend Backend(Filename);
+		for (const FFirebaseAnalyticsCall& Call : Calls)
+		{
+			Backend.Apply(Call);
+		}
+		Backend.Flush();
+
+		// Flushed lines are readable while the backend still has the file open
+		TestEqual(TEXT("Lines after Flush"), LoadBackendsTestLines(Filename).Num(), Calls.Num());
+	}
+
+	// A second backend appends to what the first one wrote
+	{
+		FFirebaseAnalyticsFileBackend Backend(Filename);
+		TArray<FFirebaseAnalyticsEvent> Events;
+		Events.Add(Calls[0].Event);
+		Backend.LogEvents(Events);
+	}
+
+	const TArray<FString> Lines = LoadBackendsTestLines(Filename);
+	if (TestEqual(TEXT("Lines written"), Lines.Num(), Calls.Num() + 1))
+	{
+		// Each line is exactly the call as FirebaseAnalyticsCallToJson formats it
+		for (int32 CallIdx = 0; CallIdx < Calls.Num(); CallIdx++)
+		{
+			TestEqual(*FString::Printf(TEXT("Line %d"), CallIdx), Lines[CallIdx], FirebaseAnalyticsCallToJson(Calls[CallIdx]));
+		}
+		TestEqual(TEXT("Appended line"), Lines.Last(), FirebaseAnalyticsCallToJson(Calls[0]));
+
+		TestEqual(TEXT("Event line"), Lines[0], FString(
+			TEXT("{\"call\":\"log_event\",\"name\":\"level_up\",\"params\":{")
+			TEXT("\"level\":3,")
+			TEXT("\"character\":\"\\\"Ren\\\"\\n\\\\caf\u00e9\\u0001\",")
+			TEXT("\"ratio\":0.5,")
+			TEXT("\"broken\":null,")
+			TEXT("\"big\":1099511627776,")
+			TEXT("\"cleared\":null,")
+			TEXT("\"items\":[{\"item_id\":\"sword\"},{\"item_id\":\"shield\"}]}}")));
+		TestEqual(TEXT("Collection line"), Lines[2], FString(TEXT("{\"call\":\"set_analytics_collection_enabled\",\"value\":true}")));
+		TestEqual(TEXT("User ID line"), Lines[4], FString(TEXT("{\"call\":\"set_user_id\",\"value\":\"player\\t42\"}")));
+	}
+
+	IFileManager::Get().Delete(*Filename, false, true, true);
+
+	return true;
+}
+
+#endif
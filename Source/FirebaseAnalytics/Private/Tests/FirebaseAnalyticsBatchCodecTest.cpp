@@ -0,0 +1,293 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsBatchCodec.h"
+#include "FirebaseAnalyticsTestBundles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Events with every parameter type and every kind of string, plus a few random ones. */
+static TArray<FFirebaseAnalyticsEvent> MakeBatchCodecTestEvents()
+{
+	TArray<FFirebaseAnalyticsEvent> Events;
+
+	FFirebaseAnalyticsEvent& Purchase = Events.AddDefaulted_GetRef();
+	Purchase.Name = TEXT("purchase");
+	Purchase.Parameters.PutString(EBuiltinParamNames::CURRENCY, TEXT("EUR"));
+	Purchase.Parameters.PutDouble(EBuiltinParamNames::VALUE, 19.99);
+	Purchase.Parameters.PutFloat(TEXT("discount_rate"), 0.15f);
+	Purchase.Parameters.PutInteger(FFirebaseAnalyticsStaticName(TEXT("attempt")), -3);
+	Purchase.Parameters.PutInt64(TEXT("order_number"), (int64)1 << 40);
+	Purchase.Parameters.PutNull(TEXT("coupon"));
+	Purchase.Parameters.PutString(TEXT("store"), TEXT("caf\u00e9 \u00fcber"));
+	Purchase.Parameters.PutString(TEXT("greeting"), TEXT("\u3053\u3093\u306b\u3061\u306f"));
+	Purchase.Parameters.PutString(TEXT("empty"), FString());
+
+	TArray<FFlatBundle> Items;
+	Items.SetNum(3);
+	for (int32 ItemIdx = 0; ItemIdx < Items.Num(); ItemIdx++)
+	{
+		Items[ItemIdx].PutString(EBuiltinParamNames::ITEM_ID, FString::Printf(TEXT("sku_%d"), ItemIdx));
+		Items[ItemIdx].PutDouble(EBuiltinParamNames::PRICE, ItemIdx * 2.5);
+		Items[ItemIdx].PutInteger(EBuiltinParamNames::QUANTITY, ItemIdx + 1);
+	}
+	Items[2].PutString(EBuiltinParamNames::ITEM_NAME, TEXT("\u0428\u043b\u0435\u043c"));
+	Purchase.Parameters.PutBundles(EBuiltinParamNames::ITEMS, MoveTemp(Items));
+
+	Events.AddDefaulted_GetRef().Name = TEXT("app_open");
+
+	FRandomStream Random(2021);
+	for (int32 EventIdx = 0; EventIdx < 50; EventIdx++)
+	{
+		FFirebaseAnalyticsEvent& Event = Events.AddDefaulted_GetRef();
+		Event.Name = FString::Printf(TEXT("event_%d"), EventIdx);
+		Event.Parameters = FirebaseAnalyticsTestBundles::MakeBundle(Random, 12);
+	}
+
+	return Events;
+}
+
+/** Empty when Decoded holds the same events as Expected, otherwise the first difference. */
+static FString CompareBatchCodecTestEvents(const TArray<FFirebaseAnalyticsEvent>& Expected, const TArray<FFirebaseAnalyticsEvent>& Decoded)
+{
+	if (Expected.Num() != Decoded.Num())
+	{
+		return FString::Printf(TEXT("%d events instead of %d"), Decoded.Num(), Expected.Num());
+	}
+
+	for (int32 EventIdx = 0; EventIdx < Expected.Num(); EventIdx++)
+	{
+		if (!Expected[EventIdx].Name.Equals(Decoded[EventIdx].Name, ESearchCase::CaseSensitive))
+		{
+			return FString::Printf(TEXT("event %d is \"%s\" instead of \"%s\""), EventIdx, *Decoded[EventIdx].Name, *Expected[EventIdx].Name);
+		}
+
+		const FString Difference = FirebaseAnalyticsTestBundles::Compare(Expected[EventIdx].Parameters, Decoded[EventIdx].Parameters);
+		if (!Difference.IsEmpty())
+		{
+			return FString::Printf(TEXT("event %s: %s"), *Expected[EventIdx].Name, *Difference);
+		}
+	}
+
+	return FString();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBatchCodecRoundTripTest,
+	"Plugins.FirebaseAnalytics.BatchCodec.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBatchCodecRoundTripTest::RunTest(const FString& Parameters)
+{
+	const TArray<FFirebaseAnalyticsEvent> Events = MakeBatchCodecTestEvents();
+
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	TArray<FFirebaseAnalyticsEvent> Decoded;
+	TestTrue(TEXT("Empty batch decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Encoder.GetData(), Encoder.GetSize(), Decoded));
+	TestEqual(TEXT("Events in an empty batch"), Decoded.Num(), 0);
+
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		Encoder.AddEvent(Event);
+	}
+	TestEqual(TEXT("Events encoded"), Encoder.GetNumEvents(), Events.Num());
+
+	TestTrue(TEXT("Batch decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Encoder.GetData(), Encoder.GetSize(), Decoded));
+	TestEqual(TEXT("Round trip"), CompareBatchCodecTestEvents(Events, Decoded), FString());
+
+	// A reset encoder starts a new batch on the same buffer
+	Encoder.Reset();
+	Encoder.AddEvent(Events[1]);
+	Decoded.Reset();
+	TestTrue(TEXT("Batch after Reset decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Encoder.GetData(), Encoder.GetSize(), Decoded));
+	TestEqual(TEXT("Round trip after Reset"), CompareBatchCodecTestEvents({Events[1]}, Decoded), FString());
+
+	// Latin-1 strings take one byte per character
+	FFirebaseAnalyticsEvent Narrow;
+	Narrow.Name = TEXT("a");
+	Narrow.Parameters.PutString(TEXT("b"), TEXT("\u00e9\u00e9\u00e9\u00e9"));
+	Encoder.Reset();
+	Encoder.AddEvent(Narrow);
+	TestEqual(TEXT("Size of a Latin-1 event"), Encoder.GetSize(), 5 + (2 + 1) + 4 + 2 + 1 + (2 + 1) + (2 + 4));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBatchCodecMalformedTest,
+	"Plugins.FirebaseAnalytics.BatchCodec.Malformed",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBatchCodecMalformedTest::RunTest(const FString& Parameters)
+{
+	TArray<FFirebaseAnalyticsEvent> Events;
+	for (const TCHAR* Name : {TEXT("first"), TEXT("second"), TEXT("third")})
+	{
+		FFirebaseAnalyticsEvent& Event = Events.AddDefaulted_GetRef();
+		Event.Name = Name;
+		Event.Parameters.PutInteger(EBuiltinParamNames::LEVEL, Events.Num());
+		Event.Parameters.PutString(TEXT("label"), Name);
+	}
+
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	TArray<int32> EventOffsets;
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		EventOffsets.Add(Encoder.GetSize());
+		Encoder.AddEvent(Event);
+	}
+	const TArray<uint8> Batch(Encoder.GetData(), Encoder.GetSize());
+
+	// Every strict prefix is refused, and what was decoded before the cut is still right
+	int32 NumBadPrefixes = 0;
+	for (int32 Size = 0; Size < Batch.Num(); Size++)
+	{
+		TArray<FFirebaseAnalyticsEvent> Decoded;
+		const bool bDecoded = FFirebaseAnalyticsBatchDecoder::Decode(Batch.GetData(), Size, Decoded);
+		const TArray<FFirebaseAnalyticsEvent> Expected(Events.GetData(), FMath::Min(Decoded.Num(), Events.Num()));
+		if ((bDecoded || !CompareBatchCodecTestEvents(Expected, Decoded).IsEmpty()) && NumBadPrefixes++ < 8)
+		{
+			AddError(FString::Printf(TEXT("Prefix of %d bytes decoded to %d events, %s"), Size, Decoded.Num(), bDecoded ? TEXT("accepted") : TEXT("refused")));
+		}
+	}
+	TestEqual(TEXT("Prefixes decoded wrong"), NumBadPrefixes, 0);
+
+	// A broken bundle costs only its own event
+	const int32 SecondNameLength = Events[1].Name.Len();
+	TArray<uint8> BadType = Batch;
+	BadType[EventOffsets[1] + 2 + SecondNameLength + 4 + 2] = 0xEE;
+
+	TArray<FFirebaseAnalyticsEvent> Decoded;
+	TestTrue(TEXT("Batch with a bad parameter type decodes"), FFirebaseAnalyticsBatchDecoder::Decode(BadType.GetData(), BadType.Num(), Decoded));
+	TestEqual(TEXT("Events around a bad parameter type"), CompareBatchCodecTestEvents({Events[0], Events[2]}, Decoded), FString());
+
+	// A bundle shorter than its size says is skipped too
+	TArray<uint8> ShortCount = Batch;
+	ShortCount[EventOffsets[1] + 2 + SecondNameLength + 4] = 1;
+	Decoded.Reset();
+	TestTrue(TEXT("Batch with a short bundle decodes"), FFirebaseAnalyticsBatchDecoder::Decode(ShortCount.GetData(), ShortCount.Num(), Decoded));
+	TestEqual(TEXT("Events around a short bundle"), CompareBatchCodecTestEvents({Events[0], Events[2]}, Decoded), FString());
+
+	// A size past the end of the buffer breaks the framing
+	TArray<uint8> BadSize = Batch;
+	const uint32 HugeSize = MAX_uint32;
+	FMemory::Memcpy(BadSize.GetData() + EventOffsets[1] + 2 + SecondNameLength, &HugeSize, sizeof(HugeSize));
+	Decoded.Reset();
+	TestFalse(TEXT("Batch with a bundle size past the end decodes"), FFirebaseAnalyticsBatchDecoder::Decode(BadSize.GetData(), BadSize.Num(), Decoded));
+	TestEqual(TEXT("Events before a bad bundle size"), CompareBatchCodecTestEvents({Events[0]}, Decoded), FString());
+
+	TArray<uint8> BadVersion = Batch;
+	BadVersion[0] = 99;
+	Decoded.Reset();
+	TestFalse(TEXT("Batch of an unknown version decodes"), FFirebaseAnalyticsBatchDecoder::Decode(BadVersion.GetData(), BadVersion.Num(), Decoded));
+
+	TArray<uint8> Trailing = Batch;
+	Trailing.Add(0);
+	Decoded.Reset();
+	TestFalse(TEXT("Batch with trailing bytes decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Trailing.GetData(), Trailing.Num(), Decoded));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBatchCodecUnframedTest,
+	"Plugins.FirebaseAnalytics.BatchCodec.Unframed",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBatchCodecUnframedTest::RunTest(const FString& Parameters)
+{
+	const TArray<FFirebaseAnalyticsEvent> Events = MakeBatchCodecTestEvents();
+
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	TArray<int32> EventOffsets;
+	for (const FFirebaseAnalyticsEvent& Event : Events)
+	{
+		EventOffsets.Add(Encoder.GetSize());
+		Encoder.AddEvent(Event);
+	}
+	EventOffsets.Add(Encoder.GetSize());
+
+	// Version 3 is the same batch without the size after each event name. Event names here are ASCII.
+	TArray<uint8> Unframed(Encoder.GetData(), EventOffsets[0]);
+	Unframed[0] = FirebaseAnalyticsBatchUnframedVersion;
+	for (int32 EventIdx = 0; EventIdx < Events.Num(); EventIdx++)
+	{
+		const int32 SizeOffset = EventOffsets[EventIdx] + 2 + Events[EventIdx].Name.Len();
+		Unframed.Append(Encoder.GetData() + EventOffsets[EventIdx], SizeOffset - EventOffsets[EventIdx]);
+		Unframed.Append(Encoder.GetData() + SizeOffset + 4, EventOffsets[EventIdx + 1] - SizeOffset - 4);
+	}
+
+	TArray<FFirebaseAnalyticsEvent> Decoded;
+	TestTrue(TEXT("Version 3 batch decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Unframed.GetData(), Unframed.Num(), Decoded));
+	TestEqual(TEXT("Version 3 round trip"), CompareBatchCodecTestEvents(Events, Decoded), FString());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBatchCodecLimitsTest,
+	"Plugins.FirebaseAnalytics.BatchCodec.Limits",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBatchCodecLimitsTest::RunTest(const FString& Parameters)
+{
+	// More items than the uint16 count holds are cut at the count, and the next event still lines up
+	FFirebaseAnalyticsEvent ManyItems;
+	ManyItems.Name = TEXT("view_item_list");
+	TArray<FFlatBundle> Items;
+	Items.SetNum(MAX_uint16 + 10);
+	ManyItems.Parameters.PutBundles(EBuiltinParamNames::ITEMS, MoveTemp(Items));
+
+	// Longer strings are cut at 0x7FFF units, never between the halves of a surrogate pair
+	FFirebaseAnalyticsEvent LongStrings;
+	LongStrings.Name = TEXT("long_strings");
+	const FString LongLatin1 = FString::ChrN(FirebaseAnalyticsBatchMaxStringLength + 100, TEXT('\u00e9'));
+	LongStrings.Parameters.PutString(TEXT("latin1"), LongLatin1);
+	if (sizeof(TCHAR) == sizeof(UTF16CHAR))
+	{
+		FString LongPairs;
+		for (int32 PairIdx = 0; PairIdx < FirebaseAnalyticsBatchMaxStringLength; PairIdx++)
+		{
+			LongPairs.AppendChar((TCHAR)0xD83D);
+			LongPairs.AppendChar((TCHAR)0xDE00);
+		}
+		LongStrings.Parameters.PutString(TEXT("pairs"), LongPairs);
+	}
+
+	FFirebaseAnalyticsBatchEncoder Encoder;
+	Encoder.AddEvent(ManyItems);
+	Encoder.AddEvent(LongStrings);
+
+	TArray<FFirebaseAnalyticsEvent> Decoded;
+	TestTrue(TEXT("Batch past the limits decodes"), FFirebaseAnalyticsBatchDecoder::Decode(Encoder.GetData(), Encoder.GetSize(), Decoded));
+	if (!TestEqual(TEXT("Events past the limits"), Decoded.Num(), 2))
+	{
+		return true;
+	}
+
+	const TArrayView<const FFirebaseAnalyticsParameter> DecodedItems = Decoded[0].Parameters.GetParameters();
+	TestTrue(TEXT("Items parameter kept"), DecodedItems.Num() == 1 && DecodedItems[0].Type == EFirebaseAnalyticsParameterType::Bundles);
+	if (DecodedItems.Num() == 1)
+	{
+		TestEqual(TEXT("Items cut at the count"), DecodedItems[0].Items.Num, (int32)MAX_uint16);
+	}
+
+	const TArrayView<const FFirebaseAnalyticsParameter> DecodedStrings = Decoded[1].Parameters.GetParameters();
+	TestEqual(TEXT("Event after the cut items"), Decoded[1].Name, LongStrings.Name);
+	if (DecodedStrings.Num() >= 1)
+	{
+		TestEqual(TEXT("Latin-1 string cut"), DecodedStrings[0].StringValue, LongLatin1.Left(FirebaseAnalyticsBatchMaxStringLength));
+	}
+	if (DecodedStrings.Num() >= 2)
+	{
+		const FString& Pairs = DecodedStrings[1].StringValue;
+		TestEqual(TEXT("Surrogate pairs cut before a lone half"), Pairs.Len(), FirebaseAnalyticsBatchMaxStringLength - 1);
+		TestTrue(TEXT("Cut string ends on a whole pair"), Pairs.Len() > 0 && Pairs[Pairs.Len() - 1] == (TCHAR)0xDE00);
+	}
+
+	return true;
+}
+
+#endif
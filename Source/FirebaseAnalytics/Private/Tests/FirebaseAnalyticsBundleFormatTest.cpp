@@ -0,0 +1,350 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsBundleFormat.h"
+#include "FirebaseAnalyticsTestBundles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Keys come mostly from a small set so repeats, including ones inside items, take the key index path
+static const TCHAR* const BundleFormatTestKeys[] =
+{
+	TEXT("level"),
+	TEXT("score"),
+	TEXT("item_id"),
+	TEXT("price"),
+	TEXT("caf\u00e9"),
+	TEXT("\u540d\u524d"),
+};
+
+static FBundle MakeBundleFormatTestBundle(FRandomStream& Random, int32 Depth)
+{
+	FBundle Bundle;
+	const int32 NumParameters = Random.RandRange(0, 8);
+	for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ParameterIdx++)
+	{
+		const FString Key = Random.RandRange(0, 3) == 0
+			? FirebaseAnalyticsTestBundles::MakeString(Random, 12)
+			: FString(BundleFormatTestKeys[Random.RandRange(0, UE_ARRAY_COUNT(BundleFormatTestKeys) - 1)]);
+
+		switch (Random.RandRange(0, Depth < 2 ? 3 : 2))
+		{
+			case 0:
+				Bundle.StringParameters.Add(Key, FirebaseAnalyticsTestBundles::MakeString(Random, 60));
+				break;
+			case 1:
+				Bundle.IntegerParameters.Add(Key, (int32)Random.GetUnsignedInt());
+				break;
+			case 2:
+				Bundle.FloatParameters.Add(Key, Random.FRandRange(-1.0e6f, 1.0e6f));
+				break;
+			default:
+			{
+				TArray<FBundle>& Items = Bundle.BundlesParameters.Add(Key);
+				const int32 NumItems = Random.RandRange(0, 4);
+				for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+				{
+					Items.Add(MakeBundleFormatTestBundle(Random, Depth + 1));
+				}
+				break;
+			}
+		}
+	}
+	return Bundle;
+}
+
+/** Bundle holding one item, which holds one item, Depth levels down. */
+static FBundle MakeBundleFormatTestChain(int32 Depth)
+{
+	FBundle Bundle;
+	Bundle.IntegerParameters.Add(TEXT("depth"), Depth);
+	if (Depth > 0)
+	{
+		Bundle.BundlesParameters.Add(TEXT("items")).Add(MakeBundleFormatTestChain(Depth - 1));
+	}
+	return Bundle;
+}
+
+/** Empty when B holds the same parameters as A, otherwise the first difference. */
+static FString CompareBundleFormatTestBundles(const FBundle& A, const FBundle& B)
+{
+	if (A.StringParameters.Num() != B.StringParameters.Num()
+		|| A.IntegerParameters.Num() != B.IntegerParameters.Num()
+		|| A.FloatParameters.Num() != B.FloatParameters.Num()
+		|| A.BundlesParameters.Num() != B.BundlesParameters.Num())
+	{
+		return TEXT("different number of parameters");
+	}
+
+	for (const auto& Parameter : A.StringParameters)
+	{
+		const FString* Value = B.StringParameters.Find(Parameter.Key);
+		if (Value == nullptr || !Value->Equals(Parameter.Value, ESearchCase::CaseSensitive))
+		{
+			return FString::Printf(TEXT("string \"%s\""), *Parameter.Key);
+		}
+	}
+
+	for (const auto& Parameter : A.IntegerParameters)
+	{
+		const int32* Value = B.IntegerParameters.Find(Parameter.Key);
+		if (Value == nullptr || *Value != Parameter.Value)
+		{
+			return FString::Printf(TEXT("integer \"%s\""), *Parameter.Key);
+		}
+	}
+
+	for (const auto& Parameter : A.FloatParameters)
+	{
+		const float* Value = B.FloatParameters.Find(Parameter.Key);
+		if (Value == nullptr || FMemory::Memcmp(Value, &Parameter.Value, sizeof(float)) != 0)
+		{
+			return FString::Printf(TEXT("float \"%s\""), *Parameter.Key);
+		}
+	}
+
+	for (const auto& Parameter : A.BundlesParameters)
+	{
+		const TArray<FBundle>* Items = B.BundlesParameters.Find(Parameter.Key);
+		if (Items == nullptr || Items->Num() != Parameter.Value.Num())
+		{
+			return FString::Printf(TEXT("items of \"%s\""), *Parameter.Key);
+		}
+
+		for (int32 ItemIdx = 0; ItemIdx < Items->Num(); ItemIdx++)
+		{
+			const FString Difference = CompareBundleFormatTestBundles(Parameter.Value[ItemIdx], (*Items)[ItemIdx]);
+			if (!Difference.IsEmpty())
+			{
+				return FString::Printf(TEXT("item %d of \"%s\": %s"), ItemIdx, *Parameter.Key, *Difference);
+			}
+		}
+	}
+
+	return FString();
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBundleFormatRoundTripTest,
+	"Plugins.FirebaseAnalytics.BundleFormat.RoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBundleFormatRoundTripTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(18);
+	int32 NumErrors = 0;
+
+	for (int32 BundleIdx = 0; BundleIdx < 500 && NumErrors < 8; BundleIdx++)
+	{
+		const FBundle Bundle = MakeBundleFormatTestBundle(Random, 0);
+
+		// Appending leaves what was already there alone
+		TArray<uint8> Out = {1, 2, 3};
+		FFirebaseAnalyticsBundleWriter::Write(Bundle, Out);
+		const TArrayView<const uint8> Blob = MakeArrayView(Out).Slice(3, Out.Num() - 3);
+
+		FFirebaseAnalyticsBundleView View;
+		FBundle ReadBack;
+		if (Out[0] != 1 || Out[1] != 2 || Out[2] != 3 || !View.Initialize(Blob))
+		{
+			AddError(FString::Printf(TEXT("Bundle %d: written blob refused"), BundleIdx));
+			NumErrors++;
+			continue;
+		}
+
+		View.ToBundle(ReadBack);
+		const FString Difference = CompareBundleFormatTestBundles(Bundle, ReadBack);
+		if (!Difference.IsEmpty())
+		{
+			AddError(FString::Printf(TEXT("Bundle %d: %s"), BundleIdx, *Difference));
+			NumErrors++;
+		}
+
+		// The fixed span form writes the same bytes, and reports a span one byte short
+		TArray<uint8> Exact;
+		Exact.SetNumUninitialized(Blob.Num());
+		const int32 Written = FFirebaseAnalyticsBundleWriter::Write(Bundle, MakeArrayView(Exact));
+		if (Written != Blob.Num() || FMemory::Memcmp(Exact.GetData(), Blob.GetData(), Blob.Num()) != 0
+			|| FFirebaseAnalyticsBundleWriter::Write(Bundle, MakeArrayView(Exact.GetData(), Blob.Num() - 1)) != INDEX_NONE)
+		{
+			AddError(FString::Printf(TEXT("Bundle %d: fixed span write of %d bytes gave %d"), BundleIdx, Blob.Num(), Written));
+			NumErrors++;
+		}
+	}
+
+	TestEqual(TEXT("Bundles that didn't round trip"), NumErrors, 0);
+
+	// Items nest as deep as the reader allows, and no deeper
+	for (const int32 Depth : {1, 16, 17, 100})
+	{
+		const FBundle Chain = MakeBundleFormatTestChain(Depth);
+		TArray<uint8> Blob;
+		FFirebaseAnalyticsBundleWriter::Write(Chain, Blob);
+
+		FFirebaseAnalyticsBundleView View;
+		const bool bValid = View.Initialize(Blob);
+		TestEqual(*FString::Printf(TEXT("Items %d deep accepted"), Depth), bValid, Depth <= 16);
+		if (bValid)
+		{
+			FBundle ReadBack;
+			View.ToBundle(ReadBack);
+			TestEqual(*FString::Printf(TEXT("Items %d deep round trip"), Depth), CompareBundleFormatTestBundles(Chain, ReadBack), FString());
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBundleFormatTruncatedTest,
+	"Plugins.FirebaseAnalytics.BundleFormat.Truncated",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBundleFormatTruncatedTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1818);
+	int32 NumAccepted = 0;
+
+	for (int32 BundleIdx = 0; BundleIdx < 100; BundleIdx++)
+	{
+		TArray<uint8> Blob;
+		FFirebaseAnalyticsBundleWriter::Write(MakeBundleFormatTestBundle(Random, 0), Blob);
+
+		// Every strict prefix is missing bytes that its counts and sizes ask for
+		for (int32 Size = 0; Size < Blob.Num(); Size++)
+		{
+			FFirebaseAnalyticsBundleView View;
+			if ((View.Initialize(MakeArrayView(Blob.GetData(), Size)) || View.IsValid()) && NumAccepted++ < 8)
+			{
+				AddError(FString::Printf(TEXT("Bundle %d cut to %d of %d bytes accepted"), BundleIdx, Size, Blob.Num()));
+			}
+		}
+
+		// Bytes past the bundle are refused too
+		Blob.Add(0);
+		FFirebaseAnalyticsBundleView View;
+		if (View.Initialize(Blob) && NumAccepted++ < 8)
+		{
+			AddError(FString::Printf(TEXT("Bundle %d with a trailing byte accepted"), BundleIdx));
+		}
+	}
+
+	TestEqual(TEXT("Truncated or padded blobs accepted"), NumAccepted, 0);
+
+	// A view that fails to initialize forgets the blob it had before
+	TArray<uint8> Blob;
+	FFirebaseAnalyticsBundleWriter::Write(MakeBundleFormatTestChain(2), Blob);
+	FFirebaseAnalyticsBundleView View;
+	TestTrue(TEXT("Valid blob accepted"), View.Initialize(Blob));
+	TestFalse(TEXT("Bad magic accepted"), View.Initialize(MakeArrayView(Blob.GetData() + 1, Blob.Num() - 1)));
+	TestFalse(TEXT("View valid after a failed Initialize"), View.IsValid());
+
+	// Hand made damage the writer never produces
+	const TArray<TArray<uint8>> Hostile =
+	{
+		// Wrong version
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion + 1, 0},
+		// Varint running past five bytes
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00},
+		// Huge parameter count with nothing behind it
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F},
+		// Repeated key that was never written
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 1, (uint8)EFirebaseAnalyticsBundleValueType::Integer, 1, 0},
+		// Unknown value type
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 1, 9, 0, 0},
+		// String longer than the blob
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 1, (uint8)EFirebaseAnalyticsBundleValueType::String, 0, 2, 'a', 0xFE, 0xFF, 0xFF, 0xFF, 0x0F},
+		// Item size that doesn't match the items
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 1, (uint8)EFirebaseAnalyticsBundleValueType::Bundles, 0, 0, 1, 2, 0, 0, 0, 0},
+		// Item size past the end
+		{FirebaseAnalyticsBundleMagic, FirebaseAnalyticsBundleVersion, 1, (uint8)EFirebaseAnalyticsBundleValueType::Bundles, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF},
+	};
+
+	for (int32 BlobIdx = 0; BlobIdx < Hostile.Num(); BlobIdx++)
+	{
+		TestFalse(*FString::Printf(TEXT("Hostile blob %d accepted"), BlobIdx), View.Initialize(Hostile[BlobIdx]));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsBundleFormatCorruptedTest,
+	"Plugins.FirebaseAnalytics.BundleFormat.Corrupted",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsBundleFormatCorruptedTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(181818);
+	int32 NumAccepted = 0;
+	int32 NumUnstable = 0;
+
+	for (int32 Iteration = 0; Iteration < 5000; Iteration++)
+	{
+		TArray<uint8> Blob;
+		FFirebaseAnalyticsBundleWriter::Write(MakeBundleFormatTestBundle(Random, 0), Blob);
+
+		// A few overwritten or flipped bytes past the header, sometimes a cut or grown tail on top
+		const int32 NumMutations = Random.RandRange(1, 4);
+		for (int32 MutationIdx = 0; MutationIdx < NumMutations && Blob.Num() > 2; MutationIdx++)
+		{
+			const int32 Offset = Random.RandRange(2, Blob.Num() - 1);
+			if (Random.RandRange(0, 1) == 0)
+			{
+				Blob[Offset] = (uint8)Random.RandRange(0, 255);
+			}
+			else
+			{
+				Blob[Offset] ^= (uint8)(1 << Random.RandRange(0, 7));
+			}
+		}
+		switch (Random.RandRange(0, 5))
+		{
+			case 0:
+				Blob.SetNum(Random.RandRange(0, Blob.Num()));
+				break;
+			case 1:
+				Blob.Add((uint8)Random.RandRange(0, 255));
+				break;
+			default:
+				break;
+		}
+
+		// Whatever a damaged blob holds, a view that accepts it must read it without leaving the buffer
+		FFirebaseAnalyticsBundleView View;
+		if (!View.Initialize(Blob))
+		{
+			continue;
+		}
+
+		NumAccepted++;
+		FBundle ReadBack;
+		View.ToBundle(ReadBack);
+
+		// And what it read is a plain bundle again, which writes and reads back unchanged
+		TArray<uint8> Rewritten;
+		FFirebaseAnalyticsBundleWriter::Write(ReadBack, Rewritten);
+
+		FFirebaseAnalyticsBundleView RewrittenView;
+		FBundle RewrittenBundle;
+		if (RewrittenView.Initialize(Rewritten))
+		{
+			RewrittenView.ToBundle(RewrittenBundle);
+		}
+		if (!RewrittenView.IsValid() || !CompareBundleFormatTestBundles(ReadBack, RewrittenBundle).IsEmpty())
+		{
+			if (NumUnstable++ < 8)
+			{
+				AddError(FString::Printf(TEXT("Iteration %d: accepted damaged blob doesn't round trip once read"), Iteration));
+			}
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d of 5000 damaged blobs still parsed"), NumAccepted));
+	TestEqual(TEXT("Accepted damaged blobs that didn't round trip"), NumUnstable, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsFakeJniWriter.h"
+#include "FirebaseAnalyticsJavaBundleFill.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static FFlatBundle MakeFirebaseAnalyticsTestItemsBundle(int32 NumItems)
+{
+	FFlatBundle Bundle;
+	Bundle.PutString(EBuiltinParamNames::CURRENCY, TEXT("USD"));
+	Bundle.PutDouble(EBuiltinParamNames::VALUE, 9.99);
+	Bundle.PutNull(TEXT("cleared"));
+
+	TArray<FFlatBundle> Items;
+	Items.SetNum(NumItems);
+	for (int32 ItemIdx = 0; ItemIdx < NumItems; ItemIdx++)
+	{
+		Items[ItemIdx].PutString(EBuiltinParamNames::ITEM_ID, FString::Printf(TEXT("sku_%d"), ItemIdx));
+		Items[ItemIdx].PutDouble(EBuiltinParamNames::PRICE, ItemIdx * 0.5);
+		Items[ItemIdx].PutInteger(EBuiltinParamNames::QUANTITY, 1);
+		Items[ItemIdx].PutInt64(TEXT("stock"), (int64)ItemIdx << 32);
+	}
+	Bundle.PutBundles(EBuiltinParamNames::ITEMS, MoveTemp(Items));
+	return Bundle;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsJavaBundleFillLocalRefsTest,
+	"Plugins.FirebaseAnalytics.JavaBundleFill.LocalRefs",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsJavaBundleFillLocalRefsTest::RunTest(const FString& Parameters)
+{
+	int32 FirstPeak = INDEX_NONE;
+	for (const int32 NumItems : {1, 100, 10000})
+	{
+		const FFlatBundle Bundle = MakeFirebaseAnalyticsTestItemsBundle(NumItems);
+
+		FFirebaseAnalyticsFakeJniWriter Writer(1);
+		const int32 JBundle = Writer.NewLocal();
+		FillFirebaseAnalyticsJavaBundle(Writer, JBundle, Bundle, Bundle.GetParameters());
+
+		const FString Context = FString::Printf(TEXT("%d items"), NumItems);
+		TestEqual(*(Context + TEXT(": refs used after they were freed")), Writer.NumDeadUses, 0);
+		TestEqual(*(Context + TEXT(": frames held more refs than they asked room for")), Writer.NumOverCapacity, 0);
+		TestEqual(*(Context + TEXT(": frames left pushed")), Writer.GetNumFrames(), 1);
+		TestEqual(*(Context + TEXT(": refs left past the fill")), Writer.GetNumLiveRefs(), 1);
+		TestEqual(*(Context + TEXT(": items stored")), Writer.NumItemsSet, NumItems);
+		TestEqual(*(Context + TEXT(": parameters put")), Writer.NumPuts, 4 + NumItems * 4);
+
+		// The table holds one bundle level at a time, so the peak can't grow with the number of items
+		if (FirstPeak == INDEX_NONE)
+		{
+			FirstPeak = Writer.PeakLiveRefs;
+		}
+		TestEqual(*(Context + TEXT(": peak local refs")), Writer.PeakLiveRefs, FirstPeak);
+	}
+
+	TestTrue(TEXT("Peak local refs stay below one bundle level of names and values"), FirstPeak <= 1 + (4 * 2 + 2) + (4 * 2 + 2));
+	return true;
+}
+
+#endif
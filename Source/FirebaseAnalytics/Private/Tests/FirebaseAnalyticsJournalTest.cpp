@@ -0,0 +1,234 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "FirebaseAnalyticsJournal.h"
+#include "FirebaseAnalyticsTestBundles.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Layout the journal writes, the tests damage records through it while the journal is closed
+static constexpr int32 JournalTestFileHeaderSize = 64;
+static constexpr int32 JournalTestPayloadSizeOffset = 4;
+static constexpr int32 JournalTestRecordHeaderSize = 24;
+
+/** Event whose encoded batch is 20 + ValueLength bytes. */
+static FFirebaseAnalyticsEvent MakeJournalTestEvent(int32 Index, int32 ValueLength)
+{
+	FFirebaseAnalyticsEvent Event;
+	Event.Name = TEXT("e");
+	Event.Parameters.PutString(TEXT("s"), FString::FromInt(Index).LeftPad(ValueLength));
+	return Event;
+}
+
+/** Empty when Recovered holds exactly Expected, otherwise the first difference. */
+static FString CompareJournalTestEvents(const TArray<FFirebaseAnalyticsEvent>& Expected, const TArray<FFirebaseAnalyticsEvent>& Recovered)
+{
+	if (Expected.Num() != Recovered.Num())
+	{
+		return FString::Printf(TEXT("%d events instead of %d"), Recovered.Num(), Expected.Num());
+	}
+
+	for (int32 EventIdx = 0; EventIdx < Expected.Num(); EventIdx++)
+	{
+		const FString Difference = FirebaseAnalyticsTestBundles::Compare(Expected[EventIdx].Parameters, Recovered[EventIdx].Parameters);
+		if (Expected[EventIdx].Name != Recovered[EventIdx].Name || !Difference.IsEmpty())
+		{
+			return FString::Printf(TEXT("event %d differs %s"), EventIdx, *Difference);
+		}
+	}
+
+	return FString();
+}
+
+/** Change the closed journal file in place. */
+template <typename EditType>
+static bool EditJournalTestFile(const FString& Filename, EditType&& Edit)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		return false;
+	}
+
+	Edit(Bytes);
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsJournalTornWriteTest,
+	"Plugins.FirebaseAnalytics.Journal.TornWrite",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsJournalTornWriteTest::RunTest(const FString& Parameters)
+{
+	const FString Filename = FPaths::AutomationTransientDir() / TEXT("FirebaseAnalyticsJournalTornWrite.bin");
+	IFileManager::Get().Delete(*Filename, false, true, true);
+
+	TArray<FFirebaseAnalyticsEvent> Events;
+	TArray<FFirebaseAnalyticsJournalRecord> Records;
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("New journal opens"), Journal.Open(Pending));
+		TestEqual(TEXT("Events pending in a new journal"), Pending.Num(), 0);
+
+		for (int32 EventIdx = 0; EventIdx < 5; EventIdx++)
+		{
+			Events.Add(MakeJournalTestEvent(EventIdx, 40 + EventIdx * 7));
+			Records.Add(Journal.Append(Events.Last()));
+			TestTrue(*FString::Printf(TEXT("Event %d journaled"), EventIdx), Records.Last().IsValid());
+		}
+
+		Journal.Acknowledge(Records[0]);
+	}
+
+	// The process dies while writing the last record: its slot was invalidated first and the payload is half there.
+	// The third record took a stray write to its payload after it was sealed.
+	const bool bEdited = EditJournalTestFile(Filename, [&Records](TArray<uint8>& Bytes)
+	{
+		const int32 Torn = JournalTestFileHeaderSize + Records[4].Offset;
+		FMemory::Memzero(Bytes.GetData() + Torn, sizeof(uint32));
+		FMemory::Memzero(Bytes.GetData() + Torn + JournalTestRecordHeaderSize + 10, 16);
+
+		Bytes[JournalTestFileHeaderSize + Records[2].Offset + JournalTestRecordHeaderSize + 12] ^= 0x40;
+	});
+	TestTrue(TEXT("Journal file edited"), bEdited);
+
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("Damaged journal opens"), Journal.Open(Pending));
+
+		// Acknowledged and damaged records are left out, the rest come back oldest first
+		TestEqual(TEXT("Recovered events"), CompareJournalTestEvents({Events[1], Events[3]}, Pending), FString());
+
+		// Sequences carry on past every record that survived
+		const FFirebaseAnalyticsJournalRecord Next = Journal.Append(Events[0]);
+		TestTrue(TEXT("Sequence after recovery"), Next.Sequence > Records[3].Sequence);
+	}
+
+	{
+		// Survivors were handed over once and are not replayed again, the record written after recovery is
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("Journal reopens"), Journal.Open(Pending));
+		TestEqual(TEXT("Events pending after recovery"), CompareJournalTestEvents({Events[0]}, Pending), FString());
+	}
+
+	// A record header torn so its size runs past the ring is refused, not followed
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		Journal.Open(Pending);
+		Records.Reset();
+		for (int32 EventIdx = 0; EventIdx < 2; EventIdx++)
+		{
+			Records.Add(Journal.Append(Events[EventIdx]));
+		}
+	}
+
+	EditJournalTestFile(Filename, [&Records](TArray<uint8>& Bytes)
+	{
+		const uint32 HugeSize = MAX_uint32 - 8;
+		FMemory::Memcpy(Bytes.GetData() + JournalTestFileHeaderSize + Records[0].Offset + JournalTestPayloadSizeOffset, &HugeSize, sizeof(HugeSize));
+	});
+
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("Journal with a torn header opens"), Journal.Open(Pending));
+		TestEqual(TEXT("Events recovered past a torn header"), CompareJournalTestEvents({Events[1]}, Pending), FString());
+	}
+
+	// A file that isn't a journal at all starts over empty
+	EditJournalTestFile(Filename, [](TArray<uint8>& Bytes)
+	{
+		Bytes[0] ^= 0xFF;
+	});
+
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, 64 * 1024);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("Journal with a bad file header opens"), Journal.Open(Pending));
+		TestEqual(TEXT("Events pending from a bad file header"), Pending.Num(), 0);
+	}
+
+	IFileManager::Get().Delete(*Filename, false, true, true);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsJournalWrapTest,
+	"Plugins.FirebaseAnalytics.Journal.Wrap",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsJournalWrapTest::RunTest(const FString& Parameters)
+{
+	// 104 byte payloads make 128 byte records, 32 to a lap of the smallest ring, so no lap ends in padding
+	static constexpr int32 Capacity = 4096;
+	static constexpr int32 RecordsPerLap = Capacity / 128;
+	static constexpr int32 NumEvents = 100;
+	static constexpr int32 OldestLive = NumEvents - RecordsPerLap;
+
+	const FString Filename = FPaths::AutomationTransientDir() / TEXT("FirebaseAnalyticsJournalWrap.bin");
+	IFileManager::Get().Delete(*Filename, false, true, true);
+
+	TArray<FFirebaseAnalyticsEvent> Events;
+	TArray<FFirebaseAnalyticsJournalRecord> Records;
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, Capacity);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		Journal.Open(Pending);
+
+		for (int32 EventIdx = 0; EventIdx < NumEvents; EventIdx++)
+		{
+			Events.Add(MakeJournalTestEvent(EventIdx, 84));
+			Records.Add(Journal.Append(Events.Last()));
+		}
+
+		// Every fourth event is never delivered. Records overwritten since are ignored, not flagged in their slot's new owner.
+		TArray<FFirebaseAnalyticsJournalRecord> Delivered;
+		for (int32 EventIdx = 0; EventIdx < NumEvents; EventIdx++)
+		{
+			if (EventIdx % 4 != 0)
+			{
+				Delivered.Add(Records[EventIdx]);
+			}
+		}
+		Journal.Acknowledge(Delivered);
+	}
+
+	TestEqual(TEXT("Record slot reused a lap later"), Records[NumEvents - 1].Offset, Records[NumEvents - 1 - RecordsPerLap].Offset);
+
+	// The crash hits the next append, right after it invalidated the oldest record to reuse its slot
+	const bool bEdited = EditJournalTestFile(Filename, [&Records](TArray<uint8>& Bytes)
+	{
+		FMemory::Memzero(Bytes.GetData() + JournalTestFileHeaderSize + Records[OldestLive].Offset, sizeof(uint32));
+	});
+	TestTrue(TEXT("Journal file edited"), bEdited);
+
+	TArray<FFirebaseAnalyticsEvent> Expected;
+	for (int32 EventIdx = OldestLive + 1; EventIdx < NumEvents; EventIdx++)
+	{
+		if (EventIdx % 4 == 0)
+		{
+			Expected.Add(Events[EventIdx]);
+		}
+	}
+
+	{
+		FFirebaseAnalyticsJournal Journal(Filename, Capacity);
+		TArray<FFirebaseAnalyticsEvent> Pending;
+		TestTrue(TEXT("Wrapped journal opens"), Journal.Open(Pending));
+		TestEqual(TEXT("Events recovered from a wrapped ring"), CompareJournalTestEvents(Expected, Pending), FString());
+	}
+
+	IFileManager::Get().Delete(*Filename, false, true, true);
+	return true;
+}
+
+#endif
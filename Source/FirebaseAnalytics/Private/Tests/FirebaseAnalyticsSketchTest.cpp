@@ -0,0 +1,135 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsSketch.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+static constexpr double SketchTestAccuracy = 0.01;
+static const double SketchTestQuantiles[] = {0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0};
+
+/** Exact quantile with the rank GetQuantile uses. Values must be sorted. */
+static double GetExactSketchTestQuantile(const TArray<double>& Values, double Q)
+{
+	return Values[(int32)(Q * (Values.Num() - 1))];
+}
+
+/** Values spread over several orders of magnitude and both signs, with a few zeros. */
+static TArray<double> MakeSketchTestValues(int32 NumValues, int32 Seed)
+{
+	FRandomStream Random(Seed);
+	TArray<double> Values;
+	Values.Reserve(NumValues);
+	for (int32 ValueIdx = 0; ValueIdx < NumValues; ValueIdx++)
+	{
+		const double Magnitude = FMath::Pow(10.0, Random.FRandRange(-3.0f, 6.0f));
+		const int32 Kind = Random.RandRange(0, 9);
+		Values.Add(Kind == 0 ? 0.0 : Kind <= 2 ? -Magnitude : Magnitude);
+	}
+	return Values;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsSketchRelativeErrorTest,
+	"Plugins.FirebaseAnalytics.Sketch.RelativeError",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsSketchRelativeErrorTest::RunTest(const FString& Parameters)
+{
+	TArray<double> Values = MakeSketchTestValues(20000, 1234);
+
+	// Enough bins for the whole range, nothing collapses
+	FFirebaseAnalyticsSketch Sketch(SketchTestAccuracy, 4096);
+	for (double Value : Values)
+	{
+		Sketch.Add(Value);
+	}
+	Values.Sort();
+
+	TestEqual(TEXT("Count"), (int64)Sketch.GetCount(), (int64)Values.Num());
+	for (double Q : SketchTestQuantiles)
+	{
+		const double Exact = GetExactSketchTestQuantile(Values, Q);
+		const double Estimate = Sketch.GetQuantile(Q);
+
+		// The bound is exact in theory, the slack only covers rounding of the bin index at bin edges
+		TestTrue(*FString::Printf(TEXT("Quantile %g: %g estimated for %g"), Q, Estimate, Exact),
+			FMath::Abs(Estimate - Exact) <= SketchTestAccuracy * FMath::Abs(Exact) * 1.0001);
+	}
+
+	TestEqual(TEXT("Empty sketch quantile"), FFirebaseAnalyticsSketch().GetQuantile(0.5), 0.0);
+
+	// Past MaxBins only the lowest bins collapse, high quantiles keep the bound
+	FFirebaseAnalyticsSketch Bounded(SketchTestAccuracy, 64);
+	TArray<double> Uniform;
+	for (int32 Value = 1; Value <= 10000; Value++)
+	{
+		Uniform.Add(Value);
+		Bounded.Add(Value);
+	}
+
+	for (double Q : {0.5, 0.9, 0.99, 1.0})
+	{
+		const double Exact = GetExactSketchTestQuantile(Uniform, Q);
+		const double Estimate = Bounded.GetQuantile(Q);
+		TestTrue(*FString::Printf(TEXT("Collapsed sketch quantile %g: %g estimated for %g"), Q, Estimate, Exact),
+			FMath::Abs(Estimate - Exact) <= SketchTestAccuracy * Exact * 1.0001);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsSketchMergeTest,
+	"Plugins.FirebaseAnalytics.Sketch.Merge",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsSketchMergeTest::RunTest(const FString& Parameters)
+{
+	const TArray<double> Values = MakeSketchTestValues(10000, 5678);
+
+	// The same values through one sketch, and split unevenly over four merged ones
+	FFirebaseAnalyticsSketch Whole(SketchTestAccuracy, 4096);
+	FFirebaseAnalyticsSketch Parts[4] =
+	{
+		FFirebaseAnalyticsSketch(SketchTestAccuracy, 4096),
+		FFirebaseAnalyticsSketch(SketchTestAccuracy, 4096),
+		FFirebaseAnalyticsSketch(SketchTestAccuracy, 4096),
+		FFirebaseAnalyticsSketch(SketchTestAccuracy, 4096),
+	};
+
+	for (int32 ValueIdx = 0; ValueIdx < Values.Num(); ValueIdx++)
+	{
+		Whole.Add(Values[ValueIdx]);
+		Parts[(ValueIdx * ValueIdx) % 4].Add(Values[ValueIdx]);
+	}
+
+	FFirebaseAnalyticsSketch Merged(SketchTestAccuracy, 4096);
+	for (const FFirebaseAnalyticsSketch& Part : Parts)
+	{
+		Merged.Merge(Part);
+	}
+
+	// Merging moves bin counts as they are, so the result matches to the bit
+	TestEqual(TEXT("Merged count"), (int64)Merged.GetCount(), (int64)Whole.GetCount());
+	for (double Q : SketchTestQuantiles)
+	{
+		TestEqual(*FString::Printf(TEXT("Merged quantile %g"), Q), Merged.GetQuantile(Q), Whole.GetQuantile(Q));
+	}
+
+	// Merging an empty sketch, or into a reset one, changes nothing
+	Merged.Merge(FFirebaseAnalyticsSketch(SketchTestAccuracy, 4096));
+	TestEqual(TEXT("Quantile after merging an empty sketch"), Merged.GetQuantile(0.5), Whole.GetQuantile(0.5));
+
+	FFirebaseAnalyticsSketch Reused(SketchTestAccuracy, 4096);
+	Reused.Add(1.0e9, 100);
+	Reused.Reset();
+	Reused.Merge(Whole);
+	TestEqual(TEXT("Quantile of a reset sketch after merging"), Reused.GetQuantile(0.99), Whole.GetQuantile(0.99));
+
+	return true;
+}
+
+#endif
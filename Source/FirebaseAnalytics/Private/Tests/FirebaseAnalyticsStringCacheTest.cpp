@@ -0,0 +1,184 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsStringCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Global refs as the fake VM sees them. */
+struct FFirebaseAnalyticsFakeGlobalRefs
+{
+	TMap<int32, FString> Live;
+	int32 NextRef = 1;
+	int32 PeakLive = 0;
+	int32 NumBadReleases = 0;
+};
+
+/** Mirrors FJavaNameCachePolicy: one global ref per cached name, none when there is no JNIEnv to create it with. */
+struct FFirebaseAnalyticsFakeNameCachePolicy
+{
+	typedef int32 HandleType;
+
+	FFirebaseAnalyticsFakeGlobalRefs* Refs = nullptr;
+	bool bHasEnv = true;
+
+	int32 Create(const FString& Name)
+	{
+		if (!bHasEnv)
+		{
+			return 0;
+		}
+
+		const int32 Ref = Refs->NextRef++;
+		Refs->Live.Add(Ref, Name);
+		Refs->PeakLive = FMath::Max(Refs->PeakLive, Refs->Live.Num());
+		return Ref;
+	}
+
+	void Release(int32 Handle)
+	{
+		if (Refs->Live.Remove(Handle) == 0)
+		{
+			Refs->NumBadReleases++;
+		}
+	}
+};
+
+typedef TFirebaseAnalyticsStringCache<FFirebaseAnalyticsFakeNameCachePolicy> FFirebaseAnalyticsFakeNameCache;
+
+/** Handle the cache passes to the visitor for Name. */
+static int32 VisitFirebaseAnalyticsTestName(FFirebaseAnalyticsFakeNameCache& Cache, const FString& Name)
+{
+	int32 Handle = INDEX_NONE;
+	Cache.Visit(Name, [&Handle](int32 VisitedHandle) { Handle = VisitedHandle; });
+	return Handle;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsStringCacheEvictionTest,
+	"Plugins.FirebaseAnalytics.StringCache.Eviction",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsStringCacheEvictionTest::RunTest(const FString& Parameters)
+{
+	FFirebaseAnalyticsFakeGlobalRefs Refs;
+	{
+		FFirebaseAnalyticsFakeNameCachePolicy Policy;
+		Policy.Refs = &Refs;
+		FFirebaseAnalyticsFakeNameCache Cache(3, Policy);
+
+		const int32 LevelUp = VisitFirebaseAnalyticsTestName(Cache, TEXT("level_up"));
+		const int32 Score = VisitFirebaseAnalyticsTestName(Cache, TEXT("score"));
+		const int32 Character = VisitFirebaseAnalyticsTestName(Cache, TEXT("character"));
+		TestEqual(TEXT("Misses while filling"), (int64)Cache.GetStats().Misses, (int64)3);
+		TestEqual(TEXT("Live refs while filling"), Refs.Live.Num(), 3);
+
+		// A hit hands out the cached ref and makes it the most recently used
+		TestEqual(TEXT("Handle of a hit"), VisitFirebaseAnalyticsTestName(Cache, TEXT("level_up")), LevelUp);
+		TestEqual(TEXT("Hits"), (int64)Cache.GetStats().Hits, (int64)1);
+
+		// Full, so the least recently used name, score, makes room
+		const int32 Level = VisitFirebaseAnalyticsTestName(Cache, TEXT("level"));
+		TestEqual(TEXT("Evictions"), (int64)Cache.GetStats().Evictions, (int64)1);
+		TestFalse(TEXT("Evicted ref released"), Refs.Live.Contains(Score));
+		TestTrue(TEXT("Recently used ref kept"), Refs.Live.Contains(LevelUp));
+		TestEqual(TEXT("Live refs at capacity"), Refs.Live.Num(), 3);
+
+		// Coming back, score is a miss with a new ref, and character is now the oldest
+		TestNotEqual(TEXT("Handle of an evicted name"), VisitFirebaseAnalyticsTestName(Cache, TEXT("score")), Score);
+		TestFalse(TEXT("Oldest ref released"), Refs.Live.Contains(Character));
+		TestTrue(TEXT("Newer ref kept"), Refs.Live.Contains(Level));
+
+		const FFirebaseAnalyticsStringCacheStats Stats = Cache.GetStats();
+		TestEqual(TEXT("Final hits"), (int64)Stats.Hits, (int64)1);
+		TestEqual(TEXT("Final misses"), (int64)Stats.Misses, (int64)5);
+		TestEqual(TEXT("Final evictions"), (int64)Stats.Evictions, (int64)2);
+		TestEqual(TEXT("Final size"), Stats.Num, 3);
+
+		Cache.Empty();
+		TestEqual(TEXT("Live refs after Empty"), Refs.Live.Num(), 0);
+		TestEqual(TEXT("Size after Empty"), Cache.GetStats().Num, 0);
+
+		VisitFirebaseAnalyticsTestName(Cache, TEXT("level_up"));
+	}
+
+	TestEqual(TEXT("Live refs after the cache is destroyed"), Refs.Live.Num(), 0);
+	TestEqual(TEXT("Refs released twice or never created"), Refs.NumBadReleases, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsStringCacheNoEnvTest,
+	"Plugins.FirebaseAnalytics.StringCache.NoEnv",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsStringCacheNoEnvTest::RunTest(const FString& Parameters)
+{
+	FFirebaseAnalyticsFakeGlobalRefs Refs;
+	FFirebaseAnalyticsFakeNameCachePolicy Policy;
+	Policy.Refs = &Refs;
+	Policy.bHasEnv = false;
+	FFirebaseAnalyticsFakeNameCache Cache(4, Policy);
+
+	// Nothing is cached without a ref, so every visit tries again
+	TestEqual(TEXT("Handle without a JNIEnv"), VisitFirebaseAnalyticsTestName(Cache, TEXT("level_up")), 0);
+	TestEqual(TEXT("Handle without a JNIEnv, again"), VisitFirebaseAnalyticsTestName(Cache, TEXT("level_up")), 0);
+
+	const FFirebaseAnalyticsStringCacheStats Stats = Cache.GetStats();
+	TestEqual(TEXT("Misses"), (int64)Stats.Misses, (int64)2);
+	TestEqual(TEXT("Hits"), (int64)Stats.Hits, (int64)0);
+	TestEqual(TEXT("Size"), Stats.Num, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsStringCacheChurnTest,
+	"Plugins.FirebaseAnalytics.StringCache.Churn",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsStringCacheChurnTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 Capacity = 16;
+	static constexpr int32 NumVisits = 20000;
+
+	FFirebaseAnalyticsFakeGlobalRefs Refs;
+	{
+		FFirebaseAnalyticsFakeNameCachePolicy Policy;
+		Policy.Refs = &Refs;
+		FFirebaseAnalyticsFakeNameCache Cache(Capacity, Policy);
+
+		// A few hot names and a long tail, the way games log events
+		FRandomStream Random(42);
+		int32 NumWrongNames = 0;
+		for (int32 VisitIdx = 0; VisitIdx < NumVisits; VisitIdx++)
+		{
+			const int32 NameIdx = Random.FRand() < 0.8f ? Random.RandRange(0, 7) : Random.RandRange(8, 199);
+			const FString Name = FString::Printf(TEXT("event_%d"), NameIdx);
+
+			const int32 Handle = VisitFirebaseAnalyticsTestName(Cache, Name);
+			const FString* RefName = Refs.Live.Find(Handle);
+			if (RefName == nullptr || *RefName != Name)
+			{
+				NumWrongNames++;
+			}
+		}
+
+		const FFirebaseAnalyticsStringCacheStats Stats = Cache.GetStats();
+		TestEqual(TEXT("Visits handed a ref to another name or a released one"), NumWrongNames, 0);
+		TestEqual(TEXT("Hits and misses"), (int64)(Stats.Hits + Stats.Misses), (int64)NumVisits);
+		TestEqual(TEXT("Every miss past capacity evicts"), (int64)Stats.Evictions, (int64)(Stats.Misses - Stats.Num));
+		TestTrue(TEXT("Hot names mostly hit"), Stats.Hits > Stats.Misses);
+
+		// The new ref is created before the oldest is released, so one over capacity for a moment
+		TestTrue(TEXT("Peak live refs within capacity"), Refs.PeakLive <= Capacity + 1);
+		TestEqual(TEXT("Live refs match the cache size"), Refs.Live.Num(), Stats.Num);
+	}
+
+	TestEqual(TEXT("Live refs after the cache is destroyed"), Refs.Live.Num(), 0);
+	TestEqual(TEXT("Refs released twice or never created"), Refs.NumBadReleases, 0);
+	return true;
+}
+
+#endif
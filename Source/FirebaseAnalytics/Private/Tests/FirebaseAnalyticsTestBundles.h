@@ -0,0 +1,207 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "FirebaseAnalyticsTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Bundles and comparisons shared by the round trip tests. */
+namespace FirebaseAnalyticsTestBundles
+{
+	/** Empty when A and B hold the same parameters in the same order, otherwise where they first differ.
+	 *	Names are compared as text, so a built-in name equals the same name read back as a string.
+	 */
+	inline FString Compare(
+		const FFlatBundle& BundleA, TArrayView<const FFirebaseAnalyticsParameter> A,
+		const FFlatBundle& BundleB, TArrayView<const FFirebaseAnalyticsParameter> B)
+	{
+		if (A.Num() != B.Num())
+		{
+			return FString::Printf(TEXT("%d parameters instead of %d"), B.Num(), A.Num());
+		}
+
+		for (int32 ParameterIdx = 0; ParameterIdx < A.Num(); ParameterIdx++)
+		{
+			const FFirebaseAnalyticsParameter& ParameterA = A[ParameterIdx];
+			const FFirebaseAnalyticsParameter& ParameterB = B[ParameterIdx];
+			const TCHAR* Name = ParameterA.GetName();
+
+			if (!ParameterB.HasName(Name))
+			{
+				return FString::Printf(TEXT("parameter %d is \"%s\" instead of \"%s\""), ParameterIdx, ParameterB.GetName(), Name);
+			}
+			if (ParameterA.Type != ParameterB.Type)
+			{
+				return FString::Printf(TEXT("\"%s\" has type %d instead of %d"), Name, (int32)ParameterB.Type, (int32)ParameterA.Type);
+			}
+
+			bool bSameValue = true;
+			switch (ParameterA.Type)
+			{
+				case EFirebaseAnalyticsParameterType::String:
+					bSameValue = ParameterA.StringValue.Equals(ParameterB.StringValue, ESearchCase::CaseSensitive);
+					break;
+				case EFirebaseAnalyticsParameterType::Float:
+					bSameValue = FMemory::Memcmp(&ParameterA.FloatValue, &ParameterB.FloatValue, sizeof(float)) == 0;
+					break;
+				case EFirebaseAnalyticsParameterType::Double:
+					bSameValue = FMemory::Memcmp(&ParameterA.DoubleValue, &ParameterB.DoubleValue, sizeof(double)) == 0;
+					break;
+				case EFirebaseAnalyticsParameterType::Integer:
+					bSameValue = ParameterA.IntegerValue == ParameterB.IntegerValue;
+					break;
+				case EFirebaseAnalyticsParameterType::Int64:
+					bSameValue = ParameterA.Int64Value == ParameterB.Int64Value;
+					break;
+				case EFirebaseAnalyticsParameterType::Bundles:
+				{
+					if (ParameterA.Items.Num != ParameterB.Items.Num)
+					{
+						return FString::Printf(TEXT("\"%s\" has %d items instead of %d"), Name, ParameterB.Items.Num, ParameterA.Items.Num);
+					}
+					for (int32 ItemIdx = 0; ItemIdx < ParameterA.Items.Num; ItemIdx++)
+					{
+						const FString Difference = Compare(
+							BundleA, BundleA.GetItemParameters(ParameterA, ItemIdx),
+							BundleB, BundleB.GetItemParameters(ParameterB, ItemIdx));
+						if (!Difference.IsEmpty())
+						{
+							return FString::Printf(TEXT("item %d of \"%s\": %s"), ItemIdx, Name, *Difference);
+						}
+					}
+					break;
+				}
+				case EFirebaseAnalyticsParameterType::Null:
+					break;
+			}
+
+			if (!bSameValue)
+			{
+				return FString::Printf(TEXT("\"%s\" has a different value"), Name);
+			}
+		}
+
+		return FString();
+	}
+
+	inline FString Compare(const FFlatBundle& A, const FFlatBundle& B)
+	{
+		return Compare(A, A.GetParameters(), B, B.GetParameters());
+	}
+
+	/** Random string of up to MaxLength characters, all ASCII, all Latin-1, wider BMP characters or surrogate pairs. */
+	inline FString MakeString(FRandomStream& Random, int32 MaxLength)
+	{
+		const int32 Length = Random.RandRange(0, MaxLength);
+		const int32 Kind = Random.RandRange(0, 3);
+
+		FString Result;
+		Result.Reserve(Length);
+		while (Result.Len() < Length)
+		{
+			switch (Kind)
+			{
+				case 0:
+					Result.AppendChar((TCHAR)Random.RandRange(0x20, 0x7E));
+					break;
+				case 1:
+					Result.AppendChar((TCHAR)Random.RandRange(0x20, 0xFF));
+					break;
+				case 2:
+					Result.AppendChar((TCHAR)Random.RandRange(0x100, 0xD7FF));
+					break;
+				default:
+					if (sizeof(TCHAR) == 2 && Result.Len() + 2 <= Length)
+					{
+						Result.AppendChar((TCHAR)Random.RandRange(0xD800, 0xDBFF));
+						Result.AppendChar((TCHAR)Random.RandRange(0xDC00, 0xDFFF));
+					}
+					else
+					{
+						Result.AppendChar((TCHAR)Random.RandRange(0xE000, 0xFFFD));
+					}
+					break;
+			}
+		}
+		return Result;
+	}
+
+	/** Put a random parameter under a custom name or a built-in one. Items only when bAllowItems, since they can't nest. */
+	inline void PutRandomParameter(FFlatBundle& Bundle, FRandomStream& Random, int32 ParameterIdx, bool bAllowItems)
+	{
+		const bool bBuiltin = Random.RandRange(0, 3) == 0;
+		const EBuiltinParamNames BuiltinName = (EBuiltinParamNames)Random.RandRange(0, (int32)EBuiltinParamNames::VALUE);
+		const FString Name = FString::Printf(TEXT("param_%d"), ParameterIdx);
+
+		switch (Random.RandRange(0, bAllowItems ? 6 : 5))
+		{
+			case 0:
+			{
+				const FString Value = MakeString(Random, 120);
+				bBuiltin ? Bundle.PutString(BuiltinName, Value) : Bundle.PutString(Name, Value);
+				break;
+			}
+			case 1:
+			{
+				const float Value = Random.FRandRange(-1.0e6f, 1.0e6f);
+				bBuiltin ? Bundle.PutFloat(BuiltinName, Value) : Bundle.PutFloat(Name, Value);
+				break;
+			}
+			case 2:
+			{
+				const double Value = Random.FRandRange(-1.0f, 1.0f) * 1.0e12;
+				bBuiltin ? Bundle.PutDouble(BuiltinName, Value) : Bundle.PutDouble(Name, Value);
+				break;
+			}
+			case 3:
+			{
+				const int32 Value = (int32)Random.GetUnsignedInt();
+				bBuiltin ? Bundle.PutInteger(BuiltinName, Value) : Bundle.PutInteger(Name, Value);
+				break;
+			}
+			case 4:
+			{
+				const int64 Value = (int64)(((uint64)Random.GetUnsignedInt() << 32) | Random.GetUnsignedInt());
+				bBuiltin ? Bundle.PutInt64(BuiltinName, Value) : Bundle.PutInt64(Name, Value);
+				break;
+			}
+			case 5:
+			{
+				bBuiltin ? Bundle.PutNull(BuiltinName) : Bundle.PutNull(Name);
+				break;
+			}
+			default:
+			{
+				TArray<FFlatBundle> Items;
+				Items.SetNum(Random.RandRange(0, 5));
+				for (FFlatBundle& Item : Items)
+				{
+					const int32 NumItemParameters = Random.RandRange(0, 6);
+					for (int32 ItemParameterIdx = 0; ItemParameterIdx < NumItemParameters; ItemParameterIdx++)
+					{
+						PutRandomParameter(Item, Random, ItemParameterIdx, false);
+					}
+				}
+				bBuiltin ? Bundle.PutBundles(BuiltinName, MoveTemp(Items)) : Bundle.PutBundles(Name, MoveTemp(Items));
+				break;
+			}
+		}
+	}
+
+	/** Random bundle with up to MaxParameters parameters of every type, items included. */
+	inline FFlatBundle MakeBundle(FRandomStream& Random, int32 MaxParameters)
+	{
+		FFlatBundle Bundle;
+		const int32 NumParameters = Random.RandRange(0, MaxParameters);
+		for (int32 ParameterIdx = 0; ParameterIdx < NumParameters; ParameterIdx++)
+		{
+			PutRandomParameter(Bundle, Random, ParameterIdx, true);
+		}
+		return Bundle;
+	}
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "FirebaseAnalyticsSwar.h"
+#include "FirebaseAnalyticsValidator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Valid characters at the edges of their ranges, the ones a carry out of a neighbouring lane would flip
+static const TCHAR ValidatorTestNeighbours[] = {TEXT('a'), TEXT('z'), TEXT('A'), TEXT('Z'), TEXT('0'), TEXT('9'), TEXT('_')};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsValidatorNameCharsTest,
+	"Plugins.FirebaseAnalytics.Validator.NameChars",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsValidatorNameCharsTest::RunTest(const FString& Parameters)
+{
+	int32 NumMismatches = 0;
+
+	for (uint32 Unit = 0; Unit <= 0xFFFF; Unit++)
+	{
+		const TCHAR Char = (TCHAR)Unit;
+		const bool bExpected = FirebaseAnalyticsLimits::IsNameChar(Char);
+
+		for (TCHAR Neighbour : ValidatorTestNeighbours)
+		{
+			// Two full words for the word-at-a-time loop and a tail of three for the scalar one
+			TCHAR Chars[11];
+			for (int32 Position = 0; Position < UE_ARRAY_COUNT(Chars); Position++)
+			{
+				for (TCHAR& Other : Chars)
+				{
+					Other = Neighbour;
+				}
+				Chars[Position] = Char;
+
+				if (FFirebaseAnalyticsValidator::HasOnlyNameChars(Chars, UE_ARRAY_COUNT(Chars)) != bExpected && NumMismatches++ < 16)
+				{
+					AddError(FString::Printf(TEXT("U+%04X at %d next to '%c' is %s by the scan"),
+						Unit, Position, Neighbour, bExpected ? TEXT("refused") : TEXT("accepted")));
+				}
+			}
+		}
+	}
+
+	TestEqual(TEXT("Code units the scan and IsNameChar disagree on"), NumMismatches, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsValidatorAllBelowTest,
+	"Plugins.FirebaseAnalytics.Validator.AllBelow",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsValidatorAllBelowTest::RunTest(const FString& Parameters)
+{
+	int32 NumMismatches = 0;
+
+	for (const uint32 Mask : {0x7Fu, 0xFFu, 0x7FFu, 0xFFFFu})
+	{
+		for (uint32 Unit = 0; Unit <= 0xFFFF; Unit++)
+		{
+			TCHAR Chars[6] = {TEXT('a'), TEXT('b'), TEXT('c'), TEXT('d'), TEXT('e'), TEXT('f')};
+			for (int32 Position = 0; Position < UE_ARRAY_COUNT(Chars); Position += 5)
+			{
+				const TCHAR Saved = Chars[Position];
+				Chars[Position] = (TCHAR)Unit;
+
+				if (FirebaseAnalyticsSwar::AllBelow(Chars, UE_ARRAY_COUNT(Chars), Mask) != (Unit <= Mask) && NumMismatches++ < 16)
+				{
+					AddError(FString::Printf(TEXT("U+%04X at %d against mask 0x%X"), Unit, Position, Mask));
+				}
+				Chars[Position] = Saved;
+			}
+		}
+	}
+
+	TestEqual(TEXT("Code units AllBelow gets wrong"), NumMismatches, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FFirebaseAnalyticsValidatorCheckNameTest,
+	"Plugins.FirebaseAnalytics.Validator.CheckName",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FFirebaseAnalyticsValidatorCheckNameTest::RunTest(const FString& Parameters)
+{
+	struct FCase
+	{
+		const TCHAR* Name;
+		EFirebaseAnalyticsNameKind Kind;
+		EFirebaseAnalyticsNameError Error;
+	};
+
+	const FCase Cases[] =
+	{
+		{TEXT("level_up"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::None},
+		{TEXT(""), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::Empty},
+		{TEXT("1st_level"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::BadFirstChar},
+		{TEXT("_level"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::BadFirstChar},
+		{TEXT("level-up"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::BadChar},
+		{TEXT("level_up_\u00e9"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::BadChar},
+		{TEXT("firebase_level"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::ReservedPrefix},
+		{TEXT("user_id"), EFirebaseAnalyticsNameKind::UserProperty, EFirebaseAnalyticsNameError::Reserved},
+		{TEXT("user_id"), EFirebaseAnalyticsNameKind::Parameter, EFirebaseAnalyticsNameError::None},
+		{TEXT("a_name_longer_than_forty_characters_in_total"), EFirebaseAnalyticsNameKind::Event, EFirebaseAnalyticsNameError::TooLong},
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		const EFirebaseAnalyticsNameError Error = FFirebaseAnalyticsValidator::CheckName(Case.Name, FCString::Strlen(Case.Name), Case.Kind);
+		TestEqual(*FString::Printf(TEXT("CheckName(\"%s\")"), Case.Name), FString(LexToString(Error)), FString(LexToString(Case.Error)));
+	}
+
+	return true;
+}
+
+#endif
@@ -3,10 +3,102 @@
 #pragma once
 
 #include "Modules/ModuleManager.h"
+#include "Templates/Atomic.h"
+#include "FirebaseAnalyticsBackend.h"
 
-class FFirebaseAnalyticsModule : public IModuleInterface
+class FFirebaseAnalyticsBundlePool;
+class FFirebaseAnalyticsDispatcher;
+class FFirebaseAnalyticsEventFilter;
+class FFirebaseAnalyticsJournal;
+class FFirebaseAnalyticsMetrics;
+class FFirebaseAnalyticsPriorityLanes;
+class FFirebaseAnalyticsTraceWriter;
+class FFirebaseAnalyticsValidator;
+
+class FIREBASEANALYTICS_API FFirebaseAnalyticsModule : public IModuleInterface
 {
 public:
+	FFirebaseAnalyticsModule();
+	virtual ~FFirebaseAnalyticsModule();
+
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	/** Return the running module, or nullptr outside of StartupModule/ShutdownModule. */
+	static FFirebaseAnalyticsModule* Get();
+
+	/** Replace the backend that receives every call. Passing nullptr discards calls. */
+	void SetBackend(FFirebaseAnalyticsBackendPtr InBackend);
+	FFirebaseAnalyticsBackendPtr GetBackend() const;
+
+	/** Hand a captured call to the dispatch queue, or straight to the backend when async dispatch is off. */
+	void SubmitCall(FFirebaseAnalyticsCall&& Call);
+
+	/** Block until every held and queued call has reached the backend. */
+	void FlushEvents();
+
+	/** Send held and queued calls until Deadline, in FPlatformTime::Seconds. Returns false when some were left. */
+	bool FlushEventsUntil(double Deadline);
+
+	bool IsAsyncDispatchEnabled() const { return Dispatcher.IsValid(); }
+
+	/** While suspended, submitted events aren't written to the journal. */
+	void SetJournalSuspended(bool bSuspended) { bJournalSuspended = bSuspended; }
+
+	/** Sampling and rate limits from the settings, nullptr when there are no rules. */
+	FFirebaseAnalyticsEventFilter* GetEventFilter() const { return EventFilter.Get(); }
+
+	/** Aggregator behind RecordMetric. */
+	FFirebaseAnalyticsMetrics* GetMetrics() const { return Metrics.Get(); }
+
+	/** Log one summary event per metric series recorded since the last flush. */
+	void FlushMetrics();
+
+	/** Bundles behind the Blueprint bundle handles. */
+	FFirebaseAnalyticsBundlePool* GetBundlePool() const { return BundlePool.Get(); }
+
+	/** Recorder behind FirebaseAnalytics.StartTrace, sees every call before validation. */
+	FFirebaseAnalyticsTraceWriter& GetTraceWriter() const { return *TraceWriter; }
+
+	/** Deliver the calls held back while the backend wasn't ready. Game thread only, like every direct delivery. */
+	void OnBackendReady();
+
+private:
+	/** Hold the call in its priority lane, or hand it on right away. Past the pre-init buffer. */
+	void RouteCall(FFirebaseAnalyticsCall&& Call);
+
+	/** Hand a call to the dispatcher or the backend. */
+	void DeliverCall(FFirebaseAnalyticsCall&& Call);
+
+	bool TickMetrics(float DeltaTime);
+	bool TickPriorityLanes(float DeltaTime);
+	void OnPreLoadMap(const FString& MapName);
+
+	/** Send what is pending within LifecycleFlushDeadlineSeconds, the process may not get another chance. */
+	void FlushForLifecycle();
+
+	mutable FCriticalSection BackendCriticalSection;
+	FFirebaseAnalyticsBackendPtr Backend;
+	TUniquePtr<FFirebaseAnalyticsJournal> Journal;
+	TAtomic<bool> bJournalSuspended{false};
+	TUniquePtr<FFirebaseAnalyticsDispatcher> Dispatcher;
+	TUniquePtr<FFirebaseAnalyticsEventFilter> EventFilter;
+	TUniquePtr<FFirebaseAnalyticsMetrics> Metrics;
+	TUniquePtr<FFirebaseAnalyticsValidator> Validator;
+	TUniquePtr<FFirebaseAnalyticsTraceWriter> TraceWriter;
+	TUniquePtr<FFirebaseAnalyticsBundlePool> BundlePool;
+	TUniquePtr<FFirebaseAnalyticsPriorityLanes> PriorityLanes;
+	FDelegateHandle MetricsTickerHandle;
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PriorityLanesTickerHandle;
+	FDelegateHandle EnterBackgroundHandle;
+	FDelegateHandle TerminateHandle;
+	double LifecycleFlushDeadlineSeconds = 1.0;
+
+	// Calls made before the backend was ready, in submission order
+	FCriticalSection PreInitCriticalSection;
+	TArray<FFirebaseAnalyticsCall> PreInitCalls;
+	int32 MaxPreInitCalls = 0;
+	TAtomic<bool> bHoldingPreInitCalls{false};
+	double StartupTime = 0.0;
 };
@@ -0,0 +1,43 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsEvent.h"
+
+/** Whatever actually receives analytics calls: the Firebase SDK on device, or a stand-in off-device.
+ *	Methods are called either directly on the caller or on the dispatch thread, never concurrently.
+ */
+class FIREBASEANALYTICS_API IFirebaseAnalyticsBackend
+{
+public:
+	virtual ~IFirebaseAnalyticsBackend() = default;
+
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) = 0;
+
+	/** Deliver several events at once. Backends that can cross into the SDK in one go should override this. */
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events)
+	{
+		for (const FFirebaseAnalyticsEvent& Event : Events)
+		{
+			LogEvent(Event);
+		}
+	}
+
+	virtual void ResetAnalyticsData() = 0;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) = 0;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) = 0;
+	virtual void SetUserID(const FString& UserID) = 0;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) = 0;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) = 0;
+
+	/** False while calls can't reach their destination yet, e.g. before the SDK bindings are resolved.
+	 *	Journaled events delivered meanwhile stay unacknowledged and are replayed on the next launch.
+	 */
+	virtual bool IsReady() const { return true; }
+
+	/** Route a captured call to the matching method. */
+	void Apply(const FFirebaseAnalyticsCall& Call);
+};
+
+typedef TSharedPtr<IFirebaseAnalyticsBackend, ESPMode::ThreadSafe> FFirebaseAnalyticsBackendPtr;
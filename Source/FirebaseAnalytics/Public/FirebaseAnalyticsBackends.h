@@ -0,0 +1,110 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsBackend.h"
+
+class FArchive;
+
+/** Create the backend selected by Type, configured from UFirebaseAnalyticsSettings. */
+FIREBASEANALYTICS_API FFirebaseAnalyticsBackendPtr CreateFirebaseAnalyticsBackend(EFirebaseAnalyticsBackendType Type);
+
+/** Call as one JSON object, in the format the File backend writes. */
+FIREBASEANALYTICS_API FString FirebaseAnalyticsCallToJson(const FFirebaseAnalyticsCall& Call);
+
+/** Append Value as a quoted JSON string. */
+FIREBASEANALYTICS_API void AppendFirebaseAnalyticsJsonString(FString& Out, const TCHAR* Value);
+
+/** Append Parameters of Owner as one JSON object, items as arrays of objects. */
+FIREBASEANALYTICS_API void AppendFirebaseAnalyticsParametersJson(
+	FString& Out,
+	const FFlatBundle& Owner,
+	TArrayView<const FFirebaseAnalyticsParameter> Parameters);
+
+/** Discards every call. Measures the plugin's own cost without any SDK behind it. */
+class FIREBASEANALYTICS_API FFirebaseAnalyticsNullBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override {}
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override {}
+	virtual void ResetAnalyticsData() override {}
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override {}
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override {}
+	virtual void SetUserID(const FString& UserID) override {}
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override {}
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override {}
+	//~ End IFirebaseAnalyticsBackend Interface
+};
+
+/** Keeps the most recent calls in a fixed size ring buffer, oldest are overwritten. */
+class FIREBASEANALYTICS_API FFirebaseAnalyticsMemoryBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	explicit FFirebaseAnalyticsMemoryBackend(int32 InCapacity);
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	/** Copy of the calls still in the buffer, oldest first. */
+	TArray<FFirebaseAnalyticsCall> GetCalls() const;
+
+	/** Number of calls received since construction or the last Empty(), including overwritten ones. */
+	int64 GetNumReceived() const;
+
+	int32 GetCapacity() const { return Capacity; }
+
+	void Empty();
+
+private:
+	FFirebaseAnalyticsCall& Add(EFirebaseAnalyticsCallType Type);
+
+	mutable FCriticalSection CriticalSection;
+	TArray<FFirebaseAnalyticsCall> Calls;
+	int32 Capacity;
+	int64 NumReceived = 0;
+};
+
+/** Appends every call to a file as one JSON object per line. */
+class FIREBASEANALYTICS_API FFirebaseAnalyticsFileBackend : public IFirebaseAnalyticsBackend
+{
+public:
+	explicit FFirebaseAnalyticsFileBackend(const FString& InFilename);
+	virtual ~FFirebaseAnalyticsFileBackend();
+
+	//~ Begin IFirebaseAnalyticsBackend Interface
+	virtual void LogEvent(const FFirebaseAnalyticsEvent& Event) override;
+	virtual void LogEvents(TArrayView<const FFirebaseAnalyticsEvent> Events) override;
+	virtual void ResetAnalyticsData() override;
+	virtual void SetAnalyticsCollectionEnabled(bool bEnabled) override;
+	virtual void SetSessionTimeoutDuration(int32 Milliseconds) override;
+	virtual void SetUserID(const FString& UserID) override;
+	virtual void SetUserProperty(const FString& PropertyName, const FString& PropertyValue) override;
+	virtual void SetDefaultEventParameters(const FFlatBundle& Parameters) override;
+	//~ End IFirebaseAnalyticsBackend Interface
+
+	/** Push buffered lines to disk. */
+	void Flush();
+
+	const FString& GetFilename() const { return Filename; }
+
+private:
+	void BeginLine(EFirebaseAnalyticsCallType Type);
+	void WriteLine();
+
+	FCriticalSection CriticalSection;
+	FString Filename;
+	FArchive* Writer = nullptr;
+
+	// Reused between lines
+	FString Line;
+};
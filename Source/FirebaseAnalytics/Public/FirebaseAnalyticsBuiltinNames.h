@@ -0,0 +1,141 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+static constexpr int32 NumBuiltinEventNames = (int32)EBuiltinEventNames::VIEW_SEARCH_RESULTS + 1;
+static constexpr int32 NumBuiltinParamNames = (int32)EBuiltinParamNames::VIRTUAL_CURRENCY_NAME + 1;
+
+/** Reserved Firebase event names, indexed by EBuiltinEventNames. */
+FORCEINLINE const TCHAR* GetBuiltinEventNameLiteral(EBuiltinEventNames Name)
+{
+	static constexpr const TCHAR* Table[] =
+	{
+		TEXT("add_payment_info"),		// ADD_PAYMENT_INFO
+		TEXT("add_shipping_info"),		// ADD_SHIPPING_INFO
+		TEXT("add_to_cart"),			// ADD_TO_CART
+		TEXT("add_to_wishlist"),		// ADD_TO_WISHLIST
+		TEXT("ad_impression"),			// AD_IMPRESSION
+		TEXT("app_open"),				// APP_OPEN
+		TEXT("begin_checkout"),			// BEGIN_CHECKOUT
+		TEXT("campaign_details"),		// CAMPAIGN_DETAILS
+		TEXT("checkout_progress"),		// CHECKOUT_PROGRESS
+		TEXT("earn_virtual_currency"),	// EARN_VIRTUAL_CURRENCY
+		TEXT("ecommerce_purchase"),		// ECOMMERCE_PURCHASE
+		TEXT("generate_lead"),			// GENERATE_LEAD
+		TEXT("join_group"),				// JOIN_GROUP
+		TEXT("level_end"),				// LEVEL_END
+		TEXT("level_start"),			// LEVEL_START
+		TEXT("level_up"),				// LEVEL_UP
+		TEXT("login"),					// LOGIN
+		TEXT("post_score"),				// POST_SCORE
+		TEXT("present_offer"),			// PRESENT_OFFER
+		TEXT("purchase"),				// PURCHASE
+		TEXT("purchase_refund"),		// PURCHASE_REFUND
+		TEXT("refund"),					// REFUND
+		TEXT("remove_from_cart"),		// REMOVE_FROM_CART
+		TEXT("screen_view"),			// SCREEN_VIEW
+		TEXT("search"),					// SEARCH
+		TEXT("select_content"),			// SELECT_CONTENT
+		TEXT("select_item"),			// SELECT_ITEM
+		TEXT("select_promotion"),		// SELECT_PROMOTION
+		TEXT("set_checkout_option"),	// SET_CHECKOUT_OPTION
+		TEXT("share"),					// SHARE
+		TEXT("sign_up"),				// SIGN_UP
+		TEXT("spend_virtual_currency"),	// SPEND_VIRTUAL_CURRENCY
+		TEXT("tutorial_begin"),			// TUTORIAL_BEGIN
+		TEXT("tutorial_complete"),		// TUTORIAL_COMPLETE
+		TEXT("unlock_achievement"),		// UNLOCK_ACHIEVEMENT
+		TEXT("view_cart"),				// VIEW_CART
+		TEXT("view_item"),				// VIEW_ITEM
+		TEXT("view_item_list"),			// VIEW_ITEM_LIST
+		TEXT("view_promotion"),			// VIEW_PROMOTION
+		TEXT("view_search_results"),	// VIEW_SEARCH_RESULTS
+	};
+	static_assert(UE_ARRAY_COUNT(Table) == NumBuiltinEventNames, "Table is out of sync with EBuiltinEventNames");
+
+	return Table[(int32)Name];
+}
+
+/** Reserved Firebase parameter names, indexed by EBuiltinParamNames. */
+FORCEINLINE const TCHAR* GetBuiltinParamNameLiteral(EBuiltinParamNames Name)
+{
+	static constexpr const TCHAR* Table[] =
+	{
+		TEXT("achievement_id"),		// ACHIEVEMENT_ID
+		TEXT("aclid"),					// ACLID
+		TEXT("ad_format"),				// AD_FORMAT
+		TEXT("ad_platform"),			// AD_PLATFORM
+		TEXT("ad_source"),				// AD_SOURCE
+		TEXT("ad_unit_name"),			// AD_UNIT_NAME
+		TEXT("affiliation"),			// AFFILIATION
+		TEXT("campaign"),				// CAMPAIGN
+		TEXT("character"),				// CHARACTER
+		TEXT("checkout_option"),		// CHECKOUT_OPTION
+		TEXT("checkout_step"),			// CHECKOUT_STEP
+		TEXT("content"),				// CONTENT
+		TEXT("content_type"),			// CONTENT_TYPE
+		TEXT("coupon"),				// COUPON
+		TEXT("cp1"),					// CP1
+		TEXT("creative_name"),			// CREATIVE_NAME
+		TEXT("creative_slot"),			// CREATIVE_SLOT
+		TEXT("currency"),				// CURRENCY
+		TEXT("destination"),			// DESTINATION
+		TEXT("discount"),				// DISCOUNT
+		TEXT("end_date"),				// END_DATE
+		TEXT("extend_session"),		// EXTEND_SESSION
+		TEXT("flight_number"),			// FLIGHT_NUMBER
+		TEXT("group_id"),				// GROUP_ID
+		TEXT("index"),					// INDEX
+		TEXT("items"),					// ITEMS
+		TEXT("item_brand"),			// ITEM_BRAND
+		TEXT("item_category"),			// ITEM_CATEGORY
+		TEXT("item_category2"),		// ITEM_CATEGORY2
+		TEXT("item_category3"),		// ITEM_CATEGORY3
+		TEXT("item_category4"),		// ITEM_CATEGORY4
+		TEXT("item_category5"),		// ITEM_CATEGORY5
+		TEXT("item_id"),				// ITEM_ID
+		TEXT("item_list"),				// ITEM_LIST
+		TEXT("item_list_id"),			// ITEM_LIST_ID
+		TEXT("item_list_name"),		// ITEM_LIST_NAME
+		TEXT("item_location_id"),		// ITEM_LOCATION_ID
+		TEXT("item_name"),				// ITEM_NAME
+		TEXT("item_variant"),			// ITEM_VARIANT
+		TEXT("level"),					// LEVEL
+		TEXT("level_name"),			// LEVEL_NAME
+		TEXT("location"),				// LOCATION
+		TEXT("location_id"),			// LOCATION_ID
+		TEXT("medium"),				// MEDIUM
+		TEXT("method"),				// METHOD
+		TEXT("number_of_nights"),		// NUMBER_OF_NIGHTS
+		TEXT("number_of_passengers"),	// NUMBER_OF_PASSENGERS
+		TEXT("number_of_rooms"),		// NUMBER_OF_ROOMS
+		TEXT("origin"),				// ORIGIN
+		TEXT("payment_type"),			// PAYMENT_TYPE
+		TEXT("price"),					// PRICE
+		TEXT("promotion_id"),			// PROMOTION_ID
+		TEXT("promotion_name"),		// PROMOTION_NAME
+		TEXT("quantity"),				// QUANTITY
+		TEXT("score"),					// SCORE
+		TEXT("screen_class"),			// SCREEN_CLASS
+		TEXT("screen_name"),			// SCREEN_NAME
+		TEXT("search_term"),			// SEARCH_TERM
+		TEXT("shipping"),				// SHIPPING
+		TEXT("shipping_tier"),			// SHIPPING_TIER
+		TEXT("sign_up_method"),		// SIGN_UP_METHOD
+		TEXT("source"),				// SOURCE
+		TEXT("start_date"),			// START_DATE
+		TEXT("success"),				// SUCCESS
+		TEXT("tax"),					// TAX
+		TEXT("term"),					// TERM
+		TEXT("transaction_id"),		// TRANSACTION_ID
+		TEXT("travel_class"),			// TRAVEL_CLASS
+		TEXT("value"),					// VALUE
+		TEXT("virtual_currency_name"),	// VIRTUAL_CURRENCY_NAME
+	};
+	static_assert(UE_ARRAY_COUNT(Table) == NumBuiltinParamNames, "Table is out of sync with EBuiltinParamNames");
+
+	return Table[(int32)Name];
+}
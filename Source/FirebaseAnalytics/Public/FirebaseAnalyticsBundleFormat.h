@@ -0,0 +1,141 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+/** Compact binary form of FBundle, for moving parameters across threads, to disk or to another process.
+ *
+ *	Blob		:= uint8 Magic, uint8 Version, Bundle
+ *	Bundle		:= varint ParameterCount, Parameter[ParameterCount]
+ *	Parameter	:= uint8 Type, Key, Value
+ *	Key			:= varint 0, String for a key seen for the first time | varint KeyIndex + 1 for a repeated one
+ *	Value		:= String | zigzag varint Integer | float32 | varint ItemCount, uint32 ItemBytes, Bundle[ItemCount]
+ *	String		:= varint (Length << 1 | bUTF16), Latin-1 bytes[Length] or UTF-16 code units[Length]
+ *
+ *	Keys are numbered in the order they first appear, nested items included, so every name is stored once.
+ *	Varints are unsigned LEB128, everything else is little-endian.
+ */
+enum class EFirebaseAnalyticsBundleValueType : uint8
+{
+	String = 0,
+	Integer = 1,
+	Float = 2,
+	Bundles = 3,
+};
+
+static constexpr uint8 FirebaseAnalyticsBundleMagic = 0xFB;
+static constexpr uint8 FirebaseAnalyticsBundleVersion = 1;
+
+/** String as it sits in the buffer, converted only when asked to. */
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsBundleString
+{
+	const uint8* Data = nullptr;
+	int32 Length = 0;
+	bool bUTF16 = false;
+
+	FString ToString() const;
+	bool Equals(const TCHAR* Other) const;
+};
+
+class FFirebaseAnalyticsBundleView;
+
+/** Item bundles of a Bundles parameter. Item views are only valid inside the visitor. */
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsBundleItems
+{
+	const FFirebaseAnalyticsBundleView* Owner = nullptr;
+	const uint8* First = nullptr;
+	int32 Num = 0;
+
+	/** Calls Visitor(const FFirebaseAnalyticsBundleView&) for every item, in order. */
+	template <typename VisitorType>
+	void ForEach(VisitorType&& Visitor) const;
+};
+
+/** One parameter read straight out of the buffer. */
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsBundleParameter
+{
+	EFirebaseAnalyticsBundleValueType Type = EFirebaseAnalyticsBundleValueType::String;
+	FFirebaseAnalyticsBundleString Name;
+	FFirebaseAnalyticsBundleString StringValue;
+	int32 IntegerValue = 0;
+	float FloatValue = 0.0f;
+	FFirebaseAnalyticsBundleItems Items;
+};
+
+/** Read-only view over a serialized bundle. Nothing is copied, parameters are decoded as they are visited.
+ *	The buffer must outlive the view.
+ */
+class FIREBASEANALYTICS_API FFirebaseAnalyticsBundleView
+{
+public:
+	FFirebaseAnalyticsBundleView() = default;
+
+	/** Check the whole blob once and index its keys, so later reads need no bounds checks. */
+	bool Initialize(TArrayView<const uint8> Data);
+
+	bool IsValid() const { return Bundle != nullptr; }
+
+	/** Calls Visitor(const FFirebaseAnalyticsBundleParameter&) for every top-level parameter, in the order they were written. */
+	template <typename VisitorType>
+	void ForEachParameter(VisitorType&& Visitor) const
+	{
+		const uint8* Cursor = Bundle;
+		const uint32 NumParameters = ReadVarint(Cursor);
+
+		FFirebaseAnalyticsBundleParameter Parameter;
+		for (uint32 ParameterIdx = 0; ParameterIdx < NumParameters; ParameterIdx++)
+		{
+			Cursor = ReadParameter(Cursor, Parameter);
+			Visitor(Parameter);
+		}
+	}
+
+	/** Rebuild the FBundle the blob was written from. */
+	void ToBundle(FBundle& Out) const;
+
+private:
+	friend struct FFirebaseAnalyticsBundleItems;
+
+	FFirebaseAnalyticsBundleView(const FFirebaseAnalyticsBundleView* InRoot, const uint8* InBundle)
+		: Root(InRoot)
+		, Bundle(InBundle)
+	{
+	}
+
+	const FFirebaseAnalyticsBundleView* GetRoot() const { return Root ? Root : this; }
+
+	// Unchecked readers, only used on blobs that passed Initialize
+	static uint32 ReadVarint(const uint8*& Cursor);
+	const uint8* ReadParameter(const uint8* Cursor, FFirebaseAnalyticsBundleParameter& Out) const;
+	const uint8* SkipBundle(const uint8* Cursor) const;
+
+	/** The view that owns the key index, nullptr for the top level itself. */
+	const FFirebaseAnalyticsBundleView* Root = nullptr;
+	const uint8* Bundle = nullptr;
+	TArray<FFirebaseAnalyticsBundleString, TInlineAllocator<16>> Keys;
+};
+
+template <typename VisitorType>
+void FFirebaseAnalyticsBundleItems::ForEach(VisitorType&& Visitor) const
+{
+	const uint8* Cursor = First;
+	for (int32 ItemIdx = 0; ItemIdx < Num; ItemIdx++)
+	{
+		const FFirebaseAnalyticsBundleView Item(Owner->GetRoot(), Cursor);
+		Visitor(Item);
+		Cursor = Owner->SkipBundle(Cursor);
+	}
+}
+
+/** Serializes FBundle in one pass, straight into the caller's memory. */
+class FIREBASEANALYTICS_API FFirebaseAnalyticsBundleWriter
+{
+public:
+	/** Returns the number of bytes written, or INDEX_NONE when Buffer is too small. */
+	static int32 Write(const FBundle& Bundle, TArrayView<uint8> Buffer);
+
+	/** Appends to Out, growing it as needed. */
+	static void Write(const FBundle& Bundle, TArray<uint8>& Out);
+};
@@ -0,0 +1,56 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+
+/** Event captured at the call site. Owns copies of everything needed to dispatch it later. */
+struct FFirebaseAnalyticsEvent
+{
+	FString Name;
+	FFlatBundle Parameters;
+};
+
+enum class EFirebaseAnalyticsCallType : uint8
+{
+	LogEvent,
+	ResetAnalyticsData,
+	SetAnalyticsCollectionEnabled,
+	SetSessionTimeoutDuration,
+	SetUserID,
+	SetUserProperty,
+	SetDefaultEventParameters,
+};
+
+FIREBASEANALYTICS_API const TCHAR* LexToString(EFirebaseAnalyticsCallType Type);
+
+/** Where a journaled call sits in the event journal, so it can be acknowledged once delivered. */
+struct FFirebaseAnalyticsJournalRecord
+{
+	int32 Offset = INDEX_NONE;
+	uint64 Sequence = 0;
+
+	bool IsValid() const { return Offset != INDEX_NONE; }
+};
+
+/** Any call made through the static API, captured so it reaches the backend in the order it was made. */
+struct FFirebaseAnalyticsCall
+{
+	EFirebaseAnalyticsCallType Type = EFirebaseAnalyticsCallType::LogEvent;
+
+	/** LogEvent: the event. SetUserProperty: property name. SetDefaultEventParameters: parameters. */
+	FFirebaseAnalyticsEvent Event;
+
+	/** SetUserID: user ID. SetUserProperty: property value. */
+	FString Value;
+
+	/** SetAnalyticsCollectionEnabled: 0 or 1. SetSessionTimeoutDuration: milliseconds. */
+	int32 IntegerValue = 0;
+
+	/** Set for typed events, whose names were checked while compiling. Only value lengths are validated. */
+	bool bNamesValidated = false;
+
+	/** Set when the call was written to the event journal. */
+	FFirebaseAnalyticsJournalRecord JournalRecord;
+};
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "FirebaseAnalyticsTypes.h"
 #include "FirebaseAnalyticsSettings.generated.h"
 
 UCLASS(transient, config = Engine)
@@ -11,6 +12,7 @@ class UFirebaseAnalyticsSettings : public UObject
 {
 	GENERATED_BODY()
 
+public:
 	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics")
 	bool bPermanentlyDeactivateCollection = false;
 	
@@ -25,7 +27,211 @@ class UFirebaseAnalyticsSettings : public UObject
 
 	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics")
 	bool bAllowAdPersonalizationSignals = false;
-	
+
+	/** Capture LogEvent* calls into a lock-free queue and do the platform work on a dedicated thread. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Dispatch")
+	bool bAsyncEventDispatch = false;
+
+	/** Upper bound of events the dispatch thread hands to the sink in one batch. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Dispatch", meta = (ClampMin = "1", EditCondition = "bAsyncEventDispatch"))
+	int32 MaxEventsPerBatch = 64;
+
+	/** Skip setting a user ID, user property or default parameter to the value it already has this session. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Dispatch")
+	bool bSkipRedundantWrites = true;
+
+	/** What to do with calls Firebase would drop for their names or lengths. Problems are logged once per name. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Dispatch")
+	EFirebaseAnalyticsValidationPolicy Validation = EFirebaseAnalyticsValidationPolicy::Truncate;
+
+	/** Number of event and parameter names kept as global Java strings, least recently used are evicted. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Marshaling", meta = (ClampMin = "1"))
+	int32 JavaNameCacheSize = 256;
+
+	/** Send single events with parameters through the reusable native buffer batches use, decoded on the Java side, instead of building a Bundle over JNI. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Marshaling")
+	bool bMarshalThroughNativeBuffer = false;
+
+	/** Send arrays of items that share one layout, e.g. from PutItems, as a few primitive arrays the Java side turns into bundles in one call. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Marshaling")
+	bool bMarshalItemsByColumn = true;
+
+	/** Number of bundles Blueprints can hold through bundle handles at once. Handles never logged or released keep their slot. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Marshaling", meta = (ClampMin = "1"))
+	int32 BundleHandlePoolSize = 64;
+
+	/** Where analytics calls end up. Anything other than Platform keeps the SDK untouched, also on Android. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend")
+	EFirebaseAnalyticsBackendType Backend = EFirebaseAnalyticsBackendType::Platform;
+
+	/** Number of most recent calls kept by the Memory backend. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "1", EditCondition = "Backend == EFirebaseAnalyticsBackendType::Memory"))
+	int32 MemoryBackendCapacity = 1024;
+
+	/** File the File backend appends to. Empty writes FirebaseAnalytics.jsonl to the project log directory. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (EditCondition = "Backend == EFirebaseAnalyticsBackendType::File"))
+	FString FileBackendPath;
+
+	/** Directory of the BlockLog backend. Empty writes to Saved/FirebaseAnalytics/EventLog. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	FString BlockLogDirectory;
+
+	/** FCompression format of the blocks, e.g. Zlib, Gzip or LZ4. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	FName BlockLogCompressionFormat = NAME_Zlib;
+
+	/** Uncompressed kilobytes per block. Larger blocks compress better and are written less often. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "1", EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	int32 BlockLogBlockSizeKB = 64;
+
+	/** Seconds a partial block waits before it is written anyway, 0 writes only full blocks. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "0", EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	float BlockLogFlushIntervalSeconds = 5.0f;
+
+	/** Start a new file past this size, 0 for no limit. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "0", EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	int32 BlockLogMaxFileSizeMB = 64;
+
+	/** Start a new file after this many minutes, 0 for no limit. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "0", EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	float BlockLogRotationIntervalMinutes = 60.0f;
+
+	/** Oldest files past this count are deleted, 0 keeps all of them. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Backend", meta = (ClampMin = "0", EditCondition = "Backend == EFirebaseAnalyticsBackendType::BlockLog"))
+	int32 BlockLogMaxFiles = 16;
+
+	/** Measurement Protocol endpoint of the Http backend. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	FString HttpEndpoint = TEXT("https://www.google-analytics.com/mp/collect");
+
+	/** Measurement id sent with every request. Dedicated servers use the Http backend for Platform once it is set. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	FString HttpMeasurementId;
+
+	/** API secret sent with every request. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	FString HttpApiSecret;
+
+	/** Client id of the events. Empty uses the login id of the machine. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	FString HttpClientId;
+
+	/** Events per request. The Measurement Protocol takes at most 25. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "1", ClampMax = "25"))
+	int32 HttpMaxEventsPerRequest = 25;
+
+	/** Seconds a partial batch waits for more events before it is sent. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "0"))
+	float HttpBatchIntervalSeconds = 1.0f;
+
+	/** Requests in flight at once, each on a connection the HTTP module keeps alive between them. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "1", ClampMax = "16"))
+	int32 HttpMaxConcurrentRequests = 2;
+
+	/** Gzip request bodies. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	bool bHttpGzip = true;
+
+	/** Retries of a request that failed to connect, timed out or got a 408, 429 or 5xx, before its events are dropped. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "0"))
+	int32 HttpMaxRetries = 5;
+
+	/** Delay before the first retry, doubled on every further one and jittered. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "0"))
+	float HttpRetryBaseDelaySeconds = 1.0f;
+
+	/** Upper bound of the retry delay. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "0"))
+	float HttpRetryMaxDelaySeconds = 60.0f;
+
+	/** Request bodies kept in memory while waiting to be sent. Past this the newest ones spill to disk. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "1"))
+	int32 HttpMaxQueuedKB = 512;
+
+	/** Directory of spilled request bodies. Empty uses Saved/FirebaseAnalytics/HttpSpill. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP")
+	FString HttpSpillDirectory;
+
+	/** Size cap of the spill directory. The oldest bodies are dropped past it, 0 disables spilling. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | HTTP", meta = (ClampMin = "0"))
+	int32 HttpMaxSpillSizeMB = 16;
+
+	/** Keep logged events in a memory-mapped journal until the backend has taken them, and replay leftovers on the next launch. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Journal")
+	bool bEnableEventJournal = false;
+
+	/** Size cap of the journal file in kilobytes. The oldest records are reclaimed when it's full. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Journal", meta = (ClampMin = "4", EditCondition = "bEnableEventJournal"))
+	int32 EventJournalSizeKB = 1024;
+
+	/** Initialize the Firebase SDK on a background thread after the first frame instead of in GameActivity.onCreate. Applied when packaging. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Startup")
+	bool bDeferInitialization = true;
+
+	/** Number of calls held back until the SDK is initialized, later ones are dropped. 0 drops all of them, as before. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Startup", meta = (ClampMin = "0"))
+	int32 PreInitBufferSize = 256;
+
+	/** Sampling and rate limits per event name. Read at startup. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Event Rules")
+	TArray<FFirebaseAnalyticsEventRule> EventRules;
+
+	/** Parameter that carries the sample rate when a rule asks for it. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Event Rules")
+	FString SampleRateParameterName = TEXT("sample_rate");
+
+	/** Events the game logs and their parameters. Names are checked once at startup, calls are checked against it before dispatch. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Event Schema")
+	TArray<FFirebaseAnalyticsEventSchema> EventSchema;
+
+	/** Drop events missing from the schema or carrying parameters it doesn't list, in Shipping. Other builds log them once and send them. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Event Schema")
+	bool bRejectEventsOutsideSchema = false;
+
+	/** Hold Normal and Low priority events and send them within a per-frame time budget. Critical events are always sent right away. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority")
+	bool bEnablePriorityLanes = false;
+
+	/** Priorities per event name. Purchases and refunds default to Critical, screen views and browsing events to Low, everything else to Normal. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (EditCondition = "bEnablePriorityLanes"))
+	TArray<FFirebaseAnalyticsEventPriorityRule> EventPriorities;
+
+	/** Milliseconds per frame spent sending held events. Halved on every hitch and regained over smooth frames. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (ClampMin = "0.01", EditCondition = "bEnablePriorityLanes"))
+	float FlushBudgetMilliseconds = 0.5f;
+
+	/** Frames longer than this count as hitches. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (ClampMin = "1", EditCondition = "bEnablePriorityLanes"))
+	float HitchThresholdMilliseconds = 50.0f;
+
+	/** Seconds an event may be held before it is sent regardless of the budget. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (ClampMin = "0", EditCondition = "bEnablePriorityLanes"))
+	float MaxEventHoldSeconds = 10.0f;
+
+	/** Number of held events. Past it, an event is sent right away after the events already held in its lane. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (ClampMin = "1", EditCondition = "bEnablePriorityLanes"))
+	int32 MaxHeldEvents = 1024;
+
+	/** Seconds the game may spend sending pending events when it goes to the background or terminates. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Priority", meta = (ClampMin = "0"))
+	float LifecycleFlushDeadlineSeconds = 1.0f;
+
+	/** Seconds between metric summary events, 0 logs them only on FlushMetrics and map changes. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Metrics", meta = (ClampMin = "0"))
+	float MetricsFlushInterval = 60.0f;
+
+	/** Log metric summaries before a new map is loaded. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Metrics")
+	bool bFlushMetricsOnMapChange = true;
+
+	/** Number of metric and dimension combinations each of the 16 recording shards keeps per interval. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Metrics", meta = (ClampMin = "1"))
+	int32 MaxMetricSeriesPerThread = 256;
+
+	/** Relative error of the p50/p90/p99 values in metric summaries. */
+	UPROPERTY(Config, EditAnywhere, Category = "Firebase Analytics | Metrics", meta = (ClampMin = "0.0001", ClampMax = "0.5"))
+	float MetricsRelativeAccuracy = 0.01f;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
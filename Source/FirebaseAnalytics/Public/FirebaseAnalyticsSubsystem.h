@@ -4,139 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "FirebaseAnalyticsTypes.h"
 #include "FirebaseAnalyticsSubsystem.generated.h"
 
-UENUM(Blueprintable)
-enum class EBuiltinParamNames : uint8
-{
-	ACHIEVEMENT_ID,
-	ACLID,
-	AD_FORMAT,
-	AD_PLATFORM,
-	AD_SOURCE,
-	AD_UNIT_NAME,
-	AFFILIATION	,
-	CAMPAIGN,
-	CHARACTER,
-	CHECKOUT_OPTION,
-	CHECKOUT_STEP,
-	CONTENT,
-	CONTENT_TYPE,
-	COUPON,
-	CP1,
-	CREATIVE_NAME,
-	CREATIVE_SLOT,
-	CURRENCY,
-	DESTINATION,
-	DISCOUNT,
-	END_DATE,
-	EXTEND_SESSION,
-	FLIGHT_NUMBER,
-	GROUP_ID,
-	INDEX,
-	ITEMS,
-	ITEM_BRAND,
-	ITEM_CATEGORY,
-	ITEM_CATEGORY2,
-	ITEM_CATEGORY3,
-	ITEM_CATEGORY4,
-	ITEM_CATEGORY5,
-	ITEM_ID,
-	ITEM_LIST,
-	ITEM_LIST_ID,
-	ITEM_LIST_NAME,
-	ITEM_LOCATION_ID,
-	ITEM_NAME,
-	ITEM_VARIANT,
-	LEVEL,
-	LEVEL_NAME,
-	LOCATION,
-	LOCATION_ID,
-	MEDIUM,
-	METHOD,
-	NUMBER_OF_NIGHTS,
-	NUMBER_OF_PASSENGERS,
-	NUMBER_OF_ROOMS,
-	ORIGIN,
-	PAYMENT_TYPE,
-	PRICE,
-	PROMOTION_ID,
-	PROMOTION_NAME,
-	QUANTITY,
-	SCORE,
-	SCREEN_CLASS,
-	SCREEN_NAME,
-	SEARCH_TERM,
-	SHIPPING,
-	SHIPPING_TIER,
-	SIGN_UP_METHOD,
-	SOURCE,
-	START_DATE,
-	SUCCESS,
-	TAX,
-	TERM,
-	TRANSACTION_ID,
-	TRAVEL_CLASS,
-	VALUE,
-	VIRTUAL_CURRENCY_NAME,
-};
-
-UENUM(Blueprintable)
-enum class EBuiltinEventNames : uint8
-{
-	ADD_PAYMENT_INFO,
-	ADD_SHIPPING_INFO,
-	ADD_TO_CART,
-	ADD_TO_WISHLIST,
-	AD_IMPRESSION,
-	APP_OPEN,
-	BEGIN_CHECKOUT,
-	CAMPAIGN_DETAILS,
-	CHECKOUT_PROGRESS,
-	EARN_VIRTUAL_CURRENCY,
-	ECOMMERCE_PURCHASE,
-	GENERATE_LEAD,
-	JOIN_GROUP,
-	LEVEL_END,
-	LEVEL_START,
-	LEVEL_UP,
-	LOGIN,
-	POST_SCORE,
-	PRESENT_OFFER,
-	PURCHASE,
-	PURCHASE_REFUND,
-	REFUND,
-	REMOVE_FROM_CART,
-	SCREEN_VIEW,
-	SEARCH,
-	SELECT_CONTENT,
-	SELECT_ITEM,
-	SELECT_PROMOTION,
-	SET_CHECKOUT_OPTION,
-	SHARE,
-	SIGN_UP,
-	SPEND_VIRTUAL_CURRENCY,
-	TUTORIAL_BEGIN,
-	TUTORIAL_COMPLETE,
-	UNLOCK_ACHIEVEMENT,
-	VIEW_CART,
-	VIEW_ITEM,
-	VIEW_ITEM_LIST,
-	VIEW_PROMOTION,
-	VIEW_SEARCH_RESULTS,
-};
-
-USTRUCT(BlueprintType)
-struct FBundle
-{
-	GENERATED_BODY()
-
-	TMap<FString, FString> StringParameters;
-	TMap<FString, float> FloatParameters;
-	TMap<FString, int> IntegerParameters;
-	TMap<FString, TArray<FBundle>> BundlesParameters;
-};
-
 UCLASS()
 class UFirebaseAnalyticsSubsystem : public UGameInstanceSubsystem
 {
@@ -226,6 +96,27 @@ public:
 		const FString& EventName, 
 		const FBundle& Bundle);
 
+	/** Same as above, taking the string values and items out of Bundle instead of copying them. */
+	static void LogEventWithParameters(
+		const FString& EventName,
+		FBundle&& Bundle);
+
+	/** Log an event with parameters stored in a flat bundle.
+	 *	Same as LogEventWithParameters, but the parameters are copied as one block
+	 *	and can carry double and int64 values.
+	 *  @param EventName	Name of the event to log. Same rules as LogEventWithParameters.
+	 *  @param Bundle		Flat bundle of event parameters.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics")
+	static void LogEventWithFlatParameters(
+		const FString& EventName,
+		const FFlatBundle& Bundle);
+
+	/** Same as above, taking Bundle over instead of copying it. */
+	static void LogEventWithFlatParameters(
+		const FString& EventName,
+		FFlatBundle&& Bundle);
+
 	/** Clears all analytics data for this app from the device and resets the app instance id. */
 	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics")
 	static void ResetAnalyticsData();
@@ -289,17 +180,79 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics")
 	static void SetDefaultEventParameters(const FBundle& Bundle);
+
+	/** Same as above, taking the string values out of Bundle instead of copying them. */
+	static void SetDefaultEventParameters(FBundle&& Bundle);
+
+	/** Same as SetDefaultEventParameters, with parameters stored in a flat bundle.
+	 *	Put a null parameter to clear a single default parameter.
+	 *  @param Bundle	Flat bundle of parameters to add, or an empty one to clear all parameters.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics")
+	static void SetDefaultEventFlatParameters(const FFlatBundle& Bundle);
+
+	/** Same as above, taking Bundle over instead of copying it. */
+	static void SetDefaultEventFlatParameters(FFlatBundle&& Bundle);
 	
-	/** Return a built-in event names.
+	/** Return a built-in event names. Copies the whole map on every call, use GetBuiltinEventName instead.
 	 */
-	UFUNCTION(BlueprintCallable, Category="FirebaseAnalytics")
+	UFUNCTION(BlueprintCallable, Category="FirebaseAnalytics", meta = (DeprecatedFunction, DeprecationMessage = "Copies every name on each call, use GetBuiltinEventName."))
 	static TMap<EBuiltinEventNames, FString> GetBuiltinEventNames();
 
-	/** Return a built-in param names.
+	/** Return a built-in param names. Copies the whole map on every call, use GetBuiltinParamName instead.
 	 */
-	UFUNCTION(BlueprintCallable, Category="FirebaseAnalytics")
+	UFUNCTION(BlueprintCallable, Category="FirebaseAnalytics", meta = (DeprecatedFunction, DeprecationMessage = "Copies every name on each call, use GetBuiltinParamName."))
 	static TMap<EBuiltinParamNames, FString> GetBuiltinParamNames();
 
+	/** Return the name of a single built-in event.
+	 */
+	UFUNCTION(BlueprintPure, Category="FirebaseAnalytics")
+	static FString GetBuiltinEventName(EBuiltinEventNames EventName);
+
+	/** Return the name of a single built-in param.
+	 */
+	UFUNCTION(BlueprintPure, Category="FirebaseAnalytics")
+	static FString GetBuiltinParamName(EBuiltinParamNames ParamName);
+
+	/** Log a built-in event. The event name is taken from a static table,
+	 *	no name map is built for the call.
+	 *  @param EventName	Built-in event to log.
+	 *  @param Bundle		The map of event parameters, may be left empty.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics", meta = (AutoCreateRefTerm = "Bundle"))
+	static void LogBuiltinEvent(
+		EBuiltinEventNames EventName,
+		const FBundle& Bundle);
+
+	/** Log a built-in event with parameters stored in a flat bundle.
+	 *  @param EventName	Built-in event to log.
+	 *  @param Bundle		Flat bundle of event parameters, may be left empty.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics", meta = (AutoCreateRefTerm = "Bundle"))
+	static void LogBuiltinEventWithFlatParameters(
+		EBuiltinEventNames EventName,
+		const FFlatBundle& Bundle);
+
+	/** Add a value to a metric summary instead of logging an event for it. Every flush logs one
+	 *	MetricName event per set of dimensions, with count, sum, min, max, p50, p90 and p99.
+	 *  @param MetricName	Name of the summary event.
+	 *  @param Value		Value to add.
+	 *  @param Dimensions	Parameters the summary is split by, may be left empty.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Metrics", meta = (AutoCreateRefTerm = "Dimensions"))
+	static void RecordMetric(
+		const FString& MetricName,
+		const float Value,
+		const TMap<FString, FString>& Dimensions);
+
+	/** Log the summaries of every metric recorded since the last flush. */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Metrics")
+	static void FlushMetrics();
+
+	/** Send every held and queued event now, e.g. before a checkpoint the game can't come back from. Blocks until they reach the SDK. */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics")
+	static void FlushEvents();
+
 	/** Add a string parameter to Bundle.
 	 *	@param Bundle			Bundle reference
 	 *  @param ParameterName	Name of the parameter to log.
@@ -343,4 +296,358 @@ public:
 		UPARAM(ref) FBundle& Bundle, 
 		const FString& ParameterName, 
 		const TArray<FBundle>& ParameterValue);
+
+	/** Same as above, moving the items into Bundle. */
+	static void PutBundles(
+		FBundle& Bundle,
+		const FString& ParameterName,
+		TArray<FBundle>&& ParameterValue);
+
+	/** Add a string parameter with a built-in name to Bundle.
+	 *	@param Bundle			Bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	String parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Bundle")
+	static void PutBuiltinString(
+		UPARAM(ref) FBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const FString& ParameterValue);
+
+	/** Add a floating point parameter with a built-in name to Bundle.
+	 *	@param Bundle			Bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Float parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Bundle")
+	static void PutBuiltinFloat(
+		UPARAM(ref) FBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const float ParameterValue);
+
+	/** Add a integer parameter with a built-in name to Bundle.
+	 *	@param Bundle			Bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Bundle")
+	static void PutBuiltinInteger(
+		UPARAM(ref) FBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const int ParameterValue);
+
+	/** Add a bundles array with a built-in name to Bundle.
+	 *	@param Bundle			Bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Array of bundle to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Bundle")
+	static void PutBuiltinBundles(
+		UPARAM(ref) FBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const TArray<FBundle>& ParameterValue);
+
+	/** Add a string parameter to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	String parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatString(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName,
+		const FString& ParameterValue);
+
+	/** Add a string parameter with a built-in name to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	String parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinString(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const FString& ParameterValue);
+
+	/** Add a floating point parameter to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	Float parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatFloat(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName,
+		const float ParameterValue);
+
+	/** Add a floating point parameter with a built-in name to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Float parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinFloat(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const float ParameterValue);
+
+	/** Add an integer parameter to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	Integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatInteger(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName,
+		const int ParameterValue);
+
+	/** Add an integer parameter with a built-in name to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinInteger(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const int ParameterValue);
+
+	/** Add a 64-bit integer parameter to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	64-bit integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatInt64(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName,
+		const int64 ParameterValue);
+
+	/** Add a 64-bit integer parameter with a built-in name to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	64-bit integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinInt64(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const int64 ParameterValue);
+
+	/** Add a parameter without a value to flat Bundle. Only meaningful for default event parameters, where it clears the parameter.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to clear.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatNull(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName);
+
+	/** Add a parameter with a built-in name and without a value to flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to clear.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinNull(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName);
+
+	/** Add an items array to flat Bundle. Items can't contain nested arrays.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	Array of flat bundles to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBundles(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FString& ParameterName,
+		const TArray<FFlatBundle>& ParameterValue);
+
+	/** Add an items array with a built-in name to flat Bundle. Items can't contain nested arrays.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Array of flat bundles to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | FlatBundle")
+	static void PutFlatBuiltinBundles(
+		UPARAM(ref) FFlatBundle& Bundle,
+		EBuiltinParamNames ParameterName,
+		const TArray<FFlatBundle>& ParameterValue);
+
+	/** Take a pooled flat bundle to fill in place with the PutHandle nodes. The handle is two integers,
+	 *	so passing it around a graph never copies parameters. Log it or release it when done.
+	 *	@return	An invalid handle when the pool is exhausted, Put and Log nodes ignore it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static FFirebaseAnalyticsBundleHandle AcquireBundleHandle();
+
+	/** Return the bundle to the pool without logging it.
+	 *	@param Handle	Handle from AcquireBundleHandle. Every copy of it goes stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void ReleaseBundleHandle(FFirebaseAnalyticsBundleHandle Handle);
+
+	/** Log an event with the parameters behind Handle, then return the bundle to the pool.
+	 *  @param EventName	Name of the event to log. Same rules as LogEventWithParameters.
+	 *  @param Handle		Handle from AcquireBundleHandle. Every copy of it goes stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void LogEventWithHandle(
+		const FString& EventName,
+		FFirebaseAnalyticsBundleHandle Handle);
+
+	/** Log a built-in event with the parameters behind Handle, then return the bundle to the pool.
+	 *  @param EventName	Built-in event to log.
+	 *  @param Handle		Handle from AcquireBundleHandle. Every copy of it goes stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void LogBuiltinEventWithHandle(
+		EBuiltinEventNames EventName,
+		FFirebaseAnalyticsBundleHandle Handle);
+
+	/** Same as SetDefaultEventFlatParameters with the parameters behind Handle, then return the bundle to the pool.
+	 *  @param Handle		Handle from AcquireBundleHandle. Every copy of it goes stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void SetDefaultEventHandleParameters(FFirebaseAnalyticsBundleHandle Handle);
+
+	/** Add a string parameter to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	String parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleString(
+		FFirebaseAnalyticsBundleHandle Handle,
+		const FString& ParameterName,
+		const FString& ParameterValue);
+
+	/** Add a string parameter with a built-in name to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	String parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleBuiltinString(
+		FFirebaseAnalyticsBundleHandle Handle,
+		EBuiltinParamNames ParameterName,
+		const FString& ParameterValue);
+
+	/** Add a floating point parameter to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	Float parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleFloat(
+		FFirebaseAnalyticsBundleHandle Handle,
+		const FString& ParameterName,
+		const float ParameterValue);
+
+	/** Add a floating point parameter with a built-in name to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Float parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleBuiltinFloat(
+		FFirebaseAnalyticsBundleHandle Handle,
+		EBuiltinParamNames ParameterName,
+		const float ParameterValue);
+
+	/** Add an integer parameter to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param ParameterValue	Integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleInteger(
+		FFirebaseAnalyticsBundleHandle Handle,
+		const FString& ParameterName,
+		const int ParameterValue);
+
+	/** Add an integer parameter with a built-in name to the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param ParameterValue	Integer parameter to log.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleBuiltinInteger(
+		FFirebaseAnalyticsBundleHandle Handle,
+		EBuiltinParamNames ParameterName,
+		const int ParameterValue);
+
+	/** Move the bundles behind Items into the bundle behind Handle as an items array. Items can't contain nested arrays.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Name of the parameter to log.
+	 *  @param Items			Handles of the item bundles. They are returned to the pool and go stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleBundles(
+		FFirebaseAnalyticsBundleHandle Handle,
+		const FString& ParameterName,
+		const TArray<FFirebaseAnalyticsBundleHandle>& Items);
+
+	/** Move the bundles behind Items into the bundle behind Handle as an items array with a built-in name.
+	 *	@param Handle			Bundle handle
+	 *  @param ParameterName	Built-in parameter to log.
+	 *  @param Items			Handles of the item bundles. They are returned to the pool and go stale.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | BundleHandle")
+	static void PutHandleBuiltinBundles(
+		FFirebaseAnalyticsBundleHandle Handle,
+		EBuiltinParamNames ParameterName,
+		const TArray<FFirebaseAnalyticsBundleHandle>& Items);
+
+	/** Set one column of an items array, e.g. ITEM_ID or ITEM_NAME for every item.
+	 *	@param Items			Item columns reference
+	 *  @param ParameterName	Built-in item parameter the column holds.
+	 *  @param Values			One value per item.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Items")
+	static void SetItemStrings(
+		UPARAM(ref) FFirebaseAnalyticsItemColumns& Items,
+		EBuiltinParamNames ParameterName,
+		const TArray<FString>& Values);
+
+	/** Set one floating point column of an items array, e.g. PRICE. Sent as doubles.
+	 *	@param Items			Item columns reference
+	 *  @param ParameterName	Built-in item parameter the column holds.
+	 *  @param Values			One value per item.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Items")
+	static void SetItemFloats(
+		UPARAM(ref) FFirebaseAnalyticsItemColumns& Items,
+		EBuiltinParamNames ParameterName,
+		const TArray<float>& Values);
+
+	/** Set one integer column of an items array, e.g. QUANTITY or INDEX. Sent as longs.
+	 *	@param Items			Item columns reference
+	 *  @param ParameterName	Built-in item parameter the column holds.
+	 *  @param Values			One value per item.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Items")
+	static void SetItemIntegers(
+		UPARAM(ref) FFirebaseAnalyticsItemColumns& Items,
+		EBuiltinParamNames ParameterName,
+		const TArray<int32>& Values);
+
+	/** Put the items as the ITEMS parameter of flat Bundle.
+	 *	@param Bundle			Flat bundle reference
+	 *  @param Items			Item columns, one item per row.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Items")
+	static void PutFlatItems(
+		UPARAM(ref) FFlatBundle& Bundle,
+		const FFirebaseAnalyticsItemColumns& Items);
+
+	/** Put the items as the ITEMS parameter of the bundle behind Handle.
+	 *	@param Handle			Bundle handle
+	 *  @param Items			Item columns, one item per row.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "FirebaseAnalytics | Items")
+	static void PutHandleItems(
+		FFirebaseAnalyticsBundleHandle Handle,
+		const FFirebaseAnalyticsItemColumns& Items);
 };
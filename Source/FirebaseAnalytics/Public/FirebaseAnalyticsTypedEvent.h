@@ -0,0 +1,68 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.h"
+#include "FirebaseAnalyticsValidation.h"
+#include "Templates/Function.h"
+
+/** Events of a fixed catalogue declared as C++ structs, one member per parameter:
+ *
+ *	#define LEVEL_UP_PARAMETERS(Parameter) \
+ *		Parameter(int32, level) \
+ *		Parameter(FString, character)
+ *
+ *	FIREBASE_ANALYTICS_TYPED_EVENT(FLevelUpEvent, level_up, LEVEL_UP_PARAMETERS)
+ *
+ *	FLevelUpEvent Event;
+ *	Event.level = 5;
+ *	Event.Log();
+ *
+ *	Names are checked against the Firebase rules while compiling and parameters point at their literal names,
+ *	so logging skips name validation and the event schema and copies no names. Event rules still apply.
+ *	Parameter types are int32, int64, float, double and FString.
+ */
+namespace FirebaseAnalyticsTypedEvent
+{
+	inline void Put(FFlatBundle& Bundle, FFirebaseAnalyticsStaticName Name, int32 Value) { Bundle.PutInteger(Name, Value); }
+	inline void Put(FFlatBundle& Bundle, FFirebaseAnalyticsStaticName Name, int64 Value) { Bundle.PutInt64(Name, Value); }
+	inline void Put(FFlatBundle& Bundle, FFirebaseAnalyticsStaticName Name, float Value) { Bundle.PutFloat(Name, Value); }
+	inline void Put(FFlatBundle& Bundle, FFirebaseAnalyticsStaticName Name, double Value) { Bundle.PutDouble(Name, Value); }
+	inline void Put(FFlatBundle& Bundle, FFirebaseAnalyticsStaticName Name, const FString& Value) { Bundle.PutString(Name, Value); }
+
+	/** Runs the event rules, then lets PutParameters fill the bundle and submits the call with its names marked as checked. */
+	FIREBASEANALYTICS_API void Log(const FString& EventName, TFunctionRef<void(FFlatBundle&)> PutParameters);
+}
+
+#define FIREBASE_ANALYTICS_TYPED_EVENT_MEMBER(Type, Name) \
+	Type Name{};
+
+#define FIREBASE_ANALYTICS_TYPED_EVENT_PUT(Type, Name) \
+	{ \
+		static_assert(FirebaseAnalyticsLimits::IsValidName(TEXT(#Name), EFirebaseAnalyticsNameKind::Parameter), "Invalid Firebase Analytics parameter name: " #Name); \
+		FirebaseAnalyticsTypedEvent::Put(Bundle, FFirebaseAnalyticsStaticName(TEXT(#Name)), Name); \
+	}
+
+#define FIREBASE_ANALYTICS_TYPED_EVENT(StructName, EventName, Parameters) \
+	struct StructName \
+	{ \
+		Parameters(FIREBASE_ANALYTICS_TYPED_EVENT_MEMBER) \
+		\
+		static const FString& GetEventName() \
+		{ \
+			static_assert(FirebaseAnalyticsLimits::IsValidName(TEXT(#EventName), EFirebaseAnalyticsNameKind::Event), "Invalid Firebase Analytics event name: " #EventName); \
+			static const FString EventNameString(TEXT(#EventName)); \
+			return EventNameString; \
+		} \
+		\
+		void PutParameters(FFlatBundle& Bundle) const \
+		{ \
+			Parameters(FIREBASE_ANALYTICS_TYPED_EVENT_PUT) \
+		} \
+		\
+		void Log() const \
+		{ \
+			FirebaseAnalyticsTypedEvent::Log(GetEventName(), [this](FFlatBundle& Bundle) { PutParameters(Bundle); }); \
+		} \
+	};
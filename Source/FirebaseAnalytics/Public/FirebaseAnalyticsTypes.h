@@ -0,0 +1,453 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FirebaseAnalyticsTypes.generated.h"
+
+UENUM(Blueprintable)
+enum class EBuiltinParamNames : uint8
+{
+	ACHIEVEMENT_ID,
+	ACLID,
+	AD_FORMAT,
+	AD_PLATFORM,
+	AD_SOURCE,
+	AD_UNIT_NAME,
+	AFFILIATION	,
+	CAMPAIGN,
+	CHARACTER,
+	CHECKOUT_OPTION,
+	CHECKOUT_STEP,
+	CONTENT,
+	CONTENT_TYPE,
+	COUPON,
+	CP1,
+	CREATIVE_NAME,
+	CREATIVE_SLOT,
+	CURRENCY,
+	DESTINATION,
+	DISCOUNT,
+	END_DATE,
+	EXTEND_SESSION,
+	FLIGHT_NUMBER,
+	GROUP_ID,
+	INDEX,
+	ITEMS,
+	ITEM_BRAND,
+	ITEM_CATEGORY,
+	ITEM_CATEGORY2,
+	ITEM_CATEGORY3,
+	ITEM_CATEGORY4,
+	ITEM_CATEGORY5,
+	ITEM_ID,
+	ITEM_LIST,
+	ITEM_LIST_ID,
+	ITEM_LIST_NAME,
+	ITEM_LOCATION_ID,
+	ITEM_NAME,
+	ITEM_VARIANT,
+	LEVEL,
+	LEVEL_NAME,
+	LOCATION,
+	LOCATION_ID,
+	MEDIUM,
+	METHOD,
+	NUMBER_OF_NIGHTS,
+	NUMBER_OF_PASSENGERS,
+	NUMBER_OF_ROOMS,
+	ORIGIN,
+	PAYMENT_TYPE,
+	PRICE,
+	PROMOTION_ID,
+	PROMOTION_NAME,
+	QUANTITY,
+	SCORE,
+	SCREEN_CLASS,
+	SCREEN_NAME,
+	SEARCH_TERM,
+	SHIPPING,
+	SHIPPING_TIER,
+	SIGN_UP_METHOD,
+	SOURCE,
+	START_DATE,
+	SUCCESS,
+	TAX,
+	TERM,
+	TRANSACTION_ID,
+	TRAVEL_CLASS,
+	VALUE,
+	VIRTUAL_CURRENCY_NAME,
+};
+
+UENUM(Blueprintable)
+enum class EBuiltinEventNames : uint8
+{
+	ADD_PAYMENT_INFO,
+	ADD_SHIPPING_INFO,
+	ADD_TO_CART,
+	ADD_TO_WISHLIST,
+	AD_IMPRESSION,
+	APP_OPEN,
+	BEGIN_CHECKOUT,
+	CAMPAIGN_DETAILS,
+	CHECKOUT_PROGRESS,
+	EARN_VIRTUAL_CURRENCY,
+	ECOMMERCE_PURCHASE,
+	GENERATE_LEAD,
+	JOIN_GROUP,
+	LEVEL_END,
+	LEVEL_START,
+	LEVEL_UP,
+	LOGIN,
+	POST_SCORE,
+	PRESENT_OFFER,
+	PURCHASE,
+	PURCHASE_REFUND,
+	REFUND,
+	REMOVE_FROM_CART,
+	SCREEN_VIEW,
+	SEARCH,
+	SELECT_CONTENT,
+	SELECT_ITEM,
+	SELECT_PROMOTION,
+	SET_CHECKOUT_OPTION,
+	SHARE,
+	SIGN_UP,
+	SPEND_VIRTUAL_CURRENCY,
+	TUTORIAL_BEGIN,
+	TUTORIAL_COMPLETE,
+	UNLOCK_ACHIEVEMENT,
+	VIEW_CART,
+	VIEW_ITEM,
+	VIEW_ITEM_LIST,
+	VIEW_PROMOTION,
+	VIEW_SEARCH_RESULTS,
+};
+
+USTRUCT(BlueprintType)
+struct FBundle
+{
+	GENERATED_BODY()
+
+	TMap<FString, FString> StringParameters;
+	TMap<FString, float> FloatParameters;
+	TMap<FString, int> IntegerParameters;
+	TMap<FString, TArray<FBundle>> BundlesParameters;
+};
+
+UENUM(BlueprintType)
+enum class EFirebaseAnalyticsParameterType : uint8
+{
+	String,
+	Float,
+	Double,
+	Integer,
+	Int64,
+	Bundles,
+	/** No value. Clears the parameter in SetDefaultEventParameters. */
+	Null,
+};
+
+UENUM()
+enum class EFirebaseAnalyticsBackendType : uint8
+{
+	/** Firebase SDK on Android, Http on dedicated servers with a measurement id, Null everywhere else. */
+	Platform,
+	/** Discard every call. */
+	Null,
+	/** Keep the most recent calls in a ring buffer. */
+	Memory,
+	/** Append every call to a file, one JSON object per line. */
+	File,
+	/** Write every call to compressed blocks on a background thread, see the FirebaseAnalyticsBlockLog commandlet. */
+	BlockLog,
+	/** Post batches of events to a Measurement Protocol endpoint, see the FirebaseAnalyticsHttpStub commandlet. */
+	Http,
+};
+
+/** What happens to calls that break the Firebase naming and length limits. */
+UENUM()
+enum class EFirebaseAnalyticsValidationPolicy : uint8
+{
+	/** Don't check anything. */
+	Off,
+	/** Log the problem and send the call as it is. */
+	Log,
+	/** Shorten names and values that are too long and drop extra parameters; drop calls that can't be fixed. */
+	Truncate,
+	/** Drop every call with a problem. */
+	Reject,
+};
+
+/** Sampling and rate limit for one event name, applied before anything is marshaled. */
+USTRUCT()
+struct FFirebaseAnalyticsEventRule
+{
+	GENERATED_BODY()
+
+	/** Event name the rule applies to, case sensitive. "*" applies to every event no other rule names. */
+	UPROPERTY(EditAnywhere, Category = "Rule")
+	FString EventName;
+
+	/** Fraction of events kept. */
+	UPROPERTY(EditAnywhere, Category = "Rule", meta = (ClampMin = "0", ClampMax = "1"))
+	float SampleRate = 1.0f;
+
+	/** Events per second let through after sampling, 0 for no limit. */
+	UPROPERTY(EditAnywhere, Category = "Rule", meta = (ClampMin = "0"))
+	float MaxEventsPerSecond = 0.0f;
+
+	/** Events let through back to back after a quiet period. */
+	UPROPERTY(EditAnywhere, Category = "Rule", meta = (ClampMin = "1", EditCondition = "MaxEventsPerSecond > 0"))
+	int32 BurstSize = 1;
+
+	/** Add the sample rate to kept events, so counts can be scaled back up. */
+	UPROPERTY(EditAnywhere, Category = "Rule")
+	bool bAddSampleRateParameter = false;
+};
+
+/** How soon a logged event has to leave the device. */
+UENUM()
+enum class EFirebaseAnalyticsEventPriority : uint8
+{
+	/** Sent right away, never held back. */
+	Critical,
+	/** Held for a quiet moment and sent within the per-frame flush budget. */
+	Normal,
+	/** Sent when the budget has room left after every Normal event. */
+	Low,
+};
+
+/** Priority of one event name, on top of the defaults of the built-in events. */
+USTRUCT()
+struct FFirebaseAnalyticsEventPriorityRule
+{
+	GENERATED_BODY()
+
+	/** Event name the priority applies to, case sensitive. "*" applies to every event with no other priority. */
+	UPROPERTY(EditAnywhere, Category = "Priority")
+	FString EventName;
+
+	UPROPERTY(EditAnywhere, Category = "Priority")
+	EFirebaseAnalyticsEventPriority Priority = EFirebaseAnalyticsEventPriority::Normal;
+};
+
+/** One parameter an event of the schema may carry. */
+USTRUCT()
+struct FFirebaseAnalyticsParameterSchema
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Schema")
+	FString Name;
+
+	UPROPERTY(EditAnywhere, Category = "Schema")
+	EFirebaseAnalyticsParameterType Type = EFirebaseAnalyticsParameterType::String;
+};
+
+/** Event of the catalogue with the parameters it is allowed to carry. */
+USTRUCT()
+struct FFirebaseAnalyticsEventSchema
+{
+	GENERATED_BODY()
+
+	/** Case sensitive. */
+	UPROPERTY(EditAnywhere, Category = "Schema")
+	FString EventName;
+
+	UPROPERTY(EditAnywhere, Category = "Schema")
+	TArray<FFirebaseAnalyticsParameterSchema> Parameters;
+};
+
+/** Blueprint reference to a pooled FFlatBundle, see UFirebaseAnalyticsSubsystem::AcquireBundleHandle.
+ *	Copying it copies two integers. A handle goes stale once its bundle is logged or released.
+ */
+USTRUCT(BlueprintType)
+struct FFirebaseAnalyticsBundleHandle
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/** One column of FFirebaseAnalyticsItemColumns. Only the array matching Type is used. */
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsItemColumn
+{
+	EBuiltinParamNames Name = EBuiltinParamNames::ITEM_ID;
+	EFirebaseAnalyticsParameterType Type = EFirebaseAnalyticsParameterType::String;
+	TArray<FString> Strings;
+	TArray<double> Doubles;
+	TArray<int64> Integers;
+
+	int32 Num() const;
+};
+
+/** Items of an ecommerce event as parallel arrays, one column per built-in item parameter,
+ *	e.g. ITEM_ID, ITEM_NAME, PRICE and QUANTITY. Row N of every column makes item N.
+ *	Items put with FFlatBundle::PutItems share their parameter layout, which lets the Android backend
+ *	hand the whole array to Java column by column.
+ */
+USTRUCT(BlueprintType)
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsItemColumns
+{
+	GENERATED_BODY()
+
+	/** Replace the column of Name. */
+	void SetStrings(EBuiltinParamNames Name, TArrayView<const FString> Values);
+	void SetStrings(EBuiltinParamNames Name, TArray<FString>&& Values);
+	void SetDoubles(EBuiltinParamNames Name, TArrayView<const double> Values);
+	void SetIntegers(EBuiltinParamNames Name, TArrayView<const int64> Values);
+
+	/** Number of items, the length of the longest column. Shorter columns leave their parameter out of the last items. */
+	int32 Num() const;
+
+	TArrayView<const FFirebaseAnalyticsItemColumn> GetColumns() const { return Columns; }
+
+	void Reset() { Columns.Reset(); }
+
+private:
+	FFirebaseAnalyticsItemColumn& FindOrAdd(EBuiltinParamNames Name, EFirebaseAnalyticsParameterType Type);
+
+	TArray<FFirebaseAnalyticsItemColumn, TInlineAllocator<8>> Columns;
+};
+
+/** Parameter name that outlives every bundle, e.g. a string literal. Bundles keep the pointer instead of copying the name. */
+struct FFirebaseAnalyticsStaticName
+{
+	explicit constexpr FFirebaseAnalyticsStaticName(const TCHAR* InName)
+		: Name(InName)
+	{
+	}
+
+	const TCHAR* Name;
+};
+
+/** Range of items inside FFlatBundle::Items. */
+struct FFlatBundleItemRange
+{
+	int32 First;
+	int32 Num;
+};
+
+/** One tagged parameter of FFlatBundle.
+ *	Built-in names are stored as an EBuiltinParamNames index and static names as a pointer, so no string is built for them.
+ */
+struct FIREBASEANALYTICS_API FFirebaseAnalyticsParameter
+{
+	EFirebaseAnalyticsParameterType Type = EFirebaseAnalyticsParameterType::String;
+	int16 BuiltinName = INDEX_NONE;
+	const TCHAR* StaticName = nullptr;
+	FString Name;
+	FString StringValue;
+	union
+	{
+		float FloatValue;
+		double DoubleValue;
+		int32 IntegerValue;
+		int64 Int64Value;
+		FFlatBundleItemRange Items;
+	};
+
+	FFirebaseAnalyticsParameter()
+		: Int64Value(0)
+	{
+	}
+
+	bool IsBuiltin() const { return BuiltinName != INDEX_NONE; }
+
+	/** True when the name is held in Name rather than by index or pointer. */
+	bool HasNameString() const { return !IsBuiltin() && StaticName == nullptr; }
+
+	/** Parameter name, resolved from the built-in table when needed. */
+	const TCHAR* GetName() const;
+
+	bool HasName(const TCHAR* OtherName) const;
+};
+
+/** Compact alternative to FBundle.
+ *	Parameters are kept in one insertion-ordered array with inline storage for small events,
+ *	and the parameters of every nested item bundle share one arena. Items can't nest further,
+ *	the same as Firebase. Replacing a bundles parameter leaves its old items in the arena until Reset().
+ */
+USTRUCT(BlueprintType)
+struct FIREBASEANALYTICS_API FFlatBundle
+{
+	GENERATED_BODY()
+
+	typedef TArray<FFirebaseAnalyticsParameter, TInlineAllocator<6>> FParameterArray;
+
+	FFlatBundle() = default;
+	explicit FFlatBundle(const FBundle& Bundle);
+
+	/** Takes string values and items out of Bundle instead of copying them. */
+	explicit FFlatBundle(FBundle&& Bundle);
+
+	void PutString(const FString& Name, const FString& Value);
+	void PutString(EBuiltinParamNames Name, const FString& Value);
+	void PutString(FFirebaseAnalyticsStaticName Name, const FString& Value);
+	void PutFloat(const FString& Name, float Value);
+	void PutFloat(EBuiltinParamNames Name, float Value);
+	void PutFloat(FFirebaseAnalyticsStaticName Name, float Value);
+	void PutDouble(const FString& Name, double Value);
+	void PutDouble(EBuiltinParamNames Name, double Value);
+	void PutDouble(FFirebaseAnalyticsStaticName Name, double Value);
+	void PutInteger(const FString& Name, int32 Value);
+	void PutInteger(EBuiltinParamNames Name, int32 Value);
+	void PutInteger(FFirebaseAnalyticsStaticName Name, int32 Value);
+	void PutInt64(const FString& Name, int64 Value);
+	void PutInt64(EBuiltinParamNames Name, int64 Value);
+	void PutInt64(FFirebaseAnalyticsStaticName Name, int64 Value);
+	void PutBundles(const FString& Name, TArrayView<const FFlatBundle> Value);
+	void PutBundles(EBuiltinParamNames Name, TArrayView<const FFlatBundle> Value);
+	void PutBundles(FFirebaseAnalyticsStaticName Name, TArrayView<const FFlatBundle> Value);
+	void PutBundles(const FString& Name, TArray<FFlatBundle>&& Value);
+	void PutBundles(EBuiltinParamNames Name, TArray<FFlatBundle>&& Value);
+	void PutBundles(FFirebaseAnalyticsStaticName Name, TArray<FFlatBundle>&& Value);
+
+	/** Put the rows of Columns as the ITEMS parameter. */
+	void PutItems(const FFirebaseAnalyticsItemColumns& Columns);
+	void PutNull(const FString& Name);
+	void PutNull(EBuiltinParamNames Name);
+	void PutNull(FFirebaseAnalyticsStaticName Name);
+
+	/** Top-level parameters in insertion order. */
+	TArrayView<const FFirebaseAnalyticsParameter> GetParameters() const { return Parameters; }
+
+	/** Parameters of one item of a Bundles parameter. */
+	TArrayView<const FFirebaseAnalyticsParameter> GetItemParameters(const FFirebaseAnalyticsParameter& Parameter, int32 ItemIdx) const;
+
+	int32 Num() const { return Parameters.Num(); }
+	bool IsEmpty() const { return Parameters.Num() == 0; }
+
+	/** For fixing names and values in place, e.g. truncating them. Types and item ranges must be left alone. */
+	TArrayView<FFirebaseAnalyticsParameter> GetMutableParameters() { return Parameters; }
+
+	/** Parameters of every item, including items no longer referenced. Same rules as GetMutableParameters(). */
+	TArrayView<FFirebaseAnalyticsParameter> GetMutableItemParameters() { return ItemParameters; }
+
+	/** Keep the first NumToKeep top-level parameters and drop the rest. */
+	void TruncateParameters(int32 NumToKeep);
+
+	/** Remove all parameters but keep the allocated storage. */
+	void Reset();
+
+private:
+	FFirebaseAnalyticsParameter& FindOrAdd(const FString& Name);
+	FFirebaseAnalyticsParameter& FindOrAdd(EBuiltinParamNames Name);
+	FFirebaseAnalyticsParameter& FindOrAdd(FFirebaseAnalyticsStaticName Name);
+	/** Copies item parameters out of const items and moves them out of mutable ones. */
+	template <typename ItemType>
+	void SetItems(FFirebaseAnalyticsParameter& Parameter, TArrayView<ItemType> Value);
+
+	FParameterArray Parameters;
+
+	/** Parameters of all nested items, back to back. */
+	TArray<FFirebaseAnalyticsParameter> ItemParameters;
+
+	/** Slice of ItemParameters for each item. */
+	TArray<FFlatBundleItemRange> Items;
+};
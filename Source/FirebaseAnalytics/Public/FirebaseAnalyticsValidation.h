@@ -0,0 +1,175 @@
+// Copyright (C) 2021. Nikita Klimov. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EFirebaseAnalyticsNameKind : uint8
+{
+	Event,
+	Parameter,
+	UserProperty,
+};
+
+/** Firebase limits on names and values, shared by the runtime validator and the compile-time checks below. */
+namespace FirebaseAnalyticsLimits
+{
+	constexpr int32 MaxEventNameLength = 40;
+	constexpr int32 MaxParameterNameLength = 40;
+	constexpr int32 MaxParameterValueLength = 100;
+	constexpr int32 MaxParameters = 25;
+	constexpr int32 MaxUserPropertyNameLength = 24;
+	constexpr int32 MaxUserPropertyValueLength = 36;
+	constexpr int32 MaxUserIDLength = 256;
+
+	constexpr const TCHAR* ReservedPrefixes[] =
+	{
+		TEXT("firebase_"),
+		TEXT("google_"),
+		TEXT("ga_"),
+	};
+
+	/** Logged automatically by the SDK, can't be logged by the app. */
+	constexpr const TCHAR* ReservedEventNames[] =
+	{
+		TEXT("ad_activeview"),
+		TEXT("ad_click"),
+		TEXT("ad_exposure"),
+		TEXT("ad_query"),
+		TEXT("ad_reward"),
+		TEXT("adunit_exposure"),
+		TEXT("app_background"),
+		TEXT("app_clear_data"),
+		TEXT("app_exception"),
+		TEXT("app_remove"),
+		TEXT("app_store_refund"),
+		TEXT("app_store_subscription_cancel"),
+		TEXT("app_store_subscription_convert"),
+		TEXT("app_store_subscription_renew"),
+		TEXT("app_update"),
+		TEXT("app_upgrade"),
+		TEXT("dynamic_link_app_open"),
+		TEXT("dynamic_link_app_update"),
+		TEXT("dynamic_link_first_open"),
+		TEXT("error"),
+		TEXT("first_open"),
+		TEXT("first_visit"),
+		TEXT("in_app_purchase"),
+		TEXT("notification_dismiss"),
+		TEXT("notification_foreground"),
+		TEXT("notification_open"),
+		TEXT("notification_receive"),
+		TEXT("os_update"),
+		TEXT("session_start"),
+		TEXT("session_start_with_rollout"),
+		TEXT("user_engagement"),
+	};
+
+	constexpr const TCHAR* ReservedUserPropertyNames[] =
+	{
+		TEXT("first_open_after_install"),
+		TEXT("first_open_time"),
+		TEXT("first_visit_time"),
+		TEXT("last_deep_link_referrer"),
+		TEXT("user_id"),
+	};
+
+	constexpr bool IsLetter(TCHAR Char)
+	{
+		return (Char >= TEXT('a') && Char <= TEXT('z')) || (Char >= TEXT('A') && Char <= TEXT('Z'));
+	}
+
+	constexpr bool IsNameChar(TCHAR Char)
+	{
+		return IsLetter(Char) || (Char >= TEXT('0') && Char <= TEXT('9')) || Char == TEXT('_');
+	}
+
+	constexpr bool StartsWith(const TCHAR* Name, const TCHAR* Prefix)
+	{
+		for (; *Prefix; ++Name, ++Prefix)
+		{
+			if (*Name != *Prefix)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	constexpr bool Equals(const TCHAR* A, const TCHAR* B)
+	{
+		for (; *A && *A == *B; ++A, ++B)
+		{
+		}
+		return *A == *B;
+	}
+
+	template <int32 NumNames>
+	constexpr bool IsOneOf(const TCHAR* Name, const TCHAR* const (&Names)[NumNames])
+	{
+		for (const TCHAR* Candidate : Names)
+		{
+			if (Equals(Name, Candidate))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr int32 GetMaxNameLength(EFirebaseAnalyticsNameKind Kind)
+	{
+		return Kind == EFirebaseAnalyticsNameKind::Event ? MaxEventNameLength
+			: Kind == EFirebaseAnalyticsNameKind::Parameter ? MaxParameterNameLength
+			: MaxUserPropertyNameLength;
+	}
+
+	constexpr bool HasReservedPrefix(const TCHAR* Name)
+	{
+		for (const TCHAR* Prefix : ReservedPrefixes)
+		{
+			if (StartsWith(Name, Prefix))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	constexpr bool IsReservedName(const TCHAR* Name, EFirebaseAnalyticsNameKind Kind)
+	{
+		return Kind == EFirebaseAnalyticsNameKind::Event ? IsOneOf(Name, ReservedEventNames)
+			: Kind == EFirebaseAnalyticsNameKind::UserProperty ? IsOneOf(Name, ReservedUserPropertyNames)
+			: false;
+	}
+
+	/** Whether a string literal is usable as a name, checked while compiling. */
+	template <int32 N>
+	constexpr bool IsValidName(const TCHAR (&Name)[N], EFirebaseAnalyticsNameKind Kind)
+	{
+		if (N < 2 || N - 1 > GetMaxNameLength(Kind) || !IsLetter(Name[0]))
+		{
+			return false;
+		}
+		for (int32 CharIdx = 0; CharIdx < N - 1; ++CharIdx)
+		{
+			if (!IsNameChar(Name[CharIdx]))
+			{
+				return false;
+			}
+		}
+		return !HasReservedPrefix(Name) && !IsReservedName(Name, Kind);
+	}
+}
+
+/** Event name literal checked at compile time, e.g. LogEvent(FIREBASE_ANALYTICS_EVENT_NAME("level_up")).
+ *	The runtime validator still sees the name, but only ever as a cache hit.
+ */
+#define FIREBASE_ANALYTICS_EVENT_NAME(Literal) \
+	([]() { static_assert(FirebaseAnalyticsLimits::IsValidName(TEXT(Literal), EFirebaseAnalyticsNameKind::Event), "Invalid Firebase Analytics event name: " Literal); return TEXT(Literal); }())
+
+#define FIREBASE_ANALYTICS_PARAM_NAME(Literal) \
+	([]() { static_assert(FirebaseAnalyticsLimits::IsValidName(TEXT(Literal), EFirebaseAnalyticsNameKind::Parameter), "Invalid Firebase Analytics parameter name: " Literal); return TEXT(Literal); }())
+
+#define FIREBASE_ANALYTICS_USER_PROPERTY_NAME(Literal) \
+	([]() { static_assert(FirebaseAnalyticsLimits::IsValidName(TEXT(Literal), EFirebaseAnalyticsNameKind::UserProperty), "Invalid Firebase Analytics user property name: " Literal); return TEXT(Literal); }())